@@ -5,3 +5,6 @@
 #import "ShaderTypes.h"
 #include "PngEncoder.h"
 #include "PngDecoder.h"
+#include "DepthRansCoder.h"
+#include "FrameStoreCoder.h"
+#include "DatasetAsyncWriter.h"
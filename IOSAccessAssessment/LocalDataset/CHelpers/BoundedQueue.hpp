@@ -0,0 +1,112 @@
+//
+//  BoundedQueue.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef BoundedQueue_hpp
+#define BoundedQueue_hpp
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+    A lock-free queue of fixed capacity, for any number of producers and consumers (Vyukov's bounded MPMC queue).
+
+    Every slot has a sequence number that tells whether it is ready to be written or read in the current lap,
+    so producers and consumers only contend on their own position, with a single compare-and-swap each.
+    Pushing to a full queue and popping from an empty one fail instead of waiting; callers decide how to wait.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /// The capacity is rounded up to a power of two
+    explicit BoundedQueue (size_t minimumCapacity) {
+        size_t capacity = 2;
+        while (capacity < minimumCapacity) {
+            capacity *= 2;
+        }
+        mask = capacity - 1;
+        slots.reset(new Slot[capacity]);
+        for (size_t i = 0; i < capacity; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue (const BoundedQueue &) = delete;
+    BoundedQueue &operator= (const BoundedQueue &) = delete;
+
+    size_t capacity () const {
+        return mask + 1;
+    }
+
+    /// Number of values in the queue. Only a snapshot while other threads push or pop.
+    size_t size () const {
+        size_t tail = dequeuePosition.load(std::memory_order_relaxed);
+        size_t head = enqueuePosition.load(std::memory_order_relaxed);
+        return head > tail ? head - tail : 0;
+    }
+
+    bool tryPush (T &value) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[position & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = intptr_t(sequence) - intptr_t(position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop (T &value) {
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[position & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = intptr_t(sequence) - intptr_t(position + 1);
+            if (difference == 0) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(slot->value);
+        // Release what the slot held now, instead of when it is next written
+        slot->value = T();
+        slot->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask = 0;
+    // On their own cache lines, so that producers and consumers do not invalidate each other's
+    alignas(64) std::atomic<size_t> enqueuePosition { 0 };
+    alignas(64) std::atomic<size_t> dequeuePosition { 0 };
+};
+
+#endif /* BoundedQueue_hpp */
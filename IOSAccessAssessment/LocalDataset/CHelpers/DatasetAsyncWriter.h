@@ -0,0 +1,79 @@
+//
+//  DatasetAsyncWriter.h
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DatasetAsyncWriter_h
+#define DatasetAsyncWriter_h
+#include <Foundation/Foundation.h>
+NS_ASSUME_NONNULL_BEGIN
+
+/// What the writer does with a frame that is submitted while its queue is full
+typedef NS_ENUM(NSInteger, DatasetWriterOverflowPolicy) {
+    /// Wait for a free slot, for up to the block timeout, then drop the frame
+    DatasetWriterOverflowPolicyBlock,
+    /// Drop the submitted frame
+    DatasetWriterOverflowPolicyDropNewest,
+    /// Drop the oldest frame that is still waiting for an encoder
+    DatasetWriterOverflowPolicyDropOldest
+};
+
+/**
+    The files of a frame, each with a block that encodes it. The blocks run on the encoder threads of the writer,
+    so they must only capture what stays unchanged until then, such as the immutable images and mesh anchors of the frame,
+    which they retain until the frame is encoded. The encoded data is written without being copied.
+ */
+@interface DatasetAsyncFrame : NSObject
+
+- (instancetype) initWithFrameId:(NSUUID *)frameId timestamp:(double)timestamp;
+
+/**
+    Runs on the writer thread once every file of the frame is written, such as to add the rows of the frame to the CSV files,
+    so that no row points to files that do not exist. It does not run if the frame is dropped or a file of it fails.
+    Returning NO counts the frame as failed. Must be set before the frame is submitted.
+    The blocks of the frames run in the order the frames were submitted.
+ */
+@property (nonatomic, copy, nullable) BOOL (^onWritten)(void);
+
+- (void) addFileAtPath:(NSString *)path
+                stream:(uint32_t)stream
+         fileExtension:(NSString *)fileExtension
+               encoder:(NSData * _Nullable (^)(void))encoder;
+
+@end
+
+/**
+    Encodes and writes dataset frames on background threads, through a bounded queue.
+ */
+@interface DatasetAsyncWriter : NSObject
+
+/**
+    A frame store path of nil writes every file to its path; otherwise every file is appended to the store.
+    A block timeout of 0 waits for as long as it takes. Returns nil if the frame store cannot be opened.
+ */
+- (nullable instancetype) initWithQueueCapacity:(NSInteger)queueCapacity
+                                 encoderThreads:(NSInteger)encoderThreads
+                                       overflow:(DatasetWriterOverflowPolicy)overflow
+                                 blockTimeoutMs:(int64_t)blockTimeoutMs
+                                 frameStorePath:(nullable NSString *)frameStorePath;
+
+/// Returns NO if the frame was dropped. A frame can only be submitted once.
+- (BOOL) submitFrame:(DatasetAsyncFrame *)frame;
+
+/// Waits until every submitted frame is written, with its onWritten block run, or dropped. Returns NO if any file failed since the last flush.
+- (BOOL) flush;
+
+/// Flushes and stops the threads. Frames submitted afterwards are dropped.
+- (BOOL) close;
+
+/**
+    Queue depth, frame, file and byte counts, and stage latencies in nanoseconds,
+    keyed by the names of the fields of DatasetWriterCounters.
+ */
+@property (nonatomic, readonly) NSDictionary<NSString *, NSNumber *> *counters;
+
+@end
+NS_ASSUME_NONNULL_END
+#endif /* DatasetAsyncWriter_h */
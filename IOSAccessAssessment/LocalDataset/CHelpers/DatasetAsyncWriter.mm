@@ -0,0 +1,135 @@
+//
+//  DatasetAsyncWriter.mm
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#import <Foundation/Foundation.h>
+#import "DatasetAsyncWriter.h"
+#include "DatasetWriter.hpp"
+#include <memory>
+
+@implementation DatasetAsyncFrame {
+    @public
+    DatasetWriterFrame frame;
+}
+
+- (instancetype)initWithFrameId:(NSUUID *)frameId timestamp:(double)timestamp {
+    self = [super init];
+    if (self) {
+        [frameId getUUIDBytes:frame.frameId];
+        frame.timestamp = timestamp;
+    }
+    return self;
+}
+
+- (void)addFileAtPath:(NSString *)path
+               stream:(uint32_t)stream
+        fileExtension:(NSString *)fileExtension
+              encoder:(NSData * _Nullable (^)(void))encoder {
+    DatasetWriterBlob blob;
+    blob.path = path.fileSystemRepresentation;
+    blob.stream = stream;
+    blob.fileExtension = fileExtension.UTF8String;
+    blob.encode = [encoder](DatasetWriterBytes &encoded) {
+        // Encoder threads have no autorelease pool of their own
+        @autoreleasepool {
+            NSData *data = encoder();
+            if (data == nil) {
+                return false;
+            }
+            // The data is retained until its bytes are written, and written where they are
+            encoded.external = (const uint8_t *)data.bytes;
+            encoded.externalSize = data.length;
+            encoded.owner = std::shared_ptr<const void>((__bridge_retained const void *)data, [](const void *owner) {
+                CFRelease(owner);
+            });
+            return true;
+        }
+    };
+    frame.blobs.push_back(std::move(blob));
+}
+
+@end
+
+@implementation DatasetAsyncWriter {
+    std::unique_ptr<DatasetWriter> writer;
+}
+
+- (instancetype)initWithQueueCapacity:(NSInteger)queueCapacity
+                       encoderThreads:(NSInteger)encoderThreads
+                             overflow:(DatasetWriterOverflowPolicy)overflow
+                       blockTimeoutMs:(int64_t)blockTimeoutMs
+                       frameStorePath:(NSString *)frameStorePath {
+    self = [super init];
+    if (self) {
+        DatasetWriterConfig config;
+        config.queueCapacity = size_t(MAX(queueCapacity, 1));
+        config.encoderThreads = unsigned(MAX(encoderThreads, 1));
+        switch (overflow) {
+            case DatasetWriterOverflowPolicyBlock:
+                config.overflow = DatasetWriterOverflow::Block;
+                break;
+            case DatasetWriterOverflowPolicyDropNewest:
+                config.overflow = DatasetWriterOverflow::DropNewest;
+                break;
+            case DatasetWriterOverflowPolicyDropOldest:
+                config.overflow = DatasetWriterOverflow::DropOldest;
+                break;
+        }
+        config.blockTimeoutMs = blockTimeoutMs;
+        if (frameStorePath != nil) {
+            config.frameStorePath = frameStorePath.fileSystemRepresentation;
+        }
+        writer.reset(new DatasetWriter(config));
+        if (!writer->valid()) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (BOOL)submitFrame:(DatasetAsyncFrame *)frame {
+    BOOL (^onWritten)(void) = frame.onWritten;
+    if (onWritten != nil) {
+        frame->frame.written = [onWritten]() {
+            // The writer thread has no autorelease pool of its own
+            @autoreleasepool {
+                return bool(onWritten());
+            }
+        };
+    }
+    return writer->submit(frame->frame);
+}
+
+- (BOOL)flush {
+    return writer->flush();
+}
+
+- (BOOL)close {
+    return writer->close();
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)counters {
+    DatasetWriterCounters counters = writer->counters();
+    return @{
+        @"queueDepth": @(counters.queueDepth),
+        @"maxQueueDepth": @(counters.maxQueueDepth),
+        @"framesSubmitted": @(counters.framesSubmitted),
+        @"framesDropped": @(counters.framesDropped),
+        @"framesWritten": @(counters.framesWritten),
+        @"blobsWritten": @(counters.blobsWritten),
+        @"blobsFailed": @(counters.blobsFailed),
+        @"bytesWritten": @(counters.bytesWritten),
+        @"batchesWritten": @(counters.batchesWritten),
+        @"blockedNanoseconds": @(counters.blockedNanoseconds),
+        @"queuedNanoseconds": @(counters.queuedNanoseconds),
+        @"encodeNanoseconds": @(counters.encodeNanoseconds),
+        @"maxEncodeNanoseconds": @(counters.maxEncodeNanoseconds),
+        @"writeNanoseconds": @(counters.writeNanoseconds),
+        @"maxWriteNanoseconds": @(counters.maxWriteNanoseconds),
+    };
+}
+
+@end
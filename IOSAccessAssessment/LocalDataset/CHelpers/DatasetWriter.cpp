@@ -0,0 +1,367 @@
+//
+//  DatasetWriter.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "DatasetWriter.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+static uint64_t nanosecondsBetween (std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+template <typename T>
+static void storeMaximum (std::atomic<T> &maximum, T value) {
+    T current = maximum.load(std::memory_order_relaxed);
+    while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+    Writes a file whole or not at all: the bytes go to a hidden file in the same directory, which is synced and then
+    renamed over the path, so that a crash never leaves a truncated file where a reader expects a whole one.
+ */
+static bool writeFile (const std::string &path, const DatasetWriterBytes &bytes) {
+    size_t slash = path.rfind('/');
+    size_t nameStart = slash == std::string::npos ? 0 : slash + 1;
+    std::string temporaryPath = path.substr(0, nameStart) + "." + path.substr(nameStart) + ".partial";
+    FILE *file = fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && fflush(file) == 0
+        && fsync(fileno(file)) == 0;
+    written = fclose(file) == 0 && written && rename(temporaryPath.c_str(), path.c_str()) == 0;
+    if (!written) {
+        unlink(temporaryPath.c_str());
+    }
+    return written;
+}
+
+DatasetWriter::DatasetWriter (const DatasetWriterConfig &writerConfig)
+    : config(writerConfig),
+      frames(std::max<size_t>(writerConfig.queueCapacity, 1)),
+      // Room for every encoder to finish a frame while the writer is busy with a batch
+      encoded(std::max<size_t>(writerConfig.encoderThreads, 1) * 2) {
+    if (!config.frameStorePath.empty()) {
+        hasStore = true;
+        storeStatus = store.open(config.frameStorePath);
+    }
+    unsigned encoderCount = std::max(config.encoderThreads, 1u);
+    for (unsigned i = 0; i < encoderCount; i++) {
+        encoders.emplace_back(&DatasetWriter::encodeLoop, this);
+    }
+    writer = std::thread(&DatasetWriter::writeLoop, this);
+}
+
+DatasetWriter::~DatasetWriter () {
+    close();
+}
+
+bool DatasetWriter::submit (DatasetWriterFrame &frame) {
+    framesSubmitted.fetch_add(1, std::memory_order_relaxed);
+    if (closed.load()) {
+        framesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    std::unique_ptr<QueuedFrame> queued(new QueuedFrame());
+    queued->frame = std::move(frame);
+    queued->submitted = Clock::now();
+
+    // Counted before the push, so that a flush never sees the frame finish before it was accepted
+    uint64_t sequence = acceptedFrames.fetch_add(1);
+    queued->sequence = sequence;
+    bool pushed = frames.tryPush(queued);
+    if (!pushed && config.overflow == DatasetWriterOverflow::DropOldest) {
+        std::unique_ptr<QueuedFrame> oldest;
+        while (!pushed) {
+            if (frames.tryPop(oldest)) {
+                uint64_t oldestSequence = oldest->sequence;
+                oldest.reset();
+                dropFrame(oldestSequence);
+            }
+            pushed = frames.tryPush(queued);
+        }
+    } else if (!pushed && config.overflow == DatasetWriterOverflow::Block) {
+        Clock::time_point blockStart = Clock::now();
+        std::unique_lock<std::mutex> lock(waitMutex);
+        auto deadline = blockStart + std::chrono::milliseconds(config.blockTimeoutMs);
+        // Pushed under the lock, which encoders take before they notify, so that no notification is missed
+        while (!(pushed = frames.tryPush(queued))) {
+            if (config.blockTimeoutMs <= 0) {
+                framesChanged.wait(lock);
+            } else if (framesChanged.wait_until(lock, deadline) == std::cv_status::timeout) {
+                pushed = frames.tryPush(queued);
+                break;
+            }
+        }
+        blockedNanoseconds.fetch_add(nanosecondsBetween(blockStart, Clock::now()), std::memory_order_relaxed);
+    }
+    if (!pushed) {
+        dropFrame(sequence);
+        return false;
+    }
+    storeMaximum(maxQueueDepth, frames.size());
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+    }
+    framesChanged.notify_all();
+    return true;
+}
+
+void DatasetWriter::dropFrame (uint64_t sequence) {
+    framesDropped.fetch_add(1, std::memory_order_relaxed);
+    // The writer finishes it in order, as frames after it may be waiting for it
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        droppedSequences.push_back(sequence);
+    }
+    encodedChanged.notify_all();
+}
+
+void DatasetWriter::finishFrames (uint64_t count) {
+    finishedFrames.fetch_add(count);
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+    }
+    framesFinished.notify_all();
+}
+
+void DatasetWriter::encodeLoop () {
+    std::unique_ptr<QueuedFrame> queued;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(waitMutex);
+            while (!frames.tryPop(queued)) {
+                if (stopping.load()) {
+                    return;
+                }
+                framesChanged.wait(lock);
+            }
+        }
+        // Wakes submissions that wait for a free slot
+        framesChanged.notify_all();
+        Clock::time_point started = Clock::now();
+        queuedNanoseconds.fetch_add(nanosecondsBetween(queued->submitted, started), std::memory_order_relaxed);
+
+        std::unique_ptr<EncodedFrame> frame(new EncodedFrame());
+        frame->sequence = queued->sequence;
+        memcpy(frame->frameId, queued->frame.frameId, 16);
+        frame->timestamp = queued->frame.timestamp;
+        frame->written = std::move(queued->frame.written);
+        frame->blobs.reserve(queued->frame.blobs.size());
+        for (DatasetWriterBlob &blob : queued->frame.blobs) {
+            EncodedBlob encodedBlob;
+            Clock::time_point start = Clock::now();
+            bool succeeded = blob.encode && blob.encode(encodedBlob.bytes);
+            uint64_t elapsed = nanosecondsBetween(start, Clock::now());
+            encodeNanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+            storeMaximum(maxEncodeNanoseconds, elapsed);
+            if (!succeeded) {
+                blobsFailed.fetch_add(1, std::memory_order_relaxed);
+                frame->failed = true;
+                continue;
+            }
+            encodedBlob.path = std::move(blob.path);
+            encodedBlob.stream = blob.stream;
+            encodedBlob.fileExtension = std::move(blob.fileExtension);
+            frame->blobs.push_back(std::move(encodedBlob));
+        }
+        // Releases what the encoders held, such as the images and pixel buffers of the frame, before waiting for the writer
+        queued.reset();
+
+        std::unique_lock<std::mutex> lock(waitMutex);
+        while (!encoded.tryPush(frame)) {
+            encodedChanged.wait(lock);
+        }
+        lock.unlock();
+        encodedChanged.notify_all();
+    }
+}
+
+void DatasetWriter::writeLoop () {
+    std::vector<std::unique_ptr<EncodedFrame>> batch;
+    std::unique_ptr<EncodedFrame> frame;
+    std::vector<uint64_t> dropped;
+    while (true) {
+        size_t batchBlobs = 0;
+        size_t batchBytes = 0;
+        bool popped = false;
+        {
+            std::unique_lock<std::mutex> lock(waitMutex);
+            while (!(popped = encoded.tryPop(frame)) && droppedSequences.empty()) {
+                if (encodersStopped.load()) {
+                    return;
+                }
+                encodedChanged.wait(lock);
+            }
+            dropped.swap(droppedSequences);
+        }
+        if (!popped) {
+            finishInOrder(dropped);
+            continue;
+        }
+        // Takes whatever else is ready, up to the size of a batch, without waiting for more
+        do {
+            batchBlobs += frame->blobs.size();
+            for (const EncodedBlob &blob : frame->blobs) {
+                batchBytes += blob.bytes.size();
+            }
+            batch.push_back(std::move(frame));
+        } while (batchBlobs < config.batchBlobs && batchBytes < config.batchBytes && encoded.tryPop(frame));
+        {
+            std::lock_guard<std::mutex> lock(waitMutex);
+        }
+        encodedChanged.notify_all();
+        writeBatch(batch);
+        finishInOrder(dropped);
+    }
+}
+
+void DatasetWriter::writeBatch (std::vector<std::unique_ptr<EncodedFrame>> &batch) {
+    Clock::time_point start = Clock::now();
+    size_t blobCount = 0;
+    size_t byteCount = 0;
+    size_t failedCount = 0;
+    if (hasStore) {
+        std::vector<FrameStoreAppend> appends;
+        for (const std::unique_ptr<EncodedFrame> &frame : batch) {
+            for (const EncodedBlob &blob : frame->blobs) {
+                FrameStoreAppend append;
+                append.frameId = frame->frameId;
+                append.timestamp = frame->timestamp;
+                append.stream = blob.stream;
+                append.fileExtension = blob.fileExtension.c_str();
+                append.data = blob.bytes.data();
+                append.size = blob.bytes.size();
+                appends.push_back(append);
+                byteCount += blob.bytes.size();
+            }
+        }
+        blobCount = appends.size();
+        if (storeStatus != FrameStoreStatus::Ok || store.appendBatch(appends.data(), appends.size()) != FrameStoreStatus::Ok) {
+            failedCount = blobCount;
+            byteCount = 0;
+            for (const std::unique_ptr<EncodedFrame> &frame : batch) {
+                frame->failed = true;
+            }
+        }
+    } else {
+        for (const std::unique_ptr<EncodedFrame> &frame : batch) {
+            for (const EncodedBlob &blob : frame->blobs) {
+                blobCount++;
+                if (writeFile(blob.path, blob.bytes)) {
+                    byteCount += blob.bytes.size();
+                } else {
+                    failedCount++;
+                    frame->failed = true;
+                }
+            }
+        }
+    }
+    uint64_t elapsed = nanosecondsBetween(start, Clock::now());
+    writeNanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+    storeMaximum(maxWriteNanoseconds, elapsed);
+    batchesWritten.fetch_add(1, std::memory_order_relaxed);
+    blobsWritten.fetch_add(blobCount - failedCount, std::memory_order_relaxed);
+    blobsFailed.fetch_add(failedCount, std::memory_order_relaxed);
+    bytesWritten.fetch_add(byteCount, std::memory_order_relaxed);
+    // The encoded bytes are released as soon as they are written, even if the frame waits for an earlier one
+    for (std::unique_ptr<EncodedFrame> &frame : batch) {
+        frame->blobs.clear();
+        uint64_t sequence = frame->sequence;
+        waitingFrames[sequence] = std::move(frame);
+    }
+    batch.clear();
+}
+
+/**
+    Finishes the written and dropped frames that no earlier frame is still waiting for, in the order they were accepted,
+    so that the callbacks add the rows of the frames in the order they were captured, however the encoders finished.
+ */
+void DatasetWriter::finishInOrder (std::vector<uint64_t> &dropped) {
+    for (uint64_t sequence : dropped) {
+        waitingFrames[sequence] = nullptr;
+    }
+    dropped.clear();
+    uint64_t finished = 0;
+    for (auto next = waitingFrames.begin(); next != waitingFrames.end() && next->first == nextSequence;
+         next = waitingFrames.erase(next)) {
+        EncodedFrame *frame = next->second.get();
+        nextSequence++;
+        finished++;
+        if (frame == nullptr) {
+            continue;
+        }
+        // The rows of a frame are only added once its files exist
+        if (!frame->failed && frame->written && !frame->written()) {
+            frame->failed = true;
+        }
+        if (frame->failed) {
+            failedSinceFlush.store(true);
+        } else {
+            framesWritten.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (finished > 0) {
+        finishFrames(finished);
+    }
+}
+
+bool DatasetWriter::flush () {
+    uint64_t target = acceptedFrames.load();
+    std::unique_lock<std::mutex> lock(waitMutex);
+    framesFinished.wait(lock, [this, target] { return finishedFrames.load() >= target; });
+    lock.unlock();
+    return !failedSinceFlush.exchange(false);
+}
+
+bool DatasetWriter::close () {
+    if (closed.exchange(true)) {
+        return true;
+    }
+    bool flushed = flush();
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        stopping.store(true);
+    }
+    framesChanged.notify_all();
+    for (std::thread &encoder : encoders) {
+        encoder.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        encodersStopped.store(true);
+    }
+    encodedChanged.notify_all();
+    writer.join();
+    if (hasStore && storeStatus == FrameStoreStatus::Ok) {
+        flushed = store.finish() == FrameStoreStatus::Ok && flushed;
+    }
+    return flushed;
+}
+
+DatasetWriterCounters DatasetWriter::counters () const {
+    DatasetWriterCounters counters;
+    counters.queueDepth = frames.size();
+    counters.maxQueueDepth = maxQueueDepth.load(std::memory_order_relaxed);
+    counters.framesSubmitted = framesSubmitted.load(std::memory_order_relaxed);
+    counters.framesDropped = framesDropped.load(std::memory_order_relaxed);
+    counters.framesWritten = framesWritten.load(std::memory_order_relaxed);
+    counters.blobsWritten = blobsWritten.load(std::memory_order_relaxed);
+    counters.blobsFailed = blobsFailed.load(std::memory_order_relaxed);
+    counters.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+    counters.batchesWritten = batchesWritten.load(std::memory_order_relaxed);
+    counters.blockedNanoseconds = blockedNanoseconds.load(std::memory_order_relaxed);
+    counters.queuedNanoseconds = queuedNanoseconds.load(std::memory_order_relaxed);
+    counters.encodeNanoseconds = encodeNanoseconds.load(std::memory_order_relaxed);
+    counters.maxEncodeNanoseconds = maxEncodeNanoseconds.load(std::memory_order_relaxed);
+    counters.writeNanoseconds = writeNanoseconds.load(std::memory_order_relaxed);
+    counters.maxWriteNanoseconds = maxWriteNanoseconds.load(std::memory_order_relaxed);
+    return counters;
+}
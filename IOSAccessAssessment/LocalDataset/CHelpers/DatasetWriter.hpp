@@ -0,0 +1,231 @@
+//
+//  DatasetWriter.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DatasetWriter_hpp
+#define DatasetWriter_hpp
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BoundedQueue.hpp"
+#include "FrameStore.hpp"
+
+/**
+    What the writer does with a frame that is submitted while its queue is full.
+ */
+enum class DatasetWriterOverflow {
+    /// Wait for a free slot, for up to the block timeout, then drop the frame
+    Block,
+    /// Drop the submitted frame
+    DropNewest,
+    /// Drop the oldest frame that no encoder has started on, to make room for the submitted one
+    DropOldest
+};
+
+struct DatasetWriterConfig {
+    /// Frames waiting for an encoder
+    size_t queueCapacity = 8;
+    unsigned encoderThreads = 2;
+    DatasetWriterOverflow overflow = DatasetWriterOverflow::Block;
+    /// 0 waits for as long as it takes
+    int64_t blockTimeoutMs = 0;
+    /// Encoded blobs are written once this many are waiting, or once their size reaches batchBytes,
+    /// or as soon as no more are coming
+    size_t batchBlobs = 16;
+    size_t batchBytes = 8 << 20;
+    /// Path of a frame store to append every blob to, instead of writing one file per blob
+    std::string frameStorePath;
+};
+
+/**
+    The encoded bytes of a blob. An encoder either fills storage, or points external at bytes that owner keeps alive,
+    such as those of an NSData, so that they are written from where they were encoded instead of being copied.
+ */
+struct DatasetWriterBytes {
+    std::vector<uint8_t> storage;
+    std::shared_ptr<const void> owner;
+    const uint8_t *external = nullptr;
+    size_t externalSize = 0;
+
+    const uint8_t *data () const {
+        return owner != nullptr ? external : storage.data();
+    }
+
+    size_t size () const {
+        return owner != nullptr ? externalSize : storage.size();
+    }
+};
+
+/**
+    A file of a frame, and how to encode it. The encoder runs on a worker thread.
+ */
+struct DatasetWriterBlob {
+    /// Path of the file, used when the writer has no frame store
+    std::string path;
+    /// Stream and file extension of the blob in the frame store
+    uint32_t stream = 0;
+    std::string fileExtension;
+    std::function<bool (DatasetWriterBytes &encoded)> encode;
+};
+
+struct DatasetWriterFrame {
+    uint8_t frameId[16] = {};
+    double timestamp = 0;
+    std::vector<DatasetWriterBlob> blobs;
+    /**
+        Runs on the writer thread once every blob of the frame is written, such as to add the rows of the frame
+        to the CSV files of the dataset, so that no row points to files that do not exist. It does not run for frames
+        that were dropped, or that a blob of failed. Returning false counts the frame as failed.
+        Callbacks run in the order the frames were submitted, whichever encoder finishes first.
+     */
+    std::function<bool ()> written;
+};
+
+/**
+    A snapshot of the counters of a writer. Latencies are in nanoseconds; stage latencies are summed over blobs.
+ */
+struct DatasetWriterCounters {
+    size_t queueDepth = 0;
+    size_t maxQueueDepth = 0;
+    uint64_t framesSubmitted = 0;
+    uint64_t framesDropped = 0;
+    uint64_t framesWritten = 0;
+    uint64_t blobsWritten = 0;
+    uint64_t blobsFailed = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t batchesWritten = 0;
+    /// Time that submissions waited for a free slot
+    uint64_t blockedNanoseconds = 0;
+    /// Time from submission until an encoder started on the frame
+    uint64_t queuedNanoseconds = 0;
+    uint64_t encodeNanoseconds = 0;
+    uint64_t maxEncodeNanoseconds = 0;
+    uint64_t writeNanoseconds = 0;
+    uint64_t maxWriteNanoseconds = 0;
+};
+
+/**
+    Saves dataset frames off the capturing thread.
+
+    Submitted frames go into a bounded lock-free queue. Encoder threads take frames from it and encode their blobs,
+    then hand them to a single writer thread through a second queue. The writer writes the blobs in batches,
+    either to their files or to a frame store. A file is written to a hidden file next to it, then renamed,
+    so that it either exists whole or not at all. When the first queue is full, the overflow policy decides
+    whether the caller waits or a frame is dropped, so that a slow encoder never holds more than queueCapacity frames.
+    When the second queue is full, encoders wait for the writer.
+ */
+class DatasetWriter {
+public:
+    explicit DatasetWriter (const DatasetWriterConfig &config);
+    DatasetWriter (const DatasetWriter &) = delete;
+    DatasetWriter &operator= (const DatasetWriter &) = delete;
+    /// Closes the writer
+    ~DatasetWriter ();
+
+    /// Whether the frame store could be opened, if the writer has one
+    bool valid () const {
+        return storeStatus == FrameStoreStatus::Ok;
+    }
+
+    /// Returns false if the frame was dropped. The frame is moved from even if it was dropped.
+    bool submit (DatasetWriterFrame &frame);
+
+    /**
+        Waits until every frame submitted before the call is written or dropped.
+        Returns false if any blob failed to encode or write since the last flush.
+     */
+    bool flush ();
+
+    /// Flushes, stops the threads and finishes the frame store. Frames submitted afterwards are dropped.
+    bool close ();
+
+    DatasetWriterCounters counters () const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct QueuedFrame {
+        DatasetWriterFrame frame;
+        Clock::time_point submitted;
+        /// Position of the frame among the accepted ones
+        uint64_t sequence = 0;
+    };
+    struct EncodedBlob {
+        std::string path;
+        uint32_t stream = 0;
+        std::string fileExtension;
+        DatasetWriterBytes bytes;
+    };
+    struct EncodedFrame {
+        uint64_t sequence = 0;
+        uint8_t frameId[16] = {};
+        double timestamp = 0;
+        std::vector<EncodedBlob> blobs;
+        std::function<bool ()> written;
+        bool failed = false;
+    };
+
+    void encodeLoop ();
+    void writeLoop ();
+    void writeBatch (std::vector<std::unique_ptr<EncodedFrame>> &batch);
+    void dropFrame (uint64_t sequence);
+    void finishInOrder (std::vector<uint64_t> &dropped);
+    void finishFrames (uint64_t count);
+
+    DatasetWriterConfig config;
+    BoundedQueue<std::unique_ptr<QueuedFrame>> frames;
+    BoundedQueue<std::unique_ptr<EncodedFrame>> encoded;
+    FrameStoreWriter store;
+    FrameStoreStatus storeStatus = FrameStoreStatus::Ok;
+    bool hasStore = false;
+
+    /// Sleeping threads wait on these; the queues themselves are never locked
+    std::mutex waitMutex;
+    std::condition_variable framesChanged;
+    std::condition_variable encodedChanged;
+    std::condition_variable framesFinished;
+    std::atomic<bool> stopping { false };
+    std::atomic<bool> encodersStopped { false };
+    std::atomic<bool> closed { false };
+    std::vector<std::thread> encoders;
+    std::thread writer;
+    /// Sequences of the accepted frames that were dropped, for the writer to skip; guarded by waitMutex
+    std::vector<uint64_t> droppedSequences;
+    /// Written frames, by sequence (null for dropped ones), that wait for an earlier frame; only used by the writer thread
+    std::map<uint64_t, std::unique_ptr<EncodedFrame>> waitingFrames;
+    uint64_t nextSequence = 0;
+
+    /// Frames that were accepted, and accepted frames that were written or dropped
+    std::atomic<uint64_t> acceptedFrames { 0 };
+    std::atomic<uint64_t> finishedFrames { 0 };
+    std::atomic<bool> failedSinceFlush { false };
+
+    std::atomic<size_t> maxQueueDepth { 0 };
+    std::atomic<uint64_t> framesSubmitted { 0 };
+    std::atomic<uint64_t> framesDropped { 0 };
+    std::atomic<uint64_t> framesWritten { 0 };
+    std::atomic<uint64_t> blobsWritten { 0 };
+    std::atomic<uint64_t> blobsFailed { 0 };
+    std::atomic<uint64_t> bytesWritten { 0 };
+    std::atomic<uint64_t> batchesWritten { 0 };
+    std::atomic<uint64_t> blockedNanoseconds { 0 };
+    std::atomic<uint64_t> queuedNanoseconds { 0 };
+    std::atomic<uint64_t> encodeNanoseconds { 0 };
+    std::atomic<uint64_t> maxEncodeNanoseconds { 0 };
+    std::atomic<uint64_t> writeNanoseconds { 0 };
+    std::atomic<uint64_t> maxWriteNanoseconds { 0 };
+};
+
+#endif /* DatasetWriter_hpp */
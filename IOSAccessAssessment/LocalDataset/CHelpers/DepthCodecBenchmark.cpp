@@ -0,0 +1,163 @@
+//
+//  DepthCodecBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "DepthCodecBenchmark.hpp"
+#include "DepthPngCodec.hpp"
+#include "DepthRansCodec.hpp"
+#include "LodePngZlib.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+typedef std::chrono::steady_clock BenchmarkClock;
+
+static double millisecondsSince (BenchmarkClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+}
+
+/**
+    Size and fastest times of a codec on a frame.
+ */
+struct CodecResult {
+    size_t bytes = 0;
+    double encodeMs = 0;
+    double decodeMs = 0;
+    bool lossless = false;
+};
+
+static std::string codecJSON (const CodecResult &result) {
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "{\"bytes\":%zu,\"encode_ms\":%.3f,\"decode_ms\":%.3f,\"lossless\":%s}",
+             result.bytes, result.encodeMs, result.decodeMs, result.lossless ? "true" : "false");
+    return buffer;
+}
+
+static void addResult (CodecResult &total, const CodecResult &result) {
+    total.bytes += result.bytes;
+    total.encodeMs += result.encodeMs;
+    total.decodeMs += result.decodeMs;
+    total.lossless = total.lossless && result.lossless;
+}
+
+std::string runDepthCodecBenchmark (const std::vector<std::vector<uint8_t>> &pngFiles, int iterations) {
+    iterations = std::max(iterations, 1);
+    CodecResult pngTotal;
+    CodecResult ransTotal;
+    pngTotal.lossless = true;
+    ransTotal.lossless = true;
+    size_t rawBytes = 0;
+    int frameCount = 0;
+
+    std::string frames;
+    std::vector<float> reference;
+    std::vector<float> decoded;
+    std::vector<uint8_t> samples;
+    std::vector<uint8_t> encoded;
+    for (size_t f = 0; f < pngFiles.size(); f++) {
+        const std::vector<uint8_t> &file = pngFiles[f];
+        int width = 0;
+        int height = 0;
+        size_t imageBytes = 0;
+        if (!readPngSize(file.data(), file.size(), width, height) || !depthImageBytes(width, height, imageBytes)) {
+            continue;
+        }
+        size_t pixelCount = imageBytes / sizeof(float);
+        reference.resize(pixelCount);
+        decoded.resize(pixelCount);
+        DepthBuffer referenceBuffer { reference.data(), 0, pixelCount * sizeof(float) };
+        DepthBuffer decodedBuffer { decoded.data(), 0, pixelCount * sizeof(float) };
+        if (decodeDepthPng(file.data(), file.size(), referenceBuffer, width, height) != DepthPngStatus::Ok) {
+            continue;
+        }
+        // The samples as the encoders get them, which is what the PNG holds
+        samples.resize(pixelCount * 2);
+        for (size_t i = 0; i < pixelCount; i++) {
+            uint16_t millimeters = uint16_t(reference[i] * 1000.0f + 0.5f);
+            samples[2 * i] = uint8_t(millimeters >> 8);
+            samples[2 * i + 1] = uint8_t(millimeters);
+        }
+
+        CodecResult png;
+        CodecResult rans;
+        png.encodeMs = rans.encodeMs = png.decodeMs = rans.decodeMs = 1e30;
+        for (int i = 0; i < iterations; i++) {
+            auto start = BenchmarkClock::now();
+            encodeGreyPng(samples.data(), width, height, 16, DepthPngFilter::Up, defaultPngCompressionLevel, 1, encoded);
+            png.encodeMs = std::min(png.encodeMs, millisecondsSince(start));
+            png.bytes = encoded.size();
+
+            start = BenchmarkClock::now();
+            png.lossless = decodeDepthPng(encoded.data(), encoded.size(), decodedBuffer, width, height) == DepthPngStatus::Ok
+                && decoded == reference;
+            png.decodeMs = std::min(png.decodeMs, millisecondsSince(start));
+
+            start = BenchmarkClock::now();
+            encodeDepthRans(samples.data(), width, height, defaultDepthRansRowsPerBlock, encoded);
+            rans.encodeMs = std::min(rans.encodeMs, millisecondsSince(start));
+            rans.bytes = encoded.size();
+
+            start = BenchmarkClock::now();
+            rans.lossless = decodeDepthRans(encoded.data(), encoded.size(), decodedBuffer, width, height) == DepthRansStatus::Ok
+                && decoded == reference;
+            rans.decodeMs = std::min(rans.decodeMs, millisecondsSince(start));
+        }
+
+        if (frameCount > 0) {
+            frames += ",";
+        }
+        frames += "{\"index\":" + std::to_string(f) + ",\"width\":" + std::to_string(width)
+            + ",\"height\":" + std::to_string(height)
+            + ",\"png\":" + codecJSON(png) + ",\"rans\":" + codecJSON(rans) + "}";
+        addResult(pngTotal, png);
+        addResult(ransTotal, rans);
+        rawBytes += pixelCount * 2;
+        frameCount++;
+    }
+
+    std::string json = "{\"frames\":" + std::to_string(frameCount) + ",\"iterations\":" + std::to_string(iterations)
+        + ",\"raw_bytes\":" + std::to_string(rawBytes)
+        + ",\"png\":" + codecJSON(pngTotal) + ",\"rans\":" + codecJSON(ransTotal);
+    if (pngTotal.bytes > 0) {
+        char ratio[64];
+        snprintf(ratio, sizeof(ratio), ",\"rans_size_ratio\":%.4f", double(ransTotal.bytes) / double(pngTotal.bytes));
+        json += ratio;
+    }
+    json += ",\"per_frame\":[" + frames + "]}";
+    return json;
+}
+
+std::vector<float> syntheticDepthFrame (int width, int height, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::normal_distribution<float> noise(0.0f, 0.004f);
+    std::vector<float> depth(size_t(width) * height);
+    for (int y = 0; y < height; y++) {
+        float floor = 0.5f + 7.5f * float(height - y) / float(height);
+        for (int x = 0; x < width; x++) {
+            depth[size_t(y) * width + x] = floor + noise(random);
+        }
+    }
+    std::uniform_int_distribution<int> column(0, std::max(width - 1, 0));
+    std::uniform_int_distribution<int> row(0, std::max(height - 1, 0));
+    std::uniform_real_distribution<float> distance(0.4f, 4.0f);
+    for (int box = 0; box < 6; box++) {
+        int left = column(random);
+        int top = row(random);
+        int right = std::min(width, left + 1 + width / 5);
+        int bottom = std::min(height, top + 1 + height / 5);
+        float boxDepth = distance(random);
+        for (int y = top; y < bottom; y++) {
+            for (int x = left; x < right; x++) {
+                depth[size_t(y) * width + x] = boxDepth + noise(random);
+            }
+        }
+    }
+    for (size_t hole = 0; hole < depth.size() / 500; hole++) {
+        depth[size_t(row(random)) * width + column(random)] = 0;
+    }
+    return depth;
+}
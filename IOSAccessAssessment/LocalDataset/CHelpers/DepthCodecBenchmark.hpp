@@ -0,0 +1,29 @@
+//
+//  DepthCodecBenchmark.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DepthCodecBenchmark_hpp
+#define DepthCodecBenchmark_hpp
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+    Compares the rANS depth format with the 16-bit PNG path on depth PNGs of a dataset.
+
+    Every frame is decoded once to get its samples, then encoded and decoded with each codec (on a single thread,
+    at the default PNG compression level), and both round trips are checked to be lossless.
+    Returns a JSON object with the size, encode and decode times of every frame, and their totals.
+ */
+std::string runDepthCodecBenchmark (const std::vector<std::vector<uint8_t>> &pngFiles, int iterations = 5);
+
+/**
+    A synthetic depth frame in meters, tightly packed: a floor that recedes towards the top of the frame, a few boxes in front
+    of it, sensor noise, and a few pixels without depth (0). The same seed always gives the same frame.
+ */
+std::vector<float> syntheticDepthFrame (int width, int height, uint32_t seed = 1);
+
+#endif /* DepthCodecBenchmark_hpp */
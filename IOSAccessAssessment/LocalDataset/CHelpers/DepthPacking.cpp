@@ -0,0 +1,135 @@
+//
+//  DepthPacking.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "DepthPacking.hpp"
+#include <cmath>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DEPTH_PACKING_NEON 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define DEPTH_PACKING_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DEPTH_PACKING_SSE2 1
+#endif
+
+/**
+    Largest depth that fits, in millimeters.
+ */
+static const float maxMillimeters = 65535.0f;
+
+static inline uint16_t millimetersFromMeters (float value) {
+    float millimeters = value * 1000.0f;
+    // Written so that NaN fails the comparison, and is saturated to 0 along with the negative values
+    if (!(millimeters > 0.0f)) {
+        return 0;
+    }
+    if (millimeters > maxMillimeters) {
+        return 65535;
+    }
+    return static_cast<uint16_t>(std::round(millimeters));
+}
+
+void packDepthMillimetersScalar (const float *depth, size_t count, uint8_t *output) {
+    for (size_t i = 0; i < count; i++) {
+        uint16_t millimeters = millimetersFromMeters(depth[i]);
+        output[2 * i] = static_cast<uint8_t>(millimeters >> 8);
+        output[2 * i + 1] = static_cast<uint8_t>(millimeters & 0xFF);
+    }
+}
+
+#if DEPTH_PACKING_NEON
+
+void packDepthMillimeters (const float *depth, size_t count, uint8_t *output) {
+    const float32x4_t scale = vdupq_n_f32(1000.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t maximum = vdupq_n_f32(maxMillimeters);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // vmaxnm returns the number when the other operand is NaN, so NaN becomes 0
+        float32x4_t low = vminq_f32(vmaxnmq_f32(vmulq_f32(vld1q_f32(depth + i), scale), zero), maximum);
+        float32x4_t high = vminq_f32(vmaxnmq_f32(vmulq_f32(vld1q_f32(depth + i + 4), scale), zero), maximum);
+        // vcvta rounds to nearest with ties away from zero, like std::round
+        uint16x8_t millimeters = vcombine_u16(vmovn_u32(vcvtaq_u32_f32(low)), vmovn_u32(vcvtaq_u32_f32(high)));
+        vst1q_u8(output + 2 * i, vrev16q_u8(vreinterpretq_u8_u16(millimeters)));
+    }
+    packDepthMillimetersScalar(depth + i, count - i, output + 2 * i);
+}
+
+#elif DEPTH_PACKING_AVX2 || DEPTH_PACKING_SSE2
+
+/**
+    Rounds non-negative values to the nearest integer with ties away from zero.
+    The conversion rounds ties to even, so the ties that were rounded down are moved up by one.
+ */
+static inline __m128i roundHalfAway (__m128 value) {
+    __m128i rounded = _mm_cvtps_epi32(value);
+    __m128 difference = _mm_sub_ps(value, _mm_cvtepi32_ps(rounded));
+    __m128i isTie = _mm_castps_si128(_mm_cmpeq_ps(difference, _mm_set1_ps(0.5f)));
+    // The tie mask is -1 where a tie was rounded down
+    return _mm_sub_epi32(rounded, isTie);
+}
+
+/**
+    Clamps four depths to millimeters in [0, 65535]. _mm_max_ps returns its second operand when either is NaN.
+ */
+static inline __m128 clampedMillimeters (const float *depth) {
+    __m128 millimeters = _mm_mul_ps(_mm_loadu_ps(depth), _mm_set1_ps(1000.0f));
+    return _mm_min_ps(_mm_max_ps(millimeters, _mm_setzero_ps()), _mm_set1_ps(maxMillimeters));
+}
+
+/**
+    Packs eight values in [0, 65535] to big-endian 16-bit. SSE2 only has a signed saturating pack, so the values are biased around it.
+ */
+static inline __m128i packBigEndian (__m128i low, __m128i high) {
+    const __m128i bias = _mm_set1_epi32(32768);
+    __m128i packed = _mm_packs_epi32(_mm_sub_epi32(low, bias), _mm_sub_epi32(high, bias));
+    packed = _mm_xor_si128(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+    return _mm_or_si128(_mm_slli_epi16(packed, 8), _mm_srli_epi16(packed, 8));
+}
+
+void packDepthMillimeters (const float *depth, size_t count, uint8_t *output) {
+    size_t i = 0;
+#if DEPTH_PACKING_AVX2
+    const __m256 scale = _mm256_set1_ps(1000.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 maximum = _mm256_set1_ps(maxMillimeters);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i byteSwap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                              1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 16 <= count; i += 16) {
+        __m256i rounded[2];
+        for (int k = 0; k < 2; k++) {
+            __m256 millimeters = _mm256_mul_ps(_mm256_loadu_ps(depth + i + 8 * k), scale);
+            millimeters = _mm256_min_ps(_mm256_max_ps(millimeters, zero), maximum);
+            __m256i nearestEven = _mm256_cvtps_epi32(millimeters);
+            __m256 difference = _mm256_sub_ps(millimeters, _mm256_cvtepi32_ps(nearestEven));
+            __m256i isTie = _mm256_castps_si256(_mm256_cmp_ps(difference, half, _CMP_EQ_OQ));
+            rounded[k] = _mm256_sub_epi32(nearestEven, isTie);
+        }
+        // The pack works within 128-bit lanes, so the quadwords are put back in order afterwards
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded[0], rounded[1]), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + 2 * i), _mm256_shuffle_epi8(packed, byteSwap));
+    }
+#endif
+    for (; i + 8 <= count; i += 8) {
+        __m128i low = roundHalfAway(clampedMillimeters(depth + i));
+        __m128i high = roundHalfAway(clampedMillimeters(depth + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 2 * i), packBigEndian(low, high));
+    }
+    packDepthMillimetersScalar(depth + i, count - i, output + 2 * i);
+}
+
+#else
+
+void packDepthMillimeters (const float *depth, size_t count, uint8_t *output) {
+    packDepthMillimetersScalar(depth, count, output);
+}
+
+#endif
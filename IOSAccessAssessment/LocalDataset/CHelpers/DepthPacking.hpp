@@ -0,0 +1,29 @@
+//
+//  DepthPacking.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DepthPacking_hpp
+#define DepthPacking_hpp
+#include <cstddef>
+#include <cstdint>
+
+/**
+    Converts depth in meters to big-endian 16-bit millimeters, the sample layout of a 16-bit greyscale PNG.
+ 
+    Each value is multiplied by 1000 and rounded to the nearest integer, with halves rounded away from zero (as std::round does).
+    Values are saturated to [0, 65535] millimeters; NaN and negative values become 0.
+    The output must have room for 2 * count bytes.
+ 
+    Uses NEON, AVX2 or SSE2 when they are available at build time, and is bit-exact with packDepthMillimetersScalar.
+ */
+void packDepthMillimeters (const float *depth, size_t count, uint8_t *output);
+
+/**
+    Reference implementation of packDepthMillimeters, one value at a time.
+ */
+void packDepthMillimetersScalar (const float *depth, size_t count, uint8_t *output);
+
+#endif /* DepthPacking_hpp */
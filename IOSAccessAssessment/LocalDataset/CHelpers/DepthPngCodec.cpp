@@ -0,0 +1,480 @@
+//
+//  DepthPngCodec.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "DepthPngCodec.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <zlib.h>
+
+static const uint8_t pngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+/// Bytes per pixel of 16-bit greyscale, which is the distance the filters look back
+static const size_t bytesPerPixel = 2;
+/// Stripes shorter than this are not worth a thread of their own
+static const int minimumStripeRows = 64;
+
+static inline uint32_t readBigEndian32 (const uint8_t *bytes) {
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+}
+
+static inline void appendBigEndian32 (std::vector<uint8_t> &output, uint32_t value) {
+    output.push_back(uint8_t(value >> 24));
+    output.push_back(uint8_t(value >> 16));
+    output.push_back(uint8_t(value >> 8));
+    output.push_back(uint8_t(value));
+}
+
+static inline uint8_t paethPredictor (int left, int up, int upLeft) {
+    int estimate = left + up - upLeft;
+    int distanceLeft = std::abs(estimate - left);
+    int distanceUp = std::abs(estimate - up);
+    int distanceUpLeft = std::abs(estimate - upLeft);
+    if (distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft) {
+        return uint8_t(left);
+    }
+    return uint8_t(distanceUp <= distanceUpLeft ? up : upLeft);
+}
+
+/**
+    Appends a chunk with the given type and data, and its CRC.
+ */
+static void appendChunk (std::vector<uint8_t> &png, const char *type, const uint8_t *data, size_t length) {
+    appendBigEndian32(png, uint32_t(length));
+    size_t typeOffset = png.size();
+    png.insert(png.end(), type, type + 4);
+    if (length > 0) {
+        png.insert(png.end(), data, data + length);
+    }
+    uint32_t crc = uint32_t(crc32(0L, png.data() + typeOffset, uInt(4 + length)));
+    appendBigEndian32(png, crc);
+}
+
+/**
+    Filters a row of samples. The previous row is null for the first row, where it is taken as zeros.
+    The first byte of the output is the filter type.
+ */
+static void filterRow (const uint8_t *row, const uint8_t *previousRow, size_t rowBytes, size_t pixelBytes,
+                       DepthPngFilter filter, uint8_t *output) {
+    uint8_t *filtered = output + 1;
+    if (filter == DepthPngFilter::Up) {
+        output[0] = 2;
+        if (previousRow == nullptr) {
+            std::memcpy(filtered, row, rowBytes);
+            return;
+        }
+        for (size_t i = 0; i < rowBytes; i++) {
+            filtered[i] = uint8_t(row[i] - previousRow[i]);
+        }
+        return;
+    }
+    
+    output[0] = 4;
+    for (size_t i = 0; i < rowBytes; i++) {
+        int left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+        int up = previousRow != nullptr ? previousRow[i] : 0;
+        int upLeft = (previousRow != nullptr && i >= pixelBytes) ? previousRow[i - pixelBytes] : 0;
+        filtered[i] = uint8_t(row[i] - paethPredictor(left, up, upLeft));
+    }
+}
+
+/**
+    Runs deflate on the pending input with the given flush mode, growing the output as needed.
+    Returns false if zlib fails.
+ */
+static bool deflateInto (z_stream &stream, std::vector<uint8_t> &output, int flush) {
+    while (true) {
+        if (stream.total_out == output.size()) {
+            output.resize(output.size() * 2 + 1024);
+        }
+        stream.next_out = output.data() + stream.total_out;
+        stream.avail_out = uInt(output.size() - stream.total_out);
+        int result = deflate(&stream, flush);
+        if (result == Z_STREAM_END) {
+            return true;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            return false;
+        }
+        // Done once all the input is consumed and, for a flush, zlib did not run out of room to finish it
+        if (stream.avail_in == 0 && (flush == Z_NO_FLUSH || stream.avail_out > 0)) {
+            return true;
+        }
+    }
+}
+
+/**
+    Filters and deflates the rows [firstRow, endRow) of the samples.
+    With a raw stream the output has no zlib header or checksum, and ends at a byte boundary after a sync flush,
+    unless it holds the last rows; the Adler-32 of the filtered data is returned separately so the stripes can be joined.
+ */
+static bool deflateRows (const uint8_t *samples, size_t rowBytes, size_t pixelBytes, int firstRow, int endRow, int height,
+                         DepthPngFilter filter, int compressionLevel, bool rawStream,
+                         std::vector<uint8_t> &output, uLong &adler) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    int windowBits = rawStream ? -15 : 15;
+    if (deflateInit2(&stream, compressionLevel, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    output.resize(deflateBound(&stream, uLong((rowBytes + 1) * size_t(endRow - firstRow))) + 64);
+    adler = adler32(0L, Z_NULL, 0);
+    
+    std::vector<uint8_t> filteredRow(rowBytes + 1);
+    bool succeeded = true;
+    for (int y = firstRow; y < endRow && succeeded; y++) {
+        const uint8_t *row = samples + size_t(y) * rowBytes;
+        // Rows of the previous stripe are read from the samples, so every stripe filters exactly like a single pass
+        const uint8_t *previousRow = y > 0 ? row - rowBytes : nullptr;
+        filterRow(row, previousRow, rowBytes, pixelBytes, filter, filteredRow.data());
+        adler = adler32(adler, filteredRow.data(), uInt(filteredRow.size()));
+        stream.next_in = filteredRow.data();
+        stream.avail_in = uInt(filteredRow.size());
+        int flush = Z_NO_FLUSH;
+        if (y == endRow - 1) {
+            flush = (endRow == height) ? Z_FINISH : Z_SYNC_FLUSH;
+        }
+        succeeded = deflateInto(stream, output, flush);
+    }
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return succeeded;
+}
+
+bool encodeGreyPng (const uint8_t *samples, int width, int height, int bitDepth, DepthPngFilter filter,
+                    int compressionLevel, unsigned threadCount, std::vector<uint8_t> &png) {
+    png.clear();
+    if (width <= 0 || height <= 0 || (bitDepth != 8 && bitDepth != 16)) {
+        return false;
+    }
+    const size_t pixelBytes = size_t(bitDepth / 8);
+    const size_t rowBytes = size_t(width) * pixelBytes;
+    
+    unsigned stripeCount = std::max(1u, std::min(threadCount, unsigned(height / minimumStripeRows)));
+    std::vector<std::vector<uint8_t>> stripes(stripeCount);
+    std::vector<uLong> adlers(stripeCount);
+    std::vector<uint8_t> stripeSucceeded(stripeCount, 0);
+    auto encodeStripe = [&](unsigned stripe) {
+        int firstRow = int(size_t(height) * stripe / stripeCount);
+        int endRow = int(size_t(height) * (stripe + 1) / stripeCount);
+        stripeSucceeded[stripe] = deflateRows(samples, rowBytes, pixelBytes, firstRow, endRow, height, filter,
+                                              compressionLevel, stripeCount > 1, stripes[stripe], adlers[stripe]);
+    };
+    std::vector<std::thread> threads;
+    unsigned stripe = 1;
+    for (; stripe < stripeCount; stripe++) {
+        try {
+            threads.emplace_back(encodeStripe, stripe);
+        } catch (const std::system_error &) {
+            break;
+        }
+    }
+    // Stripes whose thread could not start are encoded here, so the file is the same either way
+    for (; stripe < stripeCount; stripe++) {
+        encodeStripe(stripe);
+    }
+    encodeStripe(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    for (uint8_t succeeded : stripeSucceeded) {
+        if (!succeeded) {
+            return false;
+        }
+    }
+    
+    // Signature and header
+    png.insert(png.end(), pngSignature, pngSignature + 8);
+    uint8_t header[13];
+    header[0] = uint8_t(uint32_t(width) >> 24);
+    header[1] = uint8_t(uint32_t(width) >> 16);
+    header[2] = uint8_t(uint32_t(width) >> 8);
+    header[3] = uint8_t(uint32_t(width));
+    header[4] = uint8_t(uint32_t(height) >> 24);
+    header[5] = uint8_t(uint32_t(height) >> 16);
+    header[6] = uint8_t(uint32_t(height) >> 8);
+    header[7] = uint8_t(uint32_t(height));
+    header[8] = uint8_t(bitDepth);
+    header[9] = 0;      // greyscale
+    header[10] = 0;     // deflate
+    header[11] = 0;     // adaptive filtering
+    header[12] = 0;     // no interlace
+    appendChunk(png, "IHDR", header, sizeof(header));
+    
+    if (stripeCount == 1) {
+        appendChunk(png, "IDAT", stripes[0].data(), stripes[0].size());
+    } else {
+        // The raw stripes are joined into a single zlib stream: a header, the stripes in order, and the combined Adler-32
+        std::vector<uint8_t> &stream = stripes[0];
+        int levelFlag = compressionLevel < 2 ? 0 : (compressionLevel < 6 ? 1 : (compressionLevel == 6 ? 2 : 3));
+        uint8_t zlibHeader[2] = { 0x78, uint8_t(levelFlag << 6) };
+        zlibHeader[1] = uint8_t(zlibHeader[1] + 31 - ((zlibHeader[0] * 256 + zlibHeader[1]) % 31));
+        stream.insert(stream.begin(), zlibHeader, zlibHeader + 2);
+        uLong adler = adlers[0];
+        for (unsigned stripe = 1; stripe < stripeCount; stripe++) {
+            stream.insert(stream.end(), stripes[stripe].begin(), stripes[stripe].end());
+            int firstRow = int(size_t(height) * stripe / stripeCount);
+            int endRow = int(size_t(height) * (stripe + 1) / stripeCount);
+            adler = adler32_combine(adler, adlers[stripe], z_off_t((rowBytes + 1) * size_t(endRow - firstRow)));
+        }
+        appendBigEndian32(stream, uint32_t(adler));
+        appendChunk(png, "IDAT", stream.data(), stream.size());
+    }
+    appendChunk(png, "IEND", nullptr, 0);
+    return true;
+}
+
+bool encodeDepthPng (const uint8_t *samples, int width, int height, DepthPngFilter filter, int compressionLevel,
+                     std::vector<uint8_t> &png) {
+    return encodeGreyPng(samples, width, height, 16, filter, compressionLevel, 1, png);
+}
+
+bool readPngSize (const uint8_t *png, size_t size, int &width, int &height) {
+    // Signature, then the IHDR chunk, which must come first
+    if (size < 8 + 8 + 13 + 4 || std::memcmp(png, pngSignature, 8) != 0
+        || readBigEndian32(png + 8) != 13 || std::memcmp(png + 12, "IHDR", 4) != 0) {
+        return false;
+    }
+    uint32_t w = readBigEndian32(png + 16);
+    uint32_t h = readBigEndian32(png + 20);
+    if (w == 0 || h == 0 || w > INT32_MAX || h > INT32_MAX) {
+        return false;
+    }
+    width = int(w);
+    height = int(h);
+    return true;
+}
+
+bool depthImageBytes (int width, int height, size_t &bytes) {
+    if (width <= 0 || height <= 0 || width > maxDepthImageSide || height > maxDepthImageSide) {
+        return false;
+    }
+    if (size_t(width) > SIZE_MAX / sizeof(float) / size_t(height)) {
+        return false;
+    }
+    bytes = size_t(width) * size_t(height) * sizeof(float);
+    return true;
+}
+
+/**
+    Reverses the filter of a row in place. The previous row is null for the first row, where it is taken as zeros.
+    Returns false for an unknown filter type.
+ */
+static bool unfilterRow (uint8_t filterType, uint8_t *row, const uint8_t *previousRow, size_t rowBytes) {
+    switch (filterType) {
+        case 0:
+            return true;
+        case 1:
+            for (size_t i = bytesPerPixel; i < rowBytes; i++) {
+                row[i] = uint8_t(row[i] + row[i - bytesPerPixel]);
+            }
+            return true;
+        case 2:
+            if (previousRow != nullptr) {
+                for (size_t i = 0; i < rowBytes; i++) {
+                    row[i] = uint8_t(row[i] + previousRow[i]);
+                }
+            }
+            return true;
+        case 3:
+            for (size_t i = 0; i < rowBytes; i++) {
+                int left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+                int up = previousRow != nullptr ? previousRow[i] : 0;
+                row[i] = uint8_t(row[i] + ((left + up) >> 1));
+            }
+            return true;
+        case 4:
+            for (size_t i = 0; i < rowBytes; i++) {
+                int left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+                int up = previousRow != nullptr ? previousRow[i] : 0;
+                int upLeft = (previousRow != nullptr && i >= bytesPerPixel) ? previousRow[i - bytesPerPixel] : 0;
+                row[i] = uint8_t(row[i] + paethPredictor(left, up, upLeft));
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline void convertDepthSamples (const uint8_t *samples, int count, float *output) {
+    for (int x = 0; x < count; x++) {
+        output[x] = float((uint16_t(samples[2 * x]) << 8) | samples[2 * x + 1]) / 1000.0f;
+    }
+}
+
+/**
+    Allocations of the inflater go through operator new, like every other buffer of the reader,
+    so that they are counted with them (see MemoryHighWaterTest).
+ */
+static voidpf allocateInflateMemory (voidpf, uInt items, uInt size) {
+    return ::operator new(size_t(items) * size_t(size), std::nothrow);
+}
+
+static void freeInflateMemory (voidpf, voidpf address) {
+    ::operator delete(address);
+}
+
+DepthPngRowReader::DepthPngRowReader (const uint8_t *png, size_t size) : _png(png), _size(size) {
+    size_t imageBytes = 0;
+    if (!readPngSize(png, size, _width, _height) || !depthImageBytes(_width, _height, imageBytes)) {
+        return;
+    }
+    const uint8_t *header = png + 16;
+    if (header[8] != 16 || header[9] != 0 || header[10] != 0 || header[11] != 0 || header[12] != 0) {
+        _status = DepthPngStatus::Unsupported;
+        return;
+    }
+    if (uint32_t(crc32(0L, png + 12, 4 + 13)) != readBigEndian32(png + 12 + 4 + 13)) {
+        return;
+    }
+    
+    _rowBytes = size_t(_width) * bytesPerPixel;
+    // Two rows (with their filter type byte) are kept: the one being inflated, and the previous one
+    _rows.resize(2 * (_rowBytes + 1));
+    _currentRow = _rows.data();
+    _previousRow = _rows.data() + _rowBytes + 1;
+    
+    _stream.reset(new z_stream);
+    std::memset(_stream.get(), 0, sizeof(z_stream));
+    _stream->zalloc = allocateInflateMemory;
+    _stream->zfree = freeInflateMemory;
+    if (inflateInit(_stream.get()) != Z_OK) {
+        return;
+    }
+    _streamOpen = true;
+    _offset = 8 + 8 + 13 + 4;
+    _status = DepthPngStatus::Ok;
+}
+
+DepthPngRowReader::~DepthPngRowReader () {
+    if (_streamOpen) {
+        inflateEnd(_stream.get());
+    }
+}
+
+/**
+    Points the inflater at the data of the next IDAT chunk, skipping any other chunk.
+    Returns false if there is none left, or if it is damaged.
+ */
+bool DepthPngRowReader::nextDataChunk () {
+    while (_offset + 12 <= _size) {
+        uint32_t length = readBigEndian32(_png + _offset);
+        const uint8_t *type = _png + _offset + 4;
+        if (length > _size - _offset - 12 || std::memcmp(type, "IEND", 4) == 0) {
+            return false;
+        }
+        size_t chunkOffset = _offset;
+        _offset += 12 + size_t(length);
+        if (std::memcmp(type, "IDAT", 4) != 0 || length == 0) {
+            continue;
+        }
+        if (uint32_t(crc32(0L, type, uInt(4 + length))) != readBigEndian32(_png + chunkOffset + 8 + length)) {
+            return false;
+        }
+        _stream->next_in = const_cast<uint8_t *>(_png + chunkOffset + 8);
+        _stream->avail_in = uInt(length);
+        return true;
+    }
+    return false;
+}
+
+const uint8_t *DepthPngRowReader::readRow () {
+    if (_status != DepthPngStatus::Ok || _nextRow >= _height) {
+        return nullptr;
+    }
+    
+    _stream->next_out = _currentRow;
+    _stream->avail_out = uInt(_rowBytes + 1);
+    while (_stream->avail_out > 0) {
+        if (_stream->avail_in == 0 && !nextDataChunk()) {
+            _status = DepthPngStatus::Corrupt;
+            return nullptr;
+        }
+        int result = inflate(_stream.get(), Z_NO_FLUSH);
+        if (result == Z_STREAM_END && _stream->avail_out == 0) {
+            break;
+        }
+        // Running out of input is fine (the next chunk carries on), anything else before the row is complete is not
+        bool needsInput = (result == Z_OK || result == Z_BUF_ERROR) && _stream->avail_in == 0;
+        if (result != Z_OK && !needsInput) {
+            _status = DepthPngStatus::Corrupt;
+            return nullptr;
+        }
+    }
+    
+    if (!unfilterRow(_currentRow[0], _currentRow + 1, _nextRow > 0 ? _previousRow + 1 : nullptr, _rowBytes)) {
+        _status = DepthPngStatus::Corrupt;
+        return nullptr;
+    }
+    std::swap(_currentRow, _previousRow);
+    _nextRow++;
+    return _previousRow + 1;
+}
+
+bool DepthPngRowReader::readDepthRow (float *output, int x, int count) {
+    const uint8_t *samples = readRow();
+    if (samples == nullptr || x < 0 || count < 0 || x + count > _width) {
+        return false;
+    }
+    convertDepthSamples(samples + size_t(x) * bytesPerPixel, count, output);
+    return true;
+}
+
+bool DepthPngRowReader::skipRows (int count) {
+    for (int i = 0; i < count; i++) {
+        if (readRow() == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DepthPngStatus decodeDepthPng (const uint8_t *png, size_t size, const DepthBuffer &output, int &width, int &height) {
+    DepthRegion region;
+    region.width = INT32_MAX;
+    region.height = INT32_MAX;
+    return decodeDepthPngRegion(png, size, region, output, width, height);
+}
+
+DepthPngStatus decodeDepthPngRegion (const uint8_t *png, size_t size, DepthRegion &region, const DepthBuffer &output,
+                                     int &width, int &height) {
+    DepthPngRowReader reader(png, size);
+    width = reader.width();
+    height = reader.height();
+    if (reader.status() != DepthPngStatus::Ok) {
+        return reader.status();
+    }
+    
+    int left = std::max(region.x, 0);
+    int top = std::max(region.y, 0);
+    int right = int(std::min<int64_t>(int64_t(region.x) + region.width, width));
+    int bottom = int(std::min<int64_t>(int64_t(region.y) + region.height, height));
+    region.x = left;
+    region.y = top;
+    region.width = std::max(right - left, 0);
+    region.height = std::max(bottom - top, 0);
+    if (region.width == 0 || region.height == 0) {
+        return DepthPngStatus::Ok;
+    }
+    if (!output.fits(region.width, region.height)) {
+        return DepthPngStatus::Corrupt;
+    }
+    
+    // Rows above the region are still unfiltered, since the rows below depend on them
+    if (!reader.skipRows(region.y)) {
+        return DepthPngStatus::Corrupt;
+    }
+    for (int y = 0; y < region.height; y++) {
+        if (!reader.readDepthRow(output.row(y, region.width), region.x, region.width)) {
+            return DepthPngStatus::Corrupt;
+        }
+    }
+    // Anything after the last row of the region is never inflated
+    return DepthPngStatus::Ok;
+}
@@ -0,0 +1,188 @@
+//
+//  DepthPngCodec.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DepthPngCodec_hpp
+#define DepthPngCodec_hpp
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct z_stream_s;
+
+/**
+    The PNG filter used for every row of a depth PNG.
+    Up is the cheapest; Paeth usually compresses depth slightly better, at a higher cost.
+ */
+enum class DepthPngFilter {
+    Up,
+    Paeth
+};
+
+/**
+    Encodes big-endian 16-bit greyscale samples (as written by packDepthMillimeters) to a standard PNG.
+ 
+    Unlike lodepng, the filter is fixed instead of searched for, and each filtered row goes straight into zlib's streaming deflate,
+    so the only buffers are a single filtered row and the output. The image data is written as a single IDAT chunk.
+    The compression level is zlib's (0 to 9).
+    Returns false if zlib fails.
+ */
+bool encodeDepthPng (const uint8_t *samples, int width, int height, DepthPngFilter filter, int compressionLevel,
+                     std::vector<uint8_t> &png);
+
+/**
+    Same as encodeDepthPng, for 8-bit (such as confidence) or 16-bit greyscale samples, on up to threadCount threads.
+ 
+    With more than one thread, the rows are split into stripes that are filtered and deflated independently, each with a
+    sync flush so that it ends on a byte boundary. The stripes are then joined into a single zlib stream, whose Adler-32 is
+    combined from theirs, so the output is a standard PNG that any decoder reads. Every stripe starts with an empty window,
+    which costs a little compression at the stripe boundaries.
+    A stripe whose thread cannot be started is encoded on the calling thread, which gives the same file.
+ */
+bool encodeGreyPng (const uint8_t *samples, int width, int height, int bitDepth, DepthPngFilter filter,
+                    int compressionLevel, unsigned threadCount, std::vector<uint8_t> &png);
+
+/**
+    The outcome of decodeDepthPng.
+ */
+enum class DepthPngStatus {
+    Ok,
+    /// A valid PNG that this decoder does not handle (anything but non-interlaced 16-bit greyscale)
+    Unsupported,
+    /// Not a valid PNG
+    Corrupt
+};
+
+/**
+    A caller-owned float image that a decoder writes into, such as the base address of a CVPixelBuffer.
+    Rows are bytesPerRow apart, which may include padding; 0 means tightly packed rows. The capacity is in bytes.
+ */
+struct DepthBuffer {
+    float *data = nullptr;
+    size_t bytesPerRow = 0;
+    size_t capacity = 0;
+    
+    size_t rowStride (int width) const {
+        return bytesPerRow != 0 ? bytesPerRow : size_t(width) * sizeof(float);
+    }
+    
+    bool fits (int width, int height) const {
+        size_t stride = rowStride(width);
+        return data != nullptr && stride >= size_t(width) * sizeof(float)
+            && (size_t(height) - 1) * stride + size_t(width) * sizeof(float) <= capacity;
+    }
+    
+    float *row (int y, int width) const {
+        return reinterpret_cast<float *>(reinterpret_cast<uint8_t *>(data) + size_t(y) * rowStride(width));
+    }
+};
+
+/**
+    Decodes a non-interlaced 16-bit greyscale PNG of millimeters directly into float meters, reading the file in place.
+ 
+    The compressed data is inflated one row at a time, and every row is unfiltered and converted as soon as it is complete,
+    so no intermediate image of bytes is made. All the PNG filter types are supported, so any encoder's output can be read.
+    The output must fit the image (see readPngSize); otherwise the image is reported as corrupt.
+    Images with a side larger than maxDepthImageSide are reported as corrupt, before anything is allocated.
+    The width and height are set whenever the header could be read.
+ */
+DepthPngStatus decodeDepthPng (const uint8_t *png, size_t size, const DepthBuffer &output, int &width, int &height);
+
+/**
+    A rectangle of pixels of a depth image.
+ */
+struct DepthRegion {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+/**
+    Reads a non-interlaced 16-bit greyscale PNG one row at a time, straight from the file bytes.
+ 
+    Only two rows are ever held: the compressed data is inflated just far enough to complete the next row, which is then unfiltered.
+    Since every row is filtered against the one above it, rows can only be read in order; skipping a row still inflates and
+    unfilters it, but does not convert it. Rows after the last one read are never inflated, so a caller that stops early only pays
+    for the rows it went through. The PNG bytes must outlive the reader.
+ */
+class DepthPngRowReader {
+public:
+    DepthPngRowReader (const uint8_t *png, size_t size);
+    ~DepthPngRowReader ();
+    DepthPngRowReader (const DepthPngRowReader &) = delete;
+    DepthPngRowReader &operator= (const DepthPngRowReader &) = delete;
+    
+    /// Unsupported if the PNG is valid but not in the layout this reader handles; Corrupt as soon as a read fails
+    DepthPngStatus status () const { return _status; }
+    int width () const { return _width; }
+    int height () const { return _height; }
+    /// Index of the row the next read returns
+    int nextRow () const { return _nextRow; }
+    
+    /**
+        Reads the next row, and returns its big-endian samples, which stay valid until the next read.
+        Returns null once every row has been read, or if the data is corrupt.
+     */
+    const uint8_t *readRow ();
+    
+    /**
+        Reads the next row, and converts count samples starting at column x to meters.
+     */
+    bool readDepthRow (float *output, int x, int count);
+    
+    /**
+        Reads past the next count rows without converting them.
+     */
+    bool skipRows (int count);
+    
+private:
+    bool nextDataChunk ();
+    
+    const uint8_t *_png;
+    size_t _size;
+    size_t _offset = 0;
+    DepthPngStatus _status = DepthPngStatus::Corrupt;
+    int _width = 0;
+    int _height = 0;
+    int _nextRow = 0;
+    size_t _rowBytes = 0;
+    std::vector<uint8_t> _rows;
+    uint8_t *_currentRow = nullptr;
+    uint8_t *_previousRow = nullptr;
+    std::unique_ptr<z_stream_s> _stream;
+    bool _streamOpen = false;
+};
+
+/**
+    Decodes only a region of a depth PNG into meters, with the top-left pixel of the region going to the first row of the output.
+ 
+    The region is clipped to the image, and the clipped region is written back. Rows below the region are never inflated,
+    and only the columns of the region are converted, so the cost depends on the bottom edge and the area of the region
+    rather than on the size of the frame. The width and height of the image are set whenever the header could be read.
+ */
+DepthPngStatus decodeDepthPngRegion (const uint8_t *png, size_t size, DepthRegion &region, const DepthBuffer &output,
+                                     int &width, int &height);
+
+/**
+    Reads the size of a PNG from its header, without decoding it. Returns false if the header is not valid.
+ */
+bool readPngSize (const uint8_t *png, size_t size, int &width, int &height);
+
+/**
+    Largest width or height of a depth image that the decoders accept.
+    The size in a PNG header decides how much memory is allocated before a single pixel is read, so it is not trusted.
+ */
+static const int maxDepthImageSide = 16384;
+
+/**
+    The bytes of a tightly packed float image of a size read from a file, for callers that allocate the output.
+    Returns false if a side is not positive or is larger than maxDepthImageSide, or if the bytes do not fit a size_t.
+ */
+bool depthImageBytes (int width, int height, size_t &bytes);
+
+#endif /* DepthPngCodec_hpp */
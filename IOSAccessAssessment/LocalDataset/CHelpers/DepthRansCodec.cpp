@@ -0,0 +1,667 @@
+//
+//  DepthRansCodec.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "DepthRansCodec.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <new>
+#include <zlib.h>
+
+static const uint8_t depthRansMagic[4] = { 'D', 'R', 'N', 'S' };
+/// The fields of the header, followed by their CRC-32
+static const size_t headerChecksumOffset = 20;
+static const size_t headerSize = headerChecksumOffset + 4;
+/// Every block has its end offset and the CRC-32 of its bytes in the index
+static const size_t indexEntrySize = 8;
+
+/**
+    Residuals are coded as tokens: the 16 smallest values have a token of their own, and larger values share a token
+    with the others of the same bit length and second-highest bit, the remaining bits being written as they are.
+ */
+static const int directTokens = 16;
+static const int tokenCount = directTokens + 2 * 12;
+
+/**
+    rANS with 32-bit states, byte-wise renormalization, and frequencies that add up to 2^12.
+    Even and odd samples of a block go to two interleaved states that share a byte stream,
+    so that the decoder can work on two tokens at once.
+ */
+static const int ransStateCount = 2;
+static const int frequencyBits = 12;
+static const uint32_t frequencyTotal = 1u << frequencyBits;
+static const uint32_t ransLowerBound = 1u << 23;
+
+static inline uint32_t readLittleEndian32 (const uint8_t *bytes) {
+    return uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+}
+
+static inline void writeLittleEndian32 (uint8_t *bytes, uint32_t value) {
+    bytes[0] = uint8_t(value);
+    bytes[1] = uint8_t(value >> 8);
+    bytes[2] = uint8_t(value >> 16);
+    bytes[3] = uint8_t(value >> 24);
+}
+
+/// CRC-32 of a range of bytes, as zlib computes it; the blocks of a file whose sides are bounded always fit a uInt
+static inline uint32_t checksumOf (const uint8_t *begin, const uint8_t *end) {
+    return uint32_t(crc32(0L, begin, uInt(end - begin)));
+}
+
+static inline void appendLittleEndian32 (std::vector<uint8_t> &output, uint32_t value) {
+    size_t offset = output.size();
+    output.resize(offset + 4);
+    writeLittleEndian32(output.data() + offset, value);
+}
+
+/**
+    Median edge detector: the left or upper neighbour across an edge, and the plane through the three neighbours elsewhere.
+    The first row of a block is predicted from the left only, and the first column from above only,
+    so that blocks do not depend on each other.
+ */
+static inline int medianPrediction (int left, int up, int upLeft) {
+    // The median of left, up and the plane, which is the same as the branches of LOCO-I
+    int low = std::min(left, up);
+    int high = std::max(left, up);
+    return std::max(low, std::min(high, left + up - upLeft));
+}
+
+static inline int predictSample (const uint16_t *row, const uint16_t *previousRow, int x) {
+    if (previousRow == nullptr) {
+        return x > 0 ? row[x - 1] : 0;
+    }
+    if (x == 0) {
+        return previousRow[0];
+    }
+    return medianPrediction(row[x - 1], previousRow[x], previousRow[x - 1]);
+}
+
+/**
+    Maps the residual (modulo the range of the samples, 2^16 for depth and 2^8 for confidence) to a token,
+    and the bits that the token leaves out.
+ */
+static inline int tokenize (int sample, int prediction, uint32_t sampleMask, uint32_t &extraBits, int &extraBitCount) {
+    uint32_t difference = uint32_t(sample - prediction) & sampleMask;
+    int residual = (difference & ((sampleMask >> 1) + 1)) != 0 ? int(difference) - int(sampleMask) - 1 : int(difference);
+    uint32_t zigzag = residual >= 0 ? uint32_t(residual) << 1 : (uint32_t(-residual) << 1) - 1;
+    if (zigzag < uint32_t(directTokens)) {
+        extraBitCount = 0;
+        return int(zigzag);
+    }
+    int bitLength = 31 - __builtin_clz(zigzag);
+    extraBitCount = bitLength - 1;
+    extraBits = zigzag & ((1u << extraBitCount) - 1);
+    return directTokens + 2 * (bitLength - 4) + int((zigzag >> extraBitCount) & 1);
+}
+
+/**
+    The smallest zigzagged residual of every token, and the number of bits that follow it.
+ */
+struct TokenRange {
+    uint16_t base = 0;
+    uint8_t extraBitCount = 0;
+};
+
+static constexpr std::array<TokenRange, tokenCount> makeTokenRanges () {
+    std::array<TokenRange, tokenCount> ranges {};
+    for (int token = 0; token < tokenCount; token++) {
+        if (token < directTokens) {
+            ranges[token].base = uint16_t(token);
+            continue;
+        }
+        int bitLength = (token - directTokens) / 2 + 4;
+        ranges[token].base = uint16_t((1u << bitLength) | (uint32_t((token - directTokens) & 1) << (bitLength - 1)));
+        ranges[token].extraBitCount = uint8_t(bitLength - 1);
+    }
+    return ranges;
+}
+
+static constexpr std::array<TokenRange, tokenCount> tokenRanges = makeTokenRanges();
+
+static inline uint16_t untokenize (uint32_t zigzag, int prediction, uint32_t sampleMask) {
+    uint32_t residual = (zigzag >> 1) ^ (0u - (zigzag & 1));
+    return uint16_t((uint32_t(prediction) + residual) & sampleMask);
+}
+
+class BitWriter {
+public:
+    explicit BitWriter (std::vector<uint8_t> &output) : _output(output) {}
+
+    void write (uint32_t bits, int count) {
+        _buffer |= uint64_t(bits) << _count;
+        _count += count;
+        while (_count >= 8) {
+            _output.push_back(uint8_t(_buffer));
+            _buffer >>= 8;
+            _count -= 8;
+        }
+    }
+
+    void flush () {
+        if (_count > 0) {
+            _output.push_back(uint8_t(_buffer));
+        }
+        _buffer = 0;
+        _count = 0;
+    }
+
+private:
+    std::vector<uint8_t> &_output;
+    uint64_t _buffer = 0;
+    int _count = 0;
+};
+
+/**
+    Reads the bits of a BitWriter. Reading past the end gives zeros, and is reported by overran().
+ */
+class BitReader {
+public:
+    BitReader (const uint8_t *data, const uint8_t *end) : _data(data), _end(end) {}
+
+    uint32_t read (int count) {
+        if (_count < count) {
+            // Refill as many whole bytes as fit, so that most reads do not touch memory
+            while (_count <= 56 && _data < _end) {
+                _buffer |= uint64_t(*_data++) << _count;
+                _count += 8;
+            }
+            if (_count < count) {
+                _overran = true;
+                _count = count;
+            }
+        }
+        uint32_t bits = uint32_t(_buffer & ((uint64_t(1) << count) - 1));
+        _buffer >>= count;
+        _count -= count;
+        return bits;
+    }
+
+    bool overran () const {
+        return _overran;
+    }
+
+private:
+    const uint8_t *_data;
+    const uint8_t *_end;
+    uint64_t _buffer = 0;
+    int _count = 0;
+    bool _overran = false;
+};
+
+static void appendVarint (std::vector<uint8_t> &output, uint32_t value) {
+    while (value >= 0x80) {
+        output.push_back(uint8_t(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back(uint8_t(value));
+}
+
+static bool readVarint (const uint8_t *&data, const uint8_t *end, uint32_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 21; shift += 7) {
+        if (data == end) {
+            return false;
+        }
+        uint8_t byte = *data++;
+        value |= uint32_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+    Scales the token counts to frequencies that add up to frequencyTotal, keeping every token that occurs at 1 or more.
+ */
+static void normalizeFrequencies (const uint32_t *counts, uint32_t total, uint32_t *frequencies) {
+    int64_t sum = 0;
+    int largest = 0;
+    for (int t = 0; t < tokenCount; t++) {
+        frequencies[t] = counts[t] == 0 ? 0 : std::max<uint32_t>(1, uint32_t(uint64_t(counts[t]) * frequencyTotal / total));
+        sum += frequencies[t];
+        if (frequencies[t] > frequencies[largest]) {
+            largest = t;
+        }
+    }
+    // The rounding error is at most one per token, and goes to (or comes from) the most frequent ones
+    while (sum != int64_t(frequencyTotal)) {
+        if (sum < int64_t(frequencyTotal)) {
+            frequencies[largest]++;
+            sum++;
+        } else {
+            int candidate = -1;
+            for (int t = 0; t < tokenCount; t++) {
+                if (frequencies[t] > 1 && (candidate < 0 || frequencies[t] > frequencies[candidate])) {
+                    candidate = t;
+                }
+            }
+            frequencies[candidate]--;
+            sum--;
+        }
+    }
+}
+
+/**
+    Buffers reused from one block to the next.
+ */
+struct PlaneScratch {
+    std::vector<uint16_t> rows;
+    std::vector<uint8_t> tokens;
+    std::vector<uint8_t> ransBytes;
+    std::vector<uint8_t> extraBytes;
+};
+
+/**
+    Appends a plane of a block: its frequency table, the length of its rANS stream, the rANS stream, and the extra bits.
+    loadRow(r, row) fills in the samples of row r of the block.
+ */
+template <typename LoadRow>
+static void encodePlane (int width, int rowCount, uint32_t sampleMask, LoadRow loadRow, PlaneScratch &scratch,
+                         std::vector<uint8_t> &output) {
+    size_t pixelCount = size_t(width) * rowCount;
+    std::vector<uint8_t> &tokens = scratch.tokens;
+    tokens.resize(pixelCount);
+    scratch.rows.resize(2 * size_t(width));
+    uint16_t *row = scratch.rows.data();
+    uint16_t *previousRow = scratch.rows.data() + width;
+
+    scratch.extraBytes.clear();
+    BitWriter extraBits(scratch.extraBytes);
+    uint32_t counts[tokenCount] = {};
+    for (int r = 0; r < rowCount; r++) {
+        loadRow(r, row);
+        const uint16_t *above = r > 0 ? previousRow : nullptr;
+        uint8_t *rowTokens = tokens.data() + size_t(r) * width;
+        for (int x = 0; x < width; x++) {
+            uint32_t bits = 0;
+            int bitCount = 0;
+            int token = tokenize(row[x], predictSample(row, above, x), sampleMask, bits, bitCount);
+            rowTokens[x] = uint8_t(token);
+            counts[token]++;
+            if (bitCount > 0) {
+                extraBits.write(bits, bitCount);
+            }
+        }
+        std::swap(row, previousRow);
+    }
+    extraBits.flush();
+
+    uint32_t frequencies[tokenCount];
+    uint32_t starts[tokenCount];
+    normalizeFrequencies(counts, uint32_t(pixelCount), frequencies);
+    uint32_t start = 0;
+    for (int t = 0; t < tokenCount; t++) {
+        starts[t] = start;
+        start += frequencies[t];
+        appendVarint(output, frequencies[t]);
+    }
+
+    // rANS codes in reverse, so the bytes are collected backwards and reversed once at the end
+    std::vector<uint8_t> &ransBytes = scratch.ransBytes;
+    ransBytes.clear();
+    uint32_t states[ransStateCount] = { ransLowerBound, ransLowerBound };
+    for (size_t i = pixelCount; i-- > 0;) {
+        uint32_t &state = states[i % ransStateCount];
+        int token = tokens[i];
+        uint32_t frequency = frequencies[token];
+        uint32_t stateLimit = ((ransLowerBound >> frequencyBits) << 8) * frequency;
+        while (state >= stateLimit) {
+            ransBytes.push_back(uint8_t(state));
+            state >>= 8;
+        }
+        state = ((state / frequency) << frequencyBits) + (state % frequency) + starts[token];
+    }
+    // The first state ends up first in the stream, most significant byte first
+    for (int k = ransStateCount; k-- > 0;) {
+        for (int i = 0; i < 4; i++) {
+            ransBytes.push_back(uint8_t(states[k]));
+            states[k] >>= 8;
+        }
+    }
+    std::reverse(ransBytes.begin(), ransBytes.end());
+
+    appendLittleEndian32(output, uint32_t(ransBytes.size()));
+    output.insert(output.end(), ransBytes.begin(), ransBytes.end());
+    output.insert(output.end(), scratch.extraBytes.begin(), scratch.extraBytes.end());
+}
+
+bool encodeDepthRans (const uint8_t *samples, int width, int height, int rowsPerBlock, std::vector<uint8_t> &output) {
+    return encodeDepthRans(samples, nullptr, width, height, rowsPerBlock, output);
+}
+
+static bool encodeBlocks (const uint8_t *samples, const uint8_t *confidence, int width, int height, int rowsPerBlock,
+                          std::vector<uint8_t> &output) {
+    DepthRansHeader header;
+    header.width = width;
+    header.height = height;
+    header.rowsPerBlock = rowsPerBlock;
+    int blockCount = header.blockCount();
+
+    // The index is filled in as the blocks are written
+    output.assign(headerSize + indexEntrySize * size_t(blockCount), 0);
+    std::memcpy(output.data(), depthRansMagic, 4);
+    output[4] = depthRansVersion;
+    output[5] = confidence != nullptr ? depthRansHasConfidence : 0;
+    output[6] = uint8_t(rowsPerBlock);
+    output[7] = uint8_t(rowsPerBlock >> 8);
+    writeLittleEndian32(output.data() + 8, uint32_t(width));
+    writeLittleEndian32(output.data() + 12, uint32_t(height));
+    writeLittleEndian32(output.data() + 16, depthRansUnitsPerMeter);
+    writeLittleEndian32(output.data() + headerChecksumOffset, checksumOf(output.data(), output.data() + headerChecksumOffset));
+    size_t indexOffset = headerSize;
+    size_t dataOffset = output.size();
+
+    PlaneScratch scratch;
+    for (int b = 0; b < blockCount; b++) {
+        size_t blockStart = output.size();
+        int firstRow = b * rowsPerBlock;
+        int rowCount = std::min(rowsPerBlock, height - firstRow);
+        auto loadDepthRow = [&] (int r, uint16_t *row) {
+            const uint8_t *source = samples + (size_t(firstRow) + r) * width * 2;
+            for (int x = 0; x < width; x++) {
+                row[x] = uint16_t((uint16_t(source[2 * x]) << 8) | source[2 * x + 1]);
+            }
+        };
+        if (confidence == nullptr) {
+            encodePlane(width, rowCount, 0xffff, loadDepthRow, scratch, output);
+        } else {
+            // The depth plane is preceded by its length, so that the confidence plane can be found
+            size_t lengthOffset = output.size();
+            output.resize(lengthOffset + 4);
+            encodePlane(width, rowCount, 0xffff, loadDepthRow, scratch, output);
+            writeLittleEndian32(output.data() + lengthOffset, uint32_t(output.size() - lengthOffset - 4));
+            encodePlane(width, rowCount, 0xff, [&] (int r, uint16_t *row) {
+                const uint8_t *source = confidence + (size_t(firstRow) + r) * width;
+                std::copy(source, source + width, row);
+            }, scratch, output);
+        }
+        uint64_t blockEnd = output.size() - dataOffset;
+        if (blockEnd > UINT32_MAX) {
+            return false;
+        }
+        uint8_t *entry = output.data() + indexOffset + indexEntrySize * size_t(b);
+        writeLittleEndian32(entry, uint32_t(blockEnd));
+        writeLittleEndian32(entry + 4, checksumOf(output.data() + blockStart, output.data() + output.size()));
+    }
+    return true;
+}
+
+bool encodeDepthRans (const uint8_t *samples, const uint8_t *confidence, int width, int height, int rowsPerBlock,
+                      std::vector<uint8_t> &output) {
+    // Files are only written with the sizes that the decoder reads
+    size_t imageBytes = 0;
+    if (!depthImageBytes(width, height, imageBytes) || rowsPerBlock <= 0 || rowsPerBlock > 0xffff) {
+        return false;
+    }
+    try {
+        return encodeBlocks(samples, confidence, width, height, rowsPerBlock, output);
+    } catch (const std::bad_alloc &) {
+        output.clear();
+        return false;
+    }
+}
+
+DepthRansStatus readDepthRansHeader (const uint8_t *data, size_t size, DepthRansHeader &header) {
+    if (data == nullptr || size < headerSize || std::memcmp(data, depthRansMagic, 4) != 0
+        || checksumOf(data, data + headerChecksumOffset) != readLittleEndian32(data + headerChecksumOffset) || data[4] == 0) {
+        return DepthRansStatus::Corrupt;
+    }
+    if (data[4] > depthRansVersion || (data[5] & ~depthRansHasConfidence) != 0) {
+        return DepthRansStatus::Unsupported;
+    }
+    uint32_t width = readLittleEndian32(data + 8);
+    uint32_t height = readLittleEndian32(data + 12);
+    int rowsPerBlock = data[6] | (data[7] << 8);
+    uint32_t unitsPerMeter = readLittleEndian32(data + 16);
+    // The same bounds as the PNG header, before the size is reported to anyone who would allocate for it
+    size_t imageBytes = 0;
+    if (width > uint32_t(maxDepthImageSide) || height > uint32_t(maxDepthImageSide)
+        || !depthImageBytes(int(width), int(height), imageBytes) || rowsPerBlock == 0 || unitsPerMeter == 0) {
+        return DepthRansStatus::Corrupt;
+    }
+    DepthRansHeader read;
+    read.width = int(width);
+    read.height = int(height);
+    read.rowsPerBlock = rowsPerBlock;
+    read.unitsPerMeter = unitsPerMeter;
+    read.hasConfidence = (data[5] & depthRansHasConfidence) != 0;
+    if (size - headerSize < indexEntrySize * size_t(read.blockCount())) {
+        return DepthRansStatus::Corrupt;
+    }
+    header = read;
+    return DepthRansStatus::Ok;
+}
+
+/**
+    Decodes the rows of a plane of a block one at a time, and hands every row to storeRow(r, row) as soon as it is complete.
+    Only the first rowCount rows are decoded.
+    The tokens of a row are decoded first, since they do not depend on the samples, and the samples are rebuilt from them after.
+ */
+template <typename StoreRow>
+static bool decodePlane (const uint8_t *block, const uint8_t *blockEnd, int width, int rowCount, uint32_t sampleMask,
+                         StoreRow storeRow, PlaneScratch &scratch) {
+    uint32_t frequencies[tokenCount];
+    uint32_t starts[tokenCount];
+    uint32_t start = 0;
+    for (int t = 0; t < tokenCount; t++) {
+        if (!readVarint(block, blockEnd, frequencies[t])) {
+            return false;
+        }
+        starts[t] = start;
+        start += frequencies[t];
+        if (start > frequencyTotal) {
+            return false;
+        }
+    }
+    if (start != frequencyTotal || blockEnd - block < 4) {
+        return false;
+    }
+    // Everything the decoder needs about a slot, in one word: its token, the token's frequency, and its offset in the token
+    uint32_t slots[frequencyTotal];
+    for (int t = 0; t < tokenCount; t++) {
+        for (uint32_t offset = 0; offset < frequencies[t]; offset++) {
+            slots[starts[t] + offset] = uint32_t(t) | (frequencies[t] << 6) | (offset << 19);
+        }
+    }
+
+    uint32_t ransLength = readLittleEndian32(block);
+    block += 4;
+    if (ransLength < 4 * ransStateCount || size_t(blockEnd - block) < ransLength) {
+        return false;
+    }
+    static_assert(ransStateCount == 2, "The decoder alternates between two states");
+    uint32_t state = (uint32_t(block[0]) << 24) | (uint32_t(block[1]) << 16) | (uint32_t(block[2]) << 8) | block[3];
+    uint32_t otherState = (uint32_t(block[4]) << 24) | (uint32_t(block[5]) << 16) | (uint32_t(block[6]) << 8) | block[7];
+    const uint8_t *rans = block + 4 * ransStateCount;
+    const uint8_t *ransEnd = block + ransLength;
+    BitReader extraBits(ransEnd, blockEnd);
+
+    scratch.rows.resize(2 * size_t(width));
+    scratch.tokens.resize(size_t(width));
+    uint16_t *row = scratch.rows.data();
+    uint16_t *previousRow = scratch.rows.data() + width;
+    uint8_t *tokens = scratch.tokens.data();
+    for (int r = 0; r < rowCount; r++) {
+        // The two states take turns, starting with the one the previous row left off at.
+        // Every token needs at most two bytes, since frequencies are at most 2^12,
+        // so the end of the stream only has to be checked once per row when there is enough of it left.
+        if (ransEnd - rans >= 2 * ptrdiff_t(width)) {
+            for (int x = 0; x < width; x++) {
+                uint32_t slot = slots[state & (frequencyTotal - 1)];
+                tokens[x] = uint8_t(slot & 63);
+                state = ((slot >> 6) & 0x1fff) * (state >> frequencyBits) + (slot >> 19);
+                bool low = state < ransLowerBound;
+                state = low ? (state << 8) | *rans : state;
+                rans += low;
+                low = state < ransLowerBound;
+                state = low ? (state << 8) | *rans : state;
+                rans += low;
+                std::swap(state, otherState);
+            }
+        } else {
+            for (int x = 0; x < width; x++) {
+                uint32_t slot = slots[state & (frequencyTotal - 1)];
+                tokens[x] = uint8_t(slot & 63);
+                state = ((slot >> 6) & 0x1fff) * (state >> frequencyBits) + (slot >> 19);
+                while (state < ransLowerBound) {
+                    if (rans == ransEnd) {
+                        return false;
+                    }
+                    state = (state << 8) | *rans++;
+                }
+                std::swap(state, otherState);
+            }
+        }
+
+        // The samples, rebuilt from their tokens and extra bits
+        const TokenRange &first = tokenRanges[tokens[0]];
+        uint32_t firstZigzag = first.base | extraBits.read(first.extraBitCount);
+        row[0] = untokenize(firstZigzag, r == 0 ? 0 : previousRow[0], sampleMask);
+        if (r == 0) {
+            for (int x = 1; x < width; x++) {
+                const TokenRange &range = tokenRanges[tokens[x]];
+                row[x] = untokenize(range.base | extraBits.read(range.extraBitCount), row[x - 1], sampleMask);
+            }
+        } else {
+            for (int x = 1; x < width; x++) {
+                const TokenRange &range = tokenRanges[tokens[x]];
+                uint32_t zigzag = range.base | extraBits.read(range.extraBitCount);
+                row[x] = untokenize(zigzag, medianPrediction(row[x - 1], previousRow[x], previousRow[x - 1]), sampleMask);
+            }
+        }
+        storeRow(r, row);
+        std::swap(row, previousRow);
+    }
+    return !extraBits.overran();
+}
+
+/**
+    Decodes the planes of a block, converting the rows that fall in the region.
+ */
+static bool decodeBlock (const uint8_t *block, const uint8_t *blockEnd, const DepthRansHeader &header, int firstRow,
+                         const DepthRegion &region, const DepthBuffer &output, const ConfidenceBuffer *confidence,
+                         PlaneScratch &scratch) {
+    int rowCount = std::min(header.rowsPerBlock, header.height - firstRow);
+    // Rows after the last one of the region are not decoded
+    rowCount = std::min(rowCount, region.y + region.height - firstRow);
+    float unitsPerMeter = float(header.unitsPerMeter);
+
+    const uint8_t *depthEnd = blockEnd;
+    if (header.hasConfidence) {
+        if (blockEnd - block < 4) {
+            return false;
+        }
+        uint32_t depthLength = readLittleEndian32(block);
+        block += 4;
+        if (size_t(blockEnd - block) < depthLength) {
+            return false;
+        }
+        depthEnd = block + depthLength;
+    }
+    bool decoded = decodePlane(block, depthEnd, header.width, rowCount, 0xffff, [&] (int r, const uint16_t *row) {
+        int y = firstRow + r;
+        if (y < region.y) {
+            return;
+        }
+        float *depthRow = output.row(y - region.y, region.width);
+        const uint16_t *samples = row + region.x;
+        for (int x = 0; x < region.width; x++) {
+            depthRow[x] = float(samples[x]) / unitsPerMeter;
+        }
+    }, scratch);
+    if (!decoded || confidence == nullptr || !header.hasConfidence) {
+        return decoded;
+    }
+    return decodePlane(depthEnd, blockEnd, header.width, rowCount, 0xff, [&] (int r, const uint16_t *row) {
+        int y = firstRow + r;
+        if (y < region.y) {
+            return;
+        }
+        uint8_t *confidenceRow = confidence->row(y - region.y, region.width);
+        const uint16_t *samples = row + region.x;
+        for (int x = 0; x < region.width; x++) {
+            confidenceRow[x] = uint8_t(samples[x]);
+        }
+    }, scratch);
+}
+
+DepthRansStatus decodeDepthRans (const uint8_t *data, size_t size, const DepthBuffer &output, int &width, int &height) {
+    return decodeDepthRans(data, size, output, nullptr, width, height);
+}
+
+DepthRansStatus decodeDepthRans (const uint8_t *data, size_t size, const DepthBuffer &output,
+                                 const ConfidenceBuffer *confidence, int &width, int &height) {
+    DepthRegion region;
+    region.width = INT32_MAX;
+    region.height = INT32_MAX;
+    return decodeDepthRansRegion(data, size, region, output, confidence, width, height);
+}
+
+DepthRansStatus decodeDepthRansRegion (const uint8_t *data, size_t size, DepthRegion &region, const DepthBuffer &output,
+                                       int &width, int &height) {
+    return decodeDepthRansRegion(data, size, region, output, nullptr, width, height);
+}
+
+/**
+    Decodes the blocks of a file that overlap the clipped region, after checking them against their checksums.
+ */
+static DepthRansStatus decodeBlocks (const uint8_t *data, size_t size, const DepthRansHeader &header, const DepthRegion &region,
+                                     const DepthBuffer &output, const ConfidenceBuffer *confidence) {
+    const uint8_t *index = data + headerSize;
+    const uint8_t *blocks = index + indexEntrySize * size_t(header.blockCount());
+    size_t blocksSize = size - size_t(blocks - data);
+    PlaneScratch scratch;
+    int firstBlock = region.y / header.rowsPerBlock;
+    int lastBlock = (region.y + region.height - 1) / header.rowsPerBlock;
+    for (int b = firstBlock; b <= lastBlock; b++) {
+        uint32_t blockStart = b > 0 ? readLittleEndian32(index + indexEntrySize * size_t(b - 1)) : 0;
+        uint32_t blockEnd = readLittleEndian32(index + indexEntrySize * size_t(b));
+        if (blockStart > blockEnd || blockEnd > blocksSize
+            || checksumOf(blocks + blockStart, blocks + blockEnd) != readLittleEndian32(index + indexEntrySize * size_t(b) + 4)) {
+            return DepthRansStatus::Corrupt;
+        }
+        if (!decodeBlock(blocks + blockStart, blocks + blockEnd, header, b * header.rowsPerBlock, region, output,
+                         confidence, scratch)) {
+            return DepthRansStatus::Corrupt;
+        }
+    }
+    return DepthRansStatus::Ok;
+}
+
+DepthRansStatus decodeDepthRansRegion (const uint8_t *data, size_t size, DepthRegion &region, const DepthBuffer &output,
+                                       const ConfidenceBuffer *confidence, int &width, int &height) {
+    DepthRansHeader header;
+    DepthRansStatus status = readDepthRansHeader(data, size, header);
+    if (status != DepthRansStatus::Ok) {
+        return status;
+    }
+    width = header.width;
+    height = header.height;
+
+    int left = std::max(region.x, 0);
+    int top = std::max(region.y, 0);
+    int right = int(std::min<int64_t>(int64_t(region.x) + region.width, width));
+    int bottom = int(std::min<int64_t>(int64_t(region.y) + region.height, height));
+    region.x = left;
+    region.y = top;
+    region.width = std::max(right - left, 0);
+    region.height = std::max(bottom - top, 0);
+    if (region.width == 0 || region.height == 0) {
+        return DepthRansStatus::Ok;
+    }
+    if (!output.fits(region.width, region.height)
+        || (confidence != nullptr && header.hasConfidence && !confidence->fits(region.width, region.height))) {
+        return DepthRansStatus::Corrupt;
+    }
+
+    try {
+        return decodeBlocks(data, size, header, region, output, confidence);
+    } catch (const std::bad_alloc &) {
+        return DepthRansStatus::OutOfMemory;
+    }
+}
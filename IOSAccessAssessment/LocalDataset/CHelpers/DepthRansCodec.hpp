@@ -0,0 +1,129 @@
+//
+//  DepthRansCodec.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DepthRansCodec_hpp
+#define DepthRansCodec_hpp
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DepthPngCodec.hpp"
+
+/**
+    A lossless depth format, as an alternative to 16-bit PNG.
+
+    Every sample is predicted from its left, upper and upper-left neighbours with the median edge detector of LOCO-I,
+    which is exact on planes and sharp at depth edges, and the residuals are entropy coded with rANS.
+    The file is a small header followed by an index of row blocks, each with its own frequency table,
+    so that any block can be decoded without the ones above it.
+
+    Header (little-endian): "DRNS", version (1 byte), flags (1 byte), rows per block (2 bytes),
+    width, height and units per meter (4 bytes each) and the CRC-32 of these 20 bytes.
+    Then, for every block, its end offset relative to the end of the index and the CRC-32 of its bytes (4 bytes each).
+    A block is checked against its CRC before it is decoded, so a damaged file is reported as corrupt
+    rather than decoded into wrong depth. The sides are bounded like the ones of the depth PNGs (maxDepthImageSide).
+
+    A file can also carry the 8-bit confidence map of the frame, as a second plane coded the same way.
+    Every block then starts with the length of its depth plane, followed by the depth and the confidence planes,
+    so that both are read from one file, and a region reads the confidence of the same blocks.
+ */
+static const uint8_t depthRansVersion = 1;
+static const char depthRansFileExtension[] = "drans";
+/// Samples are millimeters, like the ones of the depth PNGs
+static const uint32_t depthRansUnitsPerMeter = 1000;
+static const int defaultDepthRansRowsPerBlock = 32;
+/// Flag of the header, for files that carry a confidence plane
+static const uint8_t depthRansHasConfidence = 1;
+
+enum class DepthRansStatus {
+    Ok,
+    /// A file of a later version of the format
+    Unsupported,
+    /// Not a valid file
+    Corrupt,
+    /// The scratch memory of the decoder could not be allocated
+    OutOfMemory
+};
+
+struct DepthRansHeader {
+    int width = 0;
+    int height = 0;
+    int rowsPerBlock = 0;
+    uint32_t unitsPerMeter = 0;
+    bool hasConfidence = false;
+
+    int blockCount () const {
+        return int((int64_t(height) + rowsPerBlock - 1) / rowsPerBlock);
+    }
+};
+
+/**
+    A caller-owned 8-bit image that the confidence plane is written into, laid out like a DepthBuffer.
+ */
+struct ConfidenceBuffer {
+    uint8_t *data = nullptr;
+    size_t bytesPerRow = 0;
+    size_t capacity = 0;
+    
+    size_t rowStride (int width) const {
+        return bytesPerRow != 0 ? bytesPerRow : size_t(width);
+    }
+    
+    bool fits (int width, int height) const {
+        size_t stride = rowStride(width);
+        return data != nullptr && stride >= size_t(width) && (size_t(height) - 1) * stride + size_t(width) <= capacity;
+    }
+    
+    uint8_t *row (int y, int width) const {
+        return data + size_t(y) * rowStride(width);
+    }
+};
+
+/**
+    Encodes big-endian 16-bit samples (as written by packDepthMillimeters) of millimeters.
+    Returns false if the size (see depthImageBytes) or the rows per block are invalid, or if memory runs out.
+ */
+bool encodeDepthRans (const uint8_t *samples, int width, int height, int rowsPerBlock, std::vector<uint8_t> &output);
+
+/**
+    Encodes the depth together with its confidence map (one byte per pixel, tightly packed) in a single file.
+    A null confidence map gives the same file as the depth-only encoder.
+ */
+bool encodeDepthRans (const uint8_t *samples, const uint8_t *confidence, int width, int height, int rowsPerBlock,
+                      std::vector<uint8_t> &output);
+
+/**
+    Reads and checks the header, without decoding anything.
+    The header is only filled in when it is Ok, so the size it reports is always within the bounds of depthImageBytes.
+ */
+DepthRansStatus readDepthRansHeader (const uint8_t *data, size_t size, DepthRansHeader &header);
+
+/**
+    Decodes a file into meters. The output must fit the image; otherwise the file is reported as corrupt.
+    The width and height are set whenever the header could be read.
+ */
+DepthRansStatus decodeDepthRans (const uint8_t *data, size_t size, const DepthBuffer &output, int &width, int &height);
+
+/**
+    Decodes the depth and, when the file has one and a buffer is given, the confidence map, in a single pass over the file.
+    Files without a confidence plane leave the confidence buffer untouched (see DepthRansHeader::hasConfidence).
+ */
+DepthRansStatus decodeDepthRans (const uint8_t *data, size_t size, const DepthBuffer &output,
+                                 const ConfidenceBuffer *confidence, int &width, int &height);
+
+/**
+    Decodes only a region of a file into meters, with the top-left pixel of the region going to the first row of the output.
+
+    The region is clipped to the image, and the clipped region is written back.
+    Only the row blocks that overlap the region are decoded, so the cost depends on the height of the region, not of the frame.
+ */
+DepthRansStatus decodeDepthRansRegion (const uint8_t *data, size_t size, DepthRegion &region, const DepthBuffer &output,
+                                       int &width, int &height);
+
+DepthRansStatus decodeDepthRansRegion (const uint8_t *data, size_t size, DepthRegion &region, const DepthBuffer &output,
+                                       const ConfidenceBuffer *confidence, int &width, int &height);
+
+#endif /* DepthRansCodec_hpp */
@@ -0,0 +1,87 @@
+//
+//  DepthRansCoder.h
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DepthRansCoder_h
+#define DepthRansCoder_h
+#include <Foundation/Foundation.h>
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+    Encodes depth frames to the lossless rANS depth format, which is smaller and faster to write than 16-bit PNG.
+    The depth is stored in millimeters, exactly like the PNGs.
+ */
+@interface DepthRansEncoder : NSObject
+
+/// Number of rows of every independently decodable block
+@property (nonatomic) int rowsPerBlock;
+
+/// File extension of the format, without the dot
+@property (class, nonatomic, readonly) NSString *fileExtension;
+
+- (instancetype) initWithDepth:(float *)content width:(int)width height:(int)height bytesPerRow:(size_t)bytesPerRow;
+/// Stores the 8-bit confidence map of the frame in the same file, so that it does not need a file of its own
+- (void) setConfidence:(const uint8_t *)content bytesPerRow:(size_t)bytesPerRow;
+- (NSData * _Nullable) fileContents;
+
+/**
+    Compares this format with the 16-bit PNG path on depth PNGs of a dataset, and returns the results as JSON.
+ */
++ (NSString *) benchmarkWithPngFiles:(NSArray<NSData *> *)pngFiles iterations:(int)iterations;
+
+@end
+
+/**
+    Decodes files of the rANS depth format. Has the same decoding methods as PngDecoder.
+ */
+@interface DepthRansDecoder : NSObject
+
+- (instancetype) initWithContentsOfFile:(NSData *)fileContents;
+
+/// Whether the file also carries the confidence map of the frame
+@property (nonatomic, readonly) BOOL hasConfidence;
+
+/// Reads the image size from the header, without decoding the image
+- (BOOL)readWidth:(int *)width height:(int *)height;
+
+/**
+    Decodes the depth in meters straight into a caller-owned buffer.
+    Rows are bytesPerRow apart (0 for tightly packed rows), and capacity is the size of the buffer in bytes.
+ */
+- (BOOL)decodeDepthIntoBuffer:(float *)buffer
+                  bytesPerRow:(size_t)bytesPerRow
+                     capacity:(size_t)capacity
+                        width:(int *)width
+                       height:(int *)height;
+
+/**
+    Decodes the depth in meters and the confidence map in one pass, each into its own caller-owned buffer.
+    Returns NO if the file has no confidence map.
+ */
+- (BOOL)decodeDepthIntoBuffer:(float *)buffer
+                  bytesPerRow:(size_t)bytesPerRow
+                     capacity:(size_t)capacity
+             confidenceBuffer:(uint8_t *)confidenceBuffer
+        confidenceBytesPerRow:(size_t)confidenceBytesPerRow
+           confidenceCapacity:(size_t)confidenceCapacity
+                        width:(int *)width
+                       height:(int *)height;
+
+/**
+    Decodes the depth in meters of a region of the image into a caller-owned buffer. Only the row blocks the region overlaps
+    are decoded. The region is clipped to the image, and the clipped region is written back.
+ */
+- (BOOL)decodeDepthInRegionX:(int *)x
+                           y:(int *)y
+                       width:(int *)width
+                      height:(int *)height
+                  intoBuffer:(float *)buffer
+                 bytesPerRow:(size_t)bytesPerRow
+                    capacity:(size_t)capacity;
+
+@end
+NS_ASSUME_NONNULL_END
+#endif /* DepthRansCoder_h */
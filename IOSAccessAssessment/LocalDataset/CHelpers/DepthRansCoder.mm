@@ -0,0 +1,209 @@
+//
+//  DepthRansCoder.mm
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#import <Foundation/Foundation.h>
+#import "DepthRansCoder.h"
+#include <new>
+#include "DepthCodecBenchmark.hpp"
+#include "DepthPacking.hpp"
+#include "DepthRansCodec.hpp"
+
+@implementation DepthRansEncoder {
+    std::vector<uint8_t> samples;
+    std::vector<uint8_t> confidence;
+    int width;
+    int height;
+}
+
++ (NSString *)fileExtension {
+    return @(depthRansFileExtension);
+}
+
+- (instancetype)initWithDepth:(float *)content width:(int)w height:(int)h bytesPerRow:(size_t)bytesPerRow {
+    self = [super init];
+    _rowsPerBlock = defaultDepthRansRowsPerBlock;
+    width = w;
+    height = h;
+    // An invalid size, or one that cannot be allocated, leaves no samples, and fileContents returns nil
+    size_t imageBytes = 0;
+    if (!depthImageBytes(width, height, imageBytes)) {
+        return self;
+    }
+    try {
+        samples.resize((size_t)width * height * 2);
+    } catch (const std::bad_alloc &) {
+        return self;
+    }
+    // Meters to big-endian millimeters, saturated to the 16-bit range, as for the PNGs
+    for (int y = 0; y < height; y++) {
+        const float *row = (const float *)((const uint8_t *)content + (size_t)y * bytesPerRow);
+        packDepthMillimeters(row, (size_t)width, samples.data() + (size_t)y * width * 2);
+    }
+    return self;
+}
+
+- (void)setConfidence:(const uint8_t *)content bytesPerRow:(size_t)bytesPerRow {
+    if (samples.empty()) {
+        return;
+    }
+    try {
+        confidence.resize((size_t)width * height);
+    } catch (const std::bad_alloc &) {
+        // Rather than a file that silently lacks the confidence map
+        samples.clear();
+        return;
+    }
+    for (int y = 0; y < height; y++) {
+        memcpy(confidence.data() + (size_t)y * width, content + (size_t)y * bytesPerRow, width);
+    }
+}
+
+- (NSData *)fileContents {
+    if (samples.empty()) {
+        return nil;
+    }
+    // Moved into the returned data, so the encoded bytes are not copied
+    std::vector<uint8_t> *encoded = new (std::nothrow) std::vector<uint8_t>();
+    if (encoded == nullptr) {
+        return nil;
+    }
+    const uint8_t *confidenceMap = confidence.empty() ? nullptr : confidence.data();
+    if (!encodeDepthRans(samples.data(), confidenceMap, width, height, _rowsPerBlock, *encoded)) {
+        delete encoded;
+        return nil;
+    }
+    return [[NSData alloc] initWithBytesNoCopy:encoded->data()
+                                        length:encoded->size()
+                                   deallocator:^(void *bytes, NSUInteger length) {
+        delete encoded;
+    }];
+}
+
++ (NSString *)benchmarkWithPngFiles:(NSArray<NSData *> *)pngFiles iterations:(int)iterations {
+    std::vector<std::vector<uint8_t>> files;
+    files.reserve(pngFiles.count);
+    for (NSData *file in pngFiles) {
+        const uint8_t *bytes = (const uint8_t *)file.bytes;
+        files.emplace_back(bytes, bytes + file.length);
+    }
+    return @(runDepthCodecBenchmark(files, iterations).c_str());
+}
+
+@end
+
+@implementation DepthRansDecoder {
+    NSData *_fileData;
+}
+
+- (instancetype)initWithContentsOfFile:(NSData *)fileContents {
+    self = [super init];
+    if (self) {
+        _fileData = fileContents;
+    }
+    return self;
+}
+
+- (BOOL)hasConfidence {
+    DepthRansHeader header;
+    return readDepthRansHeader((const uint8_t *)_fileData.bytes, _fileData.length, header) == DepthRansStatus::Ok
+        && header.hasConfidence;
+}
+
+- (BOOL)readWidth:(int *)width height:(int *)height {
+    DepthRansHeader header;
+    if (readDepthRansHeader((const uint8_t *)_fileData.bytes, _fileData.length, header) != DepthRansStatus::Ok) {
+        return NO;
+    }
+    *width = header.width;
+    *height = header.height;
+    return YES;
+}
+
+- (BOOL)decodeDepthIntoBuffer:(float *)buffer
+                  bytesPerRow:(size_t)bytesPerRow
+                     capacity:(size_t)capacity
+                        width:(int *)width
+                       height:(int *)height {
+    DepthBuffer output;
+    output.data = buffer;
+    output.bytesPerRow = bytesPerRow;
+    output.capacity = capacity;
+
+    int fileWidth = 0;
+    int fileHeight = 0;
+    if (decodeDepthRans((const uint8_t *)_fileData.bytes, _fileData.length, output, fileWidth, fileHeight) != DepthRansStatus::Ok) {
+        return NO;
+    }
+    *width = fileWidth;
+    *height = fileHeight;
+    return YES;
+}
+
+- (BOOL)decodeDepthIntoBuffer:(float *)buffer
+                  bytesPerRow:(size_t)bytesPerRow
+                     capacity:(size_t)capacity
+             confidenceBuffer:(uint8_t *)confidenceBuffer
+        confidenceBytesPerRow:(size_t)confidenceBytesPerRow
+           confidenceCapacity:(size_t)confidenceCapacity
+                        width:(int *)width
+                       height:(int *)height {
+    if (!self.hasConfidence) {
+        return NO;
+    }
+    DepthBuffer output;
+    output.data = buffer;
+    output.bytesPerRow = bytesPerRow;
+    output.capacity = capacity;
+    
+    ConfidenceBuffer confidence;
+    confidence.data = confidenceBuffer;
+    confidence.bytesPerRow = confidenceBytesPerRow;
+    confidence.capacity = confidenceCapacity;
+
+    int fileWidth = 0;
+    int fileHeight = 0;
+    if (decodeDepthRans((const uint8_t *)_fileData.bytes, _fileData.length, output, &confidence,
+                        fileWidth, fileHeight) != DepthRansStatus::Ok) {
+        return NO;
+    }
+    *width = fileWidth;
+    *height = fileHeight;
+    return YES;
+}
+
+- (BOOL)decodeDepthInRegionX:(int *)x
+                           y:(int *)y
+                       width:(int *)width
+                      height:(int *)height
+                  intoBuffer:(float *)buffer
+                 bytesPerRow:(size_t)bytesPerRow
+                    capacity:(size_t)capacity {
+    DepthBuffer output;
+    output.data = buffer;
+    output.bytesPerRow = bytesPerRow;
+    output.capacity = capacity;
+
+    DepthRegion region;
+    region.x = *x;
+    region.y = *y;
+    region.width = *width;
+    region.height = *height;
+
+    int fileWidth = 0;
+    int fileHeight = 0;
+    if (decodeDepthRansRegion((const uint8_t *)_fileData.bytes, _fileData.length, region, output,
+                              fileWidth, fileHeight) != DepthRansStatus::Ok) {
+        return NO;
+    }
+    *x = region.x;
+    *y = region.y;
+    *width = region.width;
+    *height = region.height;
+    return YES;
+}
+
+@end
@@ -0,0 +1,527 @@
+//
+//  FrameStore.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "FrameStore.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <zlib.h>
+
+static const char frameStoreMagic[4] = { 'D', 'F', 'S', 'T' };
+static const uint8_t recordPadding[8] = {};
+
+static uint32_t readU32 (const uint8_t *bytes) {
+    return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+static uint64_t readU64 (const uint8_t *bytes) {
+    return uint64_t(readU32(bytes)) | uint64_t(readU32(bytes + 4)) << 32;
+}
+
+static void writeU32 (uint8_t *bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = uint8_t(value >> (8 * i));
+    }
+}
+
+static void writeU64 (uint8_t *bytes, uint64_t value) {
+    writeU32(bytes, uint32_t(value));
+    writeU32(bytes + 4, uint32_t(value >> 32));
+}
+
+static uint64_t paddedSize (uint64_t size) {
+    return (size + 7) & ~uint64_t(7);
+}
+
+static uint32_t checksumOf (const uint8_t *data, size_t size) {
+    uLong checksum = crc32(0L, Z_NULL, 0);
+    // crc32 takes the length as a 32-bit integer
+    while (size > 0) {
+        uInt chunk = uInt(std::min<size_t>(size, 1u << 30));
+        checksum = crc32(checksum, data, chunk);
+        data += chunk;
+        size -= chunk;
+    }
+    return uint32_t(checksum);
+}
+
+static void encodeEntry (const FrameStoreEntry &entry, uint8_t *bytes) {
+    uint64_t timestampBits;
+    memcpy(&timestampBits, &entry.timestamp, sizeof(timestampBits));
+    memcpy(bytes, entry.frameId, 16);
+    writeU64(bytes + 16, timestampBits);
+    writeU64(bytes + 24, entry.offset);
+    writeU64(bytes + 32, entry.size);
+    writeU32(bytes + 40, entry.stream);
+    writeU32(bytes + 44, entry.checksum);
+    memcpy(bytes + 48, entry.fileExtension, frameStoreExtensionSize);
+}
+
+static FrameStoreEntry decodeEntry (const uint8_t *bytes) {
+    FrameStoreEntry entry;
+    uint64_t timestampBits = readU64(bytes + 16);
+    memcpy(entry.frameId, bytes, 16);
+    memcpy(&entry.timestamp, &timestampBits, sizeof(timestampBits));
+    entry.offset = readU64(bytes + 24);
+    entry.size = readU64(bytes + 32);
+    entry.stream = readU32(bytes + 40);
+    entry.checksum = readU32(bytes + 44);
+    memcpy(entry.fileExtension, bytes + 48, frameStoreExtensionSize);
+    entry.fileExtension[frameStoreExtensionSize - 1] = 0;
+    return entry;
+}
+
+/// Orders entries by frame id, then stream, then by when they were appended
+static bool lookupOrder (const FrameStoreEntry &a, const FrameStoreEntry &b) {
+    int order = memcmp(a.frameId, b.frameId, 16);
+    if (order != 0) {
+        return order < 0;
+    }
+    if (a.stream != b.stream) {
+        return a.stream < b.stream;
+    }
+    return a.offset < b.offset;
+}
+
+/// Sorts entries into the order of the index, and returns the lookup table of the sorted entries
+static std::vector<uint32_t> sortEntries (std::vector<FrameStoreEntry> &entries) {
+    std::stable_sort(entries.begin(), entries.end(), [](const FrameStoreEntry &a, const FrameStoreEntry &b) {
+        return a.timestamp < b.timestamp;
+    });
+    std::vector<uint32_t> lookup(entries.size());
+    for (size_t i = 0; i < lookup.size(); i++) {
+        lookup[i] = uint32_t(i);
+    }
+    std::sort(lookup.begin(), lookup.end(), [&entries](uint32_t a, uint32_t b) {
+        return lookupOrder(entries[a], entries[b]);
+    });
+    return lookup;
+}
+
+/**
+    Fields of the header that are not constant.
+ */
+struct FrameStoreHeader {
+    uint64_t indexOffset = 0;
+    uint64_t entryCount = 0;
+    uint64_t lookupOffset = 0;
+};
+
+static void encodeHeader (const FrameStoreHeader &header, uint8_t *bytes) {
+    memset(bytes, 0, frameStoreHeaderSize);
+    memcpy(bytes, frameStoreMagic, 4);
+    writeU32(bytes + 4, frameStoreVersion);
+    writeU32(bytes + 8, uint32_t(frameStoreEntrySize));
+    writeU64(bytes + 16, header.indexOffset);
+    writeU64(bytes + 24, header.entryCount);
+    writeU64(bytes + 32, header.lookupOffset);
+}
+
+/**
+    Reads and checks the header. A finished file must have its index and lookup tables inside of it.
+ */
+static FrameStoreStatus decodeHeader (const uint8_t *data, size_t size, FrameStoreHeader &header) {
+    if (size < frameStoreHeaderSize || memcmp(data, frameStoreMagic, 4) != 0) {
+        return FrameStoreStatus::Corrupt;
+    }
+    if (readU32(data + 4) > frameStoreVersion) {
+        return FrameStoreStatus::Unsupported;
+    }
+    if (readU32(data + 8) != frameStoreEntrySize) {
+        return FrameStoreStatus::Corrupt;
+    }
+    header.indexOffset = readU64(data + 16);
+    header.entryCount = readU64(data + 24);
+    header.lookupOffset = readU64(data + 32);
+    if (header.indexOffset == 0) {
+        return FrameStoreStatus::Ok;
+    }
+    if (header.entryCount > (size - frameStoreHeaderSize) / (frameStoreEntrySize + 4)
+        || header.indexOffset < frameStoreHeaderSize || header.indexOffset > size - header.entryCount * frameStoreEntrySize
+        || header.lookupOffset < frameStoreHeaderSize || header.lookupOffset > size - header.entryCount * 4) {
+        return FrameStoreStatus::Corrupt;
+    }
+    return FrameStoreStatus::Ok;
+}
+
+/**
+    Where the records appended after the index of a finished file start: the end of its lookup table, padded to 8 bytes.
+ */
+static uint64_t recordsAfterTables (const FrameStoreHeader &header) {
+    return paddedSize(header.lookupOffset + header.entryCount * 4);
+}
+
+/**
+    Recovers entries from the records that start at a position, up to the first record that is incomplete
+    or does not match its checksum. Returns the end of the last complete record.
+ */
+static uint64_t scanRecords (const uint8_t *data, size_t size, uint64_t position, std::vector<FrameStoreEntry> &entries) {
+    if (position > size) {
+        return position;
+    }
+    while (size - position >= frameStoreEntrySize) {
+        FrameStoreEntry entry = decodeEntry(data + position);
+        uint64_t blobOffset = position + frameStoreEntrySize;
+        if (entry.offset != blobOffset || entry.size > size - blobOffset
+            || checksumOf(data + blobOffset, size_t(entry.size)) != entry.checksum) {
+            break;
+        }
+        entries.push_back(entry);
+        position = std::min<uint64_t>(blobOffset + paddedSize(entry.size), size);
+    }
+    return position;
+}
+
+static bool writeFully (int file, uint64_t offset, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = pwrite(file, data, size, off_t(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= size_t(written);
+        offset += uint64_t(written);
+    }
+    return true;
+}
+
+/**
+    Writes buffers one after the other, with as few calls as possible. The buffers are consumed.
+ */
+static bool writeVectorFully (int file, uint64_t offset, iovec *parts, size_t count) {
+    while (count > 0) {
+        int batch = int(std::min<size_t>(count, IOV_MAX));
+        ssize_t written = pwritev(file, parts, batch, off_t(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        offset += uint64_t(written);
+        size_t remaining = size_t(written);
+        while (count > 0 && remaining >= parts->iov_len) {
+            remaining -= parts->iov_len;
+            parts++;
+            count--;
+        }
+        if (count > 0) {
+            parts->iov_base = (uint8_t *)parts->iov_base + remaining;
+            parts->iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+/**
+    A read-only mapping of a whole file.
+ */
+struct FileMapping {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+
+    FrameStoreStatus map (int file) {
+        struct stat status;
+        if (fstat(file, &status) != 0) {
+            return FrameStoreStatus::IoError;
+        }
+        size = size_t(status.st_size);
+        if (size == 0) {
+            return FrameStoreStatus::Ok;
+        }
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapped == MAP_FAILED) {
+            size = 0;
+            return FrameStoreStatus::IoError;
+        }
+        data = (const uint8_t *)mapped;
+        return FrameStoreStatus::Ok;
+    }
+
+    void unmap () {
+        if (data != nullptr) {
+            munmap((void *)data, size);
+        }
+        data = nullptr;
+        size = 0;
+    }
+};
+
+FrameStoreWriter::~FrameStoreWriter () {
+    if (file >= 0) {
+        finish();
+    }
+}
+
+FrameStoreStatus FrameStoreWriter::open (const std::string &path) {
+    if (file >= 0) {
+        finish();
+    }
+    entries.clear();
+    indexCurrent = false;
+    file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) {
+        return FrameStoreStatus::IoError;
+    }
+
+    FileMapping mapping;
+    FrameStoreStatus status = mapping.map(file);
+    FrameStoreHeader header;
+    if (status == FrameStoreStatus::Ok && mapping.size > 0) {
+        status = decodeHeader(mapping.data, mapping.size, header);
+    }
+    if (status == FrameStoreStatus::Ok) {
+        if (mapping.size == 0) {
+            uint8_t headerBytes[frameStoreHeaderSize];
+            encodeHeader(FrameStoreHeader(), headerBytes);
+            endOffset = frameStoreHeaderSize;
+            if (!writeFully(file, 0, headerBytes, frameStoreHeaderSize)) {
+                status = FrameStoreStatus::IoError;
+            }
+        } else if (header.indexOffset == 0) {
+            endOffset = scanRecords(mapping.data, mapping.size, frameStoreHeaderSize, entries);
+        } else {
+            // The index stays where it is, and valid for the readers that have the file mapped, until a new one
+            // is written after the blobs appended from now on; blobs appended before a crash follow the old index
+            entries.reserve(size_t(header.entryCount));
+            for (uint64_t i = 0; i < header.entryCount; i++) {
+                entries.push_back(decodeEntry(mapping.data + header.indexOffset + i * frameStoreEntrySize));
+            }
+            endOffset = scanRecords(mapping.data, mapping.size, recordsAfterTables(header), entries);
+            indexCurrent = entries.size() == header.entryCount;
+        }
+    }
+    mapping.unmap();
+
+    // The file is never truncated, as readers may have it mapped: whatever follows the last complete record
+    // is written over by the next blobs
+    if (status != FrameStoreStatus::Ok) {
+        ::close(file);
+        file = -1;
+        entries.clear();
+    }
+    return status;
+}
+
+FrameStoreStatus FrameStoreWriter::append (const uint8_t frameId[16], double timestamp, uint32_t stream,
+                                           const char *fileExtension, const uint8_t *data, size_t size) {
+    FrameStoreAppend blob;
+    blob.frameId = frameId;
+    blob.timestamp = timestamp;
+    blob.stream = stream;
+    blob.fileExtension = fileExtension;
+    blob.data = data;
+    blob.size = size;
+    return appendBatch(&blob, 1);
+}
+
+FrameStoreStatus FrameStoreWriter::appendBatch (const FrameStoreAppend *blobs, size_t count) {
+    if (file < 0 || entries.size() + count > UINT32_MAX) {
+        return FrameStoreStatus::IoError;
+    }
+    std::vector<FrameStoreEntry> batchEntries(count);
+    std::vector<uint8_t> entryBytes(count * frameStoreEntrySize);
+    std::vector<iovec> parts;
+    parts.reserve(count * 3);
+    uint64_t offset = endOffset;
+    for (size_t i = 0; i < count; i++) {
+        const FrameStoreAppend &blob = blobs[i];
+        FrameStoreEntry &entry = batchEntries[i];
+        memcpy(entry.frameId, blob.frameId, 16);
+        entry.timestamp = blob.timestamp;
+        entry.offset = offset + frameStoreEntrySize;
+        entry.size = blob.size;
+        entry.stream = blob.stream;
+        entry.checksum = checksumOf(blob.data, blob.size);
+        strncpy(entry.fileExtension, blob.fileExtension, frameStoreExtensionSize - 1);
+        encodeEntry(entry, entryBytes.data() + i * frameStoreEntrySize);
+
+        size_t padding = size_t(paddedSize(blob.size) - blob.size);
+        parts.push_back({ entryBytes.data() + i * frameStoreEntrySize, frameStoreEntrySize });
+        if (blob.size > 0) {
+            parts.push_back({ (void *)blob.data, blob.size });
+        }
+        if (padding > 0) {
+            parts.push_back({ (void *)recordPadding, padding });
+        }
+        offset = entry.offset + blob.size + padding;
+    }
+    if (!writeVectorFully(file, endOffset, parts.data(), parts.size())) {
+        // The partial records are left for the next blobs to be written over, so that the blobs after them
+        // can still be recovered; the file is not truncated under the mappings of readers
+        return FrameStoreStatus::IoError;
+    }
+    endOffset = offset;
+    entries.insert(entries.end(), batchEntries.begin(), batchEntries.end());
+    indexCurrent = indexCurrent && count == 0;
+    return FrameStoreStatus::Ok;
+}
+
+FrameStoreStatus FrameStoreWriter::finish () {
+    if (file < 0) {
+        return FrameStoreStatus::IoError;
+    }
+    if (indexCurrent) {
+        // Another copy of the same index would only make the file grow with every reopen
+        ::close(file);
+        file = -1;
+        entries.clear();
+        return FrameStoreStatus::Ok;
+    }
+    std::vector<uint32_t> lookup = sortEntries(entries);
+    std::vector<uint8_t> tables(entries.size() * (frameStoreEntrySize + 4));
+    for (size_t i = 0; i < entries.size(); i++) {
+        encodeEntry(entries[i], tables.data() + i * frameStoreEntrySize);
+        writeU32(tables.data() + entries.size() * frameStoreEntrySize + i * 4, lookup[i]);
+    }
+    FrameStoreHeader header;
+    header.indexOffset = endOffset;
+    header.entryCount = entries.size();
+    header.lookupOffset = endOffset + entries.size() * frameStoreEntrySize;
+    uint8_t headerBytes[frameStoreHeaderSize];
+    encodeHeader(header, headerBytes);
+
+    // The tables must be on disk before the header points to them
+    bool written = writeFully(file, endOffset, tables.data(), tables.size()) && fsync(file) == 0
+        && writeFully(file, 0, headerBytes, frameStoreHeaderSize) && fsync(file) == 0;
+    ::close(file);
+    file = -1;
+    entries.clear();
+    return written ? FrameStoreStatus::Ok : FrameStoreStatus::IoError;
+}
+
+FrameStoreReader::~FrameStoreReader () {
+    close();
+}
+
+FrameStoreStatus FrameStoreReader::open (const std::string &path) {
+    close();
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return FrameStoreStatus::IoError;
+    }
+    FileMapping fileMapping;
+    FrameStoreStatus status = fileMapping.map(file);
+    // The mapping stays valid after the file is closed
+    ::close(file);
+    mapping = fileMapping.data;
+    mappingSize = fileMapping.size;
+
+    FrameStoreHeader header;
+    if (status == FrameStoreStatus::Ok) {
+        status = decodeHeader(mapping, mappingSize, header);
+    }
+    if (status != FrameStoreStatus::Ok) {
+        close();
+        return status;
+    }
+    if (header.indexOffset == 0) {
+        scanRecords(mapping, mappingSize, frameStoreHeaderSize, recoveredEntries);
+        recoveredLookup = sortEntries(recoveredEntries);
+        count = recoveredEntries.size();
+    } else {
+        index = mapping + header.indexOffset;
+        lookup = mapping + header.lookupOffset;
+        count = size_t(header.entryCount);
+    }
+    return FrameStoreStatus::Ok;
+}
+
+void FrameStoreReader::close () {
+    FileMapping fileMapping;
+    fileMapping.data = mapping;
+    fileMapping.size = mappingSize;
+    fileMapping.unmap();
+    mapping = nullptr;
+    mappingSize = 0;
+    count = 0;
+    index = nullptr;
+    lookup = nullptr;
+    recoveredEntries.clear();
+    recoveredLookup.clear();
+}
+
+FrameStoreEntry FrameStoreReader::entry (size_t position) const {
+    if (index == nullptr) {
+        return recoveredEntries[position];
+    }
+    return decodeEntry(index + position * frameStoreEntrySize);
+}
+
+uint32_t FrameStoreReader::lookupPosition (size_t i) const {
+    return lookup == nullptr ? recoveredLookup[i] : readU32(lookup + i * 4);
+}
+
+long FrameStoreReader::find (const uint8_t frameId[16], uint32_t stream) const {
+    // Upper bound of the frame id and stream in the lookup table, so that the last appended blob is found
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        uint32_t position = lookupPosition(middle);
+        if (position >= count) {
+            return -1;
+        }
+        FrameStoreEntry candidate = entry(position);
+        int order = memcmp(candidate.frameId, frameId, 16);
+        if (order < 0 || (order == 0 && candidate.stream <= stream)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == 0) {
+        return -1;
+    }
+    uint32_t position = lookupPosition(low - 1);
+    FrameStoreEntry candidate = entry(position);
+    if (memcmp(candidate.frameId, frameId, 16) != 0 || candidate.stream != stream) {
+        return -1;
+    }
+    return long(position);
+}
+
+size_t FrameStoreReader::lowerBound (double timestamp) const {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (entry(middle).timestamp < timestamp) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+FrameStoreBlob FrameStoreReader::blob (const FrameStoreEntry &entry) const {
+    FrameStoreBlob blob;
+    if (entry.offset > mappingSize || entry.size > mappingSize - entry.offset) {
+        return blob;
+    }
+    blob.data = mapping + entry.offset;
+    blob.size = size_t(entry.size);
+    return blob;
+}
+
+bool FrameStoreReader::verify (const FrameStoreEntry &entry) const {
+    FrameStoreBlob bytes = blob(entry);
+    if (bytes.data == nullptr && entry.size > 0) {
+        return false;
+    }
+    return checksumOf(bytes.data, bytes.size) == entry.checksum;
+}
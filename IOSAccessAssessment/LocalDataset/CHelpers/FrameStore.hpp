@@ -0,0 +1,167 @@
+//
+//  FrameStore.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef FrameStore_hpp
+#define FrameStore_hpp
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+    An append-only file that holds the encoded images of every frame of a dataset, in place of one file per image.
+
+    Header (64 bytes, little-endian): "DFST", version, entry size, then the offset of the index table,
+    its number of entries and the offset of its lookup table (8 bytes each), padded with zeros.
+    Every blob is written as a record: its entry, then its bytes, padded to 8 bytes.
+    Finishing the file appends the index table, which holds the entries sorted by timestamp,
+    and the lookup table, which holds the positions of the entries in the index sorted by frame id and stream,
+    and only then writes their offsets to the header.
+
+    A file that was not finished, such as when the app was closed during a capture, has no index,
+    and its entries are recovered from the records. Reopening a finished file for writing keeps its index in place
+    and appends after its tables, and finishing writes a new index at the end before the header points to it, so the file
+    never shrinks under the mappings of readers, which keep seeing the index they opened. Blobs appended after the index
+    of a file that was not finished again are recovered when the file is next opened for writing.
+ */
+static const uint32_t frameStoreVersion = 1;
+static const char frameStoreFileExtension[] = "dfst";
+static const size_t frameStoreHeaderSize = 64;
+static const size_t frameStoreEntrySize = 56;
+static const size_t frameStoreExtensionSize = 8;
+
+enum class FrameStoreStatus {
+    Ok,
+    /// The file could not be opened, read or written
+    IoError,
+    /// A file of a later version of the format
+    Unsupported,
+    /// Not a valid file
+    Corrupt
+};
+
+/**
+    A blob of the store. Blobs are keyed by the frame they belong to and their stream, such as the RGB or the depth image.
+ */
+struct FrameStoreEntry {
+    uint8_t frameId[16] = {};
+    double timestamp = 0;
+    /// Offset of the bytes of the blob in the file
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    uint32_t stream = 0;
+    /// CRC-32 of the bytes of the blob
+    uint32_t checksum = 0;
+    /// Extension of the file the blob is exported to, such as "png", without the dot
+    char fileExtension[frameStoreExtensionSize] = {};
+};
+
+/**
+    Bytes of a blob, in the mapping of the file.
+ */
+struct FrameStoreBlob {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+};
+
+/**
+    A blob to append to a store.
+ */
+struct FrameStoreAppend {
+    const uint8_t *frameId = nullptr;
+    double timestamp = 0;
+    uint32_t stream = 0;
+    const char *fileExtension = "";
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+};
+
+/**
+    Appends blobs to a store, at the end of the file.
+ */
+class FrameStoreWriter {
+public:
+    FrameStoreWriter () = default;
+    FrameStoreWriter (const FrameStoreWriter &) = delete;
+    FrameStoreWriter &operator= (const FrameStoreWriter &) = delete;
+    /// Finishes the file if it is still open
+    ~FrameStoreWriter ();
+
+    /// Creates the file, or opens it to append more blobs
+    FrameStoreStatus open (const std::string &path);
+    FrameStoreStatus append (const uint8_t frameId[16], double timestamp, uint32_t stream, const char *fileExtension,
+                             const uint8_t *data, size_t size);
+    /// Appends blobs with as few writes as possible. On failure, none of them are appended.
+    FrameStoreStatus appendBatch (const FrameStoreAppend *blobs, size_t count);
+    /// Writes the index, then closes the file. A file whose index already has every blob is only closed, so it does not grow.
+    FrameStoreStatus finish ();
+
+    size_t entryCount () const {
+        return entries.size();
+    }
+
+private:
+    int file = -1;
+    uint64_t endOffset = 0;
+    std::vector<FrameStoreEntry> entries;
+    /// Whether the index in the file has every entry, as nothing was appended or recovered since it was written
+    bool indexCurrent = false;
+};
+
+/**
+    Reads a store through a read-only mapping of the file. Entries are decoded from the index on access,
+    and blobs point into the mapping, so neither is copied. Blobs are valid while the reader is open.
+ */
+class FrameStoreReader {
+public:
+    FrameStoreReader () = default;
+    FrameStoreReader (const FrameStoreReader &) = delete;
+    FrameStoreReader &operator= (const FrameStoreReader &) = delete;
+    ~FrameStoreReader ();
+
+    FrameStoreStatus open (const std::string &path);
+    void close ();
+
+    /// Whether the entries were recovered from the records, as the file was not finished
+    bool recovered () const {
+        return index == nullptr;
+    }
+
+    size_t entryCount () const {
+        return count;
+    }
+
+    /// Entry at a position of the index, which is sorted by timestamp
+    FrameStoreEntry entry (size_t position) const;
+
+    /// Position of the entry of a frame and stream, or -1. If a blob was appended more than once, the last one is found.
+    long find (const uint8_t frameId[16], uint32_t stream) const;
+
+    /// Position of the first entry with a timestamp that is not before the given one, or the number of entries
+    size_t lowerBound (double timestamp) const;
+
+    /// Bytes of the blob of an entry, or an empty blob if the entry points outside of the file
+    FrameStoreBlob blob (const FrameStoreEntry &entry) const;
+
+    /// Whether the bytes of the blob of an entry match its checksum
+    bool verify (const FrameStoreEntry &entry) const;
+
+private:
+    uint32_t lookupPosition (size_t i) const;
+
+    const uint8_t *mapping = nullptr;
+    size_t mappingSize = 0;
+    size_t count = 0;
+    /// Index and lookup tables in the mapping, or null for files that were not finished
+    const uint8_t *index = nullptr;
+    const uint8_t *lookup = nullptr;
+    /// Entries and lookup table recovered from the records of files that were not finished
+    std::vector<FrameStoreEntry> recoveredEntries;
+    std::vector<uint32_t> recoveredLookup;
+};
+
+#endif /* FrameStore_hpp */
@@ -0,0 +1,64 @@
+//
+//  FrameStoreCoder.h
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef FrameStoreCoder_h
+#define FrameStoreCoder_h
+#include <Foundation/Foundation.h>
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+    Appends the encoded images of frames to a frame store, a single file that replaces the per-frame image files of a dataset.
+ */
+@interface FrameStoreEncoder : NSObject
+
+/// File extension of frame stores, without the dot
+@property (class, nonatomic, readonly) NSString *fileExtension;
+
+/// Creates the store, or opens it to append more frames. Returns nil if the file is not a valid store.
+- (nullable instancetype) initWithPath:(NSString *)path;
+
+- (BOOL) appendData:(NSData *)data
+            frameId:(NSUUID *)frameId
+          timestamp:(double)timestamp
+             stream:(uint32_t)stream
+      fileExtension:(NSString *)fileExtension;
+
+/// Writes the index of the store and closes it. Called on deallocation if it was not called before.
+- (BOOL) finish;
+
+@end
+
+/**
+    Reads a frame store through a memory mapping of the file. Entries are sorted by timestamp.
+ */
+@interface FrameStoreDecoder : NSObject
+
+- (nullable instancetype) initWithPath:(NSString *)path;
+
+@property (nonatomic, readonly) NSInteger count;
+
+- (NSUUID *) frameIdAtIndex:(NSInteger)index;
+- (double) timestampAtIndex:(NSInteger)index;
+- (uint32_t) streamAtIndex:(NSInteger)index;
+- (NSString *) fileExtensionAtIndex:(NSInteger)index;
+
+/// Index of the entry of a frame and stream, or -1
+- (NSInteger) indexOfFrame:(NSUUID *)frameId stream:(uint32_t)stream;
+
+/// Index of the first entry with a timestamp that is not before the given one, or count
+- (NSInteger) indexOfFirstEntryAtOrAfterTimestamp:(double)timestamp;
+
+/**
+    Bytes of an entry. They point into the mapping of the file, which stays alive while the returned data does,
+    so they are not copied. Returns nil if the entry points outside of the file, or if verify is set and
+    the bytes do not match their checksum.
+ */
+- (nullable NSData *) dataAtIndex:(NSInteger)index verify:(BOOL)verify;
+
+@end
+NS_ASSUME_NONNULL_END
+#endif /* FrameStoreCoder_h */
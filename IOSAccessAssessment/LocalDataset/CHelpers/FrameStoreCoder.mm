@@ -0,0 +1,110 @@
+//
+//  FrameStoreCoder.mm
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#import <Foundation/Foundation.h>
+#import "FrameStoreCoder.h"
+#include "FrameStore.hpp"
+#include <memory>
+
+@implementation FrameStoreEncoder {
+    FrameStoreWriter writer;
+}
+
++ (NSString *)fileExtension {
+    return @(frameStoreFileExtension);
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (self && writer.open(path.fileSystemRepresentation) != FrameStoreStatus::Ok) {
+        return nil;
+    }
+    return self;
+}
+
+- (BOOL)appendData:(NSData *)data
+           frameId:(NSUUID *)frameId
+         timestamp:(double)timestamp
+            stream:(uint32_t)stream
+     fileExtension:(NSString *)fileExtension {
+    uuid_t frameBytes;
+    [frameId getUUIDBytes:frameBytes];
+    return writer.append(frameBytes, timestamp, stream, fileExtension.UTF8String,
+                         (const uint8_t *)data.bytes, data.length) == FrameStoreStatus::Ok;
+}
+
+- (BOOL)finish {
+    return writer.finish() == FrameStoreStatus::Ok;
+}
+
+@end
+
+@implementation FrameStoreDecoder {
+    // Shared with the data returned by the decoder, which keeps the mapping alive
+    std::shared_ptr<FrameStoreReader> reader;
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (self) {
+        reader = std::make_shared<FrameStoreReader>();
+        if (reader->open(path.fileSystemRepresentation) != FrameStoreStatus::Ok) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (NSInteger)count {
+    return NSInteger(reader->entryCount());
+}
+
+- (NSUUID *)frameIdAtIndex:(NSInteger)index {
+    FrameStoreEntry entry = reader->entry(size_t(index));
+    return [[NSUUID alloc] initWithUUIDBytes:entry.frameId];
+}
+
+- (double)timestampAtIndex:(NSInteger)index {
+    return reader->entry(size_t(index)).timestamp;
+}
+
+- (uint32_t)streamAtIndex:(NSInteger)index {
+    return reader->entry(size_t(index)).stream;
+}
+
+- (NSString *)fileExtensionAtIndex:(NSInteger)index {
+    return @(reader->entry(size_t(index)).fileExtension);
+}
+
+- (NSInteger)indexOfFrame:(NSUUID *)frameId stream:(uint32_t)stream {
+    uuid_t frameBytes;
+    [frameId getUUIDBytes:frameBytes];
+    return NSInteger(reader->find(frameBytes, stream));
+}
+
+- (NSInteger)indexOfFirstEntryAtOrAfterTimestamp:(double)timestamp {
+    return NSInteger(reader->lowerBound(timestamp));
+}
+
+- (NSData *)dataAtIndex:(NSInteger)index verify:(BOOL)verify {
+    if (index < 0 || size_t(index) >= reader->entryCount()) {
+        return nil;
+    }
+    FrameStoreEntry entry = reader->entry(size_t(index));
+    FrameStoreBlob blob = reader->blob(entry);
+    if ((blob.data == nullptr && entry.size > 0) || (verify && !reader->verify(entry))) {
+        return nil;
+    }
+    std::shared_ptr<FrameStoreReader> mapping = reader;
+    return [[NSData alloc] initWithBytesNoCopy:(void *)blob.data
+                                        length:blob.size
+                                   deallocator:^(void *bytes, NSUInteger length) {
+        (void)mapping;
+    }];
+}
+
+@end
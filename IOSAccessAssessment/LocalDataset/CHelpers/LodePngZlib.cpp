@@ -0,0 +1,120 @@
+//
+//  LodePngZlib.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "LodePngZlib.hpp"
+#include <cstdlib>
+#include <cstring>
+
+#if LODEPNG_ZLIB_BACKEND
+#include <zlib.h>
+
+/**
+    Error codes of the hooks. lodepng reports any non-zero value from a custom zlib as its own error 110.
+ */
+enum ZlibBackendError : unsigned {
+    ZlibBackendAllocationFailed = 1,
+    ZlibBackendStreamFailed = 2,
+    ZlibBackendOutputTooLarge = 3
+};
+
+/**
+    The output buffers are allocated with malloc, since lodepng releases them with free.
+ */
+static unsigned zlibCompress (unsigned char **out, size_t *outSize, const unsigned char *in, size_t inSize,
+                              const LodePNGCompressSettings *settings) {
+    const int *level = static_cast<const int *>(settings->custom_context);
+    uLongf bound = compressBound(uLong(inSize));
+    unsigned char *buffer = static_cast<unsigned char *>(std::malloc(bound));
+    if (buffer == nullptr) {
+        return ZlibBackendAllocationFailed;
+    }
+    if (compress2(buffer, &bound, in, uLong(inSize), level != nullptr ? *level : defaultPngCompressionLevel) != Z_OK) {
+        std::free(buffer);
+        return ZlibBackendStreamFailed;
+    }
+    std::free(*out);
+    *out = buffer;
+    *outSize = bound;
+    return 0;
+}
+
+static unsigned zlibDecompress (unsigned char **out, size_t *outSize, const unsigned char *in, size_t inSize,
+                                const LodePNGDecompressSettings *settings) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit(&stream) != Z_OK) {
+        return ZlibBackendStreamFailed;
+    }
+    
+    // The decompressed size is unknown here, so the buffer starts at a typical ratio and doubles as needed
+    size_t capacity = inSize * 4 + 1024;
+    unsigned char *buffer = static_cast<unsigned char *>(std::malloc(capacity));
+    size_t size = 0;
+    stream.next_in = const_cast<unsigned char *>(in);
+    stream.avail_in = uInt(inSize);
+    unsigned error = 0;
+    while (buffer != nullptr) {
+        stream.next_out = buffer + size;
+        stream.avail_out = uInt(capacity - size);
+        int result = inflate(&stream, Z_NO_FLUSH);
+        size = capacity - stream.avail_out;
+        if (result == Z_STREAM_END) {
+            break;
+        }
+        if (result != Z_OK && !(result == Z_BUF_ERROR && stream.avail_out == 0)) {
+            error = ZlibBackendStreamFailed;
+            break;
+        }
+        if (settings->max_output_size != 0 && size > settings->max_output_size) {
+            error = ZlibBackendOutputTooLarge;
+            break;
+        }
+        if (stream.avail_out == 0) {
+            unsigned char *grown = static_cast<unsigned char *>(std::realloc(buffer, capacity * 2));
+            if (grown == nullptr) {
+                std::free(buffer);
+                buffer = nullptr;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+        }
+    }
+    inflateEnd(&stream);
+    
+    if (buffer == nullptr) {
+        return ZlibBackendAllocationFailed;
+    }
+    std::free(*out);
+    *out = buffer;
+    *outSize = size;
+    return error;
+}
+
+void configureZlibBackend (LodePNGCompressSettings &settings, const int *compressionLevel) {
+    settings.custom_zlib = zlibCompress;
+    settings.custom_context = compressionLevel;
+}
+
+void configureZlibBackend (LodePNGDecompressSettings &settings) {
+    settings.custom_zlib = zlibDecompress;
+}
+
+#else
+
+void configureZlibBackend (LodePNGCompressSettings &settings, const int *compressionLevel) {
+    // The built-in deflate has no levels, so the window is scaled with the level instead
+    if (compressionLevel != nullptr) {
+        settings.windowsize = *compressionLevel <= 3 ? 2048 : (*compressionLevel <= 6 ? 8192 : 32768);
+    }
+}
+
+void configureZlibBackend (LodePNGDecompressSettings &settings) {
+    (void)settings;
+}
+
+#endif
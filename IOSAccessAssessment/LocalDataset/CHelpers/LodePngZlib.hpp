@@ -0,0 +1,37 @@
+//
+//  LodePngZlib.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef LodePngZlib_hpp
+#define LodePngZlib_hpp
+#include "lodepng.h"
+
+/**
+    The deflate implementation that lodepng uses, chosen at build time:
+    1 (the default) plugs the system zlib into lodepng's custom_zlib hooks, 0 keeps lodepng's built-in deflate and inflate.
+ */
+#ifndef LODEPNG_ZLIB_BACKEND
+#define LODEPNG_ZLIB_BACKEND 1
+#endif
+
+/**
+    The compression level used when none is given, on zlib's scale of 0 (store) to 9 (smallest).
+    Low levels are several times faster than lodepng's built-in deflate, at a small cost in size.
+ */
+static const int defaultPngCompressionLevel = 3;
+
+/**
+    Points the compression settings at the selected backend.
+    The compression level is read through the pointer when the image is compressed, so it must still be alive then.
+ */
+void configureZlibBackend (LodePNGCompressSettings &settings, const int *compressionLevel);
+
+/**
+    Points the decompression settings at the selected backend.
+ */
+void configureZlibBackend (LodePNGDecompressSettings &settings);
+
+#endif /* LodePngZlib_hpp */
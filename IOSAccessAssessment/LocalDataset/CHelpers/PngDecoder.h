@@ -15,6 +15,34 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSData * _Nullable)depthDataWithWidth:(int *)width
                                   height:(int *)height;
 
+/// Reads the image size from the PNG header, without decoding the image.
+/// Returns NO if the header is invalid, or if a side is larger than maxDepthImageSide.
+- (BOOL)readWidth:(int *)width height:(int *)height;
+
+/**
+    Decodes the depth in meters straight into a caller-owned buffer, such as the base address of a locked CVPixelBuffer.
+    Rows are bytesPerRow apart (0 for tightly packed rows), and capacity is the size of the buffer in bytes.
+    Returns NO if the file is invalid, or if the image does not fit the buffer.
+ */
+- (BOOL)decodeDepthIntoBuffer:(float *)buffer
+                  bytesPerRow:(size_t)bytesPerRow
+                     capacity:(size_t)capacity
+                        width:(int *)width
+                       height:(int *)height;
+
+/**
+    Decodes the depth in meters of a region of the image into a caller-owned buffer, with the top-left pixel of the region
+    going to the first row of the buffer. The region is clipped to the image, and the clipped region is written back.
+    Rows below the region are never decompressed, so small regions near the top of the frame are the cheapest.
+ */
+- (BOOL)decodeDepthInRegionX:(int *)x
+                           y:(int *)y
+                       width:(int *)width
+                      height:(int *)height
+                  intoBuffer:(float *)buffer
+                 bytesPerRow:(size_t)bytesPerRow
+                    capacity:(size_t)capacity;
+
 @end
 NS_ASSUME_NONNULL_END
 #endif /* PngDecoder_h */
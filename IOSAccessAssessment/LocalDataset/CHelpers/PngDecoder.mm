@@ -8,6 +8,9 @@
 #import <Foundation/Foundation.h>
 #import "PngDecoder.h"
 #import "lodepng.h"
+#include "DepthPngCodec.hpp"
+#include "LodePngZlib.hpp"
+#include <algorithm>
 #include <cmath>
 
 @implementation PngDecoder {
@@ -20,46 +23,164 @@
     }
     return self;
 }
-- (NSData *)depthDataWithWidth:(int *)width height:(int *)height {
-    std::vector<unsigned char> pngData(
-        (unsigned char *)_fileData.bytes,
-        (unsigned char *)_fileData.bytes + _fileData.length
-    );
+- (BOOL)readWidth:(int *)width height:(int *)height {
+    // Callers allocate their buffers from this size, so sizes beyond what a depth image can be are refused
+    size_t bytes = 0;
+    return readPngSize((const uint8_t *)_fileData.bytes, _fileData.length, *width, *height)
+        && depthImageBytes(*width, *height, bytes);
+}
+
+- (BOOL)decodeDepthIntoBuffer:(float *)buffer
+                  bytesPerRow:(size_t)bytesPerRow
+                     capacity:(size_t)capacity
+                        width:(int *)width
+                       height:(int *)height {
+    DepthBuffer output;
+    output.data = buffer;
+    output.bytesPerRow = bytesPerRow;
+    output.capacity = capacity;
+    
+    // Depth PNGs are decoded straight from the file bytes into the buffer; anything else goes through lodepng below
+    const uint8_t *fileBytes = (const uint8_t *)_fileData.bytes;
+    int fileWidth = 0;
+    int fileHeight = 0;
+    DepthPngStatus status = decodeDepthPng(fileBytes, _fileData.length, output, fileWidth, fileHeight);
+    if (status == DepthPngStatus::Ok) {
+        *width = fileWidth;
+        *height = fileHeight;
+        return YES;
+    }
+    if (status == DepthPngStatus::Corrupt) {
+        return NO;
+    }
 
     std::vector<unsigned char> image;
     unsigned w = 0;
     unsigned h = 0;
 
+    lodepng::State state;
+    state.info_raw.colortype = LCT_GREY;
+    state.info_raw.bitdepth = 16;
+    configureZlibBackend(state.decoder.zlibsettings);
     unsigned error = lodepng::decode(
         image,
         w,
         h,
-        pngData,
-        LCT_GREY,
-        16
+        state,
+        fileBytes,
+        _fileData.length
     );
 
-    if (error) {
-        return nil;
+    if (error || !output.fits((int)w, (int)h)) {
+        return NO;
     }
 
-    size_t pixelCount = w * h;
-
-    std::vector<float> floatDepth(pixelCount);
-
-    for (size_t i = 0; i < pixelCount; i++) {
-        uint16_t msb = image[i * 2];
-        uint16_t lsb = image[i * 2 + 1];
-
-        uint16_t depthMM = (msb << 8) | lsb;
-
-        floatDepth[i] = depthMM / 1000.0f; // mm → meters
+    for (unsigned y = 0; y < h; y++) {
+        float *depthRow = output.row((int)y, (int)w);
+        const unsigned char *samples = image.data() + (size_t)y * w * 2;
+        for (unsigned x = 0; x < w; x++) {
+            uint16_t depthMM = (uint16_t(samples[2 * x]) << 8) | samples[2 * x + 1];
+            depthRow[x] = depthMM / 1000.0f; // mm → meters
+        }
     }
 
     *width = (int)w;
     *height = (int)h;
+    return YES;
+}
 
-    return [NSData dataWithBytes:floatDepth.data()
-                          length:pixelCount * sizeof(float)];
+- (BOOL)decodeDepthInRegionX:(int *)x
+                           y:(int *)y
+                       width:(int *)width
+                      height:(int *)height
+                  intoBuffer:(float *)buffer
+                 bytesPerRow:(size_t)bytesPerRow
+                    capacity:(size_t)capacity {
+    DepthBuffer output;
+    output.data = buffer;
+    output.bytesPerRow = bytesPerRow;
+    output.capacity = capacity;
+    
+    DepthRegion region;
+    region.x = *x;
+    region.y = *y;
+    region.width = *width;
+    region.height = *height;
+    
+    // Depth PNGs are streamed, and stop being inflated after the last row of the region
+    const uint8_t *fileBytes = (const uint8_t *)_fileData.bytes;
+    int fileWidth = 0;
+    int fileHeight = 0;
+    DepthPngStatus status = decodeDepthPngRegion(fileBytes, _fileData.length, region, output, fileWidth, fileHeight);
+    if (status == DepthPngStatus::Corrupt) {
+        return NO;
+    }
+    if (status == DepthPngStatus::Unsupported) {
+        // Anything else is decoded in full by lodepng, and cropped
+        std::vector<unsigned char> image;
+        unsigned w = 0;
+        unsigned h = 0;
+        
+        lodepng::State state;
+        state.info_raw.colortype = LCT_GREY;
+        state.info_raw.bitdepth = 16;
+        configureZlibBackend(state.decoder.zlibsettings);
+        unsigned error = lodepng::decode(image, w, h, state, fileBytes, _fileData.length);
+        if (error) {
+            return NO;
+        }
+        
+        int left = std::max(region.x, 0);
+        int top = std::max(region.y, 0);
+        int right = (int)std::min<int64_t>((int64_t)region.x + region.width, (int64_t)w);
+        int bottom = (int)std::min<int64_t>((int64_t)region.y + region.height, (int64_t)h);
+        region.x = left;
+        region.y = top;
+        region.width = std::max(right - left, 0);
+        region.height = std::max(bottom - top, 0);
+        if (region.width > 0 && region.height > 0) {
+            if (!output.fits(region.width, region.height)) {
+                return NO;
+            }
+            for (int row = 0; row < region.height; row++) {
+                float *depthRow = output.row(row, region.width);
+                const unsigned char *samples = image.data() + ((size_t)(row + region.y) * w + region.x) * 2;
+                for (int column = 0; column < region.width; column++) {
+                    uint16_t depthMM = (uint16_t(samples[2 * column]) << 8) | samples[2 * column + 1];
+                    depthRow[column] = depthMM / 1000.0f; // mm → meters
+                }
+            }
+        }
+    }
+    
+    *x = region.x;
+    *y = region.y;
+    *width = region.width;
+    *height = region.height;
+    return YES;
+}
+
+- (NSData *)depthDataWithWidth:(int *)width height:(int *)height {
+    int fileWidth = 0;
+    int fileHeight = 0;
+    if (![self readWidth:&fileWidth height:&fileHeight]) {
+        return nil;
+    }
+    // The size comes from the file, so it is bounded before it decides the allocation
+    size_t length = 0;
+    if (!depthImageBytes(fileWidth, fileHeight, length)) {
+        return nil;
+    }
+    
+    // The buffer is handed over to the returned data, which frees it, so the floats are never copied
+    float *buffer = (float *)malloc(length);
+    if (buffer == NULL) {
+        return nil;
+    }
+    if (![self decodeDepthIntoBuffer:buffer bytesPerRow:0 capacity:length width:width height:height]) {
+        free(buffer);
+        return nil;
+    }
+    return [NSData dataWithBytesNoCopy:buffer length:length freeWhenDone:YES];
 }
 @end
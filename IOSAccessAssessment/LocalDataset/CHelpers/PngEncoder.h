@@ -12,7 +12,14 @@
 
 @interface PngEncoder : NSObject
 
+/// zlib compression level of the file contents, from 0 (fastest) to 9 (smallest)
+@property (nonatomic) int compressionLevel;
+/// Number of threads that encode row stripes of the image in parallel; 0 picks one per core, up to 3, for depth, and a single thread for 8-bit images
+@property (nonatomic) int threadCount;
+
 - (instancetype) initWithDepth:(float *)content width:(int)width height:(int)height;
+/// Encodes 8-bit confidence (or any 8-bit greyscale) values as an 8-bit greyscale PNG
+- (instancetype) initWithConfidence:(const uint8_t *)content width:(int)width height:(int)height bytesPerRow:(size_t)bytesPerRow;
 - (NSData*) fileContents;
 
 @end
@@ -11,34 +11,67 @@
 #define LODEPNG_NO_COMPILE_DISK 1
 #import "PngEncoder.h"
 #import "lodepng.h"
-#include <cmath>
+#include "DepthPacking.hpp"
+#include "DepthPngCodec.hpp"
+#include "LodePngZlib.hpp"
+#include <algorithm>
+#include <thread>
+
+/**
+    Upper bound of the automatic thread count of 16-bit depth, so that a save does not take over every core from the capture.
+    A LiDAR frame (192 rows) never splits into more than 3 stripes, which png_stripe_benchmark estimates at 3.0x the speed of
+    one thread for 3.1% more bytes; a fourth thread is never used on it, and only adds stripes to camera-sized frames.
+ */
+static const unsigned maxAutomaticThreads = 3;
 
 @implementation PngEncoder {
     std::vector<unsigned char> png;
     std::vector<unsigned char> inputImage;
     int height;
     int width;
+    int bitDepth;
 }
 - (instancetype) initWithDepth:(float*) content width:(int) w height:(int) h {
     self = [super init];
+    _compressionLevel = defaultPngCompressionLevel;
+    _threadCount = 0;
     width = w;
     height = h;
+    bitDepth = 16;
     inputImage.resize(width * height * 2);
-    unsigned char* outData = inputImage.data();
-    for (int y=0; y < height; y++) {
-        for (int x=0; x < width; x++) {
-            float value = content[y * width + x];
-            uint16_t converted = uint16_t(std::round(value * 1000.0f));
-            unsigned int index = (y * width + x) * 2;
-            outData[index] = converted >> 8;
-            outData[index+1] = converted & 0xFF;
-        }
+    // Meters to big-endian millimeters, saturated to the 16-bit range
+    packDepthMillimeters(content, (size_t)width * height, inputImage.data());
+    return self;
+}
+
+- (instancetype) initWithConfidence:(const uint8_t *)content width:(int)w height:(int)h bytesPerRow:(size_t)bytesPerRow {
+    self = [super init];
+    _compressionLevel = defaultPngCompressionLevel;
+    _threadCount = 0;
+    width = w;
+    height = h;
+    bitDepth = 8;
+    inputImage.resize(width * height);
+    for (int y = 0; y < height; y++) {
+        memcpy(inputImage.data() + (size_t)y * width, content + (size_t)y * bytesPerRow, width);
     }
     return self;
 }
 
 - (NSData*) fileContents {
-    lodepng::encode(png, inputImage, width, height, LCT_GREY, 16);
+    // The specialized depth codec is used when it can be, and lodepng is kept as the general fallback
+    int level = _compressionLevel;
+    // 8-bit confidence encodes in about 0.1 ms on one thread, where stripes cost more in thread starts and bytes than they save
+    unsigned threads = _threadCount > 0
+        ? (unsigned)_threadCount
+        : (bitDepth == 8 ? 1u : std::min(std::max(std::thread::hardware_concurrency(), 1u), maxAutomaticThreads));
+    if (!encodeGreyPng(inputImage.data(), width, height, bitDepth, DepthPngFilter::Up, level, threads, png)) {
+        lodepng::State state;
+        state.info_raw.colortype = LCT_GREY;
+        state.info_raw.bitdepth = bitDepth;
+        configureZlibBackend(state.encoder.zlibsettings, &level);
+        lodepng::encode(png, inputImage.data(), width, height, state);
+    }
     NSData* outData = [[NSData alloc] initWithBytes:(void*)png.data() length:png.size()];
     return outData;
 }
@@ -0,0 +1,288 @@
+//
+//  DatasetWriterTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "DatasetWriter.hpp"
+
+/**
+    Checks the file sink of DatasetWriter:
+    - files are written whole, by renaming a hidden file, which never stays behind,
+    - bytes that an encoder keeps in memory of its own are written from there, and released once written,
+    - the written callback of a frame only runs once every file of the frame exists, and not for a frame that a file of failed,
+    - a callback that fails counts its frame as failed, which the next flush reports,
+    - callbacks run in the order the frames were submitted, when the encoders finish them in reverse order,
+      and a dropped frame between two others does not hold back the ones after it.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+static bool fileExists (const std::string &path) {
+    struct stat status;
+    return stat(path.c_str(), &status) == 0;
+}
+
+static std::vector<uint8_t> fileBytes (const std::string &path) {
+    std::ifstream input(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+/// Names in a directory, hidden ones included
+static std::vector<std::string> directoryNames (const std::string &path) {
+    std::vector<std::string> names;
+    DIR *directory = opendir(path.c_str());
+    if (directory == nullptr) {
+        return names;
+    }
+    while (dirent *item = readdir(directory)) {
+        if (std::strcmp(item->d_name, ".") != 0 && std::strcmp(item->d_name, "..") != 0) {
+            names.push_back(item->d_name);
+        }
+    }
+    closedir(directory);
+    return names;
+}
+
+/// Waits for up to a few seconds for a condition that another thread makes true
+template <typename Condition>
+static bool waitFor (const Condition &condition) {
+    for (int i = 0; i < 5000 && !condition(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return condition();
+}
+
+static std::vector<uint8_t> blobBytes (int frame, int file) {
+    std::vector<uint8_t> bytes(5000 + frame * 13 + file);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        bytes[i] = uint8_t(i * 7 + frame * 3 + file);
+    }
+    return bytes;
+}
+
+int main () {
+    char directory[] = "/tmp/dataset_writer_test_XXXXXX";
+    if (mkdtemp(directory) == nullptr) {
+        std::printf("FAIL: temporary directory (mkdtemp failed)\n");
+        return 1;
+    }
+    const std::string root = directory;
+    const int frameCount = 12;
+    std::atomic<int> callbacksWithFiles(0);
+    std::atomic<int> callbacksWithoutFiles(0);
+    std::atomic<int> ownersAlive(0);
+    std::atomic<int> ownersReleased(0);
+
+    DatasetWriterConfig config;
+    config.queueCapacity = 4;
+    config.encoderThreads = 2;
+    config.batchBlobs = 3;
+    DatasetWriter writer(config);
+    for (int f = 0; f < frameCount; f++) {
+        DatasetWriterFrame frame;
+        frame.frameId[0] = uint8_t(f);
+        frame.timestamp = f;
+        std::vector<std::string> paths;
+        for (int file = 0; file < 2; file++) {
+            DatasetWriterBlob blob;
+            blob.path = root + "/" + std::to_string(f) + "_" + std::to_string(file) + ".bin";
+            paths.push_back(blob.path);
+            if (file == 0) {
+                // Bytes of the encoder's own, as an NSData would hold them
+                blob.encode = [f, file, &ownersAlive, &ownersReleased](DatasetWriterBytes &encoded) {
+                    std::vector<uint8_t> *bytes = new std::vector<uint8_t>(blobBytes(f, file));
+                    ownersAlive++;
+                    encoded.external = bytes->data();
+                    encoded.externalSize = bytes->size();
+                    encoded.owner = std::shared_ptr<const void>(bytes, [&ownersAlive, &ownersReleased](const void *owner) {
+                        delete static_cast<const std::vector<uint8_t> *>(owner);
+                        ownersAlive--;
+                        ownersReleased++;
+                    });
+                    return true;
+                };
+            } else {
+                blob.encode = [f, file](DatasetWriterBytes &encoded) {
+                    encoded.storage = blobBytes(f, file);
+                    return true;
+                };
+            }
+            frame.blobs.push_back(std::move(blob));
+        }
+        frame.written = [paths, &callbacksWithFiles, &callbacksWithoutFiles]() {
+            bool allExist = true;
+            for (const std::string &path : paths) {
+                allExist = allExist && fileExists(path);
+            }
+            (allExist ? callbacksWithFiles : callbacksWithoutFiles)++;
+            return true;
+        };
+        writer.submit(frame);
+    }
+    bool flushed = writer.flush();
+
+    bool contents = true;
+    for (int f = 0; f < frameCount; f++) {
+        for (int file = 0; file < 2; file++) {
+            contents = contents && fileBytes(root + "/" + std::to_string(f) + "_" + std::to_string(file) + ".bin") == blobBytes(f, file);
+        }
+    }
+    std::vector<std::string> names = directoryNames(root);
+    bool noPartials = names.size() == size_t(frameCount * 2);
+    for (const std::string &name : names) {
+        noPartials = noPartials && name[0] != '.';
+    }
+    char detail[160];
+    std::snprintf(detail, sizeof(detail), "%d frames of 2 files, %zu names in the directory", frameCount, names.size());
+    check(flushed && contents && noPartials, "files written whole", detail);
+    std::snprintf(detail, sizeof(detail), "%d released, %d still held", ownersReleased.load(), ownersAlive.load());
+    check(ownersReleased == frameCount && ownersAlive == 0, "encoder bytes written in place and released", detail);
+    std::snprintf(detail, sizeof(detail), "%d callbacks with every file, %d without", callbacksWithFiles.load(),
+                  callbacksWithoutFiles.load());
+    check(callbacksWithFiles == frameCount && callbacksWithoutFiles == 0, "written callback after the files", detail);
+
+    // A frame whose second file cannot be written, as its directory does not exist
+    std::atomic<int> failedCallbacks(0);
+    DatasetWriterFrame failing;
+    for (int file = 0; file < 2; file++) {
+        DatasetWriterBlob blob;
+        blob.path = file == 0 ? root + "/failing.bin" : root + "/missing/failing.bin";
+        blob.encode = [](DatasetWriterBytes &encoded) {
+            encoded.storage = blobBytes(0, 0);
+            return true;
+        };
+        failing.blobs.push_back(std::move(blob));
+    }
+    failing.written = [&failedCallbacks]() {
+        failedCallbacks++;
+        return true;
+    };
+    writer.submit(failing);
+    bool failedFlush = !writer.flush();
+    bool noLeftover = !fileExists(root + "/missing/.failing.bin.partial") && !fileExists(root + "/.failing.bin.partial");
+    check(failedFlush && failedCallbacks == 0 && noLeftover, "no callback for a failed file", "flush reports the failure");
+
+    // A callback that fails, such as a CSV row that cannot be added
+    DatasetWriterFrame rowFails;
+    DatasetWriterBlob blob;
+    blob.path = root + "/row_fails.bin";
+    blob.encode = [](DatasetWriterBytes &encoded) {
+        encoded.storage = blobBytes(1, 1);
+        return true;
+    };
+    rowFails.blobs.push_back(std::move(blob));
+    rowFails.written = []() {
+        return false;
+    };
+    writer.submit(rowFails);
+    bool rowFlush = !writer.flush();
+    DatasetWriterCounters counters = writer.counters();
+    std::snprintf(detail, sizeof(detail), "%llu frames written", (unsigned long long)counters.framesWritten);
+    check(rowFlush && counters.framesWritten == uint64_t(frameCount), "failed callback fails the frame", detail);
+    check(writer.flush(), "flush after the failures", "no new failure");
+    writer.close();
+
+    // Every frame waits to finish encoding until the file of the next one is written, so they are written last to first
+    const int orderedCount = 4;
+    std::vector<int> callbackOrder;
+    DatasetWriterConfig orderedConfig;
+    orderedConfig.queueCapacity = orderedCount;
+    orderedConfig.encoderThreads = orderedCount;
+    orderedConfig.batchBlobs = 1;
+    DatasetWriter ordered(orderedConfig);
+    std::vector<std::string> orderedPaths;
+    for (int f = 0; f < orderedCount; f++) {
+        orderedPaths.push_back(root + "/ordered_" + std::to_string(f) + ".bin");
+    }
+    for (int f = 0; f < orderedCount; f++) {
+        DatasetWriterFrame frame;
+        frame.frameId[0] = uint8_t(f);
+        DatasetWriterBlob blob;
+        blob.path = orderedPaths[f];
+        std::string nextPath = f + 1 < orderedCount ? orderedPaths[f + 1] : std::string();
+        blob.encode = [f, nextPath](DatasetWriterBytes &encoded) {
+            bool nextWritten = nextPath.empty() || waitFor([&nextPath] { return fileExists(nextPath); });
+            encoded.storage = blobBytes(f, 0);
+            return nextWritten;
+        };
+        frame.blobs.push_back(std::move(blob));
+        frame.written = [f, &callbackOrder]() {
+            callbackOrder.push_back(f);
+            return true;
+        };
+        ordered.submit(frame);
+    }
+    bool orderedFlush = ordered.flush();
+    bool submissionOrder = callbackOrder.size() == size_t(orderedCount);
+    for (size_t i = 0; submissionOrder && i < callbackOrder.size(); i++) {
+        submissionOrder = callbackOrder[i] == int(i);
+    }
+    std::snprintf(detail, sizeof(detail), "%zu callbacks, files written last to first", callbackOrder.size());
+    check(orderedFlush && submissionOrder, "callbacks in submission order", detail);
+    ordered.close();
+
+    // The queue holds two frames, so the second of four is dropped to make room for the fourth while the first is encoded
+    callbackOrder.clear();
+    std::atomic<bool> encoding(false);
+    std::atomic<bool> release(false);
+    DatasetWriterConfig dropConfig;
+    dropConfig.queueCapacity = 2;
+    dropConfig.encoderThreads = 1;
+    dropConfig.overflow = DatasetWriterOverflow::DropOldest;
+    DatasetWriter dropping(dropConfig);
+    for (int f = 0; f < 4; f++) {
+        DatasetWriterFrame frame;
+        frame.frameId[0] = uint8_t(f);
+        DatasetWriterBlob blob;
+        blob.path = root + "/dropping_" + std::to_string(f) + ".bin";
+        blob.encode = [f, &encoding, &release](DatasetWriterBytes &encoded) {
+            encoding = true;
+            bool released = f != 0 || waitFor([&release] { return release.load(); });
+            encoded.storage = blobBytes(f, 0);
+            return released;
+        };
+        frame.blobs.push_back(std::move(blob));
+        frame.written = [f, &callbackOrder]() {
+            callbackOrder.push_back(f);
+            return true;
+        };
+        dropping.submit(frame);
+        if (f == 0) {
+            waitFor([&encoding] { return encoding.load(); });
+        }
+    }
+    release = true;
+    bool droppingFlush = dropping.flush();
+    DatasetWriterCounters dropCounters = dropping.counters();
+    bool skipped = callbackOrder == std::vector<int>({ 0, 2, 3 });
+    std::snprintf(detail, sizeof(detail), "%zu callbacks, %llu frames dropped", callbackOrder.size(),
+                  (unsigned long long)dropCounters.framesDropped);
+    check(droppingFlush && skipped && dropCounters.framesDropped == 1, "dropped frame skipped in order", detail);
+    dropping.close();
+
+    for (const std::string &name : directoryNames(root)) {
+        unlink((root + "/" + name).c_str());
+    }
+    rmdir(directory);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+//
+//  DepthPackingTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "DepthPacking.hpp"
+
+/**
+    Checks that packDepthMillimeters is bit-exact with packDepthMillimetersScalar, on whichever vector path the build selected:
+    random depths, every half-millimeter tie and its neighbours, special values, a sweep of float bit patterns,
+    and every tail length and misalignment of the input. Also checks a few values against their expected millimeters.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+static const char *vectorPath () {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    return "NEON";
+#elif defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+/// Packs the values both ways, and returns the index of the first value that differs, or -1
+static long firstMismatch (const std::vector<float> &depth) {
+    std::vector<uint8_t> packed(2 * depth.size(), 0xAA);
+    std::vector<uint8_t> expected(2 * depth.size(), 0x55);
+    packDepthMillimeters(depth.data(), depth.size(), packed.data());
+    packDepthMillimetersScalar(depth.data(), depth.size(), expected.data());
+    for (size_t i = 0; i < depth.size(); i++) {
+        if (packed[2 * i] != expected[2 * i] || packed[2 * i + 1] != expected[2 * i + 1]) {
+            return static_cast<long>(i);
+        }
+    }
+    return -1;
+}
+
+static void checkValues (const std::string &name, const std::vector<float> &depth) {
+    long mismatch = firstMismatch(depth);
+    char detail[128];
+    if (mismatch < 0) {
+        std::snprintf(detail, sizeof(detail), "%zu values bit-exact", depth.size());
+    } else {
+        std::snprintf(detail, sizeof(detail), "value %ld (%.9g) differs", mismatch, depth[mismatch]);
+    }
+    check(mismatch < 0, name, detail);
+}
+
+static void checkExpected () {
+    const float depth[] = { 0.0f, 1.0f, 0.0005f, 0.0015f, 2.5f, 65.535f, 65.6f, -1.0f,
+                            std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity() };
+    const uint16_t millimeters[] = { 0, 1000, 1, 2, 2500, 65535, 65535, 0, 0, 65535 };
+    const size_t count = sizeof(depth) / sizeof(depth[0]);
+    uint8_t packed[2 * count];
+    packDepthMillimeters(depth, count, packed);
+    bool same = true;
+    for (size_t i = 0; i < count; i++) {
+        same = same && packed[2 * i] == (millimeters[i] >> 8) && packed[2 * i + 1] == (millimeters[i] & 0xFF);
+    }
+    check(same, "expected millimeters", "big-endian, rounded, saturated");
+}
+
+int main () {
+#if defined(__AVX2__) && (defined(__GNUC__) || defined(__clang__))
+    if (!__builtin_cpu_supports("avx2")) {
+        std::printf("SKIP: AVX2 build on a machine without AVX2\n");
+        return 0;
+    }
+#endif
+    std::printf("Vector path: %s\n", vectorPath());
+    checkExpected();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> meters(-5.0f, 80.0f);
+    std::vector<float> depth(1 << 20);
+    for (float &value : depth) {
+        value = meters(random);
+    }
+    checkValues("random depths", depth);
+
+    // Values whose millimeters are exactly halfway between two integers, and the floats on either side of them
+    depth.clear();
+    for (int n = 0; n <= 65535; n++) {
+        float tie = (n + 0.5f) / 1000.0f;
+        depth.push_back(tie);
+        depth.push_back(std::nextafter(tie, 0.0f));
+        depth.push_back(std::nextafter(tie, 100.0f));
+        depth.push_back(n / 1000.0f);
+    }
+    checkValues("half-millimeter ties", depth);
+
+    const float infinity = std::numeric_limits<float>::infinity();
+    depth = { std::numeric_limits<float>::quiet_NaN(), -std::numeric_limits<float>::quiet_NaN(), infinity, -infinity,
+              0.0f, -0.0f, std::numeric_limits<float>::denorm_min(), -std::numeric_limits<float>::denorm_min(),
+              std::numeric_limits<float>::min(), std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+              65.535f, 65.5354f, 65.5355f, 65.5356f, 65.536f, 1e-4f, 4.9e-4f, 5e-4f, 5.1e-4f };
+    // Repeated so that they go through the vector loops, and not only the scalar tail
+    for (int repeat = 0; repeat < 4; repeat++) {
+        depth.insert(depth.end(), depth.begin(), depth.begin() + 20);
+    }
+    checkValues("special values", depth);
+
+    // A sweep of float bit patterns, which includes NaNs with payloads, infinities and every exponent
+    depth.clear();
+    for (uint64_t bits = 0; bits <= 0xFFFFFFFFull; bits += 4099) {
+        uint32_t pattern = static_cast<uint32_t>(bits);
+        float value;
+        std::memcpy(&value, &pattern, sizeof(value));
+        depth.push_back(value);
+    }
+    checkValues("float bit patterns", depth);
+
+    // Every tail length, and inputs and outputs that are not aligned to the vectors
+    bool tails = true;
+    std::vector<float> source(80);
+    for (float &value : source) {
+        value = meters(random);
+    }
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t count = 0; count + offset <= source.size(); count++) {
+            std::vector<uint8_t> packed(2 * count + 3, 0xAA);
+            std::vector<uint8_t> expected(2 * count, 0x55);
+            packDepthMillimeters(source.data() + offset, count, packed.data() + 1);
+            packDepthMillimetersScalar(source.data() + offset, count, expected.data());
+            tails = tails && std::memcmp(packed.data() + 1, expected.data(), 2 * count) == 0 &&
+                    packed[0] == 0xAA && packed[2 * count + 1] == 0xAA && packed[2 * count + 2] == 0xAA;
+        }
+    }
+    check(tails, "tails and misalignment", "counts 0 to 80, offsets 0 to 7, no writes past the output");
+    return failures == 0 ? 0 : 1;
+}
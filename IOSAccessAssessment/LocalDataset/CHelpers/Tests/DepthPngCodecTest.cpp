@@ -0,0 +1,193 @@
+//
+//  DepthPngCodecTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "DepthCodecBenchmark.hpp"
+#include "DepthPacking.hpp"
+#include "DepthPngCodec.hpp"
+#include "LodePngZlib.hpp"
+
+/**
+    Checks the depth PNG codec against lodepng, both ways, at several sizes, filters and thread counts;
+    the region decoder against the full decoder; and that headers with sizes no depth image has, truncated files
+    and buffers that are too small are refused before anything is allocated or written.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+static std::vector<uint8_t> packedSamples (const std::vector<float> &depth) {
+    std::vector<uint8_t> samples(depth.size() * 2);
+    packDepthMillimeters(depth.data(), depth.size(), samples.data());
+    return samples;
+}
+
+/// The meters that the decoders give for the samples
+static std::vector<float> samplesInMeters (const std::vector<uint8_t> &samples) {
+    std::vector<float> meters(samples.size() / 2);
+    for (size_t i = 0; i < meters.size(); i++) {
+        meters[i] = ((uint16_t(samples[2 * i]) << 8) | samples[2 * i + 1]) / 1000.0f;
+    }
+    return meters;
+}
+
+static bool lodepngDecode (const std::vector<uint8_t> &png, std::vector<uint8_t> &samples, unsigned &width, unsigned &height) {
+    lodepng::State state;
+    state.info_raw.colortype = LCT_GREY;
+    state.info_raw.bitdepth = 16;
+    configureZlibBackend(state.decoder.zlibsettings);
+    return lodepng::decode(samples, width, height, state, png.data(), png.size()) == 0;
+}
+
+static bool lodepngEncode (const std::vector<uint8_t> &samples, int width, int height, std::vector<uint8_t> &png) {
+    lodepng::State state;
+    state.info_raw.colortype = LCT_GREY;
+    state.info_raw.bitdepth = 16;
+    state.info_png.color.colortype = LCT_GREY;
+    state.info_png.color.bitdepth = 16;
+    state.encoder.auto_convert = 0;
+    configureZlibBackend(state.encoder.zlibsettings, &defaultPngCompressionLevel);
+    png.clear();
+    return lodepng::encode(png, samples.data(), unsigned(width), unsigned(height), state) == 0;
+}
+
+static void checkRoundTrips (int width, int height) {
+    std::vector<uint8_t> samples = packedSamples(syntheticDepthFrame(width, height));
+    std::vector<float> expected = samplesInMeters(samples);
+    std::vector<float> decoded(expected.size());
+    DepthBuffer buffer { decoded.data(), 0, decoded.size() * sizeof(float) };
+    char name[64];
+    char detail[128];
+
+    // Ours to lodepng and to ours, with both filters and with stripes on several threads
+    bool lossless = true;
+    std::vector<uint8_t> png;
+    for (DepthPngFilter filter : { DepthPngFilter::Up, DepthPngFilter::Paeth }) {
+        for (unsigned threads : { 1u, 2u, 4u }) {
+            int decodedWidth = 0;
+            int decodedHeight = 0;
+            std::fill(decoded.begin(), decoded.end(), -1.0f);
+            lossless = lossless && encodeGreyPng(samples.data(), width, height, 16, filter, defaultPngCompressionLevel, threads, png)
+                && decodeDepthPng(png.data(), png.size(), buffer, decodedWidth, decodedHeight) == DepthPngStatus::Ok
+                && decodedWidth == width && decodedHeight == height && decoded == expected;
+            std::vector<uint8_t> lodepngSamples;
+            unsigned lodepngWidth = 0;
+            unsigned lodepngHeight = 0;
+            lossless = lossless && lodepngDecode(png, lodepngSamples, lodepngWidth, lodepngHeight) && lodepngSamples == samples;
+        }
+    }
+    std::snprintf(name, sizeof(name), "%dx%d encoder", width, height);
+    std::snprintf(detail, sizeof(detail), "Up and Paeth, 1, 2 and 4 threads, read back by both decoders");
+    check(lossless, name, detail);
+
+    // lodepng to ours: lodepng picks a filter per row, so every filter type gets decoded
+    int decodedWidth = 0;
+    int decodedHeight = 0;
+    std::fill(decoded.begin(), decoded.end(), -1.0f);
+    bool read = lodepngEncode(samples, width, height, png)
+        && decodeDepthPng(png.data(), png.size(), buffer, decodedWidth, decodedHeight) == DepthPngStatus::Ok
+        && decoded == expected;
+    std::snprintf(name, sizeof(name), "%dx%d decoder", width, height);
+    check(read, name, "reads lodepng's adaptive filters");
+
+    // A region in the middle of the frame, into rows with padding
+    DepthRegion region;
+    region.x = width / 3;
+    region.y = height / 4;
+    region.width = width / 2 + 1;
+    region.height = height / 2 + 1;
+    const size_t bytesPerRow = (region.width + 3) * sizeof(float);
+    std::vector<float> regionDepth(bytesPerRow / sizeof(float) * region.height);
+    DepthBuffer regionBuffer { regionDepth.data(), bytesPerRow, regionDepth.size() * sizeof(float) };
+    bool regionMatches = decodeDepthPngRegion(png.data(), png.size(), region, regionBuffer, decodedWidth, decodedHeight)
+        == DepthPngStatus::Ok;
+    for (int y = 0; regionMatches && y < region.height; y++) {
+        const float *row = regionBuffer.row(y, region.width);
+        regionMatches = std::memcmp(row, expected.data() + size_t(region.y + y) * width + region.x,
+                                    region.width * sizeof(float)) == 0;
+    }
+    std::snprintf(name, sizeof(name), "%dx%d region", width, height);
+    check(regionMatches, name, "padded rows, same as the full decode");
+}
+
+/// A PNG header of the given size, with a valid CRC, followed by an empty image data chunk and the end chunk
+static std::vector<uint8_t> headerOnlyPng (uint32_t width, uint32_t height) {
+    std::vector<uint8_t> png = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    auto chunk = [&](const char *type, const std::vector<uint8_t> &data) {
+        uint32_t length = uint32_t(data.size());
+        for (int shift = 24; shift >= 0; shift -= 8) png.push_back(uint8_t(length >> shift));
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        uint32_t crc = uint32_t(crc32(0L, png.data() + start, uInt(png.size() - start)));
+        for (int shift = 24; shift >= 0; shift -= 8) png.push_back(uint8_t(crc >> shift));
+    };
+    std::vector<uint8_t> header;
+    for (uint32_t value : { width, height }) {
+        for (int shift = 24; shift >= 0; shift -= 8) header.push_back(uint8_t(value >> shift));
+    }
+    header.insert(header.end(), { 16, 0, 0, 0, 0 });
+    chunk("IHDR", header);
+    chunk("IDAT", {});
+    chunk("IEND", {});
+    return png;
+}
+
+static void checkUntrustedSizes () {
+    size_t bytes = 0;
+    bool limits = depthImageBytes(1920, 1440, bytes) && bytes == size_t(1920) * 1440 * sizeof(float)
+        && depthImageBytes(maxDepthImageSide, maxDepthImageSide, bytes)
+        && !depthImageBytes(0, 10, bytes) && !depthImageBytes(10, -1, bytes)
+        && !depthImageBytes(maxDepthImageSide + 1, 1, bytes) && !depthImageBytes(1, maxDepthImageSide + 1, bytes)
+        && !depthImageBytes(INT32_MAX, INT32_MAX, bytes);
+    check(limits, "image bytes", "positive sides up to maxDepthImageSide");
+
+    // The decoder refuses the size before it allocates its rows, even though the header itself is valid
+    float sample = 0;
+    DepthBuffer buffer { &sample, 0, sizeof(sample) };
+    std::vector<uint8_t> huge = headerOnlyPng(0x7FFFFFFF, 0x7FFFFFFF);
+    int width = 0;
+    int height = 0;
+    bool headerValid = readPngSize(huge.data(), huge.size(), width, height);
+    bool refused = decodeDepthPng(huge.data(), huge.size(), buffer, width, height) == DepthPngStatus::Corrupt;
+    DepthRegion region { 0, 0, 1, 1 };
+    refused = refused && decodeDepthPngRegion(huge.data(), huge.size(), region, buffer, width, height) == DepthPngStatus::Corrupt;
+    check(headerValid && refused, "huge header", "2147483647x2147483647 refused");
+
+    // Files cut before the end of their image data, and a buffer that is too small for the image
+    std::vector<uint8_t> samples = packedSamples(syntheticDepthFrame(64, 48));
+    std::vector<uint8_t> png;
+    encodeDepthPng(samples.data(), 64, 48, DepthPngFilter::Up, defaultPngCompressionLevel, png);
+    std::vector<float> decoded(64 * 48, -1.0f);
+    DepthBuffer full { decoded.data(), 0, decoded.size() * sizeof(float) };
+    bool truncated = true;
+    // The end chunk takes the last 12 bytes, and the CRC of the image data the 4 before them
+    for (size_t size : { size_t(0), size_t(8), size_t(33), png.size() / 2, png.size() - 12 - 1 }) {
+        truncated = truncated && decodeDepthPng(png.data(), size, full, width, height) != DepthPngStatus::Ok;
+    }
+    check(truncated, "truncated files", "never decoded");
+    DepthBuffer small { decoded.data(), 0, decoded.size() * sizeof(float) - 1 };
+    check(decodeDepthPng(png.data(), png.size(), small, width, height) == DepthPngStatus::Corrupt, "small buffer", "refused");
+}
+
+int main () {
+    const int sizes[][2] = { { 1, 1 }, { 3, 7 }, { 97, 131 }, { 256, 192 }, { 1920, 1440 } };
+    for (const auto &size : sizes) {
+        checkRoundTrips(size[0], size[1]);
+    }
+    checkUntrustedSizes();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,366 @@
+//
+//  DepthRansCodecTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "DepthCodecBenchmark.hpp"
+#include "DepthPacking.hpp"
+#include "DepthRansCodec.hpp"
+
+/**
+    Checks that the rANS depth codec round trips the millimeters of packDepthMillimeters bit-exactly, on synthetic and random
+    frames, on frames of a single row or column and on heights that are not a multiple of the rows per block;
+    that the region decoder gives the same depth as the full decoder; and that sizes no depth image has, truncated files,
+    flipped bits and buffers that are too small are all reported as corrupt, without crashing.
+    Files with a confidence plane are checked to round trip both planes, whole and by region, to decode with the depth-only
+    functions, and to refuse a confidence buffer that is too small.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+static std::vector<uint8_t> packedSamples (const std::vector<float> &depth) {
+    std::vector<uint8_t> samples(depth.size() * 2);
+    packDepthMillimeters(depth.data(), depth.size(), samples.data());
+    return samples;
+}
+
+/// The meters that the decoder gives for the samples
+static std::vector<float> samplesInMeters (const std::vector<uint8_t> &samples) {
+    std::vector<float> meters(samples.size() / 2);
+    for (size_t i = 0; i < meters.size(); i++) {
+        meters[i] = ((uint16_t(samples[2 * i]) << 8) | samples[2 * i + 1]) / 1000.0f;
+    }
+    return meters;
+}
+
+/// A synthetic frame with the values that the packing maps to the ends of its range: 0, NaN, infinities and saturation
+static std::vector<float> frameWithEdgeValues (int width, int height, uint32_t seed) {
+    std::vector<float> depth = syntheticDepthFrame(width, height, seed);
+    const float edgeValues[] = {
+        0.0f, -0.0f, -1.0f, std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+        -std::numeric_limits<float>::infinity(), 65.535f, 65.536f, 1e30f, 0.0004f, 0.0005f
+    };
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<size_t> position(0, depth.size() - 1);
+    for (size_t i = 0; i < depth.size() / 50 + 1; i++) {
+        depth[position(random)] = edgeValues[i % (sizeof(edgeValues) / sizeof(edgeValues[0]))];
+    }
+    return depth;
+}
+
+/// Any 16-bit samples, with no structure for the predictor to find
+static std::vector<uint8_t> randomSamples (int width, int height, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> samples(size_t(width) * height * 2);
+    for (uint8_t &sample : samples) {
+        sample = uint8_t(byte(random));
+    }
+    return samples;
+}
+
+static bool decodesTo (const std::vector<uint8_t> &file, int width, int height, const std::vector<float> &expected) {
+    std::vector<float> decoded(expected.size(), -1.0f);
+    DepthBuffer buffer { decoded.data(), 0, decoded.size() * sizeof(float) };
+    int decodedWidth = 0;
+    int decodedHeight = 0;
+    return decodeDepthRans(file.data(), file.size(), buffer, decodedWidth, decodedHeight) == DepthRansStatus::Ok
+        && decodedWidth == width && decodedHeight == height
+        && std::memcmp(decoded.data(), expected.data(), expected.size() * sizeof(float)) == 0;
+}
+
+static void checkRoundTrips (int width, int height, int rowsPerBlock) {
+    char name[64];
+    char detail[128];
+    std::vector<uint8_t> file;
+
+    std::vector<uint8_t> samples = packedSamples(frameWithEdgeValues(width, height, uint32_t(width * 31 + height)));
+    std::vector<float> expected = samplesInMeters(samples);
+    bool lossless = encodeDepthRans(samples.data(), width, height, rowsPerBlock, file) && decodesTo(file, width, height, expected);
+    DepthRansHeader header;
+    lossless = lossless && readDepthRansHeader(file.data(), file.size(), header) == DepthRansStatus::Ok
+        && header.width == width && header.height == height && header.rowsPerBlock == rowsPerBlock
+        && header.unitsPerMeter == depthRansUnitsPerMeter && !header.hasConfidence;
+    std::snprintf(name, sizeof(name), "%dx%d, %d rows per block", width, height, rowsPerBlock);
+    std::snprintf(detail, sizeof(detail), "synthetic frame with 0, NaN, infinities and saturation, %zu bytes", file.size());
+    check(lossless, name, detail);
+
+    std::vector<uint8_t> random = randomSamples(width, height, uint32_t(width + height));
+    std::vector<float> randomExpected = samplesInMeters(random);
+    bool randomLossless = encodeDepthRans(random.data(), width, height, rowsPerBlock, file)
+        && decodesTo(file, width, height, randomExpected);
+    std::snprintf(name, sizeof(name), "%dx%d random samples", width, height);
+    check(randomLossless, name, "the whole 16-bit range");
+
+    // A region across a block boundary, into rows with padding, and one that reaches past the image
+    encodeDepthRans(samples.data(), width, height, rowsPerBlock, file);
+    bool regionMatches = true;
+    DepthRegion regions[] = {
+        { width / 3, height / 4, width / 2 + 1, height / 2 + 1 },
+        { width - 1, height - 1, 5, 5 },
+        { -3, -2, width + 6, 3 }
+    };
+    for (DepthRegion region : regions) {
+        DepthRegion requested = region;
+        const size_t bytesPerRow = (size_t(std::max(region.width, 1)) + 3) * sizeof(float);
+        std::vector<float> regionDepth(bytesPerRow / sizeof(float) * size_t(std::max(region.height, 1)));
+        DepthBuffer regionBuffer { regionDepth.data(), bytesPerRow, regionDepth.size() * sizeof(float) };
+        int decodedWidth = 0;
+        int decodedHeight = 0;
+        regionMatches = regionMatches
+            && decodeDepthRansRegion(file.data(), file.size(), region, regionBuffer, decodedWidth, decodedHeight)
+                == DepthRansStatus::Ok
+            && region.x == std::max(requested.x, 0) && region.y == std::max(requested.y, 0)
+            && region.x + region.width == std::min(requested.x + requested.width, width)
+            && region.y + region.height == std::min(requested.y + requested.height, height);
+        for (int y = 0; regionMatches && y < region.height; y++) {
+            const float *row = regionBuffer.row(y, region.width);
+            regionMatches = std::memcmp(row, expected.data() + size_t(region.y + y) * width + region.x,
+                                        region.width * sizeof(float)) == 0;
+        }
+    }
+    std::snprintf(name, sizeof(name), "%dx%d region", width, height);
+    check(regionMatches, name, "clipped, padded rows, same as the full decode");
+}
+
+/// A confidence map like the one of ARKit (0, 1 or 2) in most of the frame, and any byte in its last rows
+static std::vector<uint8_t> confidenceMap (int width, int height, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> level(0, 2);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> confidence(size_t(width) * height);
+    for (size_t i = 0; i < confidence.size(); i++) {
+        confidence[i] = uint8_t(i < confidence.size() * 3 / 4 ? level(random) : byte(random));
+    }
+    return confidence;
+}
+
+static void checkConfidence (int width, int height, int rowsPerBlock) {
+    char name[64];
+    std::vector<uint8_t> samples = packedSamples(frameWithEdgeValues(width, height, uint32_t(width + 7 * height)));
+    std::vector<float> expected = samplesInMeters(samples);
+    std::vector<uint8_t> confidence = confidenceMap(width, height, uint32_t(width * height));
+    std::vector<uint8_t> depthOnly;
+    std::vector<uint8_t> file;
+    encodeDepthRans(samples.data(), width, height, rowsPerBlock, depthOnly);
+    bool encoded = encodeDepthRans(samples.data(), confidence.data(), width, height, rowsPerBlock, file);
+
+    std::vector<uint8_t> withoutMap;
+    bool sameFile = encodeDepthRans(samples.data(), nullptr, width, height, rowsPerBlock, withoutMap) && withoutMap == depthOnly;
+    std::snprintf(name, sizeof(name), "%dx%d without confidence", width, height);
+    check(sameFile, name, "a null map gives the depth-only file");
+
+    DepthRansHeader header;
+    bool flags = encoded && readDepthRansHeader(file.data(), file.size(), header) == DepthRansStatus::Ok && header.hasConfidence
+        && readDepthRansHeader(depthOnly.data(), depthOnly.size(), header) == DepthRansStatus::Ok && !header.hasConfidence;
+    std::snprintf(name, sizeof(name), "%dx%d hasConfidence", width, height);
+    check(flags, name, "set only for files with a confidence plane");
+
+    // Both planes in one pass, into rows with padding
+    std::vector<float> decoded(expected.size(), -1.0f);
+    DepthBuffer buffer { decoded.data(), 0, decoded.size() * sizeof(float) };
+    const size_t confidenceBytesPerRow = size_t(width) + 5;
+    std::vector<uint8_t> decodedConfidence(confidenceBytesPerRow * height, 0xEE);
+    ConfidenceBuffer confidenceBuffer { decodedConfidence.data(), confidenceBytesPerRow, decodedConfidence.size() };
+    int decodedWidth = 0;
+    int decodedHeight = 0;
+    bool lossless = decodeDepthRans(file.data(), file.size(), buffer, &confidenceBuffer, decodedWidth, decodedHeight)
+        == DepthRansStatus::Ok && decodedWidth == width && decodedHeight == height && decoded == expected;
+    for (int y = 0; lossless && y < height; y++) {
+        lossless = std::memcmp(confidenceBuffer.row(y, width), confidence.data() + size_t(y) * width, width) == 0;
+    }
+    std::snprintf(name, sizeof(name), "%dx%d depth and confidence", width, height);
+    check(lossless, name, "both planes, padded confidence rows");
+
+    // The depth-only functions skip the confidence plane
+    bool depthRead = decodesTo(file, width, height, expected);
+    DepthRegion region { width / 4, height / 3, width / 2 + 1, height / 2 + 1 };
+    std::vector<float> regionDepth(size_t(region.width) * region.height);
+    DepthBuffer regionBuffer { regionDepth.data(), 0, regionDepth.size() * sizeof(float) };
+    depthRead = depthRead && decodeDepthRansRegion(file.data(), file.size(), region, regionBuffer, decodedWidth, decodedHeight)
+        == DepthRansStatus::Ok;
+    for (int y = 0; depthRead && y < region.height; y++) {
+        depthRead = std::memcmp(regionBuffer.row(y, region.width), expected.data() + size_t(region.y + y) * width + region.x,
+                                region.width * sizeof(float)) == 0;
+    }
+    std::snprintf(name, sizeof(name), "%dx%d depth-only decode", width, height);
+    check(depthRead, name, "whole and by region, of a file with confidence");
+
+    // The confidence of a region comes from the same blocks as its depth
+    region = { width / 4, height / 3, width / 2 + 1, height / 2 + 1 };
+    std::vector<uint8_t> regionConfidence(size_t(region.width) * region.height);
+    ConfidenceBuffer regionConfidenceBuffer { regionConfidence.data(), 0, regionConfidence.size() };
+    bool regionRead = decodeDepthRansRegion(file.data(), file.size(), region, regionBuffer, &regionConfidenceBuffer,
+                                            decodedWidth, decodedHeight) == DepthRansStatus::Ok;
+    for (int y = 0; regionRead && y < region.height; y++) {
+        regionRead = std::memcmp(regionConfidenceBuffer.row(y, region.width),
+                                 confidence.data() + size_t(region.y + y) * width + region.x, region.width) == 0;
+    }
+    std::snprintf(name, sizeof(name), "%dx%d confidence region", width, height);
+    check(regionRead, name, "same as the full decode");
+
+    // A confidence buffer one byte short is refused before anything is written
+    std::fill(decodedConfidence.begin(), decodedConfidence.end(), 0xEE);
+    std::fill(decoded.begin(), decoded.end(), -1.0f);
+    ConfidenceBuffer small { decodedConfidence.data(), 0, size_t(width) * height - 1 };
+    bool refused = decodeDepthRans(file.data(), file.size(), buffer, &small, decodedWidth, decodedHeight)
+        == DepthRansStatus::Corrupt
+        && std::all_of(decodedConfidence.begin(), decodedConfidence.end(), [](uint8_t value) { return value == 0xEE; })
+        && std::all_of(decoded.begin(), decoded.end(), [](float value) { return value == -1.0f; });
+    std::snprintf(name, sizeof(name), "%dx%d small confidence buffer", width, height);
+    check(refused, name, "refused, nothing written");
+
+    // A file without a confidence plane decodes its depth and leaves the confidence buffer untouched
+    bool untouched = decodeDepthRans(depthOnly.data(), depthOnly.size(), buffer, &confidenceBuffer, decodedWidth, decodedHeight)
+        == DepthRansStatus::Ok && decoded == expected
+        && std::all_of(decodedConfidence.begin(), decodedConfidence.end(), [](uint8_t value) { return value == 0xEE; });
+    std::snprintf(name, sizeof(name), "%dx%d no confidence plane", width, height);
+    check(untouched, name, "depth decoded, confidence buffer untouched");
+}
+
+static void checkPredictor () {
+    // A tilted plane leaves the median edge detector only the rounding of the millimeters, which costs next to nothing
+    const int width = 256;
+    const int height = 192;
+    std::vector<float> plane(size_t(width) * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            plane[size_t(y) * width + x] = 1.0f + 0.003f * x + 0.011f * y;
+        }
+    }
+    std::vector<uint8_t> samples = packedSamples(plane);
+    std::vector<uint8_t> file;
+    bool small = encodeDepthRans(samples.data(), width, height, defaultDepthRansRowsPerBlock, file)
+        && decodesTo(file, width, height, samplesInMeters(samples)) && file.size() * 20 < samples.size();
+    char detail[128];
+    std::snprintf(detail, sizeof(detail), "%zu bytes for %zu bytes of samples", file.size(), samples.size());
+    check(small, "tilted plane", detail);
+}
+
+/// Writes the fields of a header over the one of a file, with a valid CRC, so that only the fields are wrong
+static void rewriteHeader (std::vector<uint8_t> &file, uint8_t version, uint8_t flags, uint32_t width, uint32_t height) {
+    file[4] = version;
+    file[5] = flags;
+    for (int i = 0; i < 4; i++) {
+        file[8 + i] = uint8_t(width >> (8 * i));
+        file[12 + i] = uint8_t(height >> (8 * i));
+    }
+    uint32_t crc = uint32_t(crc32(0L, file.data(), 20));
+    for (int i = 0; i < 4; i++) {
+        file[20 + i] = uint8_t(crc >> (8 * i));
+    }
+}
+
+static void checkUntrustedInput () {
+    std::vector<uint8_t> file;
+    std::vector<uint8_t> sample(2 * size_t(maxDepthImageSide + 1), 0);
+    bool refused = !encodeDepthRans(sample.data(), 0, 1, 32, file) && !encodeDepthRans(sample.data(), 1, -1, 32, file)
+        && !encodeDepthRans(sample.data(), maxDepthImageSide + 1, 1, 32, file)
+        && !encodeDepthRans(sample.data(), 1, maxDepthImageSide + 1, 32, file)
+        && !encodeDepthRans(sample.data(), 1, 1, 0, file) && !encodeDepthRans(sample.data(), 1, 1, 0x10000, file);
+    check(refused, "encoder sizes", "sides up to maxDepthImageSide, rows per block up to 65535");
+
+    const int width = 23;
+    const int height = 19;
+    std::vector<uint8_t> samples = packedSamples(frameWithEdgeValues(width, height, 7));
+    std::vector<uint8_t> valid;
+    encodeDepthRans(samples.data(), width, height, 8, valid);
+    std::vector<float> decoded(size_t(width) * height);
+    DepthBuffer buffer { decoded.data(), 0, decoded.size() * sizeof(float) };
+    int decodedWidth = 0;
+    int decodedHeight = 0;
+
+    // Headers with a valid CRC: sizes no depth image has are refused before they are reported to anyone who would allocate
+    DepthRansHeader header;
+    header.width = -1;
+    bool sizes = true;
+    const uint32_t badSides[][2] = {
+        { 0, 19 }, { 23, 0 }, { uint32_t(maxDepthImageSide) + 1, 19 }, { 23, uint32_t(maxDepthImageSide) + 1 },
+        { 0x7FFFFFFF, 0x7FFFFFFF }, { 0xFFFFFFFF, 0xFFFFFFFF }
+    };
+    for (const auto &sides : badSides) {
+        file = valid;
+        rewriteHeader(file, depthRansVersion, 0, sides[0], sides[1]);
+        sizes = sizes && readDepthRansHeader(file.data(), file.size(), header) == DepthRansStatus::Corrupt && header.width == -1
+            && decodeDepthRans(file.data(), file.size(), buffer, decodedWidth, decodedHeight) == DepthRansStatus::Corrupt;
+    }
+    check(sizes, "header sizes", "refused without filling in the header");
+
+    file = valid;
+    rewriteHeader(file, depthRansVersion + 1, 0, width, height);
+    bool versions = readDepthRansHeader(file.data(), file.size(), header) == DepthRansStatus::Unsupported;
+    rewriteHeader(file, depthRansVersion, 0x80, width, height);
+    versions = versions && readDepthRansHeader(file.data(), file.size(), header) == DepthRansStatus::Unsupported;
+    rewriteHeader(file, 0, 0, width, height);
+    versions = versions && readDepthRansHeader(file.data(), file.size(), header) == DepthRansStatus::Corrupt;
+    check(versions, "versions", "later versions and flags unsupported, version 0 corrupt");
+
+    // Every prefix of the file, and every single bit flipped, which the CRCs of the header and of the blocks catch
+    bool truncated = decodeDepthRans(nullptr, 0, buffer, decodedWidth, decodedHeight) == DepthRansStatus::Corrupt;
+    for (size_t size = 0; size < valid.size(); size++) {
+        truncated = truncated && decodeDepthRans(valid.data(), size, buffer, decodedWidth, decodedHeight) == DepthRansStatus::Corrupt;
+    }
+    char detail[128];
+    std::snprintf(detail, sizeof(detail), "all %zu prefixes corrupt", valid.size());
+    check(truncated, "truncated files", detail);
+
+    bool flipped = true;
+    for (size_t bit = 0; bit < valid.size() * 8; bit++) {
+        file = valid;
+        file[bit / 8] ^= uint8_t(1 << (bit % 8));
+        DepthRegion region { 0, 0, width, height };
+        flipped = flipped && decodeDepthRans(file.data(), file.size(), buffer, decodedWidth, decodedHeight) == DepthRansStatus::Corrupt
+            && decodeDepthRansRegion(file.data(), file.size(), region, buffer, decodedWidth, decodedHeight) == DepthRansStatus::Corrupt;
+    }
+    std::snprintf(detail, sizeof(detail), "all %zu single-bit flips corrupt", valid.size() * 8);
+    check(flipped, "flipped bits", detail);
+
+    // Random bytes behind a valid magic never crash the decoder
+    std::mt19937 random(3);
+    std::uniform_int_distribution<int> byte(0, 255);
+    bool garbage = true;
+    for (int i = 0; i < 1000; i++) {
+        file.assign(size_t(4 + i % 200), 0);
+        for (uint8_t &value : file) {
+            value = uint8_t(byte(random));
+        }
+        std::memcpy(file.data(), "DRNS", 4);
+        garbage = garbage && decodeDepthRans(file.data(), file.size(), buffer, decodedWidth, decodedHeight) == DepthRansStatus::Corrupt;
+    }
+    check(garbage, "random files", "corrupt");
+
+    DepthBuffer small { decoded.data(), 0, decoded.size() * sizeof(float) - 1 };
+    check(decodeDepthRans(valid.data(), valid.size(), small, decodedWidth, decodedHeight) == DepthRansStatus::Corrupt,
+          "small buffer", "refused");
+}
+
+int main () {
+    const int sizes[][3] = {
+        { 1, 1, 32 }, { 1, 97, 32 }, { 97, 1, 32 }, { 64, 33, 32 }, { 64, 65, 32 }, { 37, 5, 1 }, { 256, 192, 32 },
+        { 1920, 1440, defaultDepthRansRowsPerBlock }
+    };
+    for (const auto &size : sizes) {
+        checkRoundTrips(size[0], size[1], size[2]);
+        checkConfidence(size[0], size[1], size[2]);
+    }
+    checkPredictor();
+    checkUntrustedInput();
+    return failures == 0 ? 0 : 1;
+}
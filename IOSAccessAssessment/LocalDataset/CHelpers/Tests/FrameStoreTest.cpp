@@ -0,0 +1,160 @@
+//
+//  FrameStoreTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "FrameStore.hpp"
+
+/**
+    Checks that reopening a finished frame store for writing never shrinks the file or moves its index under a reader
+    that has it mapped (which would make the reader crash on its next access), that the reader keeps seeing the blobs it
+    opened, that blobs appended to a finished store are found once it is finished again, or recovered by the next
+    writer if it never is, and that reopening and finishing a store without appending anything leaves it as it was.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+static size_t fileSize (const std::string &path) {
+    struct stat status;
+    return stat(path.c_str(), &status) == 0 ? size_t(status.st_size) : 0;
+}
+
+static void copyFile (const std::string &from, const std::string &to) {
+    std::ifstream input(from, std::ios::binary);
+    std::ofstream output(to, std::ios::binary | std::ios::trunc);
+    output << input.rdbuf();
+}
+
+/// A blob whose bytes depend on its frame and stream, so that a blob read from the wrong place is noticed
+static std::vector<uint8_t> blobBytes (int frame, uint32_t stream) {
+    std::vector<uint8_t> bytes(1000 + frame * 37 + stream * 11);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        bytes[i] = uint8_t(i * 31 + frame * 7 + stream);
+    }
+    return bytes;
+}
+
+static void frameIdOf (int frame, uint8_t frameId[16]) {
+    std::memset(frameId, 0, 16);
+    frameId[0] = uint8_t(frame + 1);
+}
+
+static bool appendFrames (FrameStoreWriter &writer, int first, int end) {
+    for (int frame = first; frame < end; frame++) {
+        uint8_t frameId[16];
+        frameIdOf(frame, frameId);
+        for (uint32_t stream = 0; stream < 2; stream++) {
+            std::vector<uint8_t> bytes = blobBytes(frame, stream);
+            if (writer.append(frameId, frame * 0.1, stream, "png", bytes.data(), bytes.size()) != FrameStoreStatus::Ok) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// Whether the reader has every blob of the frames, with their bytes, and checksums that match
+static bool hasFrames (const FrameStoreReader &reader, int first, int end) {
+    for (int frame = first; frame < end; frame++) {
+        uint8_t frameId[16];
+        frameIdOf(frame, frameId);
+        for (uint32_t stream = 0; stream < 2; stream++) {
+            long position = reader.find(frameId, stream);
+            if (position < 0) {
+                return false;
+            }
+            FrameStoreEntry entry = reader.entry(size_t(position));
+            FrameStoreBlob blob = reader.blob(entry);
+            std::vector<uint8_t> expected = blobBytes(frame, stream);
+            if (blob.size != expected.size() || std::memcmp(blob.data, expected.data(), blob.size) != 0 || !reader.verify(entry)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main () {
+    char directory[] = "/tmp/frame_store_test_XXXXXX";
+    if (mkdtemp(directory) == nullptr) {
+        std::printf("FAIL: temporary directory (mkdtemp failed)\n");
+        return 1;
+    }
+    const std::string path = std::string(directory) + "/frames.dfst";
+    const std::string crashPath = std::string(directory) + "/crashed.dfst";
+    char detail[160];
+
+    FrameStoreWriter writer;
+    bool written = writer.open(path) == FrameStoreStatus::Ok && appendFrames(writer, 0, 5) && writer.finish() == FrameStoreStatus::Ok;
+    FrameStoreReader reader;
+    bool opened = written && reader.open(path) == FrameStoreStatus::Ok;
+    check(opened && !reader.recovered() && reader.entryCount() == 10 && hasFrames(reader, 0, 5), "finished store", "5 frames of 2 blobs");
+
+    // A writer reopens the store while the reader still has it mapped
+    const size_t finishedSize = fileSize(path);
+    bool reopened = writer.open(path) == FrameStoreStatus::Ok;
+    const size_t reopenedSize = fileSize(path);
+    bool appended = reopened && appendFrames(writer, 5, 8);
+    std::snprintf(detail, sizeof(detail), "file of %zu bytes, %zu once reopened, %zu entries in the writer",
+                  finishedSize, reopenedSize, writer.entryCount());
+    check(reopened && appended && reopenedSize >= finishedSize && writer.entryCount() == 16, "reopened without truncating", detail);
+    // With the old index dropped and the file truncated, this read of the mapping would crash
+    check(reader.entryCount() == 10 && hasFrames(reader, 0, 5), "mapped reader while appending", "sees the index it opened");
+
+    // A copy of the store as it is before it is finished again, as if the app was closed during the capture
+    copyFile(path, crashPath);
+    bool finished = writer.finish() == FrameStoreStatus::Ok;
+    check(finished && reader.entryCount() == 10 && hasFrames(reader, 0, 5), "mapped reader after finishing", "sees the index it opened");
+    FrameStoreReader updated;
+    bool updatedOpened = updated.open(path) == FrameStoreStatus::Ok;
+    check(updatedOpened && !updated.recovered() && updated.entryCount() == 16 && hasFrames(updated, 0, 8), "finished again",
+          "8 frames in the new index");
+
+    // Reopened and finished with nothing appended, as the import of a dataset that is already in the store does
+    const size_t finishedAgainSize = fileSize(path);
+    bool unchanged = writer.open(path) == FrameStoreStatus::Ok && writer.entryCount() == 16
+        && writer.finish() == FrameStoreStatus::Ok && fileSize(path) == finishedAgainSize;
+    FrameStoreReader unchangedReader;
+    unchanged = unchanged && unchangedReader.open(path) == FrameStoreStatus::Ok && !unchangedReader.recovered()
+        && unchangedReader.entryCount() == 16 && hasFrames(unchangedReader, 0, 8);
+    std::snprintf(detail, sizeof(detail), "file of %zu bytes, %zu after reopen and finish", finishedAgainSize, fileSize(path));
+    check(unchanged, "finished without appends", detail);
+
+    // The copy still has the old index; its writer recovers the blobs that follow the index
+    FrameStoreReader crashed;
+    bool crashedOpened = crashed.open(crashPath) == FrameStoreStatus::Ok;
+    check(crashedOpened && crashed.entryCount() == 10 && hasFrames(crashed, 0, 5), "store not finished again", "old index still valid");
+    FrameStoreWriter recovering;
+    bool recovered = recovering.open(crashPath) == FrameStoreStatus::Ok;
+    std::snprintf(detail, sizeof(detail), "%zu entries in the writer", recovering.entryCount());
+    check(recovered && recovering.entryCount() == 16, "blobs after the old index recovered", detail);
+    recovered = recovered && appendFrames(recovering, 8, 9) && recovering.finish() == FrameStoreStatus::Ok;
+    FrameStoreReader recoveredReader;
+    check(recovered && recoveredReader.open(crashPath) == FrameStoreStatus::Ok && recoveredReader.entryCount() == 18 &&
+          hasFrames(recoveredReader, 0, 9), "recovered store finished", "9 frames in the new index");
+
+    reader.close();
+    updated.close();
+    unchangedReader.close();
+    crashed.close();
+    recoveredReader.close();
+    unlink(path.c_str());
+    unlink(crashPath.c_str());
+    rmdir(directory);
+    return failures == 0 ? 0 : 1;
+}
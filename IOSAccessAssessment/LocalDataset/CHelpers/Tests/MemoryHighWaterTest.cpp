@@ -0,0 +1,130 @@
+//
+//  MemoryHighWaterTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "DepthCodecBenchmark.hpp"
+#include "DepthPacking.hpp"
+#include "DepthPngCodec.hpp"
+#include "LodePngZlib.hpp"
+
+/**
+    Checks the memory high-water mark of the depth PNG decoders, when they write into a caller-owned DepthBuffer:
+    the peak of the heap bytes that are live during a decode must not depend on the height of the frame, and must stay
+    well under a frame of 16-bit samples, so no full-frame intermediate is ever allocated.
+
+    Live bytes are tracked by replacing the global operator new, with the size of every block kept in front of it.
+    The decoder allocates the state of zlib through operator new too, so the whole decode is counted.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+/// Room in front of every block for its size, which keeps the block aligned for any type
+static const size_t blockHeader = alignof(std::max_align_t);
+
+void *operator new (std::size_t size) {
+    unsigned char *block = static_cast<unsigned char *>(std::malloc(size + blockHeader));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t *>(block) = size;
+    liveBytes += size;
+    peakBytes = std::max(peakBytes, liveBytes);
+    return block + blockHeader;
+}
+
+void operator delete (void *pointer) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    unsigned char *block = static_cast<unsigned char *>(pointer) - blockHeader;
+    liveBytes -= *reinterpret_cast<size_t *>(block);
+    std::free(block);
+}
+
+void operator delete (void *pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
+
+/// Peak of the live heap bytes while a decode runs, over what was live before it
+template <typename Decode>
+static size_t decodePeakBytes (const Decode &decode) {
+    size_t before = liveBytes;
+    peakBytes = liveBytes;
+    decode();
+    return peakBytes - before;
+}
+
+int main () {
+    // Frames of the same width and growing heights, for both the filter that the encoder uses and the most costly one
+    const int sizes[][2] = { { 256, 16 }, { 256, 192 }, { 1920, 16 }, { 1920, 1440 } };
+    std::vector<size_t> peaks;
+    for (DepthPngFilter filter : { DepthPngFilter::Up, DepthPngFilter::Paeth }) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            const int width = sizes[s][0];
+            const int height = sizes[s][1];
+            std::vector<float> depth = syntheticDepthFrame(width, height);
+            std::vector<uint8_t> samples(depth.size() * 2);
+            packDepthMillimeters(depth.data(), depth.size(), samples.data());
+            std::vector<uint8_t> png;
+            encodeGreyPng(samples.data(), width, height, 16, filter, defaultPngCompressionLevel, 1, png);
+
+            // The output is owned by the caller, as the base address of a CVPixelBuffer is
+            std::vector<float> decoded(depth.size());
+            DepthBuffer output { decoded.data(), 0, decoded.size() * sizeof(float) };
+            int decodedWidth = 0;
+            int decodedHeight = 0;
+            DepthPngStatus status = DepthPngStatus::Corrupt;
+            size_t peak = decodePeakBytes([&]() {
+                status = decodeDepthPng(png.data(), png.size(), output, decodedWidth, decodedHeight);
+            });
+            DepthRegion region { width / 4, height / 4, width / 2, height / 2 };
+            std::vector<float> regionDecoded(size_t(region.width) * size_t(region.height));
+            DepthBuffer regionOutput { regionDecoded.data(), 0, regionDecoded.size() * sizeof(float) };
+            DepthPngStatus regionStatus = DepthPngStatus::Corrupt;
+            size_t regionPeak = decodePeakBytes([&]() {
+                regionStatus = decodeDepthPngRegion(png.data(), png.size(), region, regionOutput, decodedWidth, decodedHeight);
+            });
+            peaks.push_back(std::max(peak, regionPeak));
+
+            // Two rows, with their filter type bytes, and the inflater with its 32 KB window
+            const size_t frameBytes = samples.size();
+            const size_t rowsBytes = 2 * (size_t(width) * 2 + 1);
+            const size_t bound = rowsBytes + 64 * 1024;
+            char name[96];
+            std::snprintf(name, sizeof(name), "%dx%d %s", width, height, filter == DepthPngFilter::Up ? "Up" : "Paeth");
+            char detail[192];
+            std::snprintf(detail, sizeof(detail), "peak %zu bytes, region peak %zu, bound %zu, frame of samples %zu",
+                          peak, regionPeak, bound, frameBytes);
+            check(status == DepthPngStatus::Ok && regionStatus == DepthPngStatus::Ok && peak <= bound && regionPeak <= bound,
+                  name, detail);
+        }
+    }
+
+    // The same width must peak at the same bytes whatever the height, and the camera frame far below its size
+    bool flat = true;
+    for (size_t i = 0; i + 1 < peaks.size(); i += 2) {
+        flat = flat && peaks[i] == peaks[i + 1];
+    }
+    char detail[128];
+    std::snprintf(detail, sizeof(detail), "1920x1440 peaks at %zu bytes, the frame has %d", peaks[3], 1920 * 1440 * 2);
+    check(flat && peaks[3] * 20 < size_t(1920 * 1440 * 2), "peak does not grow with height", detail);
+    return failures == 0 ? 0 : 1;
+}
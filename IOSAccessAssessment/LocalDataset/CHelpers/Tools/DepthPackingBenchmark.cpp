@@ -0,0 +1,78 @@
+//
+//  DepthPackingBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "DepthPacking.hpp"
+
+/**
+    Times packDepthMillimeters against packDepthMillimetersScalar on depth frames of the LiDAR (256x192)
+    and of the camera (1920x1440), and prints the results as a JSON object.
+    Exits with 1 if the two ever pack a frame differently.
+
+    Usage: depth_packing_benchmark [iterations]
+ */
+typedef std::chrono::steady_clock Clock;
+
+template <typename Run>
+static double fastestMilliseconds (int iterations, const Run &run) {
+    double fastest = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        Clock::time_point start = Clock::now();
+        run();
+        fastest = std::min(fastest, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return fastest;
+}
+
+int main (int argc, char **argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    if (iterations <= 0) {
+        std::fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    const int sizes[][2] = { { 256, 192 }, { 1920, 1440 } };
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> meters(0.0f, 10.0f);
+    bool identical = true;
+    std::string json = "{\"cases\":[";
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const size_t count = size_t(sizes[s][0]) * sizes[s][1];
+        std::vector<float> depth(count);
+        for (float &value : depth) {
+            value = meters(random);
+        }
+        std::vector<uint8_t> scalarOutput(2 * count);
+        std::vector<uint8_t> output(2 * count);
+        double scalarMs = fastestMilliseconds(iterations, [&]() {
+            packDepthMillimetersScalar(depth.data(), count, scalarOutput.data());
+        });
+        double packedMs = fastestMilliseconds(iterations, [&]() {
+            packDepthMillimeters(depth.data(), count, output.data());
+        });
+        bool same = std::memcmp(output.data(), scalarOutput.data(), output.size()) == 0;
+        identical = identical && same;
+
+        char buffer[256];
+        std::snprintf(buffer, sizeof(buffer),
+                      "%s{\"width\":%d,\"height\":%d,\"scalar_ms\":%.4f,\"packed_ms\":%.4f,\"speedup\":%.2f,"
+                      "\"megavalues_per_second\":%.1f,\"bit_exact\":%s}",
+                      s == 0 ? "" : ",", sizes[s][0], sizes[s][1], scalarMs, packedMs, scalarMs / packedMs,
+                      count / 1e3 / packedMs, same ? "true" : "false");
+        json += buffer;
+    }
+    json += "]}";
+    std::printf("%s\n", json.c_str());
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+//
+//  DepthPngBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "DepthCodecBenchmark.hpp"
+#include "DepthPacking.hpp"
+#include "DepthPngCodec.hpp"
+#include "LodePngZlib.hpp"
+
+/**
+    Times the depth PNG codec against lodepng (with the deflate backend of LodePngZlib, as the app configures it)
+    on synthetic depth frames of the LiDAR (256x192) and of the camera (1920x1440), on a single thread, and prints
+    the throughput in megabytes of 16-bit samples per second, and the file sizes, as a JSON object.
+    Both decoders produce float meters. Exits with 1 if a round trip is not lossless.
+
+    Usage: depth_png_benchmark [iterations]
+ */
+typedef std::chrono::steady_clock Clock;
+
+template <typename Run>
+static double fastestMilliseconds (int iterations, const Run &run) {
+    double fastest = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        Clock::time_point start = Clock::now();
+        run();
+        fastest = std::min(fastest, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return fastest;
+}
+
+static std::string codecJSON (const char *name, size_t bytes, double rawMegabytes, double encodeMs, double decodeMs) {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "\"%s\":{\"bytes\":%zu,\"encode_ms\":%.3f,\"decode_ms\":%.3f,\"encode_mb_per_second\":%.1f,"
+                  "\"decode_mb_per_second\":%.1f}",
+                  name, bytes, encodeMs, decodeMs, rawMegabytes * 1000.0 / encodeMs, rawMegabytes * 1000.0 / decodeMs);
+    return buffer;
+}
+
+int main (int argc, char **argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 10;
+    if (iterations <= 0) {
+        std::fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    const int sizes[][2] = { { 256, 192 }, { 1920, 1440 } };
+    bool lossless = true;
+    std::string json = "{\"compression_level\":" + std::to_string(defaultPngCompressionLevel) + ",\"cases\":[";
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const int width = sizes[s][0];
+        const int height = sizes[s][1];
+        std::vector<float> depth = syntheticDepthFrame(width, height);
+        std::vector<uint8_t> samples(depth.size() * 2);
+        packDepthMillimeters(depth.data(), depth.size(), samples.data());
+        const double rawMegabytes = samples.size() / 1e6;
+        std::vector<float> expected(depth.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            expected[i] = ((uint16_t(samples[2 * i]) << 8) | samples[2 * i + 1]) / 1000.0f;
+        }
+
+        std::vector<uint8_t> png;
+        double encodeMs = fastestMilliseconds(iterations, [&]() {
+            encodeDepthPng(samples.data(), width, height, DepthPngFilter::Up, defaultPngCompressionLevel, png);
+        });
+        std::vector<float> decoded(depth.size());
+        DepthBuffer output { decoded.data(), 0, decoded.size() * sizeof(float) };
+        int decodedWidth = 0;
+        int decodedHeight = 0;
+        double decodeMs = fastestMilliseconds(iterations, [&]() {
+            decodeDepthPng(png.data(), png.size(), output, decodedWidth, decodedHeight);
+        });
+        lossless = lossless && decoded == expected;
+        size_t pngBytes = png.size();
+
+        // lodepng, as PngEncoder and PngDecoder used it before the depth codec
+        std::vector<uint8_t> lodepngFile;
+        double lodepngEncodeMs = fastestMilliseconds(iterations, [&]() {
+            lodepng::State state;
+            state.info_raw.colortype = LCT_GREY;
+            state.info_raw.bitdepth = 16;
+            state.info_png.color.colortype = LCT_GREY;
+            state.info_png.color.bitdepth = 16;
+            state.encoder.auto_convert = 0;
+            configureZlibBackend(state.encoder.zlibsettings, &defaultPngCompressionLevel);
+            lodepngFile.clear();
+            lodepng::encode(lodepngFile, samples.data(), unsigned(width), unsigned(height), state);
+        });
+        std::vector<float> lodepngDecoded(depth.size());
+        double lodepngDecodeMs = fastestMilliseconds(iterations, [&]() {
+            lodepng::State state;
+            state.info_raw.colortype = LCT_GREY;
+            state.info_raw.bitdepth = 16;
+            configureZlibBackend(state.decoder.zlibsettings);
+            std::vector<uint8_t> image;
+            unsigned w = 0;
+            unsigned h = 0;
+            if (lodepng::decode(image, w, h, state, lodepngFile.data(), lodepngFile.size()) != 0 || image.size() != samples.size()) {
+                return;
+            }
+            for (size_t i = 0; i < lodepngDecoded.size(); i++) {
+                lodepngDecoded[i] = ((uint16_t(image[2 * i]) << 8) | image[2 * i + 1]) / 1000.0f;
+            }
+        });
+        lossless = lossless && lodepngDecoded == expected;
+
+        char buffer[128];
+        std::snprintf(buffer, sizeof(buffer), "%s{\"width\":%d,\"height\":%d,\"raw_bytes\":%zu,",
+                      s == 0 ? "" : ",", width, height, samples.size());
+        json += buffer;
+        json += codecJSON("depth_png", pngBytes, rawMegabytes, encodeMs, decodeMs) + ",";
+        json += codecJSON("lodepng", lodepngFile.size(), rawMegabytes, lodepngEncodeMs, lodepngDecodeMs);
+        std::snprintf(buffer, sizeof(buffer), ",\"encode_speedup\":%.2f,\"decode_speedup\":%.2f,\"size_ratio\":%.4f}",
+                      lodepngEncodeMs / encodeMs, lodepngDecodeMs / decodeMs, double(pngBytes) / double(lodepngFile.size()));
+        json += buffer;
+    }
+    json += "],\"lossless\":" + std::string(lossless ? "true" : "false") + "}";
+    std::printf("%s\n", json.c_str());
+    return lossless ? 0 : 1;
+}
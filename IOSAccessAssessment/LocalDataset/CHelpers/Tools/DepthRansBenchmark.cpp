@@ -0,0 +1,75 @@
+//
+//  DepthRansBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "DepthCodecBenchmark.hpp"
+#include "DepthPacking.hpp"
+#include "DepthPngCodec.hpp"
+#include "LodePngZlib.hpp"
+
+/**
+    Compares the rANS depth format with the 16-bit PNG path through runDepthCodecBenchmark, as
+    DepthRansEncoder benchmarkWithPngFiles:iterations: does in the app, and prints its JSON.
+    Without files, it runs on synthetic depth frames of the LiDAR (256x192) and of the camera (1920x1440), written as depth PNGs;
+    with files, on the depth PNGs of a dataset.
+    Exits with 1 if a round trip is not lossless, or if the rANS files are not smaller than the PNGs in total.
+
+    Usage: depth_rans_benchmark [iterations] [depth.png ...]
+ */
+static bool readFile (const char *path, std::vector<uint8_t> &contents) {
+    FILE *file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    contents.clear();
+    uint8_t buffer[1 << 16];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.insert(contents.end(), buffer, buffer + read);
+    }
+    bool complete = std::ferror(file) == 0;
+    std::fclose(file);
+    return complete;
+}
+
+int main (int argc, char **argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+    if (iterations <= 0) {
+        std::fprintf(stderr, "Usage: %s [iterations] [depth.png ...]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::vector<uint8_t>> pngFiles;
+    for (int i = 2; i < argc; i++) {
+        pngFiles.emplace_back();
+        if (!readFile(argv[i], pngFiles.back())) {
+            std::fprintf(stderr, "Could not read %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (pngFiles.empty()) {
+        const int sizes[][3] = { { 256, 192, 1 }, { 256, 192, 2 }, { 256, 192, 3 }, { 1920, 1440, 1 } };
+        for (const auto &size : sizes) {
+            std::vector<float> depth = syntheticDepthFrame(size[0], size[1], uint32_t(size[2]));
+            std::vector<uint8_t> samples(depth.size() * 2);
+            packDepthMillimeters(depth.data(), depth.size(), samples.data());
+            pngFiles.emplace_back();
+            encodeDepthPng(samples.data(), size[0], size[1], DepthPngFilter::Up, defaultPngCompressionLevel, pngFiles.back());
+        }
+    }
+
+    std::string json = runDepthCodecBenchmark(pngFiles, iterations);
+    std::printf("%s\n", json.c_str());
+    bool lossless = json.find("\"lossless\":false") == std::string::npos;
+    const char *ratio = std::strstr(json.c_str(), "\"rans_size_ratio\":");
+    bool smaller = ratio != nullptr && std::strtod(ratio + std::strlen("\"rans_size_ratio\":"), nullptr) < 1.0;
+    return lossless && smaller ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+//
+//  PngStripeBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DepthCodecBenchmark.hpp"
+#include "DepthPacking.hpp"
+#include "DepthPngCodec.hpp"
+#include "LodePngZlib.hpp"
+
+/**
+    Times the striped encoding of encodeGreyPng for every thread count from 1 to maxThreads, on synthetic depth frames
+    of the LiDAR (256x192) and of the camera (1920x1440), and on the 8-bit confidence map of the LiDAR, and prints the
+    throughput in megabytes of samples per second, the speedup over one thread and the size overhead of the stripes,
+    as a JSON object.
+
+    The measured speedup only shows what the cores of the machine it runs on allow. Every thread count is also given an
+    estimated speedup, which does not depend on the cores: the time of one thread, over the time of the slowest stripe
+    encoded on its own plus the cost of starting and joining a thread for each other stripe. The recommended thread
+    count of a case is the smallest one whose measured speedup is within 10% of the best.
+    Exits with 1 if a striped file does not decode to the samples it was made from.
+
+    Usage: png_stripe_benchmark [iterations] [maxThreads]
+ */
+typedef std::chrono::steady_clock Clock;
+
+/// Rows of the smallest stripe that encodeGreyPng makes, as in DepthPngCodec.cpp
+static const int minimumStripeRows = 64;
+
+template <typename Run>
+static double fastestMilliseconds (int iterations, const Run &run) {
+    double fastest = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        Clock::time_point start = Clock::now();
+        run();
+        fastest = std::min(fastest, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return fastest;
+}
+
+/// Checks that a PNG decodes to the given samples, with lodepng, as any other decoder would read it
+static bool decodesTo (const std::vector<uint8_t> &png, const std::vector<uint8_t> &samples, int width, int height,
+                       int bitDepth) {
+    std::vector<uint8_t> decoded;
+    unsigned decodedWidth = 0;
+    unsigned decodedHeight = 0;
+    return lodepng::decode(decoded, decodedWidth, decodedHeight, png.data(), png.size(), LCT_GREY, unsigned(bitDepth)) == 0
+        && decodedWidth == unsigned(width) && decodedHeight == unsigned(height) && decoded == samples;
+}
+
+int main (int argc, char **argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 10;
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : int(std::max(std::thread::hardware_concurrency(), 8u));
+    if (iterations <= 0 || maxThreads <= 0) {
+        std::fprintf(stderr, "Usage: %s [iterations] [maxThreads]\n", argv[0]);
+        return 2;
+    }
+
+    // Starting and joining a thread that does nothing, which every stripe but the first pays for
+    std::vector<double> spawns(100);
+    for (double &spawn : spawns) {
+        Clock::time_point start = Clock::now();
+        std::thread([]() {}).join();
+        spawn = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+    std::nth_element(spawns.begin(), spawns.begin() + spawns.size() / 2, spawns.end());
+    const double spawnMs = spawns[spawns.size() / 2];
+
+    struct Case {
+        const char *name;
+        int width;
+        int height;
+        int bitDepth;
+    };
+    const Case cases[] = { { "lidar_depth", 256, 192, 16 }, { "lidar_confidence", 256, 192, 8 },
+                           { "camera_depth", 1920, 1440, 16 } };
+    bool lossless = true;
+    char buffer[512];
+    std::snprintf(buffer, sizeof(buffer), "{\"cores\":%u,\"compression_level\":%d,\"thread_spawn_ms\":%.4f,\"cases\":[",
+                  std::thread::hardware_concurrency(), defaultPngCompressionLevel, spawnMs);
+    std::string json = buffer;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const Case &frame = cases[c];
+        std::vector<float> depth = syntheticDepthFrame(frame.width, frame.height, uint32_t(c + 1));
+        std::vector<uint8_t> samples(depth.size() * 2);
+        packDepthMillimeters(depth.data(), depth.size(), samples.data());
+        if (frame.bitDepth == 8) {
+            // Confidence levels 0 to 2, from the same scene: low where there is no depth, high on the near surfaces
+            for (size_t i = 0; i < depth.size(); i++) {
+                samples[i] = depth[i] <= 0.0f ? 0 : (depth[i] < 2.0f ? 2 : 1);
+            }
+            samples.resize(depth.size());
+        }
+        const size_t rowBytes = size_t(frame.width) * size_t(frame.bitDepth / 8);
+        const double rawMegabytes = samples.size() / 1e6;
+
+        std::snprintf(buffer, sizeof(buffer), "%s{\"name\":\"%s\",\"width\":%d,\"height\":%d,\"bit_depth\":%d,\"threads\":[",
+                      c == 0 ? "" : ",", frame.name, frame.width, frame.height, frame.bitDepth);
+        json += buffer;
+        double oneThreadMs = 0.0;
+        size_t oneThreadBytes = 0;
+        double bestSpeedup = 0.0;
+        std::vector<double> speedups;
+        for (int threads = 1; threads <= maxThreads; threads++) {
+            std::vector<uint8_t> png;
+            double ms = fastestMilliseconds(iterations, [&]() {
+                encodeGreyPng(samples.data(), frame.width, frame.height, frame.bitDepth, DepthPngFilter::Up,
+                              defaultPngCompressionLevel, unsigned(threads), png);
+            });
+            lossless = lossless && decodesTo(png, samples, frame.width, frame.height, frame.bitDepth);
+
+            // The stripes as encodeGreyPng splits the rows, each encoded on its own
+            const int stripes = std::max(1, std::min(threads, frame.height / minimumStripeRows));
+            double slowestStripeMs = 0.0;
+            for (int stripe = 0; stripe < stripes; stripe++) {
+                int firstRow = int(size_t(frame.height) * stripe / stripes);
+                int endRow = int(size_t(frame.height) * (stripe + 1) / stripes);
+                std::vector<uint8_t> stripePng;
+                slowestStripeMs = std::max(slowestStripeMs, fastestMilliseconds(iterations, [&]() {
+                    encodeGreyPng(samples.data() + size_t(firstRow) * rowBytes, frame.width, endRow - firstRow,
+                                  frame.bitDepth, DepthPngFilter::Up, defaultPngCompressionLevel, 1, stripePng);
+                }));
+            }
+            if (threads == 1) {
+                oneThreadMs = ms;
+                oneThreadBytes = png.size();
+            }
+            const double speedup = oneThreadMs / ms;
+            const double estimatedSpeedup = oneThreadMs / (slowestStripeMs + (stripes - 1) * spawnMs);
+            speedups.push_back(speedup);
+            bestSpeedup = std::max(bestSpeedup, speedup);
+            std::snprintf(buffer, sizeof(buffer),
+                          "%s{\"threads\":%d,\"stripes\":%d,\"encode_ms\":%.3f,\"mb_per_second\":%.1f,\"speedup\":%.2f,"
+                          "\"estimated_speedup\":%.2f,\"bytes\":%zu,\"size_overhead\":%.4f}",
+                          threads == 1 ? "" : ",", threads, stripes, ms, rawMegabytes * 1000.0 / ms, speedup,
+                          std::min(estimatedSpeedup, double(stripes)), png.size(),
+                          double(png.size()) / double(oneThreadBytes) - 1.0);
+            json += buffer;
+        }
+        int recommended = 1;
+        while (speedups[recommended - 1] < 0.9 * bestSpeedup) {
+            recommended++;
+        }
+        std::snprintf(buffer, sizeof(buffer), "],\"recommended_threads\":%d}", recommended);
+        json += buffer;
+    }
+    json += "],\"lossless\":" + std::string(lossless ? "true" : "false") + "}";
+    std::printf("%s\n", json.c_str());
+    return lossless ? 0 : 1;
+}
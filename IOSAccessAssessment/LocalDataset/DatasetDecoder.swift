@@ -101,8 +101,10 @@ class DatasetDecoder {
         self.otherDetailsPath = datasetDirectory.appendingPathComponent("other_details.csv", isDirectory: false)
         self.meshPath = datasetDirectory.appendingPathComponent("mesh", isDirectory: true)
         
-        self.rgbDecoder = RGBDecoder(inDirectory: self.rgbFilePath)
-        self.depthDecoder = DepthDecoder(inDirectory: self.depthFilePath)
+        /// Images of datasets that were packed into a frame store are read from it, without a file per image
+        let frameStore = DatasetFrameStore(datasetDirectory: self.datasetDirectory)
+        self.rgbDecoder = RGBDecoder(inDirectory: self.rgbFilePath, frameStore: frameStore)
+        self.depthDecoder = DepthDecoder(inDirectory: self.depthFilePath, frameStore: frameStore)
         self.cameraIntrinsicsDecoder = try CameraIntrinsicsDecoder(path: self.cameraIntrinsicsPath)
         self.cameraTransformDecoder = try CameraTransformDecoder(path: self.cameraTransformPath)
         self.locationDecoder = try LocationDecoder(path: self.locationPath)
@@ -113,7 +115,7 @@ class DatasetDecoder {
             self.headingDecoder = nil
         }
         self.otherDetailsDecoder = try OtherDetailsDecoder(path: self.otherDetailsPath)
-        self.meshDecoder = MeshDecoder(inDirectory: self.meshPath)
+        self.meshDecoder = MeshDecoder(inDirectory: self.meshPath, frameStore: frameStore)
         
         self.totalFrames = self.cameraIntrinsicsDecoder.results.count
     }
@@ -142,8 +144,10 @@ class DatasetDecoder {
         let frameNumber = cameraIntrinsicsResults[index].frame
         
         let cameraImage: CIImage = try rgbDecoder.load(frameNumber: frameNumber)
-        let depthBuffer: CVPixelBuffer = try depthDecoder.decodeFrame(frameNumber: frameNumber)
+        /// Frames saved in the rANS format may carry their confidence map in the depth file
+        let (depthBuffer, confidenceBuffer) = try depthDecoder.decodeFrameWithConfidence(frameNumber: frameNumber)
         let depthImage: CIImage = CIImage(cvPixelBuffer: depthBuffer)
+        let confidenceImage: CIImage? = confidenceBuffer.map { CIImage(cvPixelBuffer: $0) }
         guard let cameraIntrinsics = cameraIntrinsicsDecoder.load(index: index, frameNumber: frameNumber)?.intrinsics else {
             throw DatasetDecoderError.indexDataNotFound(index)
         }
@@ -167,7 +171,7 @@ class DatasetDecoder {
             id: frameNumber, timestamp: cameraIntrinsicsResults[index].timestamp,
             cameraImage: cameraImage, cameraTransform: cameraTransform, cameraIntrinsics: cameraIntrinsics,
             interfaceOrientation: otherDetailsData.deviceOrientation, originalSize: otherDetailsData.originalSize,
-            depthImage: depthImage, confidenceImage: nil
+            depthImage: depthImage, confidenceImage: confidenceImage
         )
         let location = CLLocationCoordinate2D(latitude: locationData.latitude, longitude: locationData.longitude)
         let heading = headingData?.trueHeading
@@ -13,11 +13,17 @@ import PointNMapShared
 
 enum DatasetEncoderError: Error, LocalizedError {
     case directoryCreationFailed
+    case frameDropped(UUID)
+    case frameWriteFailed
     
     var errorDescription: String? {
         switch self {
         case .directoryCreationFailed:
             return "Failed to create dataset directory."
+        case .frameDropped(let frameId):
+            return "Frame \(frameId) was dropped, as the frame writer is full or the dataset was saved."
+        case .frameWriteFailed:
+            return "Failed to write some of the frame files."
         }
     }
 }
@@ -61,6 +67,10 @@ class DatasetEncoder {
     private let accessibilityFeatureEncoder: AccessibilityFeatureEncoder
     private let otherDetailsEncoder: OtherDetailsEncoder
     private let meshEncoder: MeshEncoder
+    /// Encodes and writes the files of every frame off the capturing thread
+    private let frameWriter: DatasetAsyncWriter
+    /// Longest time that a capture waits for the frame writer before its frame is dropped
+    private static let frameWriterBlockTimeoutMs: Int64 = 500
     
     public var capturedFrameIds: Set<UUID> = []
     
@@ -99,6 +109,19 @@ class DatasetEncoder {
         self.accessibilityFeatureEncoder = try AccessibilityFeatureEncoder(outDirectory: self.accessibilityFeaturePath)
         self.otherDetailsEncoder = try OtherDetailsEncoder(url: self.otherDetailsPath)
         self.meshEncoder = try MeshEncoder(outDirectory: self.meshPath)
+        /// Capture waits only when a few frames are already waiting, so that encoding is never more than a few frames behind,
+        /// and never for longer than the timeout, after which addData throws frameDropped and the writer counts the drop
+        guard let frameWriter = DatasetAsyncWriter(
+            queueCapacity: 4, encoderThreads: 2, overflow: .block,
+            blockTimeoutMs: DatasetEncoder.frameWriterBlockTimeoutMs, frameStorePath: nil
+        ) else {
+            throw DatasetEncoderError.frameWriteFailed
+        }
+        self.frameWriter = frameWriter
+    }
+    
+    deinit {
+        self.frameWriter.close()
     }
     
     static private func createDirectory(id: String, relativeTo: URL? = nil) throws -> URL {
@@ -165,36 +188,78 @@ class DatasetEncoder {
         
         let frameNumber: UUID = frameId
         
-        try self.rgbEncoder.save(ciImage: cameraImage, frameNumber: frameNumber)
+        /// The images are rendered into bitmaps of their own, and the mesh anchors retained, until the frame writer encodes them
+        let frame = DatasetAsyncFrame(frameId: frameNumber, timestamp: timestamp)
+        frame.addFile(
+            atPath: self.rgbEncoder.framePath(frameNumber: frameNumber).path, stream: DatasetFrameStream.rgb.rawValue,
+            fileExtension: "png", encoder: self.rgbEncoder.makeEncoder(ciImage: cameraImage)
+        )
+        /// The depth encoder may store the confidence map in the depth file, in which case it is not saved on its own
+        var confidencePacked = false
         if let depthImage = depthImage, let depthBuffer = depthImage.pixelBuffer {
-            try self.depthEncoder.encodeFrame(frame: depthBuffer, frameNumber: frameNumber)
+            let (encode, packedConfidence) = try self.depthEncoder.makeEncoder(
+                frame: depthBuffer, confidence: confidenceImage?.pixelBuffer
+            )
+            confidencePacked = packedConfidence
+            frame.addFile(
+                atPath: self.depthEncoder.framePath(frameNumber: frameNumber).path, stream: DatasetFrameStream.depth.rawValue,
+                fileExtension: self.depthEncoder.fileExtension, encoder: encode
+            )
         }
-        try self.segmentationEncoder.save(ciImage: segmentationLabelImage, frameNumber: frameNumber)
-        if let confidenceImage = confidenceImage {
-            try self.confidenceEncoder.save(ciImage: confidenceImage, frameNumber: frameNumber)
-        }
-        try self.cameraIntrinsicsEncoder.add(intrinsics: cameraIntrinsics, timestamp: timestamp, frameNumber: frameNumber)
-        try self.cameraTransformEncoder.add(transform: cameraTransform, timestamp: timestamp, frameNumber: frameNumber)
-        
-        if let location = location {
-            let latitude = location.latitude
-            let longitude = location.longitude
-            let locationData = LocationData(timestamp: timestamp, latitude: latitude, longitude: longitude)
-            try self.locationEncoder.add(locationData: locationData, frameNumber: frameNumber)
+        frame.addFile(
+            atPath: self.segmentationEncoder.framePath(frameNumber: frameNumber).path,
+            stream: DatasetFrameStream.segmentation.rawValue,
+            fileExtension: "png", encoder: self.segmentationEncoder.makeEncoder(ciImage: segmentationLabelImage)
+        )
+        if let confidenceImage = confidenceImage, !confidencePacked {
+            frame.addFile(
+                atPath: self.confidenceEncoder.framePath(frameNumber: frameNumber).path,
+                stream: DatasetFrameStream.confidence.rawValue,
+                fileExtension: "png", encoder: self.confidenceEncoder.makeEncoder(ciImage: confidenceImage)
+            )
         }
-        if let heading = heading {
-            let headingData = HeadingData(timestamp: timestamp, trueHeading: heading)
-            try self.headingEncoder.add(headingData: headingData, frameNumber: frameNumber)
+        if let meshAnchors = meshAnchors {
+            frame.addFile(
+                atPath: self.meshEncoder.framePath(frameNumber: frameNumber).path, stream: DatasetFrameStream.mesh.rawValue,
+                fileExtension: "ply", encoder: self.meshEncoder.makeEncoder(meshAnchors: meshAnchors)
+            )
         }
-        if let otherDetailsData = otherDetails {
-            try self.otherDetailsEncoder.add(otherDetails: otherDetailsData, frameNumber: frameNumber)
+        /**
+            The rows of the frame are added by the writer thread once its files are written, so that no row points to
+            files that do not exist. A failed row fails the frame, which the next save reports.
+            The CSV encoders are only used on the writer thread until save closes it. They are captured rather than self,
+            which the writer thread must never release, as that would close the writer from its own thread.
+         */
+        frame.onWritten = { [cameraIntrinsicsEncoder = self.cameraIntrinsicsEncoder,
+                             cameraTransformEncoder = self.cameraTransformEncoder,
+                             locationEncoder = self.locationEncoder, headingEncoder = self.headingEncoder,
+                             otherDetailsEncoder = self.otherDetailsEncoder] in
+            do {
+                try cameraIntrinsicsEncoder.add(intrinsics: cameraIntrinsics, timestamp: timestamp, frameNumber: frameNumber)
+                try cameraTransformEncoder.add(transform: cameraTransform, timestamp: timestamp, frameNumber: frameNumber)
+                if let location = location {
+                    let latitude = location.latitude
+                    let longitude = location.longitude
+                    let locationData = LocationData(timestamp: timestamp, latitude: latitude, longitude: longitude)
+                    try locationEncoder.add(locationData: locationData, frameNumber: frameNumber)
+                }
+                if let heading = heading {
+                    let headingData = HeadingData(timestamp: timestamp, trueHeading: heading)
+                    try headingEncoder.add(headingData: headingData, frameNumber: frameNumber)
+                }
+                if let otherDetailsData = otherDetails {
+                    try otherDetailsEncoder.add(otherDetails: otherDetailsData, frameNumber: frameNumber)
+                }
+            } catch {
+                print("Failed to add the rows of frame \(frameNumber): \(error.localizedDescription)")
+                return false
+            }
+            return true
         }
-        if let meshAnchors = meshAnchors {
-            try self.meshEncoder.save(meshAnchors: meshAnchors, frameNumber: frameNumber)
+        guard self.frameWriter.submitFrame(frame) else {
+            throw DatasetEncoderError.frameDropped(frameNumber)
         }
         
-        /// TODO: Add error handling for each encoder
-        
         savedFrames = savedFrames + 1
         self.capturedFrameIds.insert(frameNumber)
     }
@@ -203,11 +268,30 @@ class DatasetEncoder {
         try self.accessibilityFeatureEncoder.update(features: features, frameNumber: frameNumber, timestamp: timestamp)
     }
     
+    /// Counters of the frame writer, such as its queue depth, the frames it dropped and the latencies of its stages
+    var frameWriterCounters: [String: NSNumber] {
+        return self.frameWriter.counters
+    }
+    
+    /**
+        Saves the dataset, after which no more frames can be added.
+     */
     func save() throws {
+        /// Every file of the frames added so far is written before the dataset is considered saved. The writer is closed,
+        /// not just flushed, so that no frame added meanwhile can add its rows once the CSV encoders are done;
+        /// frames added afterwards are dropped.
+        guard self.frameWriter.close() else {
+            throw DatasetEncoderError.frameWriteFailed
+        }
         try self.cameraIntrinsicsEncoder.done()
         try self.cameraTransformEncoder.done()
         try self.locationEncoder.done()
         try self.headingEncoder.done()
         try self.accessibilityFeatureEncoder.done()
+        /// The files of the frames are moved into the frame store of the dataset, which the decoders read them from,
+        /// so that the dataset is not stored twice. Uploads export them back with DatasetFrameStore.exportDirectories.
+        if self.savedFrames > 0 {
+            try DatasetFrameStore.importDirectories(datasetDirectory: self.datasetDirectory, removingFiles: true)
+        }
     }
 }
@@ -0,0 +1,199 @@
+//
+//  DatasetFrameStore.swift
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+import Foundation
+
+enum DatasetFrameStoreError: Error, LocalizedError {
+    case storeOpenFailed(String)
+    case appendFailed(String)
+    case finishFailed
+    case invalidEntry(Int)
+
+    var errorDescription: String? {
+        switch self {
+        case .storeOpenFailed(let path):
+            return "Failed to open the frame store: \(path)"
+        case .appendFailed(let path):
+            return "Failed to add the file to the frame store: \(path)"
+        case .finishFailed:
+            return "Failed to write the index of the frame store."
+        case .invalidEntry(let index):
+            return "Entry \(index) of the frame store is invalid."
+        }
+    }
+}
+
+/**
+    Per-frame streams of a dataset, each of which is a directory with one file per frame.
+    The raw values are the stream ids of the frame store, so they must not change.
+ */
+enum DatasetFrameStream: UInt32, CaseIterable {
+    case rgb = 0
+    case depth = 1
+    case segmentation = 2
+    case confidence = 3
+    case mesh = 4
+
+    var directoryName: String {
+        switch self {
+        case .rgb:
+            return "rgb"
+        case .depth:
+            return "depth"
+        case .segmentation:
+            return "segmentation"
+        case .confidence:
+            return "confidence"
+        case .mesh:
+            return "mesh"
+        }
+    }
+}
+
+/**
+    A single memory-mapped file that holds the images of every frame of a dataset,
+    in place of the per-frame files of the rgb, depth, segmentation, confidence and mesh directories.
+
+    Images are stored as they are encoded in their files, and read back without being copied.
+    The store can be imported from the directories of a dataset, and exported back to them, such as for uploads.
+ */
+class DatasetFrameStore {
+    static let fileName = "frames.\(FrameStoreEncoder.fileExtension)"
+
+    private let decoder: FrameStoreDecoder
+
+    /// Opens the store of a dataset, or returns nil if the dataset has none
+    init?(datasetDirectory: URL) {
+        let path = DatasetFrameStore.storePath(datasetDirectory: datasetDirectory)
+        guard FileManager.default.fileExists(atPath: path.path),
+              let decoder = FrameStoreDecoder(path: path.path) else {
+            return nil
+        }
+        self.decoder = decoder
+    }
+
+    static func storePath(datasetDirectory: URL) -> URL {
+        return datasetDirectory.appendingPathComponent(DatasetFrameStore.fileName, isDirectory: false)
+    }
+
+    var isEmpty: Bool {
+        return self.decoder.count == 0
+    }
+
+    /// Encoded image of a frame, as it would be read from its file, or nil if the store does not have it
+    func data(frameNumber: UUID, stream: DatasetFrameStream) -> Data? {
+        let index = self.decoder.index(ofFrame: frameNumber, stream: stream.rawValue)
+        guard index >= 0, let data = self.decoder.data(at: index, verify: false) else {
+            return nil
+        }
+        return data
+    }
+
+    /// Extension of the file that the image of a frame was imported from, such as "png"
+    func fileExtension(frameNumber: UUID, stream: DatasetFrameStream) -> String? {
+        let index = self.decoder.index(ofFrame: frameNumber, stream: stream.rawValue)
+        return index >= 0 ? self.decoder.fileExtension(at: index) : nil
+    }
+
+    /**
+        Adds the files of the image directories of a dataset to its store, creating the store if needed.
+        Frames are ordered by the timestamps of the camera intrinsics. Files of frames that are not in them are skipped,
+        as are files that the store already has, so that a dataset can be imported again after more frames were captured.
+        If removingFiles is set, every file that the store has is deleted once the index of the store is written,
+        including the ones that an earlier import added but did not get to delete.
+        Returns the number of files that were added.
+     */
+    @discardableResult
+    static func importDirectories(datasetDirectory: URL, removingFiles: Bool = false) throws -> Int {
+        let cameraIntrinsicsPath = datasetDirectory.appendingPathComponent("camera_intrinsics.csv", isDirectory: false)
+        let frames = try CameraIntrinsicsDecoder.preload(path: cameraIntrinsicsPath)
+        let storePath = DatasetFrameStore.storePath(datasetDirectory: datasetDirectory)
+        /// The store stays readable while it is appended to, as the writer never truncates it
+        let existingStore = DatasetFrameStore(datasetDirectory: datasetDirectory)
+        guard let encoder = FrameStoreEncoder(path: storePath.path) else {
+            throw DatasetFrameStoreError.storeOpenFailed(storePath.path)
+        }
+
+        /// List every directory once, instead of checking for the file of every frame
+        var streamFiles: [DatasetFrameStream: [String: URL]] = [:]
+        for stream in DatasetFrameStream.allCases {
+            let directory = datasetDirectory.appendingPathComponent(stream.directoryName, isDirectory: true)
+            let contents = (try? FileManager.default.contentsOfDirectory(
+                at: directory, includingPropertiesForKeys: nil, options: [.skipsHiddenFiles]
+            )) ?? []
+            var files: [String: URL] = [:]
+            for file in contents {
+                files[file.deletingPathExtension().lastPathComponent] = file
+            }
+            streamFiles[stream] = files
+        }
+
+        var importedFiles: [URL] = []
+        var storedFiles: [URL] = []
+        for frame in frames {
+            for stream in DatasetFrameStream.allCases {
+                guard let file = streamFiles[stream]?[frame.frame.uuidString] else {
+                    continue
+                }
+                if (existingStore?.decoder.index(ofFrame: frame.frame, stream: stream.rawValue) ?? -1) >= 0 {
+                    storedFiles.append(file)
+                    continue
+                }
+                let data = try Data(contentsOf: file, options: .mappedIfSafe)
+                guard encoder.append(
+                    data, frameId: frame.frame, timestamp: frame.timestamp,
+                    stream: stream.rawValue, fileExtension: file.pathExtension
+                ) else {
+                    throw DatasetFrameStoreError.appendFailed(file.path)
+                }
+                importedFiles.append(file)
+            }
+        }
+        guard encoder.finish() else {
+            throw DatasetFrameStoreError.finishFailed
+        }
+        if removingFiles {
+            for file in storedFiles + importedFiles {
+                try FileManager.default.removeItem(at: file)
+            }
+        }
+        return importedFiles.count
+    }
+
+    /**
+        Writes every image of the store of a dataset back to the file it was imported from, in the image directories.
+        Returns the number of files that were written.
+     */
+    @discardableResult
+    static func exportDirectories(datasetDirectory: URL) throws -> Int {
+        let storePath = DatasetFrameStore.storePath(datasetDirectory: datasetDirectory)
+        guard let decoder = FrameStoreDecoder(path: storePath.path) else {
+            throw DatasetFrameStoreError.storeOpenFailed(storePath.path)
+        }
+        for stream in DatasetFrameStream.allCases {
+            let directory = datasetDirectory.appendingPathComponent(stream.directoryName, isDirectory: true)
+            try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true, attributes: nil)
+        }
+        var exportedCount = 0
+        for index in 0..<decoder.count {
+            guard let stream = DatasetFrameStream(rawValue: decoder.stream(at: index)) else {
+                continue
+            }
+            /// Exports are checked, as the files may leave the device
+            guard let data = decoder.data(at: index, verify: true) else {
+                throw DatasetFrameStoreError.invalidEntry(index)
+            }
+            let path = datasetDirectory
+                .appendingPathComponent(stream.directoryName, isDirectory: true)
+                .appendingPathComponent(decoder.frameId(at: index).uuidString, isDirectory: false)
+                .appendingPathExtension(decoder.fileExtension(at: index))
+            try data.write(to: path)
+            exportedCount += 1
+        }
+        return exportedCount
+    }
+}
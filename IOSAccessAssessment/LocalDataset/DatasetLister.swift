@@ -160,7 +160,8 @@ class DatasetLister: ObservableObject {
      Finds all the changeset directories within the workspace directory
      
      Changesets are number-named directories within the workspace directory, each containing data for a specific changeset.
-     Each changeset directory is expected to contain an rgb directory, within which there is at least one .png file.
+     Each changeset directory is expected to contain a frame store with at least one frame,
+     or an rgb directory, within which there is at least one .png file.
      */
     private func listChangesetDirectories(workspaceDirectory: WorkspaceDirectory) throws -> [ChangesetDirectory] {
         let contents = try FileManager.default.contentsOfDirectory(at: workspaceDirectory.url, includingPropertiesForKeys: nil, options: [.skipsHiddenFiles])
@@ -174,6 +175,10 @@ class DatasetLister: ObservableObject {
         }
         var finalChangesetDirectories: [ChangesetDirectory] = []
         for changesetDirectory in changesetDirectories {
+            if let frameStore = DatasetFrameStore(datasetDirectory: changesetDirectory.url), !frameStore.isEmpty {
+                finalChangesetDirectories.append(changesetDirectory)
+                continue
+            }
             let rgbDirectory = changesetDirectory.url.appending(path: "rgb", directoryHint: .isDirectory)
             if FileManager.default.fileExists(atPath: rgbDirectory.path) {
                 let pngFiles = try FileManager.default.contentsOfDirectory(at: rgbDirectory, includingPropertiesForKeys: nil, options: [.skipsHiddenFiles]).filter { $0.pathExtension.lowercased() == "png" }
@@ -37,4 +37,28 @@ class ConfidenceEncoder {
             try self.ciContext.writePNGRepresentation(of: ciImage, to: framePath, format: CIFormat.L8, colorSpace: colorSpace)
         }
     }
+    
+    /**
+        Returns a closure that encodes the image like save, so that the encoding can run off the capturing thread.
+        The map is rendered into a bitmap of its own first, so that a frame waiting for the encoder does not keep
+        the confidence buffer of ARKit alive.
+     */
+    func makeEncoder(ciImage: CIImage) -> () -> Data? {
+        let ciContext = self.ciContext
+        let colorSpace = CGColorSpace(name: CGColorSpace.extendedGray)
+        let cgImage = colorSpace.flatMap {
+            ciContext.createCGImage(ciImage, from: ciImage.extent, format: CIFormat.L8, colorSpace: $0)
+        }
+        return {
+            guard let colorSpace = colorSpace, let cgImage = cgImage else {
+                return nil
+            }
+            return ciContext.pngRepresentation(of: CIImage(cgImage: cgImage), format: CIFormat.L8, colorSpace: colorSpace)
+        }
+    }
+    
+    func framePath(frameNumber: UUID) -> URL {
+        let filename = String(frameNumber.uuidString)
+        return self.baseDirectory.absoluteURL.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("png")
+    }
 }
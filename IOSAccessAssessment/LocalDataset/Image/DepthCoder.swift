@@ -29,11 +29,57 @@ enum DepthCoderError: Error, LocalizedError {
     }
 }
 
+/**
+    File formats of the depth frames. PNG is the default; rANS is a lossless format of our own, smaller and faster to write.
+    Both store millimeters, so a frame decodes to the same depth whichever format it was saved in.
+ */
+enum DepthFileFormat: CaseIterable {
+    case png
+    case rans
+    
+    var fileExtension: String {
+        switch self {
+        case .png:
+            return "png"
+        case .rans:
+            return DepthRansEncoder.fileExtension
+        }
+    }
+    
+    fileprivate func makeDecoder(fileContents: Data) -> DepthFileDecoding {
+        switch self {
+        case .png:
+            return PngDecoder(contentsOfFile: fileContents)
+        case .rans:
+            return DepthRansDecoder(contentsOfFile: fileContents)
+        }
+    }
+}
+
+/// The decoding methods that the decoders of every depth file format have in common
+fileprivate protocol DepthFileDecoding {
+    func readWidth(_ width: UnsafeMutablePointer<Int32>, height: UnsafeMutablePointer<Int32>) -> Bool
+    func decodeDepth(
+        intoBuffer buffer: UnsafeMutablePointer<Float>, bytesPerRow: Int, capacity: Int,
+        width: UnsafeMutablePointer<Int32>, height: UnsafeMutablePointer<Int32>
+    ) -> Bool
+    func decodeDepth(
+        inRegionX x: UnsafeMutablePointer<Int32>, y: UnsafeMutablePointer<Int32>,
+        width: UnsafeMutablePointer<Int32>, height: UnsafeMutablePointer<Int32>,
+        intoBuffer buffer: UnsafeMutablePointer<Float>, bytesPerRow: Int, capacity: Int
+    ) -> Bool
+}
+
+extension PngDecoder: DepthFileDecoding {}
+extension DepthRansDecoder: DepthFileDecoding {}
+
 class DepthEncoder {
     private let baseDirectory: URL
+    private let format: DepthFileFormat
 
-    init(outDirectory: URL) throws {
+    init(outDirectory: URL, format: DepthFileFormat = .png) throws {
         self.baseDirectory = outDirectory
+        self.format = format
         try FileManager.default.createDirectory(at: outDirectory.absoluteURL, withIntermediateDirectories: true, attributes: nil)
     }
 
@@ -48,16 +94,82 @@ class DepthEncoder {
 //        try data.write(to: path)
 //    }
     
-    func encodeFrame(frame: CVPixelBuffer, frameNumber: UUID) throws {
-        let filename = String(frameNumber.uuidString)
-        let encoder = try self.convert(frame: frame)
-        guard let data = encoder.fileContents() else {
+    /**
+        Saves a depth frame. In the rANS format, the confidence map of the frame, if given, is stored in the same file.
+        Returns whether the confidence map was stored, in which case it does not need to be saved separately.
+     */
+    @discardableResult
+    func encodeFrame(frame: CVPixelBuffer, confidence: CVPixelBuffer? = nil, frameNumber: UUID) throws -> Bool {
+        let (encode, packedConfidence) = try self.makeEncoder(frame: frame, confidence: confidence)
+        guard let data = encode() else {
             throw DepthCoderError.invalidImageData
         }
-        let framePath = self.baseDirectory.absoluteURL.appendingPathComponent(
-            filename, isDirectory: false
-        ).appendingPathExtension("png")
-        try data.write(to: framePath)
+        try data.write(to: self.framePath(frameNumber: frameNumber))
+        return packedConfidence
+    }
+    
+    /**
+        Copies a depth frame, and returns a closure that encodes the copy, so that the encoding can run off the capturing thread.
+        The confidence map is copied and packed as in encodeFrame.
+     */
+    func makeEncoder(
+        frame: CVPixelBuffer, confidence: CVPixelBuffer? = nil
+    ) throws -> (encode: () -> Data?, packedConfidence: Bool) {
+        switch self.format {
+        case .png:
+            let encoder = try self.convert(frame: frame)
+            return ({ encoder.fileContents() }, false)
+        case .rans:
+            let packableConfidence = confidence.flatMap { self.canPack(confidence: $0, with: frame) ? $0 : nil }
+            let encoder = try self.makeRansEncoder(frame: frame, confidence: packableConfidence)
+            return ({ encoder.fileContents() }, packableConfidence != nil)
+        }
+    }
+    
+    var fileExtension: String {
+        return self.format.fileExtension
+    }
+    
+    func framePath(frameNumber: UUID) -> URL {
+        return self.baseDirectory.absoluteURL.appendingPathComponent(
+            frameNumber.uuidString, isDirectory: false
+        ).appendingPathExtension(self.format.fileExtension)
+    }
+    
+    /// The confidence map is packed only if it has one 8-bit value per depth sample
+    private func canPack(confidence: CVPixelBuffer, with frame: CVPixelBuffer) -> Bool {
+        return CVPixelBufferGetPixelFormatType(confidence) == kCVPixelFormatType_OneComponent8
+            && CVPixelBufferGetWidth(confidence) == CVPixelBufferGetWidth(frame)
+            && CVPixelBufferGetHeight(confidence) == CVPixelBufferGetHeight(frame)
+    }
+    
+    private func makeRansEncoder(frame: CVPixelBuffer, confidence: CVPixelBuffer?) throws -> DepthRansEncoder {
+        guard CVPixelBufferGetPixelFormatType(frame) == kCVPixelFormatType_DepthFloat32 else {
+            throw DepthCoderError.invalidImageData
+        }
+        CVPixelBufferLockBaseAddress(frame, .readOnly)
+        defer { CVPixelBufferUnlockBaseAddress(frame, .readOnly) }
+        guard let inBase = CVPixelBufferGetBaseAddress(frame) else {
+            throw DepthCoderError.invalidImageData
+        }
+        let encoder = DepthRansEncoder(
+            depth: inBase.assumingMemoryBound(to: Float32.self),
+            width: Int32(CVPixelBufferGetWidth(frame)),
+            height: Int32(CVPixelBufferGetHeight(frame)),
+            bytesPerRow: CVPixelBufferGetBytesPerRow(frame)
+        )
+        if let confidence = confidence {
+            CVPixelBufferLockBaseAddress(confidence, .readOnly)
+            defer { CVPixelBufferUnlockBaseAddress(confidence, .readOnly) }
+            guard let confidenceBase = CVPixelBufferGetBaseAddress(confidence) else {
+                throw DepthCoderError.invalidImageData
+            }
+            encoder.setConfidence(
+                confidenceBase.assumingMemoryBound(to: UInt8.self),
+                bytesPerRow: CVPixelBufferGetBytesPerRow(confidence)
+            )
+        }
+        return encoder
     }
     
     private func convert(frame: CVPixelBuffer) throws -> PngEncoder {
@@ -81,31 +193,151 @@ class DepthEncoder {
 
 class DepthDecoder {
     private let baseDirectory: URL
+    private let frameStore: DatasetFrameStore?
     
-    init(inDirectory: URL) {
+    /// Frames are read from the frame store of the dataset if it has them, and from their files otherwise
+    init(inDirectory: URL, frameStore: DatasetFrameStore? = nil) {
         self.baseDirectory = inDirectory
+        self.frameStore = frameStore
     }
     
     func decodeFrame(frameNumber: UUID) throws -> CVPixelBuffer {
-        let filename = String(frameNumber.uuidString)
-        let framePath = self.baseDirectory.absoluteURL.appendingPathComponent(
-            filename, isDirectory: false
-        ).appendingPathExtension("png")
-        let data = try Data(contentsOf: framePath)
+        return try self.decodeFrame(decoder: try self.openFrame(frameNumber: frameNumber))
+    }
+    
+    private func decodeFrame(decoder: DepthFileDecoding) throws -> CVPixelBuffer {
+        var width: Int32 = 0
+        var height: Int32 = 0
+        guard decoder.readWidth(&width, height: &height) else {
+            throw DepthCoderError.invalidFileData
+        }
+        
+        let buffer = try self.makePixelBuffer(width: Int(width), height: Int(height))
+        
+        /// Decode straight into the pixel buffer, so that the depth is never held in an intermediate copy
+        CVPixelBufferLockBaseAddress(buffer, [])
+        defer { CVPixelBufferUnlockBaseAddress(buffer, []) }
+        guard let bufferBaseAddress = CVPixelBufferGetBaseAddress(buffer) else {
+            throw DepthCoderError.fileReadFailed
+        }
+        let bytesPerRow = CVPixelBufferGetBytesPerRow(buffer)
+        let capacity = CVPixelBufferGetDataSize(buffer)
+        var decodedWidth: Int32 = 0
+        var decodedHeight: Int32 = 0
+        guard decoder.decodeDepth(
+            intoBuffer: bufferBaseAddress.assumingMemoryBound(to: Float.self),
+            bytesPerRow: bytesPerRow,
+            capacity: capacity,
+            width: &decodedWidth,
+            height: &decodedHeight
+        ), decodedWidth == width, decodedHeight == height else {
+            throw DepthCoderError.invalidFileData
+        }
+        
+//        CVPixelBufferUnlockBaseAddress(buffer, [])
+//        /// Read a few pixels to verify the data was copied correctly
+//        CVPixelBufferLockBaseAddress(buffer, .readOnly)
+//        if let verifyBaseAddress = CVPixelBufferGetBaseAddress(buffer) {
+//            let verifyPixelData = verifyBaseAddress.assumingMemoryBound(to: Float32.self)
+//            print("First 5 values: \(Array(UnsafeBufferPointer(start: verifyPixelData, count: min(5, pixelCount))))")
+//        }
         
-        let decoder = PngDecoder(contentsOfFile: data)
+        return buffer
+    }
+    
+    /**
+        Decodes a frame together with the confidence map stored in the same file, in a single pass over the file.
+        The confidence map is nil if the frame was saved without one, as all PNG frames are.
+     */
+    func decodeFrameWithConfidence(frameNumber: UUID) throws -> (depth: CVPixelBuffer, confidence: CVPixelBuffer?) {
+        let decoder = try self.openFrame(frameNumber: frameNumber)
+        guard let ransDecoder = decoder as? DepthRansDecoder, ransDecoder.hasConfidence else {
+            return (try self.decodeFrame(decoder: decoder), nil)
+        }
         var width: Int32 = 0
         var height: Int32 = 0
+        guard ransDecoder.readWidth(&width, height: &height) else {
+            throw DepthCoderError.invalidFileData
+        }
         
-        guard let depthData: Data = decoder.depthData(withWidth: &width, height: &height) else {
+        let buffer = try self.makePixelBuffer(width: Int(width), height: Int(height))
+        let confidenceBuffer = try self.makePixelBuffer(
+            width: Int(width), height: Int(height), pixelFormat: kCVPixelFormatType_OneComponent8
+        )
+        CVPixelBufferLockBaseAddress(buffer, [])
+        defer { CVPixelBufferUnlockBaseAddress(buffer, []) }
+        CVPixelBufferLockBaseAddress(confidenceBuffer, [])
+        defer { CVPixelBufferUnlockBaseAddress(confidenceBuffer, []) }
+        guard let bufferBaseAddress = CVPixelBufferGetBaseAddress(buffer),
+              let confidenceBaseAddress = CVPixelBufferGetBaseAddress(confidenceBuffer) else {
+            throw DepthCoderError.fileReadFailed
+        }
+        var decodedWidth: Int32 = 0
+        var decodedHeight: Int32 = 0
+        guard ransDecoder.decodeDepth(
+            intoBuffer: bufferBaseAddress.assumingMemoryBound(to: Float.self),
+            bytesPerRow: CVPixelBufferGetBytesPerRow(buffer),
+            capacity: CVPixelBufferGetDataSize(buffer),
+            confidenceBuffer: confidenceBaseAddress.assumingMemoryBound(to: UInt8.self),
+            confidenceBytesPerRow: CVPixelBufferGetBytesPerRow(confidenceBuffer),
+            confidenceCapacity: CVPixelBufferGetDataSize(confidenceBuffer),
+            width: &decodedWidth,
+            height: &decodedHeight
+        ), decodedWidth == width, decodedHeight == height else {
+            throw DepthCoderError.invalidFileData
+        }
+        return (buffer, confidenceBuffer)
+    }
+    
+    /**
+        Decodes only a region of a frame, such as the bounding box of a feature, into a pixel buffer of the size of the region.
+        The region is in pixels of the depth frame, and is clipped to it.
+        Rows of the frame below the region are never decompressed, so this is much cheaper than decoding the frame and cropping it.
+     */
+    func decodeFrame(frameNumber: UUID, region: CGRect) throws -> CVPixelBuffer {
+        let decoder = try self.openFrame(frameNumber: frameNumber)
+        var frameWidth: Int32 = 0
+        var frameHeight: Int32 = 0
+        guard decoder.readWidth(&frameWidth, height: &frameHeight) else {
             throw DepthCoderError.invalidFileData
         }
+        let clipped = region.integral.intersection(CGRect(x: 0, y: 0, width: Int(frameWidth), height: Int(frameHeight)))
+        guard !clipped.isNull, clipped.width > 0, clipped.height > 0 else {
+            throw DepthCoderError.invalidImageData
+        }
         
-        let pixelCount = Int(width * height)
+        var x = Int32(clipped.minX)
+        var y = Int32(clipped.minY)
+        var width = Int32(clipped.width)
+        var height = Int32(clipped.height)
+        let buffer = try self.makePixelBuffer(width: Int(width), height: Int(height))
+        
+        CVPixelBufferLockBaseAddress(buffer, [])
+        defer { CVPixelBufferUnlockBaseAddress(buffer, []) }
+        guard let bufferBaseAddress = CVPixelBufferGetBaseAddress(buffer) else {
+            throw DepthCoderError.fileReadFailed
+        }
+        guard decoder.decodeDepth(
+            inRegionX: &x,
+            y: &y,
+            width: &width,
+            height: &height,
+            intoBuffer: bufferBaseAddress.assumingMemoryBound(to: Float.self),
+            bytesPerRow: CVPixelBufferGetBytesPerRow(buffer),
+            capacity: CVPixelBufferGetDataSize(buffer)
+        ), width == Int32(clipped.width), height == Int32(clipped.height) else {
+            throw DepthCoderError.invalidFileData
+        }
+        return buffer
+    }
+    
+    private func makePixelBuffer(
+        width: Int, height: Int, pixelFormat: OSType = kCVPixelFormatType_DepthFloat32
+    ) throws -> CVPixelBuffer {
         var pixelBuffer: CVPixelBuffer?
         
         let attrs: [String: Any] = [
-            kCVPixelBufferPixelFormatTypeKey as String: kCVPixelFormatType_DepthFloat32,
+            kCVPixelBufferPixelFormatTypeKey as String: pixelFormat,
             kCVPixelBufferWidthKey as String: width,
             kCVPixelBufferHeightKey as String: height,
             kCVPixelBufferCGImageCompatibilityKey as String: true,
@@ -114,30 +346,31 @@ class DepthDecoder {
             kCVPixelBufferIOSurfacePropertiesKey as String: [:]
         ]
         
-        let status = CVPixelBufferCreate(kCFAllocatorDefault, Int(width), Int(height), kCVPixelFormatType_DepthFloat32, attrs as CFDictionary, &pixelBuffer)
+        let status = CVPixelBufferCreate(kCFAllocatorDefault, width, height, pixelFormat, attrs as CFDictionary, &pixelBuffer)
         guard status == kCVReturnSuccess, let buffer = pixelBuffer else {
             throw DepthCoderError.fileReadFailed
         }
         
-        CVPixelBufferLockBaseAddress(buffer, [])
-        guard let bufferBaseAddress = CVPixelBufferGetBaseAddress(buffer) else {
-            throw DepthCoderError.fileReadFailed
+        return buffer
+    }
+    
+    /// Opens the file of a frame in whichever format it was saved in
+    private func openFrame(frameNumber: UUID) throws -> DepthFileDecoding {
+        if let frameStore = self.frameStore,
+           let data = frameStore.data(frameNumber: frameNumber, stream: .depth),
+           let fileExtension = frameStore.fileExtension(frameNumber: frameNumber, stream: .depth),
+           let format = DepthFileFormat.allCases.first(where: { $0.fileExtension == fileExtension }) {
+            return format.makeDecoder(fileContents: data)
         }
-        try depthData.withUnsafeBytes { depthPtr in
-            guard let depthBaseAddress = depthPtr.baseAddress else {
-                throw DepthCoderError.invalidFileData
+        let filename = String(frameNumber.uuidString)
+        let basePath = self.baseDirectory.absoluteURL.appendingPathComponent(filename, isDirectory: false)
+        for format in DepthFileFormat.allCases where format != .png {
+            let framePath = basePath.appendingPathExtension(format.fileExtension)
+            if FileManager.default.fileExists(atPath: framePath.path) {
+                return format.makeDecoder(fileContents: try Data(contentsOf: framePath))
             }
-            bufferBaseAddress.copyMemory(from: depthBaseAddress, byteCount: pixelCount * MemoryLayout<Float32>.size)
         }
-        
-//        CVPixelBufferUnlockBaseAddress(buffer, [])
-//        /// Read a few pixels to verify the data was copied correctly
-//        CVPixelBufferLockBaseAddress(buffer, .readOnly)
-//        if let verifyBaseAddress = CVPixelBufferGetBaseAddress(buffer) {
-//            let verifyPixelData = verifyBaseAddress.assumingMemoryBound(to: Float32.self)
-//            print("First 5 values: \(Array(UnsafeBufferPointer(start: verifyPixelData, count: min(5, pixelCount))))")
-//        }
-        
-        return buffer
+        let data = try Data(contentsOf: basePath.appendingPathExtension(DepthFileFormat.png.fileExtension))
+        return DepthFileFormat.png.makeDecoder(fileContents: data)
     }
 }
@@ -34,31 +34,56 @@ enum RGBCoderError: Error, LocalizedError {
 
 class RGBEncoder {
     private let baseDirectory: URL
+    private let ciContext: CIContext
 
     init(outDirectory: URL) throws {
         self.baseDirectory = outDirectory
+        self.ciContext = CIContext()
         try FileManager.default.createDirectory(at: outDirectory.absoluteURL, withIntermediateDirectories: true, attributes: nil)
     }
     
     func save(ciImage: CIImage, frameNumber: UUID) throws {
-        let filename = String(frameNumber.uuidString)
-        let image = UIImage(ciImage: ciImage)
-        guard let data = image.pngData() else {
+        guard let data = self.makeEncoder(ciImage: ciImage)() else {
             throw RGBCoderError.invalidImageData
         }
-        let path = self.baseDirectory.absoluteURL.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("png")
-        try data.write(to: path)
+        try data.write(to: self.framePath(frameNumber: frameNumber))
+    }
+    
+    /**
+        Returns a closure that encodes the image, so that the encoding can run off the capturing thread.
+        The image is rendered into a bitmap of its own first, so that a frame waiting for the encoder does not keep
+        the camera pixel buffer behind the image alive, which ARKit needs back for the next frames.
+     */
+    func makeEncoder(ciImage: CIImage) -> () -> Data? {
+        let cgImage = self.ciContext.createCGImage(ciImage, from: ciImage.extent)
+        return {
+            guard let cgImage = cgImage else {
+                return nil
+            }
+            return UIImage(cgImage: cgImage).pngData()
+        }
+    }
+    
+    func framePath(frameNumber: UUID) -> URL {
+        let filename = String(frameNumber.uuidString)
+        return self.baseDirectory.absoluteURL.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("png")
     }
 }
 
 class RGBDecoder {
     private let baseDirectory: URL
+    private let frameStore: DatasetFrameStore?
     
-    init(inDirectory: URL) {
+    /// Frames are read from the frame store of the dataset if it has them, and from their files otherwise
+    init(inDirectory: URL, frameStore: DatasetFrameStore? = nil) {
         self.baseDirectory = inDirectory
+        self.frameStore = frameStore
     }
     
-    func load(frameNumber: UUID) throws -> CVPixelBuffer {
+    private func loadData(frameNumber: UUID) throws -> Data {
+        if let data = self.frameStore?.data(frameNumber: frameNumber, stream: .rgb) {
+            return data
+        }
         let filename = String(frameNumber.uuidString)
         let path = self.baseDirectory.absoluteURL.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("png")
         guard FileManager.default.fileExists(atPath: path.path) else {
@@ -67,6 +92,11 @@ class RGBDecoder {
         guard let data = try? Data(contentsOf: path) else {
             throw RGBCoderError.invalidFileData
         }
+        return data
+    }
+    
+    func load(frameNumber: UUID) throws -> CVPixelBuffer {
+        let data = try self.loadData(frameNumber: frameNumber)
         guard let image = UIImage(data: data),
               let cgImage = image.cgImage else {
             throw RGBCoderError.invalidFileData
@@ -25,19 +25,38 @@ enum SegmentationEncoderError: Error, LocalizedError {
 
 class SegmentationEncoder {
     private let baseDirectory: URL
+    private let ciContext: CIContext
     
     init(outDirectory: URL) throws {
         self.baseDirectory = outDirectory
+        self.ciContext = CIContext()
         try FileManager.default.createDirectory(at: outDirectory.absoluteURL, withIntermediateDirectories: true, attributes: nil)
     }
     
     func save(ciImage: CIImage, frameNumber: UUID) throws {
-        let filename = String(frameNumber.uuidString)
-        let image = UIImage(ciImage: ciImage)
-        guard let data = image.pngData() else {
+        guard let data = self.makeEncoder(ciImage: ciImage)() else {
             throw SegmentationEncoderError.invalidImageData
         }
-        let path = self.baseDirectory.absoluteURL.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("png")
-        try data.write(to: path)
+        try data.write(to: self.framePath(frameNumber: frameNumber))
+    }
+    
+    /**
+        Returns a closure that encodes the image, so that the encoding can run off the capturing thread.
+        The image is rendered into a bitmap of its own first, so that a frame waiting for the encoder does not keep
+        the pixel buffer behind the image alive, which the segmentation pipeline needs back for the next frames.
+     */
+    func makeEncoder(ciImage: CIImage) -> () -> Data? {
+        let cgImage = self.ciContext.createCGImage(ciImage, from: ciImage.extent)
+        return {
+            guard let cgImage = cgImage else {
+                return nil
+            }
+            return UIImage(cgImage: cgImage).pngData()
+        }
+    }
+    
+    func framePath(frameNumber: UUID) -> URL {
+        let filename = String(frameNumber.uuidString)
+        return self.baseDirectory.absoluteURL.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("png")
     }
 }
@@ -46,29 +46,39 @@ class MeshEncoder {
     }
     
     func save(meshAnchors: [ARMeshAnchor], frameNumber: UUID) throws {
-        let filename = String(frameNumber.uuidString)
-        
-        var meshContents: [MeshContents] = []
-        var vertexBase: UInt32 = 0
-        for anchor in meshAnchors {
-            let content = getContentsForAnchor(meshAnchor: anchor, vertexColor: .white)
-            /// Rebase the indices to the total vertex count so far
-            let rebasedIndices = content.indices.map { $0 + vertexBase }
-            vertexBase += UInt32(content.positions.count)
-            let rebasedContent = MeshContents(
-                positions: content.positions,
-                indices: rebasedIndices,
-                classifications: content.classifications,
-                colorR8: content.colorR8,
-                colorG8: content.colorG8,
-                colorB8: content.colorB8
-            )
-            meshContents.append(rebasedContent)
+        let data = self.makeEncoder(meshAnchors: meshAnchors)()
+        try data?.write(to: self.framePath(frameNumber: frameNumber), options: .atomic)
+    }
+    
+    /// Returns a closure that generates the PLY file, so that it can run off the capturing thread
+    func makeEncoder(meshAnchors: [ARMeshAnchor]) -> () -> Data? {
+        return { [self] in
+            var meshContents: [MeshContents] = []
+            var vertexBase: UInt32 = 0
+            for anchor in meshAnchors {
+                let content = self.getContentsForAnchor(meshAnchor: anchor, vertexColor: .white)
+                /// Rebase the indices to the total vertex count so far
+                let rebasedIndices = content.indices.map { $0 + vertexBase }
+                vertexBase += UInt32(content.positions.count)
+                let rebasedContent = MeshContents(
+                    positions: content.positions,
+                    indices: rebasedIndices,
+                    classifications: content.classifications,
+                    colorR8: content.colorR8,
+                    colorG8: content.colorG8,
+                    colorB8: content.colorB8
+                )
+                meshContents.append(rebasedContent)
+            }
+            
+            let ply = self.generatePlyContent(meshContents, includeColor: true, includeClassification: true)
+            return ply.data(using: .utf8)
         }
-        
-        let ply = generatePlyContent(meshContents, includeColor: true, includeClassification: true)
-        let path = baseDirectory.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("ply")
-        try ply.data(using: .utf8)?.write(to: path, options: .atomic)
+    }
+    
+    func framePath(frameNumber: UUID) -> URL {
+        let filename = String(frameNumber.uuidString)
+        return baseDirectory.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("ply")
     }
     
     func save(meshContents: MeshContents, frameNumber: UUID) throws {
@@ -230,22 +240,35 @@ struct MeshContentsHeaderConfig: Sendable {
 
 class MeshDecoder {
     private let baseDirectory: URL
+    private let frameStore: DatasetFrameStore?
     
-    init(inDirectory: URL) {
+    /// Meshes are read from the frame store of the dataset if it has them, and from their files otherwise
+    init(inDirectory: URL, frameStore: DatasetFrameStore? = nil) {
         self.baseDirectory = inDirectory
+        self.frameStore = frameStore
     }
     
-    /**
-     Since we cannot generate ARMeshAnchors from PLY files, this function will return the raw vertex and index data contained in the PLY. The caller can then decide how to use this data (e.g. create custom mesh anchors, post-process it, etc.).
-     */
-    func load(frameNumber: UUID, defaultClassificationValue: Int = 0) throws -> MeshContents {
+    private func loadData(frameNumber: UUID) throws -> Data {
+        if let data = self.frameStore?.data(frameNumber: frameNumber, stream: .mesh) {
+            return data
+        }
         let filename = String(frameNumber.uuidString)
         let path = self.baseDirectory.absoluteURL.appendingPathComponent(filename, isDirectory: false).appendingPathExtension("ply")
         guard FileManager.default.fileExists(atPath: path.path) else {
             throw MeshCoderError.invalidFilePath(path.path)
         }
-        guard let data = try? Data(contentsOf: path),
-              let text = String(data: data, encoding: .utf8) else {
+        guard let data = try? Data(contentsOf: path) else {
+            throw MeshCoderError.invalidFileData
+        }
+        return data
+    }
+    
+    /**
+     Since we cannot generate ARMeshAnchors from PLY files, this function will return the raw vertex and index data contained in the PLY. The caller can then decide how to use this data (e.g. create custom mesh anchors, post-process it, etc.).
+     */
+    func load(frameNumber: UUID, defaultClassificationValue: Int = 0) throws -> MeshContents {
+        let data = try self.loadData(frameNumber: frameNumber)
+        guard let text = String(data: data, encoding: .utf8) else {
             throw MeshCoderError.invalidFileData
         }
         return try getMeshFromPlyContent(text, defaultClassificationValue: defaultClassificationValue)
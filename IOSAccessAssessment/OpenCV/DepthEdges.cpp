@@ -0,0 +1,66 @@
+//
+//  DepthEdges.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "DepthEdges.hpp"
+#include <algorithm>
+#include <cmath>
+
+void resampleDepth (cv::Mat depth, cv::Size size, cv::Mat &scratch, cv::Mat &output) {
+    cv::Mat source = depth;
+    if (depth.type() != CV_32FC1) {
+        if (depth.channels() > 1) {
+            cv::extractChannel(depth, scratch, 0);
+            scratch.convertTo(scratch, CV_32F);
+        } else {
+            depth.convertTo(scratch, CV_32F);
+        }
+        source = scratch;
+    }
+    if (source.size() == size) {
+        output = source;
+    } else {
+        cv::resize(source, output, size, 0, 0, cv::INTER_NEAREST);
+    }
+}
+
+/**
+    Marks the discontinuities of a single row, against the next row.
+    The loop has no branches, so that the compiler can vectorize it.
+ */
+static void rowDiscontinuities (const float *row, const float *nextRow, int cols, float relativeThreshold, uchar *edges) {
+    for (int j = 0; j < cols - 1; j++)
+    {
+        float z = row[j];
+        float right = row[j + 1];
+        float down = nextRow[j];
+        float jump = std::max(std::fabs(right - z), std::fabs(down - z));
+        // Comparisons with NaN are false, so invalid depths are never marked
+        bool valid = (z > 0.0f) & (right > 0.0f) & (down > 0.0f);
+        edges[j] = (valid & (jump > relativeThreshold * z)) ? 255 : 0;
+    }
+    float z = row[cols - 1];
+    float down = nextRow[cols - 1];
+    bool valid = (z > 0.0f) & (down > 0.0f);
+    edges[cols - 1] = (valid & (std::fabs(down - z) > relativeThreshold * z)) ? 255 : 0;
+}
+
+void depthDiscontinuities (cv::Mat depth, float relativeThreshold, cv::Mat edges) {
+    CV_Assert(depth.type() == CV_32FC1);
+    CV_Assert(edges.type() == CV_8UC1 && edges.size() == depth.size());
+    if (depth.empty()) {
+        return;
+    }
+    
+    cv::parallel_for_(cv::Range(0, depth.rows), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++)
+        {
+            // The last row has no bottom neighbour, so it is compared against itself
+            int next = std::min(i + 1, depth.rows - 1);
+            rowDiscontinuities(depth.ptr<float>(i), depth.ptr<float>(next), depth.cols, relativeThreshold, edges.ptr<uchar>(i));
+        }
+    });
+}
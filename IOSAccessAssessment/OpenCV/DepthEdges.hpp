@@ -0,0 +1,34 @@
+//
+//  DepthEdges.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DepthEdges_hpp
+#define DepthEdges_hpp
+#include <opencv2/opencv.hpp>
+
+/**
+    Brings a depth map to a single channel float image of the given size.
+ 
+    Multi-channel depth images (such as a grayscale depth image read from a UIImage) use their first channel.
+    The depth is resized with nearest neighbour interpolation, since interpolating across a discontinuity would turn it into a ramp.
+    If the depth already is a float image of the right size, the output is the depth itself, without copying it.
+    The scratch buffer is only used when the depth has to be converted before it is resized.
+ */
+void resampleDepth (cv::Mat depth, cv::Size size, cv::Mat &scratch, cv::Mat &output);
+
+/**
+    Marks the depth discontinuities of a float depth map.
+ 
+    A pixel is set to 255 when the depth difference to its right or bottom neighbour is larger than
+    relativeThreshold times its own depth, and to 0 otherwise. Pixels without a valid depth (zero, negative or NaN),
+    or with invalid neighbours, are never marked.
+    The rows are processed in parallel on the OpenCV thread pool.
+ 
+    The edges (CV_8UC1) must already have the size of the depth.
+ */
+void depthDiscontinuities (cv::Mat depth, float relativeThreshold, cv::Mat edges);
+
+#endif /* DepthEdges_hpp */
@@ -0,0 +1,292 @@
+//
+//  DistanceTransform.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "DistanceTransform.hpp"
+#include <algorithm>
+#include <limits>
+
+/**
+    Column pass: the distance of every pixel to the nearest zero pixel in its own column.
+    Rows are walked one at a time over a band of columns, so that memory is accessed contiguously.
+    With labels, the distance is to the nearest pixel with another value, zero or not.
+ */
+template <bool Labels>
+static void columnPass (const cv::Mat &binary, cv::Mat &squaredDistance, int startColumn, int endColumn) {
+    const float infinity = std::numeric_limits<float>::infinity();
+    
+    // Top to bottom: the distance to the nearest zero pixel above
+    for (int i = 0; i < binary.rows; i++)
+    {
+        const uchar *binaryRow = binary.ptr<uchar>(i);
+        const uchar *binaryAbove = (i > 0) ? binary.ptr<uchar>(i - 1) : nullptr;
+        float *row = squaredDistance.ptr<float>(i);
+        const float *previousRow = (i > 0) ? squaredDistance.ptr<float>(i - 1) : nullptr;
+        for (int j = startColumn; j < endColumn; j++)
+        {
+            if (binaryRow[j] == 0) {
+                row[j] = 0;
+            } else if (Labels && previousRow && binaryAbove[j] != binaryRow[j]) {
+                row[j] = 1;
+            } else {
+                row[j] = previousRow ? previousRow[j] + 1 : infinity;
+            }
+        }
+    }
+    // Bottom to top: the distance to the nearest zero pixel below
+    for (int i = binary.rows - 2; i >= 0; i--)
+    {
+        const uchar *binaryRow = binary.ptr<uchar>(i);
+        const uchar *binaryBelow = binary.ptr<uchar>(i + 1);
+        float *row = squaredDistance.ptr<float>(i);
+        const float *nextRow = squaredDistance.ptr<float>(i + 1);
+        for (int j = startColumn; j < endColumn; j++)
+        {
+            float below = (Labels && binaryBelow[j] != binaryRow[j]) ? 1.0f : nextRow[j] + 1;
+            row[j] = std::min(row[j], below);
+        }
+    }
+}
+
+/**
+    Row pass: the lower envelope of the parabolas rooted at every pixel of the row, whose heights are the squared column distances.
+    Pixels with an infinite column distance do not contribute a parabola.
+    
+    The vertices, boundaries and samples are scratch buffers, of at least cols, cols + 1 and cols elements respectively.
+    Returns the largest squared distance of the row.
+ */
+static float rowPass (float *row, int cols, int *vertices, double *boundaries, float *samples) {
+    const float infinity = std::numeric_limits<float>::infinity();
+    for (int q = 0; q < cols; q++)
+    {
+        samples[q] = row[q] * row[q];
+    }
+    
+    int k = -1;
+    for (int q = 0; q < cols; q++)
+    {
+        if (samples[q] == infinity) {
+            continue;
+        }
+        double s = -std::numeric_limits<double>::infinity();
+        while (k >= 0) {
+            int v = vertices[k];
+            s = ((samples[q] + double(q) * q) - (samples[v] + double(v) * v)) / (2.0 * (q - v));
+            if (s > boundaries[k]) {
+                break;
+            }
+            k--;
+        }
+        if (k < 0) {
+            s = -std::numeric_limits<double>::infinity();
+        }
+        k++;
+        vertices[k] = q;
+        boundaries[k] = s;
+    }
+    
+    if (k < 0) {
+        std::fill(row, row + cols, infinity);
+        return infinity;
+    }
+    
+    float rowMaximum = 0;
+    int envelopeSize = k + 1;
+    k = 0;
+    for (int q = 0; q < cols; q++)
+    {
+        while (k + 1 < envelopeSize && boundaries[k + 1] < q) {
+            k++;
+        }
+        int v = vertices[k];
+        float distance = float(q - v) * float(q - v) + samples[v];
+        row[q] = distance;
+        rowMaximum = std::max(rowMaximum, distance);
+    }
+    return rowMaximum;
+}
+
+/**
+    Row pass of an image of labels. A pixel of a label is nearest to a pixel with another value either within its own run
+    of the label in the row, or at one of the two ends of the run, so every run is a row pass of its own, between two
+    zero samples. Pixels outside the row do not count, so runs that reach an end of the row have no sample there.
+ 
+    The scratch buffers are those of rowPass, of at least cols + 2 elements, and run, of at least cols + 2 elements.
+    Returns the largest squared distance of the row.
+ */
+static float labelRowPass (float *row, const uchar *labels, int cols, int *vertices, double *boundaries, float *samples,
+                           float *run) {
+    const float infinity = std::numeric_limits<float>::infinity();
+    float rowMaximum = 0;
+    int start = 0;
+    while (start < cols) {
+        int end = start + 1;
+        while (end < cols && labels[end] == labels[start]) {
+            end++;
+        }
+        if (labels[start] != 0) {
+            int length = end - start;
+            run[0] = (start > 0) ? 0 : infinity;
+            std::copy(row + start, row + end, run + 1);
+            run[length + 1] = (end < cols) ? 0 : infinity;
+            rowPass(run, length + 2, vertices, boundaries, samples);
+            std::copy(run + 1, run + length + 1, row + start);
+            for (int q = start; q < end; q++) {
+                rowMaximum = std::max(rowMaximum, row[q]);
+            }
+        }
+        start = end;
+    }
+    return rowMaximum;
+}
+
+void squaredDistanceTransform (cv::Mat binary, cv::Mat squaredDistance, std::vector<float> &rowMaxima) {
+    CV_Assert(binary.type() == CV_8UC1);
+    CV_Assert(squaredDistance.type() == CV_32FC1 && squaredDistance.size() == binary.size());
+    rowMaxima.resize(binary.rows);
+    
+    const int columnBand = 64;
+    int columnBands = (binary.cols + columnBand - 1) / columnBand;
+    cv::parallel_for_(cv::Range(0, columnBands), [&](const cv::Range &range) {
+        columnPass<false>(binary, squaredDistance,
+                          range.start * columnBand, std::min(range.end * columnBand, binary.cols));
+    });
+    
+    cv::parallel_for_(cv::Range(0, binary.rows), [&](const cv::Range &range) {
+        // Scratch buffers are kept per thread, so they are only allocated the first time, or when the frame grows
+        thread_local std::vector<int> vertices;
+        thread_local std::vector<double> boundaries;
+        thread_local std::vector<float> samples;
+        if (vertices.size() < size_t(binary.cols)) {
+            vertices.resize(binary.cols);
+            boundaries.resize(binary.cols + 1);
+            samples.resize(binary.cols);
+        }
+        for (int i = range.start; i < range.end; i++) {
+            rowMaxima[i] = rowPass(squaredDistance.ptr<float>(i), binary.cols,
+                                   vertices.data(), boundaries.data(), samples.data());
+        }
+    });
+}
+
+void distanceTransformPeaks (cv::Mat binary, float peakThreshold,
+                             cv::Mat squaredDistance, std::vector<float> &rowMaxima, cv::Mat peaks) {
+    CV_Assert(peaks.type() == CV_8UC1 && peaks.size() == binary.size());
+    squaredDistanceTransform(binary, squaredDistance, rowMaxima);
+    
+    // The minimum distance is 0 wherever there is a zero pixel, so normalizing only divides by the maximum
+    float maximum = 0;
+    for (float rowMaximum : rowMaxima) {
+        if (rowMaximum != std::numeric_limits<float>::infinity()) {
+            maximum = std::max(maximum, rowMaximum);
+        }
+    }
+    if (maximum <= 0) {
+        peaks.setTo(0);
+        return;
+    }
+    // dist / sqrt(maximum) > peakThreshold, without taking square roots
+    const float threshold = peakThreshold * peakThreshold * maximum;
+    
+    // Threshold and 3x3 dilation in a single pass
+    cv::parallel_for_(cv::Range(0, binary.rows), [&](const cv::Range &range) {
+        thread_local std::vector<uchar> verticalPeaks;
+        verticalPeaks.resize(binary.cols);
+        for (int i = range.start; i < range.end; i++) {
+            std::fill(verticalPeaks.begin(), verticalPeaks.end(), 0);
+            for (int neighbor = std::max(i - 1, 0); neighbor <= std::min(i + 1, binary.rows - 1); neighbor++) {
+                const float *row = squaredDistance.ptr<float>(neighbor);
+                for (int j = 0; j < binary.cols; j++) {
+                    verticalPeaks[j] |= (row[j] > threshold) ? 255 : 0;
+                }
+            }
+            uchar *peakRow = peaks.ptr<uchar>(i);
+            for (int j = 0; j < binary.cols; j++) {
+                uchar peak = verticalPeaks[j];
+                if (j > 0) peak |= verticalPeaks[j - 1];
+                if (j < binary.cols - 1) peak |= verticalPeaks[j + 1];
+                peakRow[j] = peak;
+            }
+        }
+    });
+}
+
+void squaredLabelDistanceTransform (cv::Mat labels, cv::Mat squaredDistance, std::vector<float> &rowMaxima) {
+    CV_Assert(labels.type() == CV_8UC1);
+    CV_Assert(squaredDistance.type() == CV_32FC1 && squaredDistance.size() == labels.size());
+    rowMaxima.resize(labels.rows);
+    
+    const int columnBand = 64;
+    int columnBands = (labels.cols + columnBand - 1) / columnBand;
+    cv::parallel_for_(cv::Range(0, columnBands), [&](const cv::Range &range) {
+        columnPass<true>(labels, squaredDistance,
+                         range.start * columnBand, std::min(range.end * columnBand, labels.cols));
+    });
+    
+    cv::parallel_for_(cv::Range(0, labels.rows), [&](const cv::Range &range) {
+        thread_local std::vector<int> vertices;
+        thread_local std::vector<double> boundaries;
+        thread_local std::vector<float> samples;
+        thread_local std::vector<float> run;
+        // The runs of the labels get a sample at each end
+        if (run.size() < size_t(labels.cols) + 2) {
+            vertices.resize(labels.cols + 2);
+            boundaries.resize(labels.cols + 3);
+            samples.resize(labels.cols + 2);
+            run.resize(labels.cols + 2);
+        }
+        for (int i = range.start; i < range.end; i++) {
+            rowMaxima[i] = labelRowPass(squaredDistance.ptr<float>(i), labels.ptr<uchar>(i), labels.cols,
+                                        vertices.data(), boundaries.data(), samples.data(), run.data());
+        }
+    });
+}
+
+void labelDistancePeaks (cv::Mat labels, uchar label, float peakThreshold, cv::Mat squaredDistance, cv::Mat peaks) {
+    CV_Assert(labels.type() == CV_8UC1 && label != 0);
+    CV_Assert(squaredDistance.type() == CV_32FC1 && squaredDistance.size() == labels.size());
+    CV_Assert(peaks.type() == CV_8UC1 && peaks.size() == labels.size());
+    
+    // The largest finite distance of the label, as distanceTransformPeaks finds it on the binary image of the label
+    float maximum = 0;
+    for (int i = 0; i < labels.rows; i++) {
+        const uchar *labelRow = labels.ptr<uchar>(i);
+        const float *row = squaredDistance.ptr<float>(i);
+        for (int j = 0; j < labels.cols; j++) {
+            if (labelRow[j] == label && row[j] != std::numeric_limits<float>::infinity()) {
+                maximum = std::max(maximum, row[j]);
+            }
+        }
+    }
+    if (maximum <= 0) {
+        peaks.setTo(0);
+        return;
+    }
+    const float threshold = peakThreshold * peakThreshold * maximum;
+    
+    // Threshold and 3x3 dilation in a single pass, over the pixels of the label only
+    cv::parallel_for_(cv::Range(0, labels.rows), [&](const cv::Range &range) {
+        thread_local std::vector<uchar> verticalPeaks;
+        verticalPeaks.resize(labels.cols);
+        for (int i = range.start; i < range.end; i++) {
+            std::fill(verticalPeaks.begin(), verticalPeaks.end(), 0);
+            for (int neighbor = std::max(i - 1, 0); neighbor <= std::min(i + 1, labels.rows - 1); neighbor++) {
+                const uchar *labelRow = labels.ptr<uchar>(neighbor);
+                const float *row = squaredDistance.ptr<float>(neighbor);
+                for (int j = 0; j < labels.cols; j++) {
+                    verticalPeaks[j] |= (labelRow[j] == label && row[j] > threshold) ? 255 : 0;
+                }
+            }
+            uchar *peakRow = peaks.ptr<uchar>(i);
+            for (int j = 0; j < labels.cols; j++) {
+                uchar peak = verticalPeaks[j];
+                if (j > 0) peak |= verticalPeaks[j - 1];
+                if (j < labels.cols - 1) peak |= verticalPeaks[j + 1];
+                peakRow[j] = peak;
+            }
+        }
+    });
+}
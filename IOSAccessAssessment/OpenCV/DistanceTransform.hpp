@@ -0,0 +1,57 @@
+//
+//  DistanceTransform.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef DistanceTransform_hpp
+#define DistanceTransform_hpp
+#include <opencv2/opencv.hpp>
+
+/**
+    Computes the exact squared Euclidean distance of every non-zero pixel of a binary image to the nearest zero pixel.
+ 
+    This is the separable algorithm by Felzenszwalb and Huttenlocher: a column pass followed by a row pass,
+    each of which runs in parallel on the OpenCV thread pool (see cv::setNumThreads).
+    Pixels outside the image are not treated as zero pixels.
+ 
+    The output must already have the size of the binary image, and type CV_32FC1.
+    Each entry of rowMaxima is set to the largest squared distance of the corresponding row.
+ */
+void squaredDistanceTransform (cv::Mat binary, cv::Mat squaredDistance, std::vector<float> &rowMaxima);
+
+/**
+    Computes the watershed marker peaks of a binary image.
+ 
+    This is a fused equivalent of the following chain, that never materializes the normalized distance image:
+        cv::distanceTransform(binary, dist, cv::DIST_L2, cv::DIST_MASK_PRECISE);
+        cv::normalize(dist, dist, 0, 1.0, cv::NORM_MINMAX);
+        cv::threshold(dist, dist, peakThreshold, 1.0, cv::THRESH_BINARY);
+        cv::dilate(dist, dist, cv::Mat());
+        dist.convertTo(peaks, CV_8U);
+    The peaks are set to 255 instead of 1.
+ 
+    The squared distance buffer (CV_32FC1) and the peaks (CV_8UC1) must already have the size of the binary image.
+ */
+void distanceTransformPeaks (cv::Mat binary, float peakThreshold,
+                             cv::Mat squaredDistance, std::vector<float> &rowMaxima, cv::Mat peaks);
+
+/**
+    Same as squaredDistanceTransform, for an image of several labels at once (label 0 is the background).
+ 
+    Every pixel of a label gets the squared distance to the nearest pixel with another value, zero or not, which is the
+    distance that squaredDistanceTransform gives it on the binary image of its label alone. Pixels of the background get 0.
+    Each entry of rowMaxima is set to the largest squared distance of the corresponding row, over all the labels.
+ */
+void squaredLabelDistanceTransform (cv::Mat labels, cv::Mat squaredDistance, std::vector<float> &rowMaxima);
+
+/**
+    The marker peaks of a single label of an image of labels, from the distances of squaredLabelDistanceTransform.
+    They are equal to the peaks of distanceTransformPeaks on the binary image of that label alone.
+ 
+    The peaks (CV_8UC1) must already have the size of the labels.
+ */
+void labelDistancePeaks (cv::Mat labels, uchar label, float peakThreshold, cv::Mat squaredDistance, cv::Mat peaks);
+
+#endif /* DistanceTransform_hpp */
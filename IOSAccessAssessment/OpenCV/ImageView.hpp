@@ -0,0 +1,53 @@
+//
+//  ImageView.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef ImageView_hpp
+#define ImageView_hpp
+#include <cstddef>
+#include <cstdint>
+
+/**
+    Pixel layouts that can be described by an ImageView.
+ */
+enum class ImagePixelFormat {
+    Gray8,      // 1 channel, 8 bits
+    BGRA8,      // 4 channels, 8 bits each, in B, G, R, A order
+    RGBA8,      // 4 channels, 8 bits each, in R, G, B, A order
+    Float32     // 1 channel, 32-bit float (e.g. depth in meters)
+};
+
+/**
+    A non-owning view of image memory, such as a locked pixel buffer.
+ 
+    This does not depend on any platform or image library, so the C++ core can take images from any source without copies.
+    The memory must stay valid (and locked, if it is a pixel buffer) while the view is being used.
+ */
+struct ImageView {
+    void *data = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t bytesPerRow = 0;
+    ImagePixelFormat format = ImagePixelFormat::Gray8;
+    
+    bool isEmpty () const {
+        return data == nullptr || width <= 0 || height <= 0;
+    }
+    
+    static size_t bytesPerPixel (ImagePixelFormat format) {
+        switch (format) {
+            case ImagePixelFormat::Gray8:
+                return 1;
+            case ImagePixelFormat::BGRA8:
+            case ImagePixelFormat::RGBA8:
+            case ImagePixelFormat::Float32:
+                return 4;
+        }
+        return 0;
+    }
+};
+
+#endif /* ImageView_hpp */
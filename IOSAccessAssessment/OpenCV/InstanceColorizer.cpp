@@ -0,0 +1,86 @@
+//
+//  InstanceColorizer.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "InstanceColorizer.hpp"
+#include <algorithm>
+#include <cstring>
+
+/**
+    A small integer hash (the finalizer of MurmurHash3), which spreads consecutive inputs over the whole range.
+ */
+static inline uint32_t mixBits (uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x85ebca6bu;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35u;
+    value ^= value >> 16;
+    return value;
+}
+
+cv::Vec3b instanceColor (uint32_t seed, int labelValue, size_t instanceIndex) {
+    uint32_t hash = mixBits(seed ^ mixBits(static_cast<uint32_t>(labelValue) * 0x9e3779b9u
+                                           + static_cast<uint32_t>(instanceIndex)));
+    // Each channel is kept within [64, 255], so no color is close to black
+    uchar b = static_cast<uchar>(64 + ((hash & 0xff) * 192 >> 8));
+    uchar g = static_cast<uchar>(64 + (((hash >> 8) & 0xff) * 192 >> 8));
+    uchar r = static_cast<uchar>(64 + (((hash >> 16) & 0xff) * 192 >> 8));
+    return cv::Vec3b(b, g, r);
+}
+
+void instanceColors (uint32_t seed, int labelValue, size_t count, std::vector<cv::Vec3b> &colors) {
+    colors.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        colors[i] = instanceColor(seed, labelValue, i);
+    }
+}
+
+/**
+    Colors the rows [firstRow, lastRow) of the markers.
+    The table has an entry for every marker from 0 to count + 1, where 0 and count + 1 are transparent, so every marker
+    maps to an entry with an unsigned minimum, and the loop has no branches: the compiler vectorizes it, with gathers
+    on the targets that have them.
+ */
+static void colorizeRows (const cv::Mat &markers, const uint32_t *table, uint32_t count, int firstRow, int lastRow, cv::Mat &output) {
+    const uint32_t lastEntry = count + 1;
+    for (int i = firstRow; i < lastRow; i++)
+    {
+        const int *markerRow = markers.ptr<int>(i);
+        uint32_t *outputRow = output.ptr<uint32_t>(i);
+        for (int j = 0; j < markers.cols; j++)
+        {
+            // Markers below 0 wrap around to large values, so they land on the last, transparent entry
+            outputRow[j] = table[std::min(static_cast<uint32_t>(markerRow[j]), lastEntry)];
+        }
+    }
+}
+
+void colorizeMarkers (cv::Mat markers, const std::vector<cv::Vec3b> &colors, cv::Mat output) {
+    CV_Assert(markers.type() == CV_32SC1);
+    CV_Assert(output.type() == CV_8UC4 && output.size() == markers.size());
+    
+    // Lookup table of packed BGRA pixels, indexed by marker, with transparent entries for 0 and for count + 1
+    thread_local std::vector<uint32_t> lookupTable;
+    lookupTable.resize(colors.size() + 2);
+    lookupTable.front() = 0;
+    lookupTable.back() = 0;
+    for (size_t i = 0; i < colors.size(); i++) {
+        const uchar bgra[4] = { colors[i][0], colors[i][1], colors[i][2], 255 };
+        std::memcpy(&lookupTable[i + 1], bgra, sizeof(uint32_t));
+    }
+    const uint32_t *table = lookupTable.data();
+    const uint32_t count = static_cast<uint32_t>(colors.size());
+    
+    // Rows are split between the threads of OpenCV, unless the image is too small to make up for starting them
+    const size_t parallelPixels = 1 << 16;
+    if (markers.total() < parallelPixels) {
+        colorizeRows(markers, table, count, 0, markers.rows, output);
+        return;
+    }
+    cv::parallel_for_(cv::Range(0, markers.rows), [&](const cv::Range &range) {
+        colorizeRows(markers, table, count, range.start, range.end, output);
+    });
+}
@@ -0,0 +1,36 @@
+//
+//  InstanceColorizer.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef InstanceColorizer_hpp
+#define InstanceColorizer_hpp
+#include <opencv2/opencv.hpp>
+
+/**
+    Returns the color of an instance of a label.
+ 
+    The color only depends on the seed, the label value and the instance index, so outputs are reproducible across runs.
+    Colors are never dark, so that they cannot be confused with the (black) background.
+ */
+cv::Vec3b instanceColor (uint32_t seed, int labelValue, size_t instanceIndex);
+
+/**
+    Fills the colors of the first count instances of a label.
+ */
+void instanceColors (uint32_t seed, int labelValue, size_t count, std::vector<cv::Vec3b> &colors);
+
+/**
+    Colors a watershed marker image in a single pass.
+ 
+    Markers from 1 to colors.size() get the corresponding color with an opaque alpha.
+    Every other marker (boundaries, unknown and background) is fully transparent.
+    This is equivalent to coloring the markers on a black image and then calling makeBackgroundTransparent.
+ 
+    The output must already have the size of the markers, and type CV_8UC4 (BGRA).
+ */
+void colorizeMarkers (cv::Mat markers, const std::vector<cv::Vec3b> &colors, cv::Mat output);
+
+#endif /* InstanceColorizer_hpp */
@@ -21,18 +21,31 @@
 
 #import <UIKit/UIKit.h>
 #import <Foundation/Foundation.h>
+#import <CoreVideo/CoreVideo.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+    The contours and colors are kept in flat buffers instead of one object per point.
+ 
+    contourPoints holds the (x, y) int32 pairs of all the contours back to back.
+    contourOffsets holds contourCount + 1 int32 values, and the points of contour i are the pairs from
+    contourOffsets[i] up to (excluding) contourOffsets[i + 1].
+    colors holds one (b, g, r) uint8 triplet per contour.
+ */
 @interface WatershedResult : NSObject
 
 @property (nonatomic, strong) UIImage *image;
-@property (nonatomic, strong) NSArray<NSArray<NSValue *> *> *contours;
-@property (nonatomic, strong) NSArray<NSValue *> *colors;
+@property (nonatomic, strong) NSData *contourPoints;
+@property (nonatomic, strong) NSData *contourOffsets;
+@property (nonatomic, strong) NSData *colors;
+@property (nonatomic, assign) NSInteger contourCount;
 
 - (instancetype)initWithImage:(UIImage *)image
-                     contours:(NSArray<NSArray<NSValue *> *> *)contours
-                       colors:(NSArray<NSValue *> *)colors;
+                contourPoints:(NSData *)contourPoints
+               contourOffsets:(NSData *)contourOffsets
+                       colors:(NSData *)colors
+                 contourCount:(NSInteger)contourCount;
 
 @end
 
@@ -47,6 +60,34 @@ NS_ASSUME_NONNULL_BEGIN
                                                              labelValue:(int)labelValue
     NS_SWIFT_NAME(perform1DWatershedWithContoursColors(maskImage:depthImage:labelValue:));
 
+    /**
+        Performs the watershed for every label value in a single call, sharing the per-frame work between them.
+        The results are in the same order as the label values.
+     */
+    + (NSArray<WatershedResult *> *)performMultiLabelWatershed:(UIImage*)maskImage
+                                                    depthImage:(UIImage*)depthImage
+                                                   labelValues:(NSArray<NSNumber *> *)labelValues
+    NS_SWIFT_NAME(performMultiLabelWatershed(maskImage:depthImage:labelValues:));
+
+    /**
+        Same as perform1DWatershedWithContoursColors, but reads the mask and depth directly from the pixel buffers, without copying them.
+        Supported mask formats are OneComponent8, 32BGRA and 32RGBA. The depth buffer may be DepthFloat32 or OneComponent32Float.
+        Returns nil if the mask format is not supported.
+     */
+    + (WatershedResult * _Nullable)perform1DWatershedWithContoursColorsForMaskBuffer:(CVPixelBufferRef)maskBuffer
+                                                                         depthBuffer:(CVPixelBufferRef _Nullable)depthBuffer
+                                                                          labelValue:(int)labelValue
+    NS_SWIFT_NAME(perform1DWatershedWithContoursColors(maskBuffer:depthBuffer:labelValue:));
+
+    /**
+        Same as performMultiLabelWatershed, but reads the mask and depth directly from the pixel buffers, without copying them.
+        Returns nil if the mask format is not supported.
+     */
+    + (NSArray<WatershedResult *> * _Nullable)performMultiLabelWatershedForMaskBuffer:(CVPixelBufferRef)maskBuffer
+                                                                          depthBuffer:(CVPixelBufferRef _Nullable)depthBuffer
+                                                                          labelValues:(NSArray<NSNumber *> *)labelValues
+    NS_SWIFT_NAME(performMultiLabelWatershed(maskBuffer:depthBuffer:labelValues:));
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -14,19 +14,81 @@
 @implementation WatershedResult
 
 - (instancetype)initWithImage:(UIImage *)image
-                     contours:(NSArray<NSArray<NSValue *> *> *)contours
-                       colors:(NSArray<NSValue *> *)colors {
+                contourPoints:(NSData *)contourPoints
+               contourOffsets:(NSData *)contourOffsets
+                       colors:(NSData *)colors
+                 contourCount:(NSInteger)contourCount {
     self = [super init];
     if (self) {
         _image = image;
-        _contours = contours;
+        _contourPoints = contourPoints;
+        _contourOffsets = contourOffsets;
         _colors = colors;
+        _contourCount = contourCount;
     }
     return self;
 }
 
 @end
 
+/**
+    Describes the memory of a locked pixel buffer. The view is empty if the pixel format is not supported.
+ */
+static ImageView imageViewFromPixelBuffer(CVPixelBufferRef pixelBuffer) {
+    ImageView view;
+    if (pixelBuffer == NULL) {
+        return view;
+    }
+    switch (CVPixelBufferGetPixelFormatType(pixelBuffer)) {
+        case kCVPixelFormatType_OneComponent8:
+            view.format = ImagePixelFormat::Gray8;
+            break;
+        case kCVPixelFormatType_32BGRA:
+            view.format = ImagePixelFormat::BGRA8;
+            break;
+        case kCVPixelFormatType_32RGBA:
+            view.format = ImagePixelFormat::RGBA8;
+            break;
+        case kCVPixelFormatType_DepthFloat32:
+        case kCVPixelFormatType_OneComponent32Float:
+            view.format = ImagePixelFormat::Float32;
+            break;
+        default:
+            return view;
+    }
+    view.data = CVPixelBufferGetBaseAddress(pixelBuffer);
+    view.width = (int)CVPixelBufferGetWidth(pixelBuffer);
+    view.height = (int)CVPixelBufferGetHeight(pixelBuffer);
+    view.bytesPerRow = CVPixelBufferGetBytesPerRow(pixelBuffer);
+    return view;
+}
+
+/**
+    The workspace used by the methods that return workspace results, kept per thread.
+ */
+static WatershedWorkspace &wrapperWorkspace() {
+    thread_local WatershedWorkspace workspace;
+    return workspace;
+}
+
+/**
+    Converts a watershed result to its Objective-C counterpart.
+    The image is copied out of the workspace once, since the workspace buffers are reused by the next call.
+    The contour buffers are moved into the result, and are left empty.
+ */
+static WatershedResult *convertLabelResult(WatershedLabelResult &result, bool ownsImage) {
+    UIImage *image = [UIImage imageWithCVMat:(ownsImage ? result.image : result.image.clone())];
+    NSInteger contourCount = (NSInteger)result.contours.count();
+    NSData *contourPoints = [OtherConversions convertContourPointsToNSData:result.contours.points];
+    NSData *contourOffsets = [OtherConversions convertContourOffsetsToNSData:result.contours.offsets];
+    NSData *colors = [OtherConversions convertColorsToNSData:result.contours.colors];
+    return [[WatershedResult alloc] initWithImage:image
+                                    contourPoints:contourPoints
+                                   contourOffsets:contourOffsets
+                                           colors:colors
+                                     contourCount:contourCount];
+}
+
 @implementation OpenCVWrapper
 
 + (UIImage *)perform1DWatershed:(UIImage*)maskImage
@@ -45,17 +107,91 @@
     cv::Mat maskMat = [maskImage CVMat];
     cv::Mat depthMat = [depthImage CVMat];
     
-    std::tuple<cv::Mat, std::vector<std::vector<cv::Point>>, std::vector<cv::Vec3b>> output = watershed1DMaskAndDepthAndReturnContoursColors(maskMat, depthMat, labelValue);
-    cv::Mat outputMat = std::get<0>(output);
-    std::vector<std::vector<cv::Point>> contours = std::get<1>(output);
-    std::vector<cv::Vec3b> colors = std::get<2>(output);
+    WatershedLabelResult output;
+    watershed1DMaskAndDepthAndReturnContoursColors(maskMat, depthMat, labelValue, wrapperWorkspace(), output);
+    return convertLabelResult(output, false);
+}
+
++ (NSArray<WatershedResult *> *)performMultiLabelWatershed:(UIImage*)maskImage
+                                                depthImage:(UIImage*)depthImage
+                                               labelValues:(NSArray<NSNumber *> *)labelValues {
+    cv::Mat maskMat = [maskImage CVMat];
+    cv::Mat depthMat = [depthImage CVMat];
+    
+    std::vector<int> labels;
+    labels.reserve(labelValues.count);
+    for (NSNumber *labelValue in labelValues) {
+        labels.push_back(labelValue.intValue);
+    }
     
-    UIImage *image = [UIImage imageWithCVMat:outputMat];
-    NSArray<NSArray<NSValue *> *> *convertedContours = [OtherConversions convertContoursToNSValue:contours];
-    NSArray<NSValue *> *convertedColors = [OtherConversions convertColorsToNSValue:colors];
+    std::vector<WatershedLabelResult> outputs = watershedMultiLabelMaskAndDepth(maskMat, depthMat, labels);
+    NSMutableArray<WatershedResult *> *results = [NSMutableArray arrayWithCapacity:outputs.size()];
+    for (WatershedLabelResult &output : outputs) {
+        [results addObject:convertLabelResult(output, true)];
+    }
+    return results;
+}
 
-    // Create and return an instance of WatershedResult
-    return [[WatershedResult alloc] initWithImage:image contours:convertedContours colors:convertedColors];
++ (WatershedResult *)perform1DWatershedWithContoursColorsForMaskBuffer:(CVPixelBufferRef)maskBuffer
+                                                           depthBuffer:(CVPixelBufferRef)depthBuffer
+                                                            labelValue:(int)labelValue {
+    CVPixelBufferLockBaseAddress(maskBuffer, kCVPixelBufferLock_ReadOnly);
+    if (depthBuffer != NULL) {
+        CVPixelBufferLockBaseAddress(depthBuffer, kCVPixelBufferLock_ReadOnly);
+    }
+    ImageView maskView = imageViewFromPixelBuffer(maskBuffer);
+    ImageView depthView = imageViewFromPixelBuffer(depthBuffer);
+    
+    WatershedLabelResult output;
+    if (!maskView.isEmpty()) {
+        watershed1DMaskAndDepthAndReturnContoursColors(maskView, depthView, labelValue, wrapperWorkspace(), output);
+    }
+    
+    if (depthBuffer != NULL) {
+        CVPixelBufferUnlockBaseAddress(depthBuffer, kCVPixelBufferLock_ReadOnly);
+    }
+    CVPixelBufferUnlockBaseAddress(maskBuffer, kCVPixelBufferLock_ReadOnly);
+    
+    if (maskView.isEmpty()) {
+        return nil;
+    }
+    return convertLabelResult(output, false);
+}
+
++ (NSArray<WatershedResult *> *)performMultiLabelWatershedForMaskBuffer:(CVPixelBufferRef)maskBuffer
+                                                            depthBuffer:(CVPixelBufferRef)depthBuffer
+                                                            labelValues:(NSArray<NSNumber *> *)labelValues {
+    std::vector<int> labels;
+    labels.reserve(labelValues.count);
+    for (NSNumber *labelValue in labelValues) {
+        labels.push_back(labelValue.intValue);
+    }
+    
+    CVPixelBufferLockBaseAddress(maskBuffer, kCVPixelBufferLock_ReadOnly);
+    if (depthBuffer != NULL) {
+        CVPixelBufferLockBaseAddress(depthBuffer, kCVPixelBufferLock_ReadOnly);
+    }
+    ImageView maskView = imageViewFromPixelBuffer(maskBuffer);
+    ImageView depthView = imageViewFromPixelBuffer(depthBuffer);
+    
+    std::vector<WatershedLabelResult> outputs;
+    if (!maskView.isEmpty()) {
+        watershedMultiLabelMaskAndDepth(maskView, depthView, labels, wrapperWorkspace(), outputs);
+    }
+    
+    if (depthBuffer != NULL) {
+        CVPixelBufferUnlockBaseAddress(depthBuffer, kCVPixelBufferLock_ReadOnly);
+    }
+    CVPixelBufferUnlockBaseAddress(maskBuffer, kCVPixelBufferLock_ReadOnly);
+    
+    if (maskView.isEmpty()) {
+        return nil;
+    }
+    NSMutableArray<WatershedResult *> *results = [NSMutableArray arrayWithCapacity:outputs.size()];
+    for (WatershedLabelResult &output : outputs) {
+        [results addObject:convertLabelResult(output, false)];
+    }
+    return results;
 }
 
 @end
@@ -22,9 +22,14 @@
  */
 @interface OtherConversions: NSObject
 
-+ (NSArray<NSArray<NSValue *> *> *) convertContoursToNSValue:(std::vector<std::vector<cv::Point>>) contours;
+/**
+    The methods below move the vector into the returned data without copying its contents, and leave the vector empty.
+ */
++ (NSData *) convertContourPointsToNSData:(std::vector<cv::Point> &) points;
+
++ (NSData *) convertContourOffsetsToNSData:(std::vector<int> &) offsets;
 
-+ (NSArray<NSValue *> *) convertColorsToNSValue:(std::vector<cv::Vec3b>) colors;
++ (NSData *) convertColorsToNSData:(std::vector<cv::Vec3b> &) colors;
 
 @end
 
@@ -7,30 +7,38 @@
 
 #include "OtherConversions.hpp"
 
+/**
+    Wraps the memory of a vector in an NSData, which takes ownership of the vector and frees it when it is deallocated.
+ */
+template <typename T>
+static NSData *dataByMovingVector(std::vector<T> &vector) {
+    if (vector.empty()) {
+        return [NSData data];
+    }
+    std::vector<T> *ownedVector = new std::vector<T>(std::move(vector));
+    vector.clear();
+    return [[NSData alloc] initWithBytesNoCopy:ownedVector->data()
+                                        length:ownedVector->size() * sizeof(T)
+                                   deallocator:^(void *bytes, NSUInteger length) {
+        delete ownedVector;
+    }];
+}
+
 @implementation OtherConversions
 
-+ (NSArray<NSArray<NSValue *> *> *) convertContoursToNSValue:(std::vector<std::vector<cv::Point>>) contours {
-    NSMutableArray<NSMutableArray<NSValue *> *> *convertedContours = [NSMutableArray array];
-    for (const std::vector<cv::Point> &contour : contours) {
-        NSMutableArray<NSValue *> *convertedContour = [NSMutableArray array];
++ (NSData *) convertContourPointsToNSData:(std::vector<cv::Point> &) points {
+    static_assert(sizeof(cv::Point) == 2 * sizeof(int32_t), "Contour points are exposed as int32 pairs");
+    return dataByMovingVector(points);
+}
 
-        for (const cv::Point &point : contour) {
-            CGPoint cgPoint = CGPointMake(point.x, point.y);
-            [convertedContour addObject:[NSValue valueWithCGPoint:cgPoint]];
-        }
-        [convertedContours addObject:convertedContour];
-    }
-    return convertedContours;
++ (NSData *) convertContourOffsetsToNSData:(std::vector<int> &) offsets {
+    static_assert(sizeof(int) == sizeof(int32_t), "Contour offsets are exposed as int32 values");
+    return dataByMovingVector(offsets);
 }
 
-+ (NSArray<NSValue *> *) convertColorsToNSValue:(std::vector<cv::Vec3b>) colors {
-    NSMutableArray<NSValue *> *convertedVec3bArray = [NSMutableArray array];
-    for (const cv::Vec3b &vec : colors) {
-        // Convert cv::Vec3b to an array of 3 UInt8 values
-        uint8_t values[3] = {vec[0], vec[1], vec[2]};
-        [convertedVec3bArray addObject:[NSValue valueWithBytes:&values objCType:@encode(uint8_t[3])]];
-    }
-    return convertedVec3bArray;
++ (NSData *) convertColorsToNSData:(std::vector<cv::Vec3b> &) colors {
+    static_assert(sizeof(cv::Vec3b) == 3, "Colors are exposed as uint8 triplets");
+    return dataByMovingVector(colors);
 }
 
 @end
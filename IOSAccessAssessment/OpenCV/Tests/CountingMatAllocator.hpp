@@ -0,0 +1,43 @@
+//
+//  CountingMatAllocator.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef CountingMatAllocator_hpp
+#define CountingMatAllocator_hpp
+#include <opencv2/opencv.hpp>
+#include <atomic>
+
+/**
+    A cv::Mat allocator that counts the buffers it allocates, and hands the work to the standard allocator of OpenCV.
+    Installed with cv::Mat::setDefaultAllocator, it sees every cv::Mat buffer that is allocated afterwards,
+    including those that OpenCV allocates inside its own functions.
+ */
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+    mutable std::atomic<uint64_t> buffers { 0 };
+    mutable std::atomic<uint64_t> bytes { 0 };
+    
+    cv::UMatData *allocate (int dims, const int *sizes, int type, void *data, size_t *step,
+                            cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        cv::UMatData *u = cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        // Headers of memory that the caller owns are not allocations
+        if (u != nullptr && data == nullptr) {
+            buffers.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(u->size, std::memory_order_relaxed);
+        }
+        return u;
+    }
+    
+    bool allocate (cv::UMatData *u, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+    }
+    
+    void deallocate (cv::UMatData *u) const override {
+        cv::Mat::getStdAllocator()->deallocate(u);
+    }
+};
+
+#endif /* CountingMatAllocator_hpp */
@@ -0,0 +1,168 @@
+//
+//  DistanceTransformTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include "DistanceTransform.hpp"
+
+/**
+    Checks squaredDistanceTransform against cv::distanceTransform with DIST_L2 and DIST_MASK_PRECISE (the exact transform),
+    and distanceTransformPeaks against the chain of OpenCV calls that it replaces, on random and edge case images,
+    with one thread and with the default threads of OpenCV.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// Random blobs of zero pixels on a background of ones, or the other way round
+static cv::Mat randomBinary (cv::Size size, double zeroFraction, uint32_t seed) {
+    cv::RNG rng(seed);
+    cv::Mat binary(size, CV_8UC1, cv::Scalar(255));
+    int blobs = std::max(1, cvRound(zeroFraction * size.area() / 64.0));
+    for (int b = 0; b < blobs; b++) {
+        cv::Point center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::circle(binary, center, rng.uniform(0, 6), cv::Scalar(0), -1);
+    }
+    return binary;
+}
+
+static void checkDistances (const std::string &name, const cv::Mat &binary) {
+    cv::Mat reference;
+    cv::distanceTransform(binary, reference, cv::DIST_L2, cv::DIST_MASK_PRECISE);
+    cv::Mat squared(binary.size(), CV_32FC1);
+    std::vector<float> rowMaxima;
+    squaredDistanceTransform(binary, squared, rowMaxima);
+
+    double maxError = 0;
+    bool rowMaximaMatch = true;
+    for (int i = 0; i < binary.rows; i++) {
+        float rowMaximum = 0;
+        for (int j = 0; j < binary.cols; j++) {
+            float distance = std::sqrt(squared.at<float>(i, j));
+            // Relative to the distance, for the rounding of the square root of large distances
+            double error = std::fabs(distance - reference.at<float>(i, j)) / std::max(1.0f, reference.at<float>(i, j));
+            maxError = std::max(maxError, error);
+            rowMaximum = std::max(rowMaximum, squared.at<float>(i, j));
+        }
+        rowMaximaMatch = rowMaximaMatch && rowMaximum == rowMaxima[i];
+    }
+    char detail[128];
+    std::snprintf(detail, sizeof(detail), "%dx%d, max relative error %g", binary.cols, binary.rows, maxError);
+    check(maxError <= 1e-3 && rowMaximaMatch, name + " distances", detail);
+}
+
+/**
+    Pixels whose peak differs from the reference chain are only allowed next to a distance that is at the threshold,
+    where the float rounding of the two ways of comparing can differ.
+ */
+static void checkPeaks (const std::string &name, const cv::Mat &binary) {
+    const float peakThreshold = 0.4f;
+    cv::Mat dist;
+    cv::distanceTransform(binary, dist, cv::DIST_L2, cv::DIST_MASK_PRECISE);
+    cv::Mat normalized;
+    cv::normalize(dist, normalized, 0, 1.0, cv::NORM_MINMAX);
+    cv::Mat reference;
+    cv::threshold(normalized, reference, peakThreshold, 1.0, cv::THRESH_BINARY);
+    cv::dilate(reference, reference, cv::Mat());
+    reference.convertTo(reference, CV_8U, 255);
+
+    cv::Mat squared(binary.size(), CV_32FC1);
+    cv::Mat peaks(binary.size(), CV_8UC1);
+    std::vector<float> rowMaxima;
+    distanceTransformPeaks(binary, peakThreshold, squared, rowMaxima, peaks);
+
+    int mismatches = 0;
+    int unexplained = 0;
+    for (int i = 0; i < binary.rows; i++) {
+        for (int j = 0; j < binary.cols; j++) {
+            if (peaks.at<uchar>(i, j) == reference.at<uchar>(i, j)) {
+                continue;
+            }
+            mismatches++;
+            bool nearThreshold = false;
+            for (int y = std::max(i - 1, 0); y <= std::min(i + 1, binary.rows - 1); y++) {
+                for (int x = std::max(j - 1, 0); x <= std::min(j + 1, binary.cols - 1); x++) {
+                    nearThreshold = nearThreshold || std::fabs(normalized.at<float>(y, x) - peakThreshold) < 1e-4f;
+                }
+            }
+            unexplained += !nearThreshold;
+        }
+    }
+    char detail[128];
+    std::snprintf(detail, sizeof(detail), "%dx%d, %d pixels differ, %d away from the threshold",
+                  binary.cols, binary.rows, mismatches, unexplained);
+    check(unexplained == 0, name + " peaks", detail);
+}
+
+/// Without zero pixels, every distance is infinite, and there are no peaks
+static void checkWithoutZeros () {
+    cv::Mat binary(17, 23, CV_8UC1, cv::Scalar(255));
+    cv::Mat squared(binary.size(), CV_32FC1);
+    cv::Mat peaks(binary.size(), CV_8UC1, cv::Scalar(7));
+    std::vector<float> rowMaxima;
+    distanceTransformPeaks(binary, 0.4f, squared, rowMaxima, peaks);
+    bool infinite = true;
+    for (int i = 0; i < binary.rows; i++) {
+        for (int j = 0; j < binary.cols; j++) {
+            infinite = infinite && squared.at<float>(i, j) == std::numeric_limits<float>::infinity();
+        }
+    }
+    check(infinite && cv::countNonZero(peaks) == 0, "no zero pixels", "infinite distances, no peaks");
+}
+
+/// The output must not depend on the number of threads
+static void checkThreads (const cv::Mat &binary) {
+    std::vector<float> rowMaxima;
+    cv::Mat serial(binary.size(), CV_32FC1);
+    cv::Mat parallel(binary.size(), CV_32FC1);
+    int threads = cv::getNumThreads();
+    cv::setNumThreads(1);
+    squaredDistanceTransform(binary, serial, rowMaxima);
+    cv::setNumThreads(threads);
+    squaredDistanceTransform(binary, parallel, rowMaxima);
+    bool identical = std::memcmp(serial.data, parallel.data, serial.total() * serial.elemSize()) == 0;
+    char detail[64];
+    std::snprintf(detail, sizeof(detail), "1 and %d threads", threads);
+    check(identical, "thread count", detail);
+}
+
+int main () {
+    const cv::Size sizes[] = { cv::Size(1, 1), cv::Size(1, 37), cv::Size(41, 1), cv::Size(64, 64),
+                               cv::Size(97, 131), cv::Size(640, 480) };
+    const double zeroFractions[] = { 0.01, 0.2, 1.0 };
+    uint32_t seed = 1;
+    for (const cv::Size &size : sizes) {
+        for (double zeroFraction : zeroFractions) {
+            cv::Mat binary = randomBinary(size, zeroFraction, seed++);
+            // The reference is not defined without a zero pixel, which has its own check
+            if (size_t(cv::countNonZero(binary)) == binary.total()) {
+                continue;
+            }
+            char name[64];
+            std::snprintf(name, sizeof(name), "%dx%d, %.2f zeros", size.width, size.height, zeroFraction);
+            checkDistances(name, binary);
+            checkPeaks(name, binary);
+        }
+    }
+
+    // A view into a larger image, as the watershed passes its regions
+    cv::Mat large = randomBinary(cv::Size(300, 200), 0.2, seed++);
+    cv::Mat region = large(cv::Rect(13, 7, 200, 150));
+    checkDistances("region view", region);
+    checkPeaks("region view", region);
+
+    checkWithoutZeros();
+    checkThreads(randomBinary(cv::Size(1920, 1440), 0.2, seed++));
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+//
+//  ImageViewTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cstdio>
+#include <cstring>
+#include "WatershedBenchmark.hpp"
+
+/**
+    Checks the ImageView entry points of the watershed against the cv::Mat ones, on views of padded rows
+    (as the pixel buffers of the camera have), in every pixel format:
+    - matFromImageView wraps the memory of the view, with its bytes per row, and does not copy it,
+    - BGRA, RGBA (with the channel order honored), grayscale masks and float depth give the same results as the cv::Mat path.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// A copy of an image in memory whose rows are padded, as a pixel buffer, and a view of it
+struct PaddedImage {
+    std::vector<uchar> memory;
+    ImageView view;
+
+    PaddedImage (const cv::Mat &image, ImagePixelFormat format, size_t padding) {
+        view.width = image.cols;
+        view.height = image.rows;
+        view.format = format;
+        view.bytesPerRow = image.cols * image.elemSize() + padding;
+        memory.assign(view.bytesPerRow * image.rows, 0xCD);
+        view.data = memory.data();
+        for (int i = 0; i < image.rows; i++) {
+            std::memcpy(memory.data() + i * view.bytesPerRow, image.ptr(i), image.cols * image.elemSize());
+        }
+    }
+};
+
+static bool sameResults (const std::vector<WatershedLabelResult> &results, const std::vector<WatershedLabelResult> &expected) {
+    if (results.size() != expected.size()) {
+        return false;
+    }
+    for (size_t k = 0; k < results.size(); k++) {
+        const cv::Mat &image = results[k].image;
+        if (image.size() != expected[k].image.size() || image.type() != expected[k].image.type()) {
+            return false;
+        }
+        for (int i = 0; i < image.rows; i++) {
+            if (std::memcmp(image.ptr(i), expected[k].image.ptr(i), image.cols * image.elemSize()) != 0) {
+                return false;
+            }
+        }
+        if (results[k].contours.points != expected[k].contours.points ||
+            results[k].contours.offsets != expected[k].contours.offsets) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t instanceCount (const std::vector<WatershedLabelResult> &results) {
+    size_t instances = 0;
+    for (const WatershedLabelResult &result : results) {
+        instances += result.contours.count();
+    }
+    return instances;
+}
+
+static void checkWrapping () {
+    const ImagePixelFormat formats[] = { ImagePixelFormat::Gray8, ImagePixelFormat::BGRA8, ImagePixelFormat::RGBA8,
+                                         ImagePixelFormat::Float32 };
+    const int types[] = { CV_8UC1, CV_8UC4, CV_8UC4, CV_32FC1 };
+    for (int f = 0; f < 4; f++) {
+        cv::Mat image(31, 17, types[f], cv::Scalar(1, 2, 3, 4));
+        PaddedImage padded(image, formats[f], 12);
+        cv::Mat wrapped = matFromImageView(padded.view);
+        bool same = wrapped.data == padded.view.data && wrapped.step[0] == padded.view.bytesPerRow &&
+                    wrapped.type() == types[f] && wrapped.cols == image.cols && wrapped.rows == image.rows &&
+                    wrapped.elemSize() == ImageView::bytesPerPixel(formats[f]);
+        char name[64];
+        std::snprintf(name, sizeof(name), "wraps format %d", f);
+        check(same, name, "same memory and bytes per row, no copy");
+    }
+    check(matFromImageView(ImageView()).empty(), "empty view", "empty matrix");
+}
+
+int main () {
+    checkWrapping();
+
+    SyntheticFrameOptions options;
+    options.size = cv::Size(320, 240);
+    options.classCount = 3;
+    options.blobDensity = 2.0f;
+    SyntheticFrame frame = makeSyntheticFrame(options);
+    const size_t padding = 64;
+
+    // BGRA mask on padded rows
+    WatershedWorkspace workspace;
+    std::vector<WatershedLabelResult> expected;
+    std::vector<WatershedLabelResult> results;
+    watershedMultiLabelMaskAndDepth(frame.mask.clone(), cv::Mat(), frame.labelValues, workspace, expected);
+    for (WatershedLabelResult &result : expected) {
+        result.image = result.image.clone();
+    }
+    PaddedImage bgra(frame.mask, ImagePixelFormat::BGRA8, padding);
+    watershedMultiLabelMaskAndDepth(bgra.view, ImageView(), frame.labelValues, workspace, results);
+    char detail[128];
+    std::snprintf(detail, sizeof(detail), "%zu instances", instanceCount(expected));
+    check(instanceCount(expected) > 0 && sameResults(results, expected), "BGRA view", detail);
+
+    // RGBA mask whose channels differ, so that reading it in the wrong order would give other gray values
+    cv::Mat gray;
+    cv::extractChannel(frame.mask, gray, 0);
+    cv::Mat zeros = cv::Mat::zeros(gray.size(), CV_8UC1);
+    cv::Mat alpha(gray.size(), CV_8UC1, cv::Scalar(255));
+    std::vector<cv::Mat> bgraChannels = { zeros, gray, gray, alpha };
+    std::vector<cv::Mat> rgbaChannels = { gray, gray, zeros, alpha };
+    cv::Mat unevenBGRA;
+    cv::Mat unevenRGBA;
+    cv::merge(bgraChannels, unevenBGRA);
+    cv::merge(rgbaChannels, unevenRGBA);
+    // The labels of the converted mask are the gray values of the label pixels
+    std::vector<int> unevenLabels;
+    for (int labelValue : frame.labelValues) {
+        cv::Mat pixel(1, 1, CV_8UC4, cv::Scalar(0, labelValue, labelValue, 255));
+        cv::Mat pixelGray;
+        cv::cvtColor(pixel, pixelGray, cv::COLOR_BGRA2GRAY);
+        unevenLabels.push_back(pixelGray.at<uchar>(0, 0));
+    }
+    watershedMultiLabelMaskAndDepth(unevenBGRA, cv::Mat(), unevenLabels, workspace, expected);
+    for (WatershedLabelResult &result : expected) {
+        result.image = result.image.clone();
+    }
+    PaddedImage rgba(unevenRGBA, ImagePixelFormat::RGBA8, padding);
+    watershedMultiLabelMaskAndDepth(rgba.view, ImageView(), unevenLabels, workspace, results);
+    std::snprintf(detail, sizeof(detail), "%zu instances", instanceCount(expected));
+    check(instanceCount(expected) > 0 && sameResults(results, expected), "RGBA view", detail);
+
+    // Grayscale mask, and float depth in the depth-aware mode
+    workspace.useDepth = true;
+    watershedMultiLabelMaskAndDepth(gray.clone(), frame.depth, frame.labelValues, workspace, expected);
+    for (WatershedLabelResult &result : expected) {
+        result.image = result.image.clone();
+    }
+    PaddedImage grayView(gray, ImagePixelFormat::Gray8, padding);
+    PaddedImage depthView(frame.depth, ImagePixelFormat::Float32, padding);
+    watershedMultiLabelMaskAndDepth(grayView.view, depthView.view, frame.labelValues, workspace, results);
+    std::snprintf(detail, sizeof(detail), "%zu instances", instanceCount(expected));
+    check(instanceCount(expected) > 0 && sameResults(results, expected), "gray and depth views", detail);
+
+    // The single label entry point
+    WatershedLabelResult single;
+    WatershedLabelResult singleExpected;
+    watershed1DMaskAndDepthAndReturnContoursColors(frame.mask, frame.depth, frame.labelValues[0], workspace, singleExpected);
+    singleExpected.image = singleExpected.image.clone();
+    watershed1DMaskAndDepthAndReturnContoursColors(bgra.view, depthView.view, frame.labelValues[0], workspace, single);
+    check(sameResults({ single }, { singleExpected }), "single label view", "BGRA mask and float depth");
+    return failures == 0 ? 0 : 1;
+}
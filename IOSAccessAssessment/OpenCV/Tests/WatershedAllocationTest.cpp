@@ -0,0 +1,112 @@
+//
+//  WatershedAllocationTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cstdio>
+#include "CountingMatAllocator.hpp"
+#include "HeapAllocations.hpp"
+#include "WatershedBenchmark.hpp"
+
+/**
+    Checks that once a workspace is warm, the watershed allocates no buffers of its own.
+
+    Frames of the same size, with other contents, must not reallocate the workspace, and every cv::Mat buffer that they
+    allocate must be one of the padded copies that cv::findContours makes of its input, once per label (OpenCV has no way
+    to find contours in place). The buffers per findContours call are measured first, on a frame of the same size.
+    Heap allocations of any kind are reported too; OpenCV's functions allocate small scratch memory of their own.
+ */
+static CountingMatAllocator matAllocator;
+
+static int failures = 0;
+
+static void check (bool condition, const char *name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name, detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// cv::Mat buffers allocated by a single cv::findContours call on a binary image of the given size
+static uint64_t findContoursBuffers (cv::Size size) {
+    cv::Mat binary = cv::Mat::zeros(size, CV_8UC1);
+    cv::circle(binary, cv::Point(size.width / 2, size.height / 2), std::min(size.width, size.height) / 4, cv::Scalar(255), -1);
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(binary, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    uint64_t before = matAllocator.buffers.load();
+    cv::findContours(binary, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    return matAllocator.buffers.load() - before;
+}
+
+/**
+    Runs a warm-up frame and then alternates between two frames of the same size, and checks the allocations of the
+    alternating frames. Each call runs the watershed of every label of a frame, through the given function.
+ */
+template <typename Watershed>
+static void checkSteadyState (const char *name, bool useDepth, Watershed watershed) {
+    SyntheticFrameOptions options;
+    options.size = cv::Size(640, 480);
+    options.classCount = 4;
+    options.blobDensity = 2.0f;
+    SyntheticFrame frames[2];
+    for (int f = 0; f < 2; f++) {
+        options.seed = f + 1;
+        frames[f] = makeSyntheticFrame(options);
+    }
+    const uint64_t buffersPerFindContours = findContoursBuffers(options.size);
+    const size_t labelCount = frames[0].labelValues.size();
+
+    WatershedProfile profile;
+    WatershedWorkspace workspace;
+    workspace.profile = &profile;
+    workspace.useDepth = useDepth;
+    watershed(frames[0], workspace);
+    watershed(frames[1], workspace);
+    profile.reset();
+
+    const int steadyFrames = 10;
+    uint64_t matBuffers = 0;
+    uint64_t heapAllocations = 0;
+    bool bufferBoundHolds = true;
+    for (int i = 0; i < steadyFrames; i++) {
+        uint64_t buffersBefore = matAllocator.buffers.load();
+        uint64_t heapBefore = heapAllocationCount();
+        watershed(frames[i % 2], workspace);
+        uint64_t frameBuffers = matAllocator.buffers.load() - buffersBefore;
+        heapAllocations += heapAllocationCount() - heapBefore;
+        matBuffers += frameBuffers;
+        bufferBoundHolds = bufferBoundHolds && frameBuffers <= buffersPerFindContours * labelCount;
+    }
+
+    char detail[256];
+    std::snprintf(detail, sizeof(detail), "%llu workspace reallocations in %d frames",
+                  static_cast<unsigned long long>(profile.workspaceReallocations), steadyFrames);
+    check(profile.workspaceReallocations == 0, name, detail);
+    std::snprintf(detail, sizeof(detail), "%.1f cv::Mat buffers per frame, at most %llu from findContours; %.1f heap allocations per frame",
+                  double(matBuffers) / steadyFrames, static_cast<unsigned long long>(buffersPerFindContours * labelCount),
+                  double(heapAllocations) / steadyFrames);
+    check(bufferBoundHolds, name, detail);
+}
+
+int main () {
+    cv::Mat::setDefaultAllocator(&matAllocator);
+
+    for (bool useDepth : { false, true }) {
+        checkSteadyState(useDepth ? "multi-label with depth" : "multi-label", useDepth,
+                         [](const SyntheticFrame &frame, WatershedWorkspace &workspace) {
+            static std::vector<WatershedLabelResult> results;
+            watershedMultiLabelMaskAndDepth(frame.mask, frame.depth, frame.labelValues, workspace, results);
+        });
+    }
+    checkSteadyState("single label", false, [](const SyntheticFrame &frame, WatershedWorkspace &workspace) {
+        static WatershedLabelResult result;
+        for (int labelValue : frame.labelValues) {
+            watershed1DMaskAndDepthAndReturnContoursColors(frame.mask, frame.depth, labelValue, workspace, result);
+        }
+    });
+
+    cv::Mat::setDefaultAllocator(nullptr);
+    return failures == 0 ? 0 : 1;
+}
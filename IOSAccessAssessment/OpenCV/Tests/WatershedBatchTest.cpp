@@ -0,0 +1,86 @@
+//
+//  WatershedBatchTest.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cstdio>
+#include <cstring>
+#include "WatershedBatch.hpp"
+#include "WatershedBenchmark.hpp"
+
+/**
+    Checks that watershedBatch gives the same results, in the same order, as running the jobs one after the other
+    with watershed1DMaskAndDepthAndReturnContoursColors, for several worker counts, on jobs of mixed frame sizes
+    (so that the workspaces of the workers are resized between jobs) and labels.
+ */
+static int failures = 0;
+
+static void check (bool condition, const std::string &name, const char *detail) {
+    std::printf("%s: %s (%s)\n", condition ? "PASS" : "FAIL", name.c_str(), detail);
+    if (!condition) {
+        failures++;
+    }
+}
+
+static bool sameResult (const WatershedLabelResult &result, const WatershedLabelResult &expected) {
+    if (result.labelValue != expected.labelValue || result.image.size() != expected.image.size() ||
+        result.image.type() != expected.image.type()) {
+        return false;
+    }
+    for (int i = 0; i < result.image.rows; i++) {
+        if (std::memcmp(result.image.ptr(i), expected.image.ptr(i), result.image.cols * result.image.elemSize()) != 0) {
+            return false;
+        }
+    }
+    return result.contours.points == expected.contours.points && result.contours.offsets == expected.contours.offsets &&
+           result.contours.colors == expected.contours.colors;
+}
+
+int main () {
+    const cv::Size sizes[] = { cv::Size(256, 256), cv::Size(320, 240), cv::Size(640, 480), cv::Size(97, 131) };
+    std::vector<WatershedJob> jobs;
+    uint32_t seed = 1;
+    for (int repeat = 0; repeat < 3; repeat++) {
+        for (const cv::Size &size : sizes) {
+            SyntheticFrameOptions options;
+            options.size = size;
+            options.classCount = 3;
+            options.blobDensity = 2.0f;
+            options.seed = seed++;
+            SyntheticFrame frame = makeSyntheticFrame(options);
+            for (int labelValue : frame.labelValues) {
+                jobs.push_back({ frame.mask, frame.depth, labelValue });
+            }
+        }
+    }
+
+    // The serial path, with a single workspace that is reused (and resized) from one job to the next
+    WatershedWorkspace workspace;
+    std::vector<WatershedLabelResult> expected(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        watershed1DMaskAndDepthAndReturnContoursColors(jobs[i].mask, jobs[i].depth, jobs[i].labelValue, workspace, expected[i]);
+        expected[i].image = expected[i].image.clone();
+    }
+
+    for (unsigned workerCount : { 1u, 2u, 3u, 8u, 0u }) {
+        WatershedBatchStats stats;
+        std::vector<WatershedLabelResult> results = watershedBatch(jobs, workerCount, &stats);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < jobs.size(); i++) {
+            mismatches += (i < results.size() && sameResult(results[i], expected[i])) ? 0 : 1;
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "%u workers", workerCount);
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "%zu jobs, %zu results, %zu differ from the serial path, ran on %u workers",
+                      jobs.size(), results.size(), mismatches, stats.workerCount);
+        check(results.size() == jobs.size() && mismatches == 0 && stats.jobCount == jobs.size() &&
+              stats.workerCount >= 1 && (workerCount == 0 || stats.workerCount <= workerCount), name, detail);
+    }
+
+    std::vector<WatershedLabelResult> none = watershedBatch(std::vector<WatershedJob>(), 4);
+    check(none.empty(), "no jobs", "no results");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+//
+//  ColorizeBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "InstanceColorizer.hpp"
+
+/**
+    Times colorizeMarkers against the per-pixel loop it replaced, on marker images like those of the watershed
+    (instances, boundaries of -1, and the background marker), for several sizes and instance counts,
+    with one thread and with the default threads of OpenCV. Prints the results as a JSON object.
+    Exits with 1 if the two ever color a pixel differently.
+
+    Usage: colorize_benchmark [iterations]
+ */
+typedef std::chrono::steady_clock Clock;
+
+template <typename Run>
+static double millisecondsPerRun (int iterations, const Run &run) {
+    run();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        run();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+}
+
+/// The per-pixel loop of colorizeMarkers before it was vectorized
+static void colorizeMarkersScalar (const cv::Mat &markers, const std::vector<cv::Vec3b> &colors, cv::Mat &output) {
+    std::vector<uint32_t> table(colors.size());
+    for (size_t i = 0; i < colors.size(); i++) {
+        const uchar bgra[4] = { colors[i][0], colors[i][1], colors[i][2], 255 };
+        std::memcpy(&table[i], bgra, sizeof(uint32_t));
+    }
+    const uint32_t count = static_cast<uint32_t>(colors.size());
+    for (int i = 0; i < markers.rows; i++) {
+        const int *markerRow = markers.ptr<int>(i);
+        uint32_t *outputRow = output.ptr<uint32_t>(i);
+        for (int j = 0; j < markers.cols; j++) {
+            uint32_t index = static_cast<uint32_t>(markerRow[j]) - 1u;
+            outputRow[j] = (index < count) ? table[index] : 0u;
+        }
+    }
+}
+
+/// Rectangular instances in a grid, with a boundary of -1 between them, on the background marker of the watershed
+static cv::Mat markerImage (cv::Size size, int instances) {
+    cv::Mat markers(size, CV_32SC1, cv::Scalar(255));
+    int columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(double(instances)))));
+    int cellWidth = std::max(2, size.width / columns);
+    int cellHeight = std::max(2, size.height / columns);
+    for (int k = 0; k < instances; k++) {
+        cv::Rect cell((k % columns) * cellWidth, (k / columns) * cellHeight, cellWidth, cellHeight);
+        cell &= cv::Rect(0, 0, size.width, size.height);
+        if (cell.empty()) {
+            continue;
+        }
+        markers(cell).setTo(cv::Scalar(-1));
+        cv::Rect inside(cell.x + 1, cell.y + 1, cell.width - 2, cell.height - 2);
+        if (!inside.empty()) {
+            markers(inside).setTo(cv::Scalar(k + 1));
+        }
+    }
+    return markers;
+}
+
+int main (int argc, char **argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 50;
+    if (iterations <= 0) {
+        std::fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    const cv::Size sizes[] = { cv::Size(64, 64), cv::Size(256, 256), cv::Size(640, 480), cv::Size(1920, 1440) };
+    const int instanceCounts[] = { 4, 64, 1024 };
+    const int defaultThreads = cv::getNumThreads();
+    bool identical = true;
+    bool first = true;
+    std::string json = "{\"opencv_version\":\"" CV_VERSION "\",\"cases\":[";
+    for (const cv::Size &size : sizes) {
+        for (int instances : instanceCounts) {
+            cv::Mat markers = markerImage(size, instances);
+            std::vector<cv::Vec3b> colors;
+            instanceColors(1, 128, instances, colors);
+            cv::Mat scalarOutput(size, CV_8UC4);
+            cv::Mat output(size, CV_8UC4);
+
+            double scalarMs = millisecondsPerRun(iterations, [&]() {
+                colorizeMarkersScalar(markers, colors, scalarOutput);
+            });
+            for (int threads : { 1, defaultThreads }) {
+                cv::setNumThreads(threads);
+                output.setTo(cv::Scalar(1, 2, 3, 4));
+                double colorizeMs = millisecondsPerRun(iterations, [&]() {
+                    colorizeMarkers(markers, colors, output);
+                });
+                bool same = std::memcmp(output.data, scalarOutput.data, output.total() * output.elemSize()) == 0;
+                identical = identical && same;
+
+                char buffer[384];
+                std::snprintf(buffer, sizeof(buffer),
+                              "%s{\"width\":%d,\"height\":%d,\"instances\":%d,\"threads\":%d,\"scalar_ms\":%.4f,"
+                              "\"colorize_ms\":%.4f,\"speedup\":%.3f,\"megapixels_per_second\":%.1f,\"identical\":%s}",
+                              first ? "" : ",", size.width, size.height, instances, threads, scalarMs, colorizeMs,
+                              scalarMs / colorizeMs, size.area() / 1e3 / colorizeMs, same ? "true" : "false");
+                json += buffer;
+                first = false;
+            }
+            cv::setNumThreads(defaultThreads);
+        }
+    }
+    json += "]}";
+    std::printf("%s\n", json.c_str());
+    return identical ? 0 : 1;
+}
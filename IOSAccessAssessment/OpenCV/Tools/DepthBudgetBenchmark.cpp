@@ -0,0 +1,125 @@
+//
+//  DepthBudgetBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "WatershedBenchmark.hpp"
+#include "WatershedProfile.hpp"
+
+/**
+    Measures what the depth-aware mode adds to the multi-label watershed of a frame, and checks it against a fixed budget
+    per frame. Prints the results as a JSON object.
+
+    Every iteration runs the same synthetic frame without and with depth, on two warm workspaces, one after the other,
+    so that both see the same state of the machine. The added cost of a case is the median of the differences, and covers
+    the depth edges, the cuts of the binary images and landscapes along them, and the extra markers that the cuts seed.
+    The depth edges stage is also reported on its own.
+    Exits with 1 if the added cost of a case is over the budget.
+
+    Usage: depth_budget_benchmark [--quick] [--budget-ms milliseconds]
+    --quick only runs the frames up to 640x480, with fewer iterations, as a smoke test.
+ */
+typedef std::chrono::steady_clock Clock;
+
+static double median (std::vector<double> values) {
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+int main (int argc, char **argv) {
+    bool quick = false;
+    double budgetMs = 2.0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else if (std::strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc) {
+            budgetMs = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--quick] [--budget-ms milliseconds]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<cv::Size> sizes = { cv::Size(256, 256), cv::Size(640, 480) };
+    if (!quick) {
+        sizes.push_back(cv::Size(1280, 960));
+        sizes.push_back(cv::Size(1920, 1440));
+    }
+    const int classCounts[] = { 2, 8 };
+    const float densities[] = { 0.5f, 2.0f };
+
+    bool passed = true;
+    bool first = true;
+    std::string json = "{\"opencv_version\":\"" CV_VERSION "\",\"budget_ms\":";
+    json += std::to_string(budgetMs) + ",\"cases\":[";
+    for (const cv::Size &size : sizes) {
+        const int iterations = quick ? 5 : (size.area() > 1000000 ? 15 : 40);
+        for (int classCount : classCounts) {
+            for (float density : densities) {
+                SyntheticFrameOptions options;
+                options.size = size;
+                options.classCount = classCount;
+                options.blobDensity = density;
+                SyntheticFrame frame = makeSyntheticFrame(options);
+
+                WatershedWorkspace maskWorkspace;
+                WatershedWorkspace depthWorkspace;
+                WatershedProfile profile;
+                depthWorkspace.useDepth = true;
+                std::vector<WatershedLabelResult> maskResults;
+                std::vector<WatershedLabelResult> depthResults;
+                watershedMultiLabelMaskAndDepth(frame.mask, frame.depth, frame.labelValues, maskWorkspace, maskResults);
+                watershedMultiLabelMaskAndDepth(frame.mask, frame.depth, frame.labelValues, depthWorkspace, depthResults);
+                depthWorkspace.profile = &profile;
+
+                std::vector<double> maskMs(iterations);
+                std::vector<double> addedMs(iterations);
+                for (int i = 0; i < iterations; i++) {
+                    Clock::time_point start = Clock::now();
+                    watershedMultiLabelMaskAndDepth(frame.mask, frame.depth, frame.labelValues, maskWorkspace, maskResults);
+                    Clock::time_point middle = Clock::now();
+                    watershedMultiLabelMaskAndDepth(frame.mask, frame.depth, frame.labelValues, depthWorkspace, depthResults);
+                    Clock::time_point end = Clock::now();
+                    maskMs[i] = std::chrono::duration<double, std::milli>(middle - start).count();
+                    addedMs[i] = std::chrono::duration<double, std::milli>(end - middle).count() - maskMs[i];
+                }
+                const double added = median(addedMs);
+                const double depthEdgesMs = profile.stageSeconds[static_cast<int>(WatershedStage::DepthEdges)] * 1000.0 / iterations;
+                const bool withinBudget = added <= budgetMs;
+                passed = passed && withinBudget;
+
+                size_t maskInstances = 0;
+                size_t depthInstances = 0;
+                for (size_t k = 0; k < maskResults.size(); k++) {
+                    maskInstances += maskResults[k].contours.count();
+                    depthInstances += depthResults[k].contours.count();
+                }
+
+                char buffer[512];
+                std::snprintf(buffer, sizeof(buffer),
+                              "%s{\"width\":%d,\"height\":%d,\"classes\":%d,\"blob_density\":%.1f,\"iterations\":%d,"
+                              "\"mask_ms\":%.3f,\"added_ms\":%.3f,\"depth_edges_ms\":%.3f,\"mask_instances\":%zu,"
+                              "\"depth_instances\":%zu,\"within_budget\":%s}",
+                              first ? "" : ",", size.width, size.height, classCount, density, iterations, median(maskMs),
+                              added, depthEdgesMs, maskInstances, depthInstances, withinBudget ? "true" : "false");
+                json += buffer;
+                first = false;
+                if (!withinBudget) {
+                    std::fprintf(stderr, "%dx%d, %d classes, density %.1f: depth adds %.3f ms per frame, over the budget of %.3f ms\n",
+                                 size.width, size.height, classCount, density, added, budgetMs);
+                }
+            }
+        }
+    }
+    json += "]}";
+    std::printf("%s\n", json.c_str());
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+//
+//  DistanceTransformBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "DistanceTransform.hpp"
+
+/**
+    Times squaredDistanceTransform and distanceTransformPeaks against cv::distanceTransform (DIST_L2, DIST_MASK_PRECISE)
+    and the chain of OpenCV calls that distanceTransformPeaks replaces, for every thread count from 1 to the number of cores,
+    and prints the results as a JSON object.
+
+    Usage: distance_transform_benchmark [iterations] [maxThreads]
+ */
+typedef std::chrono::steady_clock Clock;
+
+template <typename Run>
+static double millisecondsPerRun (int iterations, const Run &run) {
+    run();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        run();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+}
+
+/// Blobs of label pixels on a background of zeros, like the binary images of the watershed
+static cv::Mat blobImage (cv::Size size, uint32_t seed) {
+    cv::RNG rng(seed);
+    cv::Mat binary = cv::Mat::zeros(size, CV_8UC1);
+    int blobs = std::max(1, size.area() / 10000);
+    int maxAxis = std::max(5, std::min(size.width, size.height) / 8);
+    for (int b = 0; b < blobs; b++) {
+        cv::Point center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::Size axes(rng.uniform(4, maxAxis), rng.uniform(4, maxAxis));
+        cv::ellipse(binary, center, axes, rng.uniform(0.0, 180.0), 0, 360, cv::Scalar(255), -1);
+    }
+    return binary;
+}
+
+int main (int argc, char **argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : cv::getNumberOfCPUs();
+    if (iterations <= 0 || maxThreads <= 0) {
+        std::fprintf(stderr, "Usage: %s [iterations] [maxThreads]\n", argv[0]);
+        return 2;
+    }
+
+    const cv::Size sizes[] = { cv::Size(256, 256), cv::Size(640, 480), cv::Size(1280, 960), cv::Size(1920, 1440) };
+    std::string json = "{\"opencv_version\":\"" CV_VERSION "\",\"cores\":" + std::to_string(cv::getNumberOfCPUs()) + ",\"cases\":[";
+    bool first = true;
+    for (const cv::Size &size : sizes) {
+        cv::Mat binary = blobImage(size, 1);
+        cv::Mat squared(size, CV_32FC1);
+        cv::Mat peaks(size, CV_8UC1);
+        std::vector<float> rowMaxima;
+        cv::Mat dist;
+        cv::Mat referencePeaks;
+
+        double singleThreadMs = 0;
+        for (int threads = 1; threads <= maxThreads; threads++) {
+            cv::setNumThreads(threads);
+            double edtMs = millisecondsPerRun(iterations, [&]() {
+                squaredDistanceTransform(binary, squared, rowMaxima);
+            });
+            double opencvMs = millisecondsPerRun(iterations, [&]() {
+                cv::distanceTransform(binary, dist, cv::DIST_L2, cv::DIST_MASK_PRECISE);
+            });
+            double peaksMs = millisecondsPerRun(iterations, [&]() {
+                distanceTransformPeaks(binary, 0.4f, squared, rowMaxima, peaks);
+            });
+            double opencvPeaksMs = millisecondsPerRun(iterations, [&]() {
+                cv::distanceTransform(binary, dist, cv::DIST_L2, cv::DIST_MASK_PRECISE);
+                cv::normalize(dist, dist, 0, 1.0, cv::NORM_MINMAX);
+                cv::threshold(dist, dist, 0.4, 1.0, cv::THRESH_BINARY);
+                cv::dilate(dist, dist, cv::Mat());
+                dist.convertTo(referencePeaks, CV_8U);
+            });
+            if (threads == 1) {
+                singleThreadMs = edtMs;
+            }
+
+            char buffer[512];
+            std::snprintf(buffer, sizeof(buffer),
+                          "%s{\"width\":%d,\"height\":%d,\"threads\":%d,\"edt_ms\":%.4f,\"opencv_edt_ms\":%.4f,"
+                          "\"edt_speedup_vs_1_thread\":%.3f,\"edt_speedup_vs_opencv\":%.3f,"
+                          "\"peaks_ms\":%.4f,\"opencv_peaks_ms\":%.4f,\"peaks_speedup_vs_opencv\":%.3f}",
+                          first ? "" : ",", size.width, size.height, threads, edtMs, opencvMs,
+                          singleThreadMs / edtMs, opencvMs / edtMs, peaksMs, opencvPeaksMs, opencvPeaksMs / peaksMs);
+            json += buffer;
+            first = false;
+        }
+    }
+    json += "]}";
+    std::printf("%s\n", json.c_str());
+    return 0;
+}
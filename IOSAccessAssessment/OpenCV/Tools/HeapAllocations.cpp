@@ -0,0 +1,72 @@
+//
+//  HeapAllocations.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "HeapAllocations.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> allocatedBytes(0);
+
+uint64_t heapAllocationCount () {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t heapAllocatedBytes () {
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+static void *countedAllocation (std::size_t size, std::size_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (size == 0) {
+        size = 1;
+    }
+    void *pointer = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        pointer = std::malloc(size);
+    } else if (posix_memalign(&pointer, alignment, size) != 0) {
+        pointer = nullptr;
+    }
+    return pointer;
+}
+
+// The array and nothrow forms of the standard library call these, so they are counted too
+
+void *operator new (std::size_t size) {
+    void *pointer = countedAllocation(size, 0);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new (std::size_t size, std::align_val_t alignment) {
+    void *pointer = countedAllocation(size, static_cast<std::size_t>(alignment));
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete (void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete (void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete (void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete (void *pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
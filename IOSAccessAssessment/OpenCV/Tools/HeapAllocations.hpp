@@ -0,0 +1,26 @@
+//
+//  HeapAllocations.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef HeapAllocations_hpp
+#define HeapAllocations_hpp
+#include <cstdint>
+
+/**
+    Counts the heap allocations of the process, on every thread, by replacing the global operator new.
+    Linking HeapAllocations.cpp into an executable installs the hook; nothing has to be called to enable it.
+
+    cv::Mat buffers do not come from operator new, but every one of them comes with a cv::UMatData that does,
+    so every new cv::Mat buffer is counted as well.
+ */
+uint64_t heapAllocationCount ();
+
+/**
+    Total bytes requested from operator new so far.
+ */
+uint64_t heapAllocatedBytes ();
+
+#endif /* HeapAllocations_hpp */
@@ -0,0 +1,195 @@
+//
+//  MultiLabelBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "WatershedBenchmark.hpp"
+
+/**
+    Times the multi-label watershed with the landscapes and distances of all the labels found in shared passes over the frame,
+    against finding them label by label, and against the baseline that runs every label on the full frame
+    (WatershedWorkspace::cropLabelRegions = false), on synthetic frames with and without depth, and prints the results as a JSON object.
+
+    The corner case puts a blob of every label against the top left corner of the frame, where the frame clips the padding
+    of the label regions, so that the usual background seed at (5, 5) of a region lies on the label.
+    Every case checks that the shared and per-label ways give the same images and contours, and that their markers (the contours
+    and their colors) are those of the full frame baseline. Cropping can move a few pixels of the flood on plateaus of the landscape,
+    which is reported as the number of pixels whose color differs from the baseline. The corner case also checks that the pixel
+    at (5, 5) of every label is part of an instance, not of the background.
+    Exits with 1 if a check fails.
+
+    Usage: multi_label_benchmark [--quick]
+ */
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsPerFrame (int iterations, const SyntheticFrame &frame, bool useDepth, bool shareLabelTerms,
+                                    bool cropLabelRegions, WatershedWorkspace &workspace,
+                                    std::vector<WatershedLabelResult> &results) {
+    cv::Mat depth = useDepth ? frame.depth : cv::Mat();
+    workspace.useDepth = useDepth;
+    workspace.shareLabelTerms = shareLabelTerms;
+    workspace.cropLabelRegions = cropLabelRegions;
+    watershedMultiLabelMaskAndDepth(frame.mask, depth, frame.labelValues, workspace, results);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        watershedMultiLabelMaskAndDepth(frame.mask, depth, frame.labelValues, workspace, results);
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+}
+
+static bool resultsMatch (const std::vector<WatershedLabelResult> &shared, const std::vector<WatershedLabelResult> &perLabel) {
+    if (shared.size() != perLabel.size()) {
+        return false;
+    }
+    for (size_t k = 0; k < shared.size(); k++) {
+        const cv::Mat &image = shared[k].image;
+        const cv::Mat &expected = perLabel[k].image;
+        if (image.size() != expected.size() || image.type() != expected.type()) {
+            return false;
+        }
+        for (int i = 0; i < image.rows; i++) {
+            if (std::memcmp(image.ptr(i), expected.ptr(i), image.cols * image.elemSize()) != 0) {
+                return false;
+            }
+        }
+        if (shared[k].contours.points != perLabel[k].contours.points ||
+            shared[k].contours.offsets != perLabel[k].contours.offsets ||
+            shared[k].contours.colors != perLabel[k].contours.colors) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool markersMatch (const std::vector<WatershedLabelResult> &results, const std::vector<WatershedLabelResult> &baseline) {
+    if (results.size() != baseline.size()) {
+        return false;
+    }
+    for (size_t k = 0; k < results.size(); k++) {
+        if (results[k].contours.points != baseline[k].contours.points ||
+            results[k].contours.offsets != baseline[k].contours.offsets ||
+            results[k].contours.colors != baseline[k].contours.colors) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Pixels of all the label images whose color differs from the baseline
+static size_t differingPixels (const std::vector<WatershedLabelResult> &results, const std::vector<WatershedLabelResult> &baseline) {
+    size_t count = 0;
+    for (size_t k = 0; k < std::min(results.size(), baseline.size()); k++) {
+        const cv::Mat &image = results[k].image;
+        const cv::Mat &expected = baseline[k].image;
+        if (image.size() != expected.size() || image.type() != expected.type()) {
+            count += static_cast<size_t>(expected.total());
+            continue;
+        }
+        for (int i = 0; i < image.rows; i++) {
+            const cv::Vec4b *row = image.ptr<cv::Vec4b>(i);
+            const cv::Vec4b *expectedRow = expected.ptr<cv::Vec4b>(i);
+            for (int j = 0; j < image.cols; j++) {
+                count += row[j] != expectedRow[j];
+            }
+        }
+    }
+    return count;
+}
+
+/// A synthetic frame, with a blob of every label drawn over its top left corner
+static SyntheticFrame cornerFrame (const SyntheticFrameOptions &options) {
+    SyntheticFrame frame = makeSyntheticFrame(options);
+    for (size_t k = 0; k < frame.labelValues.size(); k++) {
+        int labelValue = frame.labelValues[k];
+        int offset = static_cast<int>(k) * 40;
+        cv::rectangle(frame.mask, cv::Rect(offset, 0, 30, 30), cv::Scalar(labelValue, labelValue, labelValue, 255), -1);
+        frame.depth(cv::Rect(offset, 0, 30, 30)).setTo(cv::Scalar(1.0 + 0.5 * k));
+    }
+    return frame;
+}
+
+static bool cornerSeedsOffLabel (const std::vector<WatershedLabelResult> &results) {
+    for (size_t k = 0; k < results.size(); k++) {
+        if (results[k].image.at<cv::Vec4b>(5, static_cast<int>(k) * 40 + 5)[3] == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main (int argc, char **argv) {
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    std::vector<cv::Size> sizes = { cv::Size(256, 256), cv::Size(640, 480) };
+    if (!quick) {
+        sizes.push_back(cv::Size(1280, 960));
+        sizes.push_back(cv::Size(1920, 1440));
+    }
+    const int classCounts[] = { 2, 6 };
+    const int iterations = quick ? 2 : 20;
+
+    bool passed = true;
+    bool first = true;
+    std::string json = "{\"opencv_version\":\"" CV_VERSION "\",\"cases\":[";
+    for (const cv::Size &size : sizes) {
+        for (int classCount : classCounts) {
+            for (bool corner : { false, true }) {
+                SyntheticFrameOptions options;
+                options.size = size;
+                options.classCount = classCount;
+                SyntheticFrame frame = corner ? cornerFrame(options) : makeSyntheticFrame(options);
+                for (bool useDepth : { false, true }) {
+                    WatershedWorkspace workspace;
+                    std::vector<WatershedLabelResult> sharedResults;
+                    std::vector<WatershedLabelResult> perLabelResults;
+                    std::vector<WatershedLabelResult> fullFrameResults;
+                    double sharedMs = millisecondsPerFrame(iterations, frame, useDepth, true, true, workspace, sharedResults);
+                    double perLabelMs = millisecondsPerFrame(iterations, frame, useDepth, false, true, workspace, perLabelResults);
+                    double fullFrameMs = millisecondsPerFrame(iterations, frame, useDepth, false, false, workspace,
+                                                              fullFrameResults);
+                    // All ran on the same workspace, so the images of the first runs were overwritten by the last
+                    for (WatershedLabelResult &result : fullFrameResults) {
+                        result.image = result.image.clone();
+                    }
+                    workspace.cropLabelRegions = true;
+                    watershedMultiLabelMaskAndDepth(frame.mask, useDepth ? frame.depth : cv::Mat(), frame.labelValues,
+                                                    workspace, perLabelResults);
+                    for (WatershedLabelResult &result : perLabelResults) {
+                        result.image = result.image.clone();
+                    }
+                    workspace.shareLabelTerms = true;
+                    watershedMultiLabelMaskAndDepth(frame.mask, useDepth ? frame.depth : cv::Mat(), frame.labelValues,
+                                                    workspace, sharedResults);
+
+                    const bool identical = resultsMatch(sharedResults, perLabelResults);
+                    const bool fullFrameMarkers = markersMatch(sharedResults, fullFrameResults);
+                    const size_t fullFramePixels = differingPixels(sharedResults, fullFrameResults);
+                    const bool seeds = !corner || cornerSeedsOffLabel(sharedResults);
+                    passed = passed && identical && fullFrameMarkers && seeds;
+
+                    char buffer[512];
+                    std::snprintf(buffer, sizeof(buffer),
+                                  "%s{\"width\":%d,\"height\":%d,\"classes\":%d,\"corner\":%s,\"depth\":%s,"
+                                  "\"shared_ms\":%.3f,\"per_label_ms\":%.3f,\"full_frame_ms\":%.3f,\"speedup\":%.2f,"
+                                  "\"speedup_over_full_frame\":%.2f,\"identical\":%s,\"full_frame_markers\":%s,"
+                                  "\"pixels_differing_from_full_frame\":%zu,\"seeds_off_label\":%s}",
+                                  first ? "" : ",", size.width, size.height, classCount, corner ? "true" : "false",
+                                  useDepth ? "true" : "false", sharedMs, perLabelMs, fullFrameMs, perLabelMs / sharedMs,
+                                  fullFrameMs / sharedMs, identical ? "true" : "false", fullFrameMarkers ? "true" : "false",
+                                  fullFramePixels, seeds ? "true" : "false");
+                    json += buffer;
+                    first = false;
+                }
+            }
+        }
+    }
+    json += "]}";
+    std::printf("%s\n", json.c_str());
+    return passed ? 0 : 1;
+}
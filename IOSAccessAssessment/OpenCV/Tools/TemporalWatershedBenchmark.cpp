@@ -0,0 +1,175 @@
+//
+//  TemporalWatershedBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "InstanceColorizer.hpp"
+#include "WatershedBenchmark.hpp"
+
+/**
+    Times the temporal watershed on sequences of frames that change a little from one frame to the next, against a full
+    recompute of every frame (watershed1DMaskAndDepthAndReturnContoursColors, with a warm workspace), and prints the results
+    as a JSON object.
+
+    Each sequence has a blob that moves, and a blob that comes and goes, over the blobs of a synthetic frame.
+    The still sequence keeps the camera in place; the pan sequence moves it, so that the previous frame is warped.
+    After the timed frames, the tool checks that
+    - the instance IDs stay below the most instances that were ever needed at once (retired IDs are handed out again),
+    - the cached outlines are those of the instances, outlined from scratch,
+    - the image is the instances colored from scratch.
+    Exits with 1 if a check fails.
+
+    Usage: temporal_watershed_benchmark [--quick]
+ */
+typedef std::chrono::steady_clock Clock;
+
+/// Frames of a sequence, and the homography from the previous frame of the sequence (cyclically) to each frame
+struct Sequence {
+    std::vector<cv::Mat> masks;
+    std::vector<cv::Matx33d> homographies;
+    int labelValue = 0;
+};
+
+static int pingPong (int k, int frameCount) {
+    return k <= frameCount / 2 ? k : frameCount - k;
+}
+
+static Sequence makeSequence (cv::Size size, int frameCount, bool pan) {
+    const int panStep = 3;
+    const int margin = panStep * frameCount;
+    SyntheticFrameOptions options;
+    options.size = cv::Size(size.width + 2 * margin, size.height + 2 * margin);
+    options.classCount = 2;
+    options.blobDensity = 1.0f;
+    SyntheticFrame frame = makeSyntheticFrame(options);
+    cv::Mat canvas;
+    cv::extractChannel(frame.mask, canvas, 0);
+
+    Sequence sequence;
+    sequence.labelValue = frame.labelValues[0];
+    for (int k = 0; k < frameCount; k++) {
+        cv::Mat gray = canvas.clone();
+        cv::Point moving(margin + size.width / 4 + 3 * pingPong(k, frameCount), margin + size.height / 2);
+        cv::ellipse(gray, moving, cv::Size(12, 8), 0, 0, 360, cv::Scalar(sequence.labelValue), -1);
+        if (k % 4 < 2) {
+            cv::Point blinking(margin + 3 * size.width / 4, margin + size.height / 4);
+            cv::ellipse(gray, blinking, cv::Size(10, 10), 0, 0, 360, cv::Scalar(sequence.labelValue), -1);
+        }
+        int offset = pan ? panStep * pingPong(k, frameCount) : 0;
+        int previousOffset = pan ? panStep * pingPong((k + frameCount - 1) % frameCount, frameCount) : 0;
+        sequence.masks.push_back(gray(cv::Rect(margin + offset, margin, size.width, size.height)).clone());
+        // The view moves right by the change of offset, so the content moves left
+        cv::Matx33d homography = cv::Matx33d::eye();
+        homography(0, 2) = previousOffset - offset;
+        sequence.homographies.push_back(homography);
+    }
+    return sequence;
+}
+
+/// The outlines of every instance, found from scratch, in increasing ID order
+static bool outlinesMatch (const WatershedTemporalState &state, const WatershedLabelResult &result) {
+    std::vector<cv::Point> points;
+    std::vector<int> instanceIds;
+    std::vector<std::vector<cv::Point>> contours;
+    cv::Mat instancePixels;
+    for (int instance = 1; instance < state.nextInstanceId; instance++) {
+        cv::compare(state.instances, instance, instancePixels, cv::CMP_EQ);
+        cv::findContours(instancePixels, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        for (const std::vector<cv::Point> &contour : contours) {
+            points.insert(points.end(), contour.begin(), contour.end());
+            instanceIds.push_back(instance);
+        }
+    }
+    return points == result.contours.points && instanceIds == state.contourInstanceIds;
+}
+
+static bool imageMatches (const WatershedTemporalState &state, const WatershedLabelResult &result) {
+    cv::Mat expected(state.instances.size(), CV_8UC4);
+    colorizeMarkers(state.instances, state.instanceColors, expected);
+    return std::memcmp(expected.data, result.image.data, expected.total() * expected.elemSize()) == 0;
+}
+
+int main (int argc, char **argv) {
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    std::vector<cv::Size> sizes = { cv::Size(320, 240), cv::Size(640, 480) };
+    if (!quick) {
+        sizes.push_back(cv::Size(1280, 960));
+        sizes.push_back(cv::Size(1920, 1440));
+    }
+    const int frameCount = 16;
+    const int cycles = quick ? 2 : 8;
+
+    bool passed = true;
+    bool first = true;
+    std::string json = "{\"opencv_version\":\"" CV_VERSION "\",\"cases\":[";
+    for (const cv::Size &size : sizes) {
+        for (bool pan : { false, true }) {
+            Sequence sequence = makeSequence(size, frameCount, pan);
+            cv::Mat depth;
+            WatershedWorkspace workspace;
+            WatershedTemporalState state;
+            WatershedLabelResult result;
+
+            // Every marker of a frame may take a new ID, on top of the instances that were already there,
+            // so with retired IDs handed out again, no more IDs than that are ever needed
+            size_t peakDemand = 0;
+            size_t peakLive = 0;
+            auto runFrame = [&](int k) {
+                size_t liveBefore = state.liveInstanceCount();
+                watershedTemporalMaskAndDepth(sequence.masks[k], depth, sequence.labelValue, sequence.homographies[k],
+                                              workspace, state, result);
+                peakDemand = std::max(peakDemand, liveBefore + state.claimedInstanceIds.size());
+                peakLive = std::max(peakLive, state.liveInstanceCount());
+            };
+
+            // A first cycle, untimed, starts from scratch
+            for (int k = 0; k < frameCount; k++) {
+                runFrame(k);
+            }
+            Clock::time_point start = Clock::now();
+            for (int c = 0; c < cycles; c++) {
+                for (int k = 0; k < frameCount; k++) {
+                    runFrame(k);
+                }
+            }
+            double steadyMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / (cycles * frameCount);
+            const size_t instanceIds = static_cast<size_t>(state.nextInstanceId - 1);
+            const bool idsBounded = instanceIds <= peakDemand;
+            const bool outlines = outlinesMatch(state, result);
+            const bool image = imageMatches(state, result);
+
+            WatershedLabelResult fullResult;
+            watershed1DMaskAndDepthAndReturnContoursColors(sequence.masks[0], depth, sequence.labelValue, workspace, fullResult);
+            start = Clock::now();
+            for (int c = 0; c < cycles; c++) {
+                for (int k = 0; k < frameCount; k++) {
+                    watershed1DMaskAndDepthAndReturnContoursColors(sequence.masks[k], depth, sequence.labelValue,
+                                                                   workspace, fullResult);
+                }
+            }
+            double fullMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / (cycles * frameCount);
+            passed = passed && idsBounded && outlines && image;
+
+            char buffer[512];
+            std::snprintf(buffer, sizeof(buffer),
+                          "%s{\"width\":%d,\"height\":%d,\"camera\":\"%s\",\"frames\":%d,\"steady_ms\":%.3f,"
+                          "\"full_recompute_ms\":%.3f,\"speedup\":%.2f,\"instance_ids\":%zu,\"peak_live_instances\":%zu,"
+                          "\"ids_bounded\":%s,\"outlines_match\":%s,\"image_matches\":%s}",
+                          first ? "" : ",", size.width, size.height, pan ? "pan" : "still", cycles * frameCount,
+                          steadyMs, fullMs, fullMs / steadyMs, instanceIds, peakLive,
+                          idsBounded ? "true" : "false", outlines ? "true" : "false", image ? "true" : "false");
+            json += buffer;
+            first = false;
+        }
+    }
+    json += "]}";
+    std::printf("%s\n", json.c_str());
+    return passed ? 0 : 1;
+}
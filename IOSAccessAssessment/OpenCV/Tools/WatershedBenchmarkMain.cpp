@@ -0,0 +1,68 @@
+//
+//  WatershedBenchmarkMain.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "HeapAllocations.hpp"
+#include "WatershedBenchmark.hpp"
+
+/**
+    Runs the watershed benchmark, prints its JSON report, and checks the depth edges of every case against its budget.
+    Exits with 1 when a case misses its budget, or when the timed calls reallocate the workspace.
+
+    Usage: watershed_benchmark [--quick] [--threads count]
+    --quick only runs the cases up to 640x480, with fewer iterations, as a smoke test.
+    --threads sets the threads of OpenCV (cv::setNumThreads).
+ */
+int main (int argc, char **argv) {
+    bool quick = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            cv::setNumThreads(std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--quick] [--threads count]\n", argv[0]);
+            return 2;
+        }
+    }
+    
+    std::vector<WatershedBenchmarkCase> cases = defaultWatershedBenchmarkCases();
+    if (quick) {
+        std::vector<WatershedBenchmarkCase> quickCases;
+        for (WatershedBenchmarkCase benchmarkCase : cases) {
+            if (benchmarkCase.frame.size.area() <= 640 * 480) {
+                benchmarkCase.iterations = 3;
+                quickCases.push_back(benchmarkCase);
+            }
+        }
+        cases = quickCases;
+    }
+    
+    std::vector<WatershedBenchmarkResult> results;
+    std::string report = runWatershedBenchmark(cases, &results, heapAllocationCount);
+    std::printf("%s\n", report.c_str());
+    
+    bool passed = true;
+    for (const WatershedBenchmarkResult &result : results) {
+        const WatershedBenchmarkCase &benchmarkCase = result.benchmarkCase;
+        if (!result.withinDepthBudget()) {
+            std::fprintf(stderr, "%dx%d, %d classes, density %.1f: depth edges take %.3f ms per frame, over the budget of %.3f ms\n",
+                         benchmarkCase.frame.size.width, benchmarkCase.frame.size.height, benchmarkCase.frame.classCount,
+                         benchmarkCase.frame.blobDensity, result.depthMsPerFrame, benchmarkCase.depthBudgetMs);
+            passed = false;
+        }
+        if (result.timedWorkspaceReallocations != 0) {
+            std::fprintf(stderr, "%dx%d, %d classes, density %.1f: %llu workspace reallocations after the warm-up call\n",
+                         benchmarkCase.frame.size.width, benchmarkCase.frame.size.height, benchmarkCase.frame.classCount,
+                         benchmarkCase.frame.blobDensity, static_cast<unsigned long long>(result.timedWorkspaceReallocations));
+            passed = false;
+        }
+    }
+    return passed ? 0 : 1;
+}
@@ -79,9 +79,21 @@
     return [[UIImage alloc] initWithCVMat:cvMat];
 }
 
+/**
+    Releases the matrix that backs a data provider, once the image no longer needs its pixels.
+ */
+static void releaseRetainedCVMat(void *info, const void *data, size_t size)
+{
+    delete static_cast<cv::Mat *>(info);
+}
+
 /**
     Convert cv::Mat to UIImage
  
+    The image shares the pixels of the matrix instead of copying them: the data provider keeps a reference to the matrix,
+    which is released when the image is deallocated. The matrix must therefore own its data (not be a view into a reused buffer).
+    A matrix whose rows are not packed (such as a region of a larger matrix) is copied first.
+ 
     The following TODO task is to address the issue where the bitmap info is being hard-coded to only serve segmentation masks with fixed bitmap info and other parameters.
     We need to make it more generic.
     TODO: Later, we would like to use the attributes of the UIImage, such as bitmap data, color space, and alpha channel to create a cv::Mat object.
@@ -89,7 +101,6 @@
  */
 - (id)initWithCVMat:(const cv::Mat&)cvMat
 {
-    NSData *data = [NSData dataWithBytes:cvMat.data length:cvMat.elemSize() * cvMat.total()];
     CGColorSpaceRef colorSpace;
     CGBitmapInfo bitmapInfo = kCGImageAlphaNone|kCGImageByteOrderDefault;
     
@@ -102,14 +113,21 @@
         bitmapInfo = kCGImageAlphaLast|kCGImageByteOrderDefault;
     }
     
-    CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)data);
+    // The last row of a region of a larger matrix ends before a full step, so step[0] * rows could run past the pixels:
+    // unless the rows are packed, the matrix is copied, so that it spans exactly step[0] * rows bytes
+    bool packedRows = cvMat.step[0] == cvMat.cols * cvMat.elemSize();
+    cv::Mat *retainedMat = new cv::Mat(packedRows ? cvMat : cvMat.clone());
+    CGDataProviderRef provider = CGDataProviderCreateWithData(retainedMat,
+                                                              retainedMat->data,
+                                                              retainedMat->step[0] * retainedMat->rows,
+                                                              releaseRetainedCVMat);
 
         // Creating CGImage from cv::Mat
-    CGImageRef imageRef = CGImageCreate(cvMat.cols,                                 //width
-                                        cvMat.rows,                                 //height
+    CGImageRef imageRef = CGImageCreate(retainedMat->cols,                          //width
+                                        retainedMat->rows,                          //height
                                         8,                                          //bits per component
-                                        8 * cvMat.elemSize(),                       //bits per pixel
-                                        cvMat.step[0],                              //bytesPerRow
+                                        8 * retainedMat->elemSize(),                //bits per pixel
+                                        retainedMat->step[0],                       //bytesPerRow
                                         colorSpace,                                 //colorspace
                                         bitmapInfo,                                 // bitmap info
                                         provider,                                   //CGDataProviderRef
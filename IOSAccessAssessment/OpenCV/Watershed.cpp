@@ -6,137 +6,134 @@
 //
 
 #include "Watershed.hpp"
+#include "DistanceTransform.hpp"
+#include "InstanceColorizer.hpp"
+#include "DepthEdges.hpp"
 #include <iostream>
 #include <fstream>
+#include <array>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 
-cv::Mat watershed1DMaskAndDepth (cv::Mat mask, cv::Mat depth, int labelValue) {
-    // Remove the alpha channel from the mask image
-    cv::cvtColor(mask, mask, cv::COLOR_BGRA2BGR);
-    
-    // Remove all the other classes and the background from the mask
-    cv::Mat bg_mask;
-    cv::Scalar lowerBounds = cv::Scalar(labelValue - 3, labelValue - 3, labelValue - 3);
-    cv::Scalar upperBounds = cv::Scalar(labelValue + 3, labelValue + 3, labelValue + 3);
-    cv::inRange(mask, lowerBounds, upperBounds, bg_mask);
-    cv::Mat bg_mask_inv;
-    cv::bitwise_not(bg_mask, bg_mask_inv);
-    mask.setTo(cv::Scalar(0, 0, 0), bg_mask_inv);
-    
-    // Erase borders from the mask
-    cv::Mat maskEroded = eraseBorders(mask, 2);
-    mask = maskEroded;
-    
-    // First, we need to compute the Laplacian of the depth map, to get the edges.
-    cv::Mat kernel = (cv::Mat_<float>(3,3) << 1,  1, 1, 1, -8, 1, 1,  1, 1);
-    cv::Mat imgLaplacian;
-    cv::filter2D(mask, imgLaplacian, CV_32F, kernel);
-    cv::Mat sharp;
-    mask.convertTo(sharp, CV_32F);
-    cv::Mat imgResult = sharp - imgLaplacian;
-
-    // convert back to 8bits gray scale
-    imgResult.convertTo(imgResult, CV_8UC3);
-    imgLaplacian.convertTo(imgLaplacian, CV_8UC3);
-    
-    cv::Mat bw;
-    cv::cvtColor(imgResult, bw, cv::COLOR_BGR2GRAY);
-    cv::threshold(bw, bw, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
-    
-    // Perform the distance transform algorithm
-    cv::Mat dist;
-    cv::distanceTransform(bw, dist, cv::DIST_L2, 3);
-    
-    // Normalize the distance image for range = {0.0, 1.0}
-    // so we can visualize and threshold it
-    cv::normalize(dist, dist, 0, 1.0, cv::NORM_MINMAX);
-    
-    // Threshold to obtain the peaks
-    // This will be the markers for the foreground objects
-    cv::threshold(dist, dist, 0.4, 1.0, cv::THRESH_BINARY);
-    
-    // Dilate the dist image
-    cv::Mat kernel1 = cv::Mat::ones(3, 3, CV_8U);
-    cv::dilate(dist, dist, kernel1);
-    
-    // Create the CV_8U version of the distance image
-    // It is needed for findContours()
-    cv::Mat dist_8u;
-    dist.convertTo(dist_8u, CV_8U);
- 
-    // Find total markers
-    std::vector<std::vector<cv::Point> > contours;
-    cv::findContours(dist_8u, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-    
-    // Create the marker image for the watershed algorithm
-    cv::Mat markers = cv::Mat::zeros(dist.size(), CV_32SC1);
-    
-    // Draw the foreground markers
-    for (size_t i = 0; i < contours.size(); i++)
-    {
-        cv::drawContours(markers, contours, static_cast<int>(i), cv::Scalar(static_cast<int>(i)+1), -1);
+/**
+    The workspace used by the functions that do not take one explicitly.
+    It is per thread, so that concurrent callers do not share buffers.
+ */
+static WatershedWorkspace &defaultWorkspace () {
+    thread_local WatershedWorkspace workspace;
+    return workspace;
+}
+
+std::vector<std::vector<cv::Point>> FlatContours::nested () const {
+    std::vector<std::vector<cv::Point>> contours(count());
+    for (size_t i = 0; i < contours.size(); i++) {
+        contours[i].assign(points.begin() + offsets[i], points.begin() + offsets[i + 1]);
     }
-    
-    // Draw the background marker
-    cv::circle(markers, cv::Point(5,5), 3, cv::Scalar(255), -1);
+    return contours;
+}
 
-    // Perform the watershed algorithm
-    cv::watershed(imgResult, markers);
-    
-    // Generate random colors
-    std::vector<cv::Vec3b> colors;
-    for (size_t i = 0; i < contours.size(); i++)
-    {
-        int b = cv::theRNG().uniform(0, 256);
-        int g = cv::theRNG().uniform(0, 256);
-        int r = cv::theRNG().uniform(0, 256);
- 
-        colors.push_back(cv::Vec3b((uchar)b, (uchar)g, (uchar)r));
+void WatershedWorkspace::prepare (cv::Size size, size_t labelCount) {
+    if (size != frameSize) {
+        // The frame size has changed, so every buffer is reallocated.
+        // Per label regions use views into these full frame buffers, so they never cause reallocations.
+        gray.create(size, CV_8UC1);
+        bgMask.create(size, CV_8UC1);
+        labelMask.create(size, CV_8UC1);
+        imgLaplacian.create(size, CV_32FC1);
+        sharp.create(size, CV_32FC1);
+        imgResult.create(size, CV_8UC1);
+        imgResultBGR.create(size, CV_8UC3);
+        bw.create(size, CV_8UC1);
+        dist.create(size, CV_32FC1);
+        dist_8u.create(size, CV_8UC1);
+        markers.create(size, CV_32SC1);
+        labelIndices.create(size, CV_8UC1);
+        landscape.create(size, CV_8UC1);
+        foregroundLabels.create(size, CV_8UC1);
+        labelImages.clear();
+        frameSize = size;
+        if (profile != nullptr) {
+            profile->workspaceReallocations++;
+        }
     }
-    
-    // Create the result image
-    cv::Mat dst = cv::Mat::zeros(markers.size(), CV_8UC3);
- 
-//    // Fill labeled objects with random colors
-    int i1 = -1;
-    int j1 = -1;
-    for (int i = 0; i < markers.rows; i++)
-    {
-        for (int j = 0; j < markers.cols; j++)
-        {
-            int index = markers.at<int>(i,j);
-            if (index > 0 && index <= static_cast<int>(contours.size()))
-            {
-                dst.at<cv::Vec3b>(i,j) = colors[index-1];
-                if ((i1 == -1) && (j1 == -1)) {
-                    i1 = i;
-                    j1 = j;
-                }
-            }
+    while (labelImages.size() < labelCount) {
+        labelImages.emplace_back(size, CV_8UC4);
+        if (profile != nullptr) {
+            profile->workspaceReallocations++;
         }
     }
-    
-    return makeBackgroundTransparent(dst, cv::Scalar(0, 0, 0, 255));
-//    return dst;
+}
+
+cv::Mat matFromImageView (const ImageView &view) {
+    if (view.isEmpty()) {
+        return cv::Mat();
+    }
+    int type = CV_8UC1;
+    switch (view.format) {
+        case ImagePixelFormat::Gray8:
+            type = CV_8UC1;
+            break;
+        case ImagePixelFormat::BGRA8:
+        case ImagePixelFormat::RGBA8:
+            type = CV_8UC4;
+            break;
+        case ImagePixelFormat::Float32:
+            type = CV_32FC1;
+            break;
+    }
+    return cv::Mat(view.height, view.width, type, view.data, view.bytesPerRow);
+}
+
+/**
+    The conversion that brings a mask to grayscale, or -1 if it already is.
+ */
+static int grayConversionCode (int channels, bool isRGBOrder) {
+    if (channels == 4) {
+        return isRGBOrder ? cv::COLOR_RGBA2GRAY : cv::COLOR_BGRA2GRAY;
+    } else if (channels == 3) {
+        return isRGBOrder ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY;
+    }
+    return -1;
+}
+
+cv::Mat watershed1DMaskAndDepth (cv::Mat mask, cv::Mat depth, int labelValue) {
+    // The returned image must outlive the shared workspace
+    return watershed1DMaskAndDepth(mask, depth, labelValue, defaultWorkspace()).clone();
+}
+
+cv::Mat watershed1DMaskAndDepth (cv::Mat mask, cv::Mat depth, int labelValue, WatershedWorkspace &workspace) {
+    WatershedLabelResult result;
+    watershed1DMaskAndDepthAndReturnContoursColors(mask, depth, labelValue, workspace, result);
+    return result.image;
 }
 
 /**
     This function erases the borders of the mask by a certain amount.
  */
 cv::Mat eraseBorders (cv::Mat mat, int borderSize) {
-    cv::Mat borderMask = cv::Mat::ones(mat.size(), CV_8UC1) * 255;
-    
-    // Set the mask borders to 0
-    borderMask(cv::Rect(0, 0, borderMask.cols, borderSize)).setTo(0);
-    borderMask(cv::Rect(0, borderMask.rows - borderSize, borderMask.cols, borderSize)).setTo(0);
-    borderMask(cv::Rect(0, 0, borderSize, borderMask.rows)).setTo(0);
-    borderMask(cv::Rect(borderMask.cols - borderSize, 0, borderSize, borderMask.rows)).setTo(0);
-    
-    cv::Mat output = cv::Mat::zeros(mat.size(), mat.type());
-    mat.copyTo(output, borderMask);
-    
+    cv::Mat output;
+    eraseBorders(mat, borderSize, output);
     return output;
 }
 
+/**
+    Same as above, but writes into the given output, which may be the input itself.
+ */
+void eraseBorders (cv::Mat mat, int borderSize, cv::Mat &output) {
+    if (output.data != mat.data) {
+        mat.copyTo(output);
+    }
+    
+    // Set the borders to 0
+    output(cv::Rect(0, 0, output.cols, borderSize)).setTo(0);
+    output(cv::Rect(0, output.rows - borderSize, output.cols, borderSize)).setTo(0);
+    output(cv::Rect(0, 0, borderSize, output.rows)).setTo(0);
+    output(cv::Rect(output.cols - borderSize, 0, borderSize, output.rows)).setTo(0);
+}
+
 /**
     This function makes the background alpha channel of the image to 0.
  */
@@ -157,116 +154,1104 @@ cv::Mat makeBackgroundTransparent (cv::Mat mat, cv::Scalar backgroundColor) {
     
     return transparentMat;
 }
-    
+
+/**
+    Runs the watershed of a single label, within the padded bounding box of its pixels.
+    The markers are those of the full frame watershed that this function used to run; the flood is cropped to the region,
+    which can give a few pixels on plateaus of the landscape to another instance or to the background
+    (see watershedLabelInRegion, and WatershedWorkspace::cropLabelRegions for the full frame).
+ */
 std::tuple<cv::Mat, std::vector<std::vector<cv::Point>>, std::vector<cv::Vec3b>>
 watershed1DMaskAndDepthAndReturnContoursColors (cv::Mat mask, cv::Mat depth, int labelValue) {
-    // Remove the alpha channel from the mask image
-    cv::cvtColor(mask, mask, cv::COLOR_BGRA2BGR);
-    
-    // Remove all the other classes and the background from the mask
-    cv::Mat bg_mask;
-    cv::Scalar lowerBounds = cv::Scalar(labelValue - 3, labelValue - 3, labelValue - 3);
-    cv::Scalar upperBounds = cv::Scalar(labelValue + 3, labelValue + 3, labelValue + 3);
-    cv::inRange(mask, lowerBounds, upperBounds, bg_mask);
-    cv::Mat bg_mask_inv;
-    cv::bitwise_not(bg_mask, bg_mask_inv);
-    mask.setTo(cv::Scalar(0, 0, 0), bg_mask_inv);
-    
-    // Erase borders from the mask
-    cv::Mat maskEroded = eraseBorders(mask, 2);
-    mask = maskEroded;
-    
-    // First, we need to compute the Laplacian of the depth map, to get the edges.
-    cv::Mat kernel = (cv::Mat_<float>(3,3) << 1,  1, 1, 1, -8, 1, 1,  1, 1);
-    cv::Mat imgLaplacian;
-    cv::filter2D(mask, imgLaplacian, CV_32F, kernel);
-    cv::Mat sharp;
-    mask.convertTo(sharp, CV_32F);
-    cv::Mat imgResult = sharp - imgLaplacian;
-
-    // convert back to 8bits gray scale
-    imgResult.convertTo(imgResult, CV_8UC3);
-    imgLaplacian.convertTo(imgLaplacian, CV_8UC3);
-    
-    cv::Mat bw;
-    cv::cvtColor(imgResult, bw, cv::COLOR_BGR2GRAY);
-    cv::threshold(bw, bw, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
-    
-    // Perform the distance transform algorithm
-    cv::Mat dist;
-    cv::distanceTransform(bw, dist, cv::DIST_L2, 3);
-    
-    // Normalize the distance image for range = {0.0, 1.0}
-    // so we can visualize and threshold it
-    cv::normalize(dist, dist, 0, 1.0, cv::NORM_MINMAX);
-    
-    // Threshold to obtain the peaks
-    // This will be the markers for the foreground objects
-    cv::threshold(dist, dist, 0.4, 1.0, cv::THRESH_BINARY);
-    
-    // Dilate the dist image
-    cv::Mat kernel1 = cv::Mat::ones(3, 3, CV_8U);
-    cv::dilate(dist, dist, kernel1);
-    
-    // Create the CV_8U version of the distance image
-    // It is needed for findContours()
-    cv::Mat dist_8u;
-    dist.convertTo(dist_8u, CV_8U);
+    WatershedLabelResult result;
+    watershed1DMaskAndDepthAndReturnContoursColors(mask, depth, labelValue, defaultWorkspace(), result);
+    
+    // The returned image must outlive the shared workspace
+    return std::make_tuple(result.image.clone(), result.contours.nested(), std::move(result.contours.colors));
+}
+
+/**
+    Computes the bounding box of every grayscale value in the image, in a single pass.
+    A value that does not occur in the image has an empty rect.
+ */
+static std::array<cv::Rect, 256> computeValueBounds (const cv::Mat &gray) {
+    std::array<int, 256> minX, minY, maxX, maxY;
+    minX.fill(INT_MAX);
+    minY.fill(INT_MAX);
+    maxX.fill(-1);
+    maxY.fill(-1);
+    
+    for (int i = 0; i < gray.rows; i++)
+    {
+        const uchar *row = gray.ptr<uchar>(i);
+        for (int j = 0; j < gray.cols; j++)
+        {
+            uchar value = row[j];
+            if (j < minX[value]) minX[value] = j;
+            if (j > maxX[value]) maxX[value] = j;
+            if (i < minY[value]) minY[value] = i;
+            maxY[value] = i;
+        }
+    }
+    
+    std::array<cv::Rect, 256> bounds;
+    for (int value = 0; value < 256; value++)
+    {
+        if (maxX[value] < 0) {
+            continue;
+        }
+        bounds[value] = cv::Rect(minX[value], minY[value],
+                                 maxX[value] - minX[value] + 1, maxY[value] - minY[value] + 1);
+    }
+    return bounds;
+}
+
+/**
+    Converts the mask to grayscale into the workspace, and erases its borders.
+    Segmentation masks have the same value in every color channel, so a single channel carries the label.
+ */
+static void prepareGrayMask (cv::Mat mask, int conversionCode, WatershedWorkspace &workspace) {
+    WatershedStageTimer timer(workspace.profile, WatershedStage::GrayMask);
+    if (conversionCode >= 0) {
+        cv::cvtColor(mask, workspace.gray, conversionCode);
+    } else {
+        mask.copyTo(workspace.gray);
+    }
+    eraseBorders(workspace.gray, 2, workspace.gray);
+}
+
+/**
+    Returns the region to process for a label: the bounding box of all the values that match the label, padded so that
+    the label pixels stay away from the edges of the region, or the full frame if crop is false.
+    The region is empty if the label does not occur.
+ */
+static cv::Rect labelRegion (const std::array<cv::Rect, 256> &valueBounds, int labelValue, cv::Size frameSize, bool crop) {
+    const int regionPadding = 8;
+    
+    cv::Rect labelBounds;
+    for (int value = std::max(labelValue - 3, 0); value <= std::min(labelValue + 3, 255); value++) {
+        if (valueBounds[value].empty()) {
+            continue;
+        }
+        labelBounds = labelBounds.empty() ? valueBounds[value] : (labelBounds | valueBounds[value]);
+    }
+    if (labelBounds.empty()) {
+        return cv::Rect();
+    }
+    if (!crop) {
+        return cv::Rect(cv::Point(0, 0), frameSize);
+    }
+    cv::Rect region(labelBounds.x - regionPadding, labelBounds.y - regionPadding,
+                    labelBounds.width + 2 * regionPadding, labelBounds.height + 2 * regionPadding);
+    return region & cv::Rect(cv::Point(0, 0), frameSize);
+}
+
+/**
+    Returns the Otsu threshold of an 8-bit landscape, as cv::threshold with THRESH_OTSU computes it, as if the landscape had
+    outsideZeros more pixels of value 0.
+    The landscape of a label is 0 everywhere outside its padded region, so counting the pixels of the frame outside the region
+    gives the threshold of the full frame landscape, which the histogram of the region alone does not.
+ */
+static double otsuThreshold (const cv::Mat &landscape, size_t outsideZeros) {
+    const int binCount = 256;
+    std::array<double, binCount> histogram {};
+    for (int i = 0; i < landscape.rows; i++)
+    {
+        const uchar *row = landscape.ptr<uchar>(i);
+        for (int j = 0; j < landscape.cols; j++)
+        {
+            histogram[row[j]]++;
+        }
+    }
+    histogram[0] += static_cast<double>(outsideZeros);
+    
+    const double scale = 1.0 / (static_cast<double>(landscape.total()) + static_cast<double>(outsideZeros));
+    double mu = 0;
+    for (int i = 0; i < binCount; i++) {
+        mu += i * histogram[i];
+    }
+    mu *= scale;
+    // The loop of getThreshVal_Otsu_8u in OpenCV, so that the threshold is the same to the last bit
+    double mu1 = 0, q1 = 0;
+    double maxSigma = 0, maxValue = 0;
+    for (int i = 0; i < binCount; i++) {
+        double p = histogram[i] * scale;
+        mu1 *= q1;
+        q1 += p;
+        double q2 = 1.0 - q1;
+        if (std::min(q1, q2) < FLT_EPSILON || std::max(q1, q2) > 1.0 - FLT_EPSILON) {
+            continue;
+        }
+        mu1 = (mu1 + i * p) / q1;
+        double mu2 = (mu - q1 * mu1) / q2;
+        double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > maxSigma) {
+            maxSigma = sigma;
+            maxValue = i;
+        }
+    }
+    return maxValue;
+}
+
+/**
+    Finds the watershed landscape and the marker peaks of a single label on the region of interest
+    of the workspace's border-erased grayscale mask.
+ 
+    The landscape is left in the workspace's imgResult, the label pixels in bgMask, and the peaks in dist_8u,
+    all at the top left of the full frame buffers (in region coordinates).
+    The Otsu threshold counts outsideZeros more pixels of 0, the pixels of the frame outside a padded region (see otsuThreshold).
  
+    If the full frame depth edges are not empty, the label is cut along them before the peaks are found,
+    so that every peak lies within a region of consistent depth, and the edges are also lowered in the landscape
+    that the watershed floods, so that touching instances at different depths are kept apart.
+ */
+static void labelPeaksInRegion (WatershedWorkspace &workspace, int labelValue, cv::Rect roi, size_t outsideZeros,
+                                cv::Mat depthEdges) {
+    static const cv::Mat kernel = (cv::Mat_<float>(3,3) << 1,  1, 1, 1, -8, 1, 1,  1, 1);
+    
+    cv::Rect region(0, 0, roi.width, roi.height);
+    cv::Mat grayRegion = workspace.gray(roi);
+    WatershedStageTimer landscapeTimer(workspace.profile, WatershedStage::Landscape);
+    
+    // Remove all the other classes and the background from the region
+    cv::Mat bg_mask = workspace.bgMask(region);
+    cv::inRange(grayRegion, cv::Scalar(labelValue - 3), cv::Scalar(labelValue + 3), bg_mask);
+    cv::Mat labelMask = workspace.labelMask(region);
+    labelMask.setTo(0);
+    grayRegion.copyTo(labelMask, bg_mask);
+    
+    // Sharpen the label mask with its Laplacian, to get the edges.
+    // The region is a view into a buffer that holds other labels and frames around it, so the border must be isolated:
+    // otherwise filter2D would read those stale pixels instead of extrapolating the region.
+    cv::Mat imgLaplacian = workspace.imgLaplacian(region);
+    cv::filter2D(labelMask, imgLaplacian, CV_32F, kernel, cv::Point(-1, -1), 0, cv::BORDER_DEFAULT | cv::BORDER_ISOLATED);
+    cv::Mat sharp = workspace.sharp(region);
+    labelMask.convertTo(sharp, CV_32F);
+    cv::subtract(sharp, imgLaplacian, sharp);
+    cv::Mat imgResult = workspace.imgResult(region);
+    sharp.convertTo(imgResult, CV_8U);
+    
+    cv::Mat bw = workspace.bw(region);
+    cv::threshold(imgResult, bw, otsuThreshold(imgResult, outsideZeros), 255, cv::THRESH_BINARY);
+    
+    if (!depthEdges.empty()) {
+        // The depth edges become background in both the binary image and the landscape
+        cv::Mat depthEdgesRegion = depthEdges(roi);
+        bw.setTo(0, depthEdgesRegion);
+        imgResult.setTo(0, depthEdgesRegion);
+    }
+    
+    landscapeTimer.stop();
+    
+    // Perform the distance transform algorithm, and threshold and dilate it to obtain the peaks
+    WatershedStageTimer peaksTimer(workspace.profile, WatershedStage::DistancePeaks);
+    cv::Mat dist = workspace.dist(region);
+    cv::Mat dist_8u = workspace.dist_8u(region);
+    distanceTransformPeaks(bw, 0.4f, dist, workspace.rowMaxima, dist_8u);
+}
+
+/// Marker of the pixels that are known not to belong to the label, above the marker of any instance
+static const int backgroundMarker = INT_MAX;
+
+/**
+    The index (from 1) of the label of every gray value, or 0 for the values of no label, for the shared passes.
+    Returns false if the values of two labels overlap, since a pixel would then belong to both.
+ */
+static bool labelIndexTable (const int *labelValues, size_t labelCount, std::array<uchar, 256> &table) {
+    table.fill(0);
+    if (labelCount > 255) {
+        return false;
+    }
+    for (size_t k = 0; k < labelCount; k++) {
+        for (int value = std::max(labelValues[k] - 3, 0); value <= std::min(labelValues[k] + 3, 255); value++) {
+            if (table[value] != 0) {
+                return false;
+            }
+            table[value] = static_cast<uchar>(k + 1);
+        }
+    }
+    return true;
+}
+
+/**
+    Finds the label of every pixel of the region, and its landscape, as labelPeaksInRegion finds them label by label.
+ 
+    The Laplacian of a pixel of a label only sees the neighbours of the same label (the label mask is zero elsewhere),
+    and the sharpened value of every other pixel is negative, which saturates to zero. So a single pass finds the landscape
+    of every label, each on the pixels of its own label. Neighbours are reflected at the edges of the region, which only
+    matters at the edges of the frame, since the regions of the labels are padded.
+ */
+static void labelLandscapes (WatershedWorkspace &workspace, const std::array<uchar, 256> &labelIndex, cv::Rect region) {
+    const cv::Mat gray = workspace.gray(region);
+    cv::Mat indices = workspace.labelIndices(region);
+    cv::Mat landscape = workspace.landscape(region);
+    const int rows = region.height;
+    const int cols = region.width;
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++)
+        {
+            const uchar *grayRow = gray.ptr<uchar>(i);
+            uchar *indexRow = indices.ptr<uchar>(i);
+            for (int j = 0; j < cols; j++)
+            {
+                indexRow[j] = labelIndex[grayRow[j]];
+            }
+        }
+    });
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++)
+        {
+            // BORDER_REFLECT_101, as filter2D extrapolates the region
+            const int above = (i > 0) ? i - 1 : std::min(1, rows - 1);
+            const int below = (i < rows - 1) ? i + 1 : std::max(rows - 2, 0);
+            const uchar *grayRows[3] = { gray.ptr<uchar>(above), gray.ptr<uchar>(i), gray.ptr<uchar>(below) };
+            const uchar *indexRows[3] = { indices.ptr<uchar>(above), indices.ptr<uchar>(i), indices.ptr<uchar>(below) };
+            uchar *landscapeRow = landscape.ptr<uchar>(i);
+            for (int j = 0; j < cols; j++)
+            {
+                const uchar index = indexRows[1][j];
+                if (index == 0) {
+                    landscapeRow[j] = 0;
+                    continue;
+                }
+                const int left = (j > 0) ? j - 1 : std::min(1, cols - 1);
+                const int right = (j < cols - 1) ? j + 1 : std::max(cols - 2, 0);
+                const int columns[3] = { left, j, right };
+                // The label mask minus its Laplacian: 9 times the pixel, minus its neighbours of the same label
+                int sharp = 9 * grayRows[1][j];
+                for (int r = 0; r < 3; r++) {
+                    for (int c = 0; c < 3; c++) {
+                        int x = columns[c];
+                        if ((r != 1 || c != 1) && indexRows[r][x] == index) {
+                            sharp -= grayRows[r][x];
+                        }
+                    }
+                }
+                landscapeRow[j] = cv::saturate_cast<uchar>(sharp);
+            }
+        }
+    });
+}
+
+/**
+    Copies the landscape and the pixels of a single label out of the shared passes, into the workspace's imgResult and bgMask,
+    at the top left of the full frame buffers (in region coordinates), as labelPeaksInRegion leaves them.
+ */
+static void extractLabelLandscape (WatershedWorkspace &workspace, uchar labelIndex, cv::Rect roi) {
+    cv::Rect region(0, 0, roi.width, roi.height);
+    const cv::Mat indices = workspace.labelIndices(roi);
+    const cv::Mat landscape = workspace.landscape(roi);
+    cv::Mat imgResult = workspace.imgResult(region);
+    cv::Mat labelPixels = workspace.bgMask(region);
+    for (int i = 0; i < roi.height; i++)
+    {
+        const uchar *indexRow = indices.ptr<uchar>(i);
+        const uchar *landscapeRow = landscape.ptr<uchar>(i);
+        uchar *resultRow = imgResult.ptr<uchar>(i);
+        uchar *labelRow = labelPixels.ptr<uchar>(i);
+        for (int j = 0; j < roi.width; j++)
+        {
+            bool isLabel = indexRow[j] == labelIndex;
+            resultRow[j] = isLabel ? landscapeRow[j] : 0;
+            labelRow[j] = isLabel ? 255 : 0;
+        }
+    }
+}
+
+/**
+    Finds the landscapes and the distances of all the labels of a frame in shared passes, over the union of their regions.
+ 
+    The Otsu threshold of each label still comes from the landscape of that label alone, over the full frame. The labels that pass it (and are not
+    on a depth edge) are left in foregroundLabels, and their distances in dist, both in frame coordinates.
+    squaredLabelDistanceTransform gives every label the distances of its own binary image, and the region of a label holds
+    all its pixels, so the peaks of each label can then be found on its own region, as labelPeaksInRegion finds them.
+ */
+static void sharedLabelTerms (WatershedWorkspace &workspace, const std::array<uchar, 256> &labelIndex, size_t labelCount,
+                              cv::Mat depthEdges) {
+    cv::Rect frameRegion;
+    for (size_t k = 0; k < labelCount; k++) {
+        const cv::Rect &roi = workspace.labelRegions[k];
+        frameRegion = frameRegion.empty() ? roi : (roi.empty() ? frameRegion : (frameRegion | roi));
+    }
+    if (frameRegion.empty()) {
+        return;
+    }
+    
+    WatershedStageTimer landscapeTimer(workspace.profile, WatershedStage::Landscape);
+    labelLandscapes(workspace, labelIndex, frameRegion);
+    
+    // Thresholds are indexed by label index; the background (index 0) never passes
+    std::vector<int> &thresholds = workspace.labelThresholds;
+    thresholds.assign(labelCount + 1, 255);
+    for (size_t k = 0; k < labelCount; k++) {
+        const cv::Rect &roi = workspace.labelRegions[k];
+        if (roi.empty()) {
+            continue;
+        }
+        cv::Rect region(0, 0, roi.width, roi.height);
+        extractLabelLandscape(workspace, static_cast<uchar>(k + 1), roi);
+        size_t outsideZeros = workspace.gray.total() - static_cast<size_t>(roi.area());
+        thresholds[k + 1] = cvFloor(otsuThreshold(workspace.imgResult(region), outsideZeros));
+    }
+    
+    const cv::Mat indices = workspace.labelIndices(frameRegion);
+    const cv::Mat landscape = workspace.landscape(frameRegion);
+    cv::Mat foreground = workspace.foregroundLabels(frameRegion);
+    const cv::Mat edges = depthEdges.empty() ? cv::Mat() : depthEdges(frameRegion);
+    cv::parallel_for_(cv::Range(0, frameRegion.height), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++)
+        {
+            const uchar *indexRow = indices.ptr<uchar>(i);
+            const uchar *landscapeRow = landscape.ptr<uchar>(i);
+            const uchar *edgeRow = edges.empty() ? nullptr : edges.ptr<uchar>(i);
+            uchar *foregroundRow = foreground.ptr<uchar>(i);
+            for (int j = 0; j < frameRegion.width; j++)
+            {
+                uchar index = indexRow[j];
+                bool passes = landscapeRow[j] > thresholds[index] && !(edgeRow && edgeRow[j]);
+                foregroundRow[j] = passes ? index : 0;
+            }
+        }
+    });
+    landscapeTimer.stop();
+    
+    WatershedStageTimer peaksTimer(workspace.profile, WatershedStage::DistancePeaks);
+    squaredLabelDistanceTransform(foreground, workspace.dist(frameRegion), workspace.rowMaxima);
+}
+
+/**
+    Finds the landscape and the marker peaks of a single label from the shared passes of the frame,
+    and leaves them where labelPeaksInRegion does.
+ */
+static void sharedLabelPeaksInRegion (WatershedWorkspace &workspace, uchar labelIndex, cv::Rect roi, cv::Mat depthEdges) {
+    cv::Rect region(0, 0, roi.width, roi.height);
+    WatershedStageTimer landscapeTimer(workspace.profile, WatershedStage::Landscape);
+    extractLabelLandscape(workspace, labelIndex, roi);
+    if (!depthEdges.empty()) {
+        workspace.imgResult(region).setTo(0, depthEdges(roi));
+    }
+    landscapeTimer.stop();
+    
+    WatershedStageTimer peaksTimer(workspace.profile, WatershedStage::DistancePeaks);
+    labelDistancePeaks(workspace.foregroundLabels(roi), labelIndex, 0.4f, workspace.dist(roi), workspace.dist_8u(region));
+}
+
+/**
+    Returns the center of the background marker of a region: a point whose 7x7 neighbourhood has no label pixels, so that
+    the marker cannot seed the label. The padding of the region puts (5, 5) on the background unless the region is clipped
+    by the frame; otherwise the first clear neighbourhood in raster order is taken. If the label leaves no clear
+    neighbourhood, the radius is set to 0 and the first pixel off the label is returned, or (-1, -1) if there is none.
+ */
+static cv::Point backgroundSeed (const cv::Mat &labelPixels, int &radius, std::vector<int> &backgroundRuns) {
+    radius = 3;
+    const int side = 2 * radius + 1;
+    auto isClear = [&](cv::Point center) {
+        if (center.x - radius < 0 || center.y - radius < 0 ||
+            center.x + radius >= labelPixels.cols || center.y + radius >= labelPixels.rows) {
+            return false;
+        }
+        for (int i = center.y - radius; i <= center.y + radius; i++) {
+            const uchar *row = labelPixels.ptr<uchar>(i);
+            for (int j = center.x - radius; j <= center.x + radius; j++) {
+                if (row[j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    if (isClear(cv::Point(5, 5))) {
+        return cv::Point(5, 5);
+    }
+    
+    // Per column, the number of rows without label pixels that end at the current row
+    backgroundRuns.assign(labelPixels.cols, 0);
+    cv::Point firstBackground(-1, -1);
+    for (int i = 0; i < labelPixels.rows; i++)
+    {
+        const uchar *row = labelPixels.ptr<uchar>(i);
+        int clearColumns = 0;
+        for (int j = 0; j < labelPixels.cols; j++)
+        {
+            backgroundRuns[j] = row[j] ? 0 : backgroundRuns[j] + 1;
+            if (firstBackground.x < 0 && !row[j]) {
+                firstBackground = cv::Point(j, i);
+            }
+            clearColumns = (backgroundRuns[j] >= side) ? clearColumns + 1 : 0;
+            if (clearColumns >= side) {
+                return cv::Point(j - radius, i - radius);
+            }
+        }
+    }
+    radius = 0;
+    return firstBackground;
+}
+
+/**
+    Runs the watershed for a single label on the region of interest of the workspace's border-erased grayscale mask,
+    and writes the colored instances into the given full frame image.
+    
+    The region is expected to be padded so that the label pixels never touch its edges. The landscape, the Otsu threshold,
+    the distances and so the markers are then those of the full frame. The flood is not always: the background is seeded
+    near the top left of the region rather than of the frame, and where an instance and the background flood the same
+    plateau of the landscape, the one that reaches a pixel first takes it, so a few pixels can change sides.
+    WatershedWorkspace::cropLabelRegions = false runs the label on the full frame instead.
+    With a label index, the peaks come from the shared passes of the frame (see sharedLabelTerms); with 0, from the label alone.
+    Every intermediate image is a view into the workspace, so no buffers are allocated here.
+ */
+static void watershedLabelInRegion (WatershedWorkspace &workspace, int labelValue, uchar labelIndex, cv::Rect roi,
+                                    cv::Mat depthEdges, cv::Mat image, WatershedLabelResult &result) {
+    result.labelValue = labelValue;
+    result.image = image;
+    FlatContours &flatContours = result.contours;
+    flatContours.points.clear();
+    flatContours.offsets.assign(1, 0);
+    flatContours.colors.clear();
+    
+    image.setTo(0);
+    if (roi.empty()) {
+        return;
+    }
+    cv::Rect region(0, 0, roi.width, roi.height);
+    if (labelIndex != 0) {
+        sharedLabelPeaksInRegion(workspace, labelIndex, roi, depthEdges);
+    } else {
+        size_t outsideZeros = workspace.gray.total() - static_cast<size_t>(roi.area());
+        labelPeaksInRegion(workspace, labelValue, roi, outsideZeros, depthEdges);
+    }
+    cv::Mat imgResult = workspace.imgResult(region);
+    cv::Mat dist_8u = workspace.dist_8u(region);
+    
     // Find total markers
-    std::vector<std::vector<cv::Point> > contours;
+    WatershedStageTimer markersTimer(workspace.profile, WatershedStage::Markers);
+    std::vector<std::vector<cv::Point>> &contours = workspace.contours;
     cv::findContours(dist_8u, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
     
     // Create the marker image for the watershed algorithm
-    cv::Mat markers = cv::Mat::zeros(dist.size(), CV_32SC1);
-    
-    // Draw the foreground markers
+    cv::Mat markers = workspace.markers(region);
+    markers.setTo(0);
     for (size_t i = 0; i < contours.size(); i++)
     {
         cv::drawContours(markers, contours, static_cast<int>(i), cv::Scalar(static_cast<int>(i)+1), -1);
     }
+    // The background marker must not seed the label, which it could where the frame clips the padding of the region
+    int seedRadius = 0;
+    cv::Point seed = backgroundSeed(workspace.bgMask(region), seedRadius, workspace.backgroundRuns);
+    if (seed.x >= 0) {
+        cv::circle(markers, seed, seedRadius, cv::Scalar(backgroundMarker), -1);
+    }
+    markersTimer.stop();
+    
+    // The watershed algorithm expects a 3-channel image
+    WatershedStageTimer floodTimer(workspace.profile, WatershedStage::Flood);
+    cv::Mat imgResultBGR = workspace.imgResultBGR(region);
+    cv::cvtColor(imgResult, imgResultBGR, cv::COLOR_GRAY2BGR);
+    cv::watershed(imgResultBGR, markers);
+    floodTimer.stop();
     
-    // Draw the background marker
-    cv::circle(markers, cv::Point(5,5), 3, cv::Scalar(255), -1);
+    // Color the instances, and leave everything else transparent.
+    // Everything outside the region is background, and is already transparent in the image.
+    WatershedStageTimer colorizeTimer(workspace.profile, WatershedStage::Colorize);
+    instanceColors(workspace.colorSeed, labelValue, contours.size(), flatContours.colors);
+    colorizeMarkers(markers, flatContours.colors, image(roi));
+    colorizeTimer.stop();
+    
+    // Flatten the contours, and move them back to the full frame coordinates
+    WatershedStageTimer contoursTimer(workspace.profile, WatershedStage::Contours);
+    for (const std::vector<cv::Point> &contour : contours) {
+        for (const cv::Point &point : contour) {
+            flatContours.points.push_back(point + roi.tl());
+        }
+        flatContours.offsets.push_back(static_cast<int>(flatContours.points.size()));
+    }
+}
 
-    // Perform the watershed algorithm
-    cv::watershed(imgResult, markers);
+/**
+    Finds the depth discontinuities of the frame into the workspace, when the depth-aware mode is enabled.
+    Returns an empty image otherwise.
+ */
+static cv::Mat frameDepthEdges (cv::Mat depth, cv::Size size, WatershedWorkspace &workspace) {
+    if (!workspace.useDepth || depth.empty()) {
+        return cv::Mat();
+    }
+    WatershedStageTimer timer(workspace.profile, WatershedStage::DepthEdges);
+    resampleDepth(depth, size, workspace.depthScratch, workspace.depthResampled);
+    workspace.depthEdges.create(size, CV_8UC1);
+    depthDiscontinuities(workspace.depthResampled, workspace.depthDiscontinuityThreshold, workspace.depthEdges);
+    return workspace.depthEdges;
+}
+
+/**
+    Runs the watershed for each label on a mask in the given channel order, into the workspace.
+ */
+static void watershedLabels (cv::Mat mask, cv::Mat depth, bool isRGBOrder, const int *labelValues, size_t labelCount,
+                             WatershedWorkspace &workspace, WatershedLabelResult *results) {
+    workspace.prepare(mask.size(), labelCount);
+    if (workspace.profile != nullptr) {
+        workspace.profile->frames++;
+    }
+    prepareGrayMask(mask, grayConversionCode(mask.channels(), isRGBOrder), workspace);
     
-    // Generate random colors
-    std::vector<cv::Vec3b> colors;
-    for (size_t i = 0; i < contours.size(); i++)
-    {
-        int b = cv::theRNG().uniform(0, 256);
-        int g = cv::theRNG().uniform(0, 256);
-        int r = cv::theRNG().uniform(0, 256);
- 
-        colors.push_back(cv::Vec3b((uchar)b, (uchar)g, (uchar)r));
+    // The depth edges are shared by all the labels, so they are found once per frame
+    cv::Mat depthEdges = frameDepthEdges(depth, mask.size(), workspace);
+    
+    WatershedStageTimer boundsTimer(workspace.profile, WatershedStage::ValueBounds);
+    std::array<cv::Rect, 256> valueBounds = computeValueBounds(workspace.gray);
+    workspace.labelRegions.resize(labelCount);
+    for (size_t k = 0; k < labelCount; k++) {
+        workspace.labelRegions[k] = labelRegion(valueBounds, labelValues[k], mask.size(), workspace.cropLabelRegions);
     }
+    boundsTimer.stop();
     
-    // Create the result image
-    cv::Mat dst = cv::Mat::zeros(markers.size(), CV_8UC3);
+    // The landscapes and distances of all the labels are found together, unless a pixel could belong to two labels
+    std::array<uchar, 256> labelIndex;
+    bool shared = workspace.shareLabelTerms && labelIndexTable(labelValues, labelCount, labelIndex);
+    if (shared) {
+        sharedLabelTerms(workspace, labelIndex, labelCount, depthEdges);
+    }
+    for (size_t k = 0; k < labelCount; k++) {
+        uchar index = shared ? static_cast<uchar>(k + 1) : 0;
+        watershedLabelInRegion(workspace, labelValues[k], index, workspace.labelRegions[k], depthEdges,
+                               workspace.labelImages[k], results[k]);
+    }
+}
+
+/**
+    Same as watershed1DMaskAndDepthAndReturnContoursColors, but uses the given workspace, and fills the given result.
+    When the workspace and the result are reused across frames of the same size, no buffers are reallocated.
+ */
+void watershed1DMaskAndDepthAndReturnContoursColors (cv::Mat mask, cv::Mat depth, int labelValue,
+                                                     WatershedWorkspace &workspace, WatershedLabelResult &result) {
+    watershedLabels(mask, depth, false, &labelValue, 1, workspace, &result);
+}
+
+/**
+    Same as above, but reads the mask (and depth) directly from the memory described by the image views, without copying it.
+ */
+void watershed1DMaskAndDepthAndReturnContoursColors (const ImageView &mask, const ImageView &depth, int labelValue,
+                                                     WatershedWorkspace &workspace, WatershedLabelResult &result) {
+    watershedLabels(matFromImageView(mask), matFromImageView(depth), mask.format == ImagePixelFormat::RGBA8, &labelValue, 1, workspace, &result);
+}
+
+/**
+    This function performs the watershed for multiple label values on the same mask in a single call.
  
-//    // Fill labeled objects with random colors
-    int i1 = -1;
-    int j1 = -1;
-    for (int i = 0; i < markers.rows; i++)
-    {
-        for (int j = 0; j < markers.cols; j++)
+    Unlike calling watershed1DMaskAndDepthAndReturnContoursColors once per label, the per-frame work is shared:
+    the mask is converted to grayscale and border-erased once, and the bounding box of every grayscale value is found in one pass.
+    Each label is then processed only within the (padded) bounding box of its pixels, instead of the full frame.
+ 
+    The results are returned in the same order as the label values.
+ */
+std::vector<WatershedLabelResult>
+watershedMultiLabelMaskAndDepth (cv::Mat mask, cv::Mat depth, const std::vector<int> &labelValues) {
+    std::vector<WatershedLabelResult> results;
+    watershedMultiLabelMaskAndDepth(mask, depth, labelValues, defaultWorkspace(), results);
+    
+    // The returned images must outlive the shared workspace
+    for (WatershedLabelResult &result : results) {
+        result.image = result.image.clone();
+    }
+    return results;
+}
+
+/**
+    Same as above, but uses the given workspace, and fills the given results.
+    When the workspace and the results are reused across frames of the same size, no buffers are reallocated.
+ */
+void watershedMultiLabelMaskAndDepth (cv::Mat mask, cv::Mat depth, const std::vector<int> &labelValues,
+                                      WatershedWorkspace &workspace, std::vector<WatershedLabelResult> &results) {
+    results.resize(labelValues.size());
+    watershedLabels(mask, depth, false, labelValues.data(), labelValues.size(), workspace, results.data());
+}
+
+/**
+    Same as above, but reads the mask (and depth) directly from the memory described by the image views, without copying it.
+ */
+void watershedMultiLabelMaskAndDepth (const ImageView &mask, const ImageView &depth, const std::vector<int> &labelValues,
+                                      WatershedWorkspace &workspace, std::vector<WatershedLabelResult> &results) {
+    results.resize(labelValues.size());
+    watershedLabels(matFromImageView(mask), matFromImageView(depth), mask.format == ImagePixelFormat::RGBA8, labelValues.data(), labelValues.size(), workspace, results.data());
+}
+
+/// Size of the tiles that the temporal watershed recomputes when the mask changes
+static const int temporalTileSize = 32;
+
+size_t WatershedTemporalState::liveInstanceCount () const {
+    return std::count_if(instanceRecords.begin(), instanceRecords.end(),
+                         [](const WatershedTemporalInstance &record) { return record.live; });
+}
+
+void WatershedTemporalState::reset () {
+    labelValue = -1;
+    labelPixels.release();
+    instances.release();
+    image.release();
+    instanceRecords.clear();
+    freeInstanceIds.clear();
+    nextInstanceId = 1;
+    contourInstanceIds.clear();
+}
+
+/**
+    Whether nearest neighbour sampling through the inverse homography maps every pixel of the frame onto itself,
+    as it does when the camera has not moved. The map must be affine, and then it moves the pixels the most at the corners.
+ */
+static bool isIdentityWarp (const cv::Matx33d &inverse, cv::Size size) {
+    if (inverse(2, 0) != 0 || inverse(2, 1) != 0 || inverse(2, 2) <= 0) {
+        return false;
+    }
+    // Below half a pixel, with a margin for the rounding of the warp's own arithmetic
+    const double maxShift = 0.5 - 1e-6;
+    const cv::Point2d corners[] = { cv::Point2d(0, 0), cv::Point2d(size.width - 1, 0),
+                                    cv::Point2d(0, size.height - 1), cv::Point2d(size.width - 1, size.height - 1) };
+    for (const cv::Point2d &corner : corners) {
+        double x = (inverse(0, 0) * corner.x + inverse(0, 1) * corner.y + inverse(0, 2)) / inverse(2, 2);
+        double y = (inverse(1, 0) * corner.x + inverse(1, 1) * corner.y + inverse(1, 2)) / inverse(2, 2);
+        if (std::fabs(x - corner.x) >= maxShift || std::fabs(y - corner.y) >= maxShift) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+    The region of the current frame whose pixels sample a region of the previous frame, through the homography.
+    Nearest neighbour sampling reaches half a pixel around the region, so the region is grown by a pixel before it is mapped.
+    Returns the whole frame when a corner maps behind the camera, where the corners no longer bound the mapped region.
+ */
+static cv::Rect warpedRegion (const cv::Matx33d &homography, cv::Rect region, cv::Size size) {
+    const cv::Rect frame(0, 0, size.width, size.height);
+    if (region.empty()) {
+        return cv::Rect();
+    }
+    const cv::Point2d corners[] = { cv::Point2d(region.x - 1, region.y - 1), cv::Point2d(region.br().x, region.y - 1),
+                                    cv::Point2d(region.x - 1, region.br().y), cv::Point2d(region.br().x, region.br().y) };
+    double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+    for (const cv::Point2d &corner : corners) {
+        double w = homography(2, 0) * corner.x + homography(2, 1) * corner.y + homography(2, 2);
+        if (w <= 0) {
+            return frame;
+        }
+        double x = (homography(0, 0) * corner.x + homography(0, 1) * corner.y + homography(0, 2)) / w;
+        double y = (homography(1, 0) * corner.x + homography(1, 1) * corner.y + homography(1, 2)) / w;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+    // Clamped before the conversion, so that far away corners cannot overflow
+    int left = static_cast<int>(std::floor(std::max(minX, -1.0)));
+    int top = static_cast<int>(std::floor(std::max(minY, -1.0)));
+    int right = static_cast<int>(std::ceil(std::min(maxX, double(size.width)))) + 1;
+    int bottom = static_cast<int>(std::ceil(std::min(maxY, double(size.height)))) + 1;
+    return cv::Rect(left, top, right - left, bottom - top) & frame;
+}
+
+/**
+    Warps the label pixels and the instances of the previous frame into the current frame, with nearest neighbour sampling.
+    Only the target region can sample label pixels; everywhere else, and where pixels map outside of the previous frame,
+    the warped pixels are cleared.
+ */
+static void warpPreviousFrame (WatershedTemporalState &state, const cv::Matx33d &homography, cv::Rect target) {
+    const cv::Matx33d inverse = homography.inv();
+    const cv::Mat &labelPixels = state.labelPixels;
+    const cv::Mat &instances = state.instances;
+    const int cols = labelPixels.cols;
+    const int rows = labelPixels.rows;
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++)
         {
-            int index = markers.at<int>(i,j);
-            if (index > 0 && index <= static_cast<int>(contours.size()))
+            uchar *labelRow = state.warpedLabelPixels.ptr<uchar>(i);
+            int *instanceRow = state.warpedInstances.ptr<int>(i);
+            if (i < target.y || i >= target.br().y) {
+                std::memset(labelRow, 0, cols * sizeof(uchar));
+                std::memset(instanceRow, 0, cols * sizeof(int));
+                continue;
+            }
+            std::memset(labelRow, 0, target.x * sizeof(uchar));
+            std::memset(instanceRow, 0, target.x * sizeof(int));
+            std::memset(labelRow + target.br().x, 0, (cols - target.br().x) * sizeof(uchar));
+            std::memset(instanceRow + target.br().x, 0, (cols - target.br().x) * sizeof(int));
+            for (int j = target.x; j < target.br().x; j++)
             {
-                dst.at<cv::Vec3b>(i,j) = colors[index-1];
-                if ((i1 == -1) && (j1 == -1)) {
-                    i1 = i;
-                    j1 = j;
+                double w = inverse(2, 0) * j + inverse(2, 1) * i + inverse(2, 2);
+                double x = (inverse(0, 0) * j + inverse(0, 1) * i + inverse(0, 2)) / w;
+                double y = (inverse(1, 0) * j + inverse(1, 1) * i + inverse(1, 2)) / w;
+                int sourceX = cvRound(x);
+                int sourceY = cvRound(y);
+                if (w <= 0 || sourceX < 0 || sourceX >= cols || sourceY < 0 || sourceY >= rows) {
+                    labelRow[j] = 0;
+                    instanceRow[j] = 0;
+                    continue;
                 }
+                labelRow[j] = labelPixels.at<uchar>(sourceY, sourceX);
+                instanceRow[j] = instances.at<int>(sourceY, sourceX);
             }
         }
+    });
+}
+
+/**
+    Finds the label pixels of the current frame, and in the same pass flags the tiles where they differ from the warped
+    label pixels (dirty tiles) and the tiles that hold label pixels at all.
+    When instances are given, the instances of the pixels that have left the label are cleared.
+    Returns the bounding box of the dirty tiles, grown by one tile so that the recomputed region has some context.
+ */
+static cv::Rect compareLabelTiles (WatershedTemporalState &state, const cv::Mat &gray, int labelValue, const cv::Mat &warped,
+                                   cv::Mat instances, int tilesX, int tilesY) {
+    // The label matches the values within 3 of its own, as in the other watershed functions
+    const int lowestValue = labelValue - 3;
+    const unsigned valueRange = 6;
+    const int cols = gray.cols;
+    const int rows = gray.rows;
+    cv::Mat &current = state.currentLabelPixels;
+    state.dirtyTiles.assign(tilesX * tilesY, 0);
+    state.labelTiles.assign(tilesX * tilesY, 0);
+    
+    cv::parallel_for_(cv::Range(0, tilesY), [&](const cv::Range &range) {
+        for (int ty = range.start; ty < range.end; ty++)
+        {
+            uchar *dirtyRow = &state.dirtyTiles[ty * tilesX];
+            uchar *labelRow = &state.labelTiles[ty * tilesX];
+            for (int i = ty * temporalTileSize; i < std::min((ty + 1) * temporalTileSize, rows); i++)
+            {
+                const uchar *grayRow = gray.ptr<uchar>(i);
+                const uchar *warpedRow = warped.ptr<uchar>(i);
+                uchar *currentRow = current.ptr<uchar>(i);
+                for (int tx = 0; tx < tilesX; tx++)
+                {
+                    uchar changed = 0;
+                    uchar labeled = 0;
+                    for (int j = tx * temporalTileSize; j < std::min((tx + 1) * temporalTileSize, cols); j++)
+                    {
+                        uchar value = static_cast<unsigned>(grayRow[j] - lowestValue) <= valueRange ? 255 : 0;
+                        currentRow[j] = value;
+                        changed |= value ^ warpedRow[j];
+                        labeled |= value;
+                    }
+                    dirtyRow[tx] |= changed;
+                    labelRow[tx] |= labeled;
+                }
+                if (!instances.empty()) {
+                    int *instanceRow = instances.ptr<int>(i);
+                    for (int j = 0; j < cols; j++)
+                    {
+                        instanceRow[j] = currentRow[j] ? instanceRow[j] : 0;
+                    }
+                }
+            }
+        }
+    });
+    
+    cv::Rect dirtyRegion;
+    state.labelBounds = cv::Rect();
+    for (int ty = 0; ty < tilesY; ty++)
+    {
+        for (int tx = 0; tx < tilesX; tx++)
+        {
+            cv::Rect tile(tx * temporalTileSize, ty * temporalTileSize, temporalTileSize, temporalTileSize);
+            if (state.dirtyTiles[ty * tilesX + tx]) {
+                dirtyRegion = dirtyRegion.empty() ? tile : (dirtyRegion | tile);
+            }
+            if (state.labelTiles[ty * tilesX + tx]) {
+                state.labelBounds = state.labelBounds.empty() ? tile : (state.labelBounds | tile);
+            }
+        }
+    }
+    const cv::Rect frame(0, 0, cols, rows);
+    state.labelBounds &= frame;
+    if (dirtyRegion.empty()) {
+        return dirtyRegion;
+    }
+    dirtyRegion = cv::Rect(dirtyRegion.x - temporalTileSize, dirtyRegion.y - temporalTileSize,
+                           dirtyRegion.width + 2 * temporalTileSize, dirtyRegion.height + 2 * temporalTileSize);
+    return dirtyRegion & frame;
+}
+
+/**
+    Returns the warped instance that most of the points of a marker contour fall on, or 0 if they fall on none.
+ */
+static int dominantInstance (const std::vector<cv::Point> &contour, cv::Point offset, const cv::Mat &warpedInstances) {
+    // Markers are small, so a short list of candidates is enough
+    std::vector<std::pair<int, int>> counts;
+    for (const cv::Point &point : contour) {
+        int instance = warpedInstances.at<int>(point + offset);
+        if (instance <= 0) {
+            continue;
+        }
+        auto it = std::find_if(counts.begin(), counts.end(),
+                               [instance](const std::pair<int, int> &count) { return count.first == instance; });
+        if (it == counts.end()) {
+            counts.emplace_back(instance, 1);
+        } else {
+            it->second++;
+        }
+    }
+    int best = 0;
+    int bestCount = 0;
+    for (const std::pair<int, int> &count : counts) {
+        if (count.second > bestCount) {
+            best = count.first;
+            bestCount = count.second;
+        }
+    }
+    return best;
+}
+
+/**
+    Hands out a retired ID if there is one, and a new ID otherwise.
+ */
+static int acquireInstanceId (WatershedTemporalState &state) {
+    int instance;
+    if (!state.freeInstanceIds.empty()) {
+        instance = state.freeInstanceIds.back();
+        state.freeInstanceIds.pop_back();
+    } else {
+        instance = state.nextInstanceId++;
+        state.instanceRecords.resize(state.nextInstanceId);
+    }
+    WatershedTemporalInstance &record = state.instanceRecords[instance];
+    record.live = true;
+    record.bounds = cv::Rect();
+    record.contours.clear();
+    return instance;
+}
+
+/**
+    Reruns the watershed within the dirty region, seeded with the warped instances of the clean tiles and with new markers
+    in the dirty tiles, and writes the flooded instances into the warped instances.
+ */
+static void recomputeDirtyRegion (WatershedWorkspace &workspace, WatershedTemporalState &state, int labelValue,
+                                  cv::Rect roi, int tilesX, cv::Mat depthEdges, const cv::Mat &instances) {
+    cv::Rect region(0, 0, roi.width, roi.height);
+    // The dirty region can cut through the label, so its threshold is that of the region alone
+    labelPeaksInRegion(workspace, labelValue, roi, 0, depthEdges);
+    WatershedStageTimer markersTimer(workspace.profile, WatershedStage::Markers);
+    cv::Mat imgResult = workspace.imgResult(region);
+    cv::Mat labelPixels = workspace.bgMask(region);
+    cv::Mat dist_8u = workspace.dist_8u(region);
+    cv::Mat warpedInstances = instances(roi);
+    
+    // Clean tiles keep their warped instances as seeds, and pixels off the label are background
+    cv::Mat markers = workspace.markers(region);
+    for (int i = 0; i < roi.height; i++)
+    {
+        const uchar *labelRow = labelPixels.ptr<uchar>(i);
+        const int *warpedRow = warpedInstances.ptr<int>(i);
+        const uchar *dirtyRow = &state.dirtyTiles[((roi.y + i) / temporalTileSize) * tilesX];
+        int *markerRow = markers.ptr<int>(i);
+        for (int j = 0; j < roi.width; j++)
+        {
+            if (labelRow[j] == 0) {
+                markerRow[j] = backgroundMarker;
+            } else if (!dirtyRow[(roi.x + j) / temporalTileSize]) {
+                markerRow[j] = warpedRow[j];
+            } else {
+                markerRow[j] = 0;
+            }
+        }
+    }
+    
+    // New markers take the ID of the instance they overlap, unless another marker has already claimed it
+    std::vector<std::vector<cv::Point>> &contours = workspace.contours;
+    cv::findContours(dist_8u, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    std::vector<int> &claimedIds = state.claimedInstanceIds;
+    claimedIds.clear();
+    for (size_t i = 0; i < contours.size(); i++)
+    {
+        int instance = dominantInstance(contours[i], roi.tl(), instances);
+        if (instance == 0 || std::find(claimedIds.begin(), claimedIds.end(), instance) != claimedIds.end()) {
+            instance = acquireInstanceId(state);
+        }
+        claimedIds.push_back(instance);
+        cv::drawContours(markers, contours, static_cast<int>(i), cv::Scalar(instance), -1);
+    }
+    markersTimer.stop();
+    
+    WatershedStageTimer floodTimer(workspace.profile, WatershedStage::Flood);
+    cv::Mat imgResultBGR = workspace.imgResultBGR(region);
+    cv::cvtColor(imgResult, imgResultBGR, cv::COLOR_GRAY2BGR);
+    cv::watershed(imgResultBGR, markers);
+    
+    // The watershed marks the edges of the region as boundaries, so the warped instances are kept there
+    for (int i = 0; i < roi.height; i++)
+    {
+        const int *markerRow = markers.ptr<int>(i);
+        int *warpedRow = warpedInstances.ptr<int>(i);
+        bool edgeRow = (i == 0 || i == roi.height - 1);
+        for (int j = 0; j < roi.width; j++)
+        {
+            int marker = markerRow[j];
+            if (marker > 0 && marker != backgroundMarker) {
+                warpedRow[j] = marker;
+            } else if (!(marker == -1 && (edgeRow || j == 0 || j == roi.width - 1))) {
+                warpedRow[j] = 0;
+            }
+        }
+    }
+}
+
+/**
+    Outlines again the instances that the changes of the frame may have reached: every instance when all of them have
+    moved, and otherwise the instances that overlap the changed region, or that have just been handed out.
+    The changed region holds every pixel whose instance may have changed. Instances with no pixels left are retired.
+    Returns the bounding box of all the instances.
+ */
+static cv::Rect outlineChangedInstances (WatershedWorkspace &workspace, WatershedTemporalState &state, cv::Rect changed,
+                                         bool moved) {
+    WatershedStageTimer timer(workspace.profile, WatershedStage::Contours);
+    const cv::Mat &instances = state.instances;
+    
+    // The pixels of an instance within the changed region, which may lie outside of its previous bounds
+    std::vector<cv::Rect> &regionBounds = state.regionBounds;
+    regionBounds.assign(state.nextInstanceId, cv::Rect());
+    for (int i = changed.y; i < changed.br().y; i++)
+    {
+        const int *row = instances.ptr<int>(i);
+        for (int j = changed.x; j < changed.br().x; j++)
+        {
+            int instance = row[j];
+            if (instance <= 0) {
+                continue;
+            }
+            cv::Rect &bound = regionBounds[instance];
+            bound = bound.empty() ? cv::Rect(j, i, 1, 1) : (bound | cv::Rect(j, i, 1, 1));
+        }
+    }
+    
+    cv::Rect allBounds;
+    for (int instance = 1; instance < state.nextInstanceId; instance++)
+    {
+        WatershedTemporalInstance &record = state.instanceRecords[instance];
+        if (!record.live) {
+            continue;
+        }
+        if (moved || record.bounds.empty() || (record.bounds & changed).area() > 0) {
+            // Pixels outside of the changed region are where they were, within the previous bounds
+            cv::Rect search = moved ? regionBounds[instance] : (record.bounds | regionBounds[instance]);
+            record.contours.clear();
+            if (!search.empty()) {
+                cv::Mat instancePixels = workspace.bw(cv::Rect(0, 0, search.width, search.height));
+                cv::compare(instances(search), instance, instancePixels, cv::CMP_EQ);
+                cv::findContours(instancePixels, record.contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, search.tl());
+            }
+            if (record.contours.empty()) {
+                record.live = false;
+                record.bounds = cv::Rect();
+                state.freeInstanceIds.push_back(instance);
+                continue;
+            }
+            record.bounds = cv::Rect();
+            for (const std::vector<cv::Point> &contour : record.contours) {
+                cv::Rect contourBounds = cv::boundingRect(contour);
+                record.bounds = record.bounds.empty() ? contourBounds : (record.bounds | contourBounds);
+            }
+        }
+        allBounds = allBounds.empty() ? record.bounds : (allBounds | record.bounds);
+    }
+    return allBounds;
+}
+
+/**
+    Flattens the outlines of every instance of the state, in increasing ID order, with the stable color of its ID.
+ */
+static void flattenOutlines (WatershedWorkspace &workspace, WatershedTemporalState &state, FlatContours &flatContours) {
+    WatershedStageTimer timer(workspace.profile, WatershedStage::Contours);
+    state.contourInstanceIds.clear();
+    for (int instance = 1; instance < state.nextInstanceId; instance++)
+    {
+        const WatershedTemporalInstance &record = state.instanceRecords[instance];
+        if (!record.live) {
+            continue;
+        }
+        for (const std::vector<cv::Point> &contour : record.contours) {
+            flatContours.points.insert(flatContours.points.end(), contour.begin(), contour.end());
+            flatContours.offsets.push_back(static_cast<int>(flatContours.points.size()));
+            flatContours.colors.push_back(state.instanceColors[instance - 1]);
+            state.contourInstanceIds.push_back(instance);
+        }
+    }
+}
+
+void watershedTemporalMaskAndDepth (cv::Mat mask, cv::Mat depth, int labelValue, const cv::Matx33d &homography,
+                                    WatershedWorkspace &workspace, WatershedTemporalState &state, WatershedLabelResult &result) {
+    workspace.prepare(mask.size(), 0);
+    if (workspace.profile != nullptr) {
+        workspace.profile->frames++;
+    }
+    prepareGrayMask(mask, grayConversionCode(mask.channels(), false), workspace);
+    cv::Mat depthEdges = frameDepthEdges(depth, mask.size(), workspace);
+    
+    bool fromScratch = state.labelValue != labelValue || state.instances.size() != mask.size();
+    if (fromScratch) {
+        // With no previous label pixels, every tile that has the label is dirty
+        state.labelValue = labelValue;
+        state.labelPixels = cv::Mat::zeros(mask.size(), CV_8UC1);
+        state.instances = cv::Mat::zeros(mask.size(), CV_32SC1);
+        state.image = cv::Mat::zeros(mask.size(), CV_8UC4);
+        state.labelBounds = cv::Rect();
+        state.instanceBounds = cv::Rect();
+        state.instanceRecords.assign(1, WatershedTemporalInstance());
+        state.freeInstanceIds.clear();
+        state.nextInstanceId = 1;
+        state.instanceColors.clear();
+        state.currentLabelPixels.create(mask.size(), CV_8UC1);
+        state.warpedLabelPixels.create(mask.size(), CV_8UC1);
+        state.warpedInstances.create(mask.size(), CV_32SC1);
+    }
+    
+    // Without camera motion, the previous frame is its own warp, so it is compared and updated in place
+    WatershedStageTimer warpTimer(workspace.profile, WatershedStage::Warp);
+    bool moved = !fromScratch && !isIdentityWarp(homography.inv(), mask.size());
+    cv::Rect warpTarget;
+    if (moved) {
+        warpTarget = warpedRegion(homography, state.labelBounds, mask.size());
+        warpPreviousFrame(state, homography, warpTarget);
+    }
+    cv::Mat instances = moved ? state.warpedInstances : state.instances;
+    int tilesX = (mask.cols + temporalTileSize - 1) / temporalTileSize;
+    int tilesY = (mask.rows + temporalTileSize - 1) / temporalTileSize;
+    cv::Rect dirtyRegion = compareLabelTiles(state, workspace.gray, labelValue,
+                                             moved ? state.warpedLabelPixels : state.labelPixels,
+                                             moved ? instances : cv::Mat(), tilesX, tilesY);
+    warpTimer.stop();
+    if (!dirtyRegion.empty()) {
+        recomputeDirtyRegion(workspace, state, labelValue, dirtyRegion, tilesX, depthEdges, instances);
+    }
+    std::swap(state.labelPixels, state.currentLabelPixels);
+    if (moved) {
+        std::swap(state.instances, state.warpedInstances);
     }
     
-    cv::Mat dist_final = makeBackgroundTransparent(dst, cv::Scalar(0, 0, 0, 255));
+    // Colors are made once per ID, so an instance keeps its color for as long as it keeps its ID
+    bool recolor = moved || state.instanceColorSeed != workspace.colorSeed;
+    if (state.instanceColorSeed != workspace.colorSeed) {
+        state.instanceColors.clear();
+        state.instanceColorSeed = workspace.colorSeed;
+    }
+    for (int instance = static_cast<int>(state.instanceColors.size()) + 1; instance < state.nextInstanceId; instance++) {
+        state.instanceColors.push_back(instanceColor(workspace.colorSeed, labelValue, instance - 1));
+    }
+    
+    cv::Rect changed = moved ? (warpTarget | dirtyRegion) : dirtyRegion;
+    cv::Rect previousInstanceBounds = state.instanceBounds;
+    if (moved || !changed.empty()) {
+        state.instanceBounds = outlineChangedInstances(workspace, state, changed, moved);
+    }
+    
+    // The image is transparent outside of the instance bounds, so only the changed region and the bounds need colors
+    WatershedStageTimer colorizeTimer(workspace.profile, WatershedStage::Colorize);
+    cv::Rect colorRegion = recolor ? (previousInstanceBounds | state.instanceBounds) : changed;
+    if (!colorRegion.empty()) {
+        colorizeMarkers(state.instances(colorRegion), state.instanceColors, state.image(colorRegion));
+    }
+    colorizeTimer.stop();
     
-    return std::make_tuple(dist_final, contours, colors);
-//    return dst;
+    result.labelValue = labelValue;
+    result.image = state.image;
+    FlatContours &flatContours = result.contours;
+    flatContours.points.clear();
+    flatContours.offsets.assign(1, 0);
+    flatContours.colors.clear();
+    flattenOutlines(workspace, state, flatContours);
 }
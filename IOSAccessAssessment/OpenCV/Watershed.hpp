@@ -8,16 +8,213 @@
 #ifndef Watershed_hpp
 #define Watershed_hpp
 #include <opencv2/opencv.hpp>
+#include "ImageView.hpp"
+#include "WatershedProfile.hpp"
+
+/**
+    Scratch buffers used by the watershed functions.
+
+    A workspace keeps its buffers alive across calls, and only reallocates them when the frame size changes.
+    Images returned through a workspace point into it, and are only valid until the next call with the same workspace.
+    A workspace must not be shared between threads.
+ */
+struct WatershedWorkspace {
+    cv::Size frameSize;
+
+    cv::Mat gray;
+    cv::Mat bgMask;
+    cv::Mat labelMask;
+    cv::Mat imgLaplacian;
+    cv::Mat sharp;
+    cv::Mat imgResult;
+    cv::Mat imgResultBGR;
+    cv::Mat bw;
+    cv::Mat dist;       // squared distances
+    cv::Mat dist_8u;    // marker peaks
+    std::vector<float> rowMaxima;
+    cv::Mat markers;
+    
+    /// Label of every pixel (its index in the call, from 1), its landscape, and its label where it passes the threshold,
+    /// found once per frame for all the labels of a call
+    cv::Mat labelIndices;
+    cv::Mat landscape;
+    cv::Mat foregroundLabels;
+    std::vector<cv::Rect> labelRegions;
+    std::vector<int> labelThresholds;
+    /// Runs of background pixels per column, to place the background marker
+    std::vector<int> backgroundRuns;
+    
+    /// Whether a call finds the landscapes and distances of all its labels in shared passes over the frame, rather than
+    /// label by label. The results are the same; labels whose values overlap always go label by label.
+    bool shareLabelTerms = true;
+    /// Whether every label is processed within the padded bounding box of its pixels, rather than on the full frame.
+    /// The markers are the same; the flood can give a few pixels on plateaus to another side (see watershedLabelInRegion).
+    bool cropLabelRegions = true;
+
+    /// Contours in the nested layout that findContours and drawContours work with
+    std::vector<std::vector<cv::Point>> contours;
+
+    /// One output image per label, so that the images of a multi-label call do not overwrite each other
+    std::vector<cv::Mat> labelImages;
+
+    /// Seed of the instance colors; the same seed always gives the same colors
+    uint32_t colorSeed = 0;
+
+    /// Depth-aware mode: when enabled and a depth map is given, instances are also split at depth discontinuities
+    bool useDepth = false;
+    /// Relative depth jump between neighbouring pixels that counts as a discontinuity
+    float depthDiscontinuityThreshold = 0.05f;
+    cv::Mat depthScratch;
+    cv::Mat depthResampled;
+    cv::Mat depthEdges;
+
+    /// When set, every call adds its per-stage timings to this profile
+    WatershedProfile *profile = nullptr;
+
+    /// Resizes the buffers if the frame size has changed
+    void prepare (cv::Size size, size_t labelCount);
+};
+
+/**
+    The contours of all the instances of a label, in one contiguous layout.
+ 
+    The points of contour i are points[offsets[i]] up to (excluding) points[offsets[i + 1]],
+    so offsets has one more entry than there are contours. Contour i has colors[i].
+ */
+struct FlatContours {
+    std::vector<cv::Point> points;
+    std::vector<int> offsets;
+    std::vector<cv::Vec3b> colors;
+    
+    size_t count () const {
+        return colors.size();
+    }
+    
+    /// Expands the contours into the nested layout used by OpenCV
+    std::vector<std::vector<cv::Point>> nested () const;
+};
+
+/**
+    Output of the watershed for a single label value.
+ */
+struct WatershedLabelResult {
+    int labelValue;
+    cv::Mat image;
+    FlatContours contours;
+};
+
+/**
+    What the temporal watershed knows about a single instance ID.
+ */
+struct WatershedTemporalInstance {
+    /// Whether the ID is in use; free IDs are handed out again before new ones
+    bool live = false;
+    /// Bounding box of the pixels of the instance, in frame coordinates
+    cv::Rect bounds;
+    /// Outlines of the instance, in frame coordinates, kept until a change of the frame reaches the instance
+    std::vector<std::vector<cv::Point>> contours;
+};
+
+/**
+    What the temporal watershed keeps from one frame to the next, for a single label.
+ 
+    The instances image holds the stable instance ID of every pixel of the label (0 elsewhere).
+    An instance keeps its ID for as long as it is tracked. Once an ID no longer appears in the instances image,
+    it is retired and handed out again to a later new instance, so the IDs stay below the peak number of instances.
+    The image holds the colored instances of the last result, and is only colored again where the instances change.
+    The remaining buffers are scratch space, and are only reallocated when the frame size changes.
+ */
+struct WatershedTemporalState {
+    int labelValue = -1;
+    cv::Mat labelPixels;
+    cv::Mat instances;
+    cv::Mat image;
+    /// Bounding box of the tiles that hold label pixels
+    cv::Rect labelBounds;
+    /// Bounding box of the instances, outside of which the image is transparent
+    cv::Rect instanceBounds;
+    
+    /// Indexed by ID; IDs below nextInstanceId have been handed out at least once
+    std::vector<WatershedTemporalInstance> instanceRecords;
+    std::vector<int> freeInstanceIds;
+    int nextInstanceId = 1;
+
+    /// The stable instance ID of every contour of the last result
+    std::vector<int> contourInstanceIds;
+
+    /// Instance colors, indexed by ID - 1, for the color seed they were made with
+    std::vector<cv::Vec3b> instanceColors;
+    uint32_t instanceColorSeed = 0;
+
+    cv::Mat currentLabelPixels;
+    cv::Mat warpedLabelPixels;
+    cv::Mat warpedInstances;
+    std::vector<uchar> dirtyTiles;
+    std::vector<uchar> labelTiles;
+    std::vector<int> claimedInstanceIds;
+    std::vector<cv::Rect> regionBounds;
+    
+    /// Number of IDs in use
+    size_t liveInstanceCount () const;
+
+    /// Forgets the previous frame, so that the next frame is processed from scratch
+    void reset ();
+};
+
+/**
+    Wraps the memory of an image view in a cv::Mat header, without copying it.
+ */
+cv::Mat matFromImageView (const ImageView &view);
 
 cv::Mat watershedMaskAndDepth (cv::Mat mask, cv::Mat depth);
 
 cv::Mat watershed1DMaskAndDepth (cv::Mat mask, cv::Mat depth, int labelValue);
 
+cv::Mat watershed1DMaskAndDepth (cv::Mat mask, cv::Mat depth, int labelValue, WatershedWorkspace &workspace);
+
 cv::Mat eraseBorders (cv::Mat mask, int borderSize);
 
+void eraseBorders (cv::Mat mask, int borderSize, cv::Mat &output);
+
 cv::Mat makeBackgroundTransparent (cv::Mat mat, cv::Scalar backgroundColor);
 
 std::tuple<cv::Mat, std::vector<std::vector<cv::Point>>, std::vector<cv::Vec3b>>
 watershed1DMaskAndDepthAndReturnContoursColors (cv::Mat mask, cv::Mat depth, int labelValue);
 
+void watershed1DMaskAndDepthAndReturnContoursColors (cv::Mat mask, cv::Mat depth, int labelValue,
+                                                     WatershedWorkspace &workspace, WatershedLabelResult &result);
+
+void watershed1DMaskAndDepthAndReturnContoursColors (const ImageView &mask, const ImageView &depth, int labelValue,
+                                                     WatershedWorkspace &workspace, WatershedLabelResult &result);
+
+std::vector<WatershedLabelResult>
+watershedMultiLabelMaskAndDepth (cv::Mat mask, cv::Mat depth, const std::vector<int> &labelValues);
+
+void watershedMultiLabelMaskAndDepth (cv::Mat mask, cv::Mat depth, const std::vector<int> &labelValues,
+                                      WatershedWorkspace &workspace, std::vector<WatershedLabelResult> &results);
+
+void watershedMultiLabelMaskAndDepth (const ImageView &mask, const ImageView &depth, const std::vector<int> &labelValues,
+                                      WatershedWorkspace &workspace, std::vector<WatershedLabelResult> &results);
+
+/**
+    Temporal watershed for a single label, that reuses the instances of the previous frame.
+ 
+    The homography maps the pixels of the previous frame to the current frame (as the one given to CentroidTracker does),
+    and is used to warp the previous instances. Only the tiles where the warped label pixels differ from the current ones
+    are recomputed; everywhere else the warped instances are kept as they are. In the recomputed tiles, new markers take
+    the ID of the warped instance they overlap the most, so that instance IDs (and colors) stay stable across frames.
+ 
+    When the homography moves no pixel (a still camera), nothing is warped, and only the recomputed region is colored
+    again and outlined again: instances that it does not reach keep their outlines from the previous frame.
+    When the camera moves, every instance moves with it, so the instances are warped, colored and outlined again,
+    within the region that the previous label pixels land in.
+ 
+    Unlike the other watershed functions, the contours are the outlines of the instances, since the markers of unchanged
+    tiles are never recomputed. Their instance IDs are left in the state's contourInstanceIds.
+    The image of the result belongs to the state, and is only valid until the next call with the same state.
+    The first frame, a change of label, or a change of frame size are processed from scratch.
+ */
+void watershedTemporalMaskAndDepth (cv::Mat mask, cv::Mat depth, int labelValue, const cv::Matx33d &homography,
+                                    WatershedWorkspace &workspace, WatershedTemporalState &state, WatershedLabelResult &result);
+
 #endif /* Watershed_hpp */
@@ -0,0 +1,164 @@
+//
+//  WatershedBatch.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "WatershedBatch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+/**
+    The queue of job indices of a single worker.
+    The owner takes jobs from the front, and the other workers steal from the back, so they rarely contend.
+ */
+struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<size_t> jobs;
+    
+    bool popFront (size_t &job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) {
+            return false;
+        }
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+    
+    bool stealBack (size_t &job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) {
+            return false;
+        }
+        job = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+};
+
+/**
+    Returns the value at the given percentile (in [0, 100]) of the samples, using the nearest-rank method.
+    The samples are reordered.
+ */
+double percentile (std::vector<double> &samples, double percent) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * samples.size()));
+    size_t index = std::min(std::max(rank, size_t(1)), samples.size()) - 1;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+}
+
+std::vector<WatershedLabelResult>
+watershedBatch (const std::vector<WatershedJob> &jobs, unsigned workerCount, WatershedBatchStats *stats) {
+    using Clock = std::chrono::steady_clock;
+    
+    std::vector<WatershedLabelResult> results(jobs.size());
+    std::vector<double> latencies(jobs.size(), 0);
+    if (jobs.empty()) {
+        if (stats != nullptr) {
+            *stats = WatershedBatchStats();
+        }
+        return results;
+    }
+    
+    if (workerCount == 0) {
+        workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    workerCount = static_cast<unsigned>(std::min<size_t>(workerCount, jobs.size()));
+    
+    // Give every worker a contiguous range of the jobs, so that consecutive frames share the same workspace sizes
+    std::vector<WorkerQueue> queues(workerCount);
+    for (unsigned w = 0; w < workerCount; w++) {
+        size_t begin = jobs.size() * w / workerCount;
+        size_t end = jobs.size() * (w + 1) / workerCount;
+        for (size_t i = begin; i < end; i++) {
+            queues[w].jobs.push_back(i);
+        }
+    }
+    
+    // The first exception thrown by a job stops the batch, and is rethrown on the calling thread
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::atomic<bool> failed(false);
+    
+    auto runWorker = [&](unsigned worker) {
+        WatershedWorkspace workspace;
+        size_t job;
+        while (!failed.load(std::memory_order_relaxed)) {
+            bool found = queues[worker].popFront(job);
+            for (unsigned k = 1; !found && k < workerCount; k++) {
+                found = queues[(worker + k) % workerCount].stealBack(job);
+            }
+            // Jobs are never added back, so once every queue is empty the worker is done
+            if (!found) {
+                break;
+            }
+            
+            Clock::time_point start = Clock::now();
+            const WatershedJob &input = jobs[job];
+            WatershedLabelResult &result = results[job];
+            try {
+                watershed1DMaskAndDepthAndReturnContoursColors(input.mask, input.depth, input.labelValue, workspace, result);
+                // The image must outlive the worker's workspace
+                result.image = result.image.clone();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed = true;
+                return;
+            }
+            latencies[job] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+    };
+    
+    Clock::time_point batchStart = Clock::now();
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (unsigned w = 1; w < workerCount; w++) {
+        // If the system cannot start another thread, the workers that did start steal the jobs of the others,
+        // and the threads that are running are still joined below
+        try {
+            threads.emplace_back(runWorker, w);
+        } catch (const std::system_error &) {
+            break;
+        }
+    }
+    // The calling thread is the first worker
+    runWorker(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    double wallSeconds = std::chrono::duration<double>(Clock::now() - batchStart).count();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    
+    if (stats != nullptr) {
+        stats->jobCount = jobs.size();
+        stats->workerCount = static_cast<unsigned>(threads.size()) + 1;
+        stats->wallSeconds = wallSeconds;
+        stats->jobsPerSecond = wallSeconds > 0 ? jobs.size() / wallSeconds : 0;
+        stats->latencyP50 = percentile(latencies, 50);
+        stats->latencyP90 = percentile(latencies, 90);
+        stats->latencyP99 = percentile(latencies, 99);
+        stats->latencyMax = *std::max_element(latencies.begin(), latencies.end());
+    }
+    return results;
+}
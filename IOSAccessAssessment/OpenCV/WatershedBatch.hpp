@@ -0,0 +1,54 @@
+//
+//  WatershedBatch.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef WatershedBatch_hpp
+#define WatershedBatch_hpp
+#include <opencv2/opencv.hpp>
+#include "Watershed.hpp"
+
+/**
+    A single frame of a batch: the watershed of one label on one mask.
+ */
+struct WatershedJob {
+    cv::Mat mask;
+    cv::Mat depth;
+    int labelValue;
+};
+
+/**
+    Timings of a batch run. The latencies are the processing times of the individual jobs, in milliseconds.
+ */
+struct WatershedBatchStats {
+    size_t jobCount = 0;
+    unsigned workerCount = 0;
+    double wallSeconds = 0;
+    double jobsPerSecond = 0;
+    double latencyP50 = 0;
+    double latencyP90 = 0;
+    double latencyP99 = 0;
+    double latencyMax = 0;
+};
+
+/**
+    Runs the watershed for every job on a bounded pool of worker threads, and returns the results in the order of the jobs.
+ 
+    The jobs are split evenly between the workers up front. A worker that runs out of jobs steals from the end of
+    the queue of another worker, so frames that take longer than the others do not leave the rest of the pool idle.
+    Each worker has its own workspace, so the scratch buffers are only allocated once per worker and frame size.
+ 
+    A worker count of 0 uses one worker per hardware thread. The pool never has more workers than there are jobs,
+    and has fewer if the system cannot start all the threads; the calling thread is always one of the workers.
+    The distance transform inside each job also runs on the OpenCV thread pool; for large batches, calling
+    cv::setNumThreads(1) beforehand avoids oversubscribing the cores.
+ 
+    If stats is not null, it is filled with the throughput and the latency percentiles of the run.
+    If a job throws, the remaining jobs are abandoned and the first exception is rethrown on the calling thread.
+ */
+std::vector<WatershedLabelResult>
+watershedBatch (const std::vector<WatershedJob> &jobs, unsigned workerCount = 0, WatershedBatchStats *stats = nullptr);
+
+#endif /* WatershedBatch_hpp */
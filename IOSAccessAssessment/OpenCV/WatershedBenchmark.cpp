@@ -0,0 +1,174 @@
+//
+//  WatershedBenchmark.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "WatershedBenchmark.hpp"
+#include <chrono>
+#include <cstdio>
+
+SyntheticFrame makeSyntheticFrame (const SyntheticFrameOptions &options) {
+    const float backgroundDepth = 8.0f;
+    cv::RNG rng(options.seed);
+    
+    SyntheticFrame frame;
+    cv::Mat gray = cv::Mat::zeros(options.size, CV_8UC1);
+    frame.depth = cv::Mat(options.size, CV_32FC1, cv::Scalar(backgroundDepth));
+    
+    // Label values are spread over the grayscale range, so that they stay apart by more than the label tolerance
+    int classCount = std::max(1, std::min(options.classCount, 30));
+    for (int k = 0; k < classCount; k++) {
+        frame.labelValues.push_back(255 * (k + 1) / (classCount + 1));
+    }
+    
+    int minAxis = 4;
+    int maxAxis = std::max(minAxis + 1, std::min(options.size.width, options.size.height) / 8);
+    int blobCount = std::max(1, cvRound(options.blobDensity * options.size.area() / 10000.0));
+    for (int b = 0; b < blobCount; b++) {
+        cv::Point center(rng.uniform(0, options.size.width), rng.uniform(0, options.size.height));
+        cv::Size axes(rng.uniform(minAxis, maxAxis), rng.uniform(minAxis, maxAxis));
+        double angle = rng.uniform(0.0, 180.0);
+        int labelValue = frame.labelValues[rng.uniform(0, classCount)];
+        float depth = rng.uniform(0.5f, backgroundDepth - 0.5f);
+        cv::ellipse(gray, center, axes, angle, 0, 360, cv::Scalar(labelValue), -1);
+        cv::ellipse(frame.depth, center, axes, angle, 0, 360, cv::Scalar(depth), -1);
+    }
+    cv::cvtColor(gray, frame.mask, cv::COLOR_GRAY2BGRA);
+    return frame;
+}
+
+std::vector<WatershedBenchmarkCase> defaultWatershedBenchmarkCases () {
+    const cv::Size sizes[] = { cv::Size(256, 256), cv::Size(640, 480), cv::Size(1280, 960), cv::Size(1920, 1440) };
+    const int classCounts[] = { 2, 8 };
+    const float densities[] = { 0.5f, 2.0f };
+    
+    std::vector<WatershedBenchmarkCase> cases;
+    for (const cv::Size &size : sizes) {
+        for (int classCount : classCounts) {
+            for (float density : densities) {
+                for (bool useDepth : { false, true }) {
+                    WatershedBenchmarkCase benchmarkCase;
+                    benchmarkCase.frame.size = size;
+                    benchmarkCase.frame.classCount = classCount;
+                    benchmarkCase.frame.blobDensity = density;
+                    benchmarkCase.iterations = size.area() > 1000000 ? 5 : 20;
+                    benchmarkCase.useDepth = useDepth;
+                    benchmarkCase.depthBudgetMs = useDepth ? 2.0 : 0;
+                    cases.push_back(benchmarkCase);
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+/**
+    Average milliseconds of a function over the given number of iterations.
+ */
+template <typename Function>
+static double averageMilliseconds (int iterations, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        function();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds * 1000.0 / std::max(iterations, 1);
+}
+
+/**
+    Runs a single case, fills its measurements, and returns it as a JSON object.
+ */
+static std::string runBenchmarkCase (const WatershedBenchmarkCase &benchmarkCase, HeapAllocationCounter heapAllocationCounter,
+                                     WatershedBenchmarkResult &result) {
+    SyntheticFrame frame = makeSyntheticFrame(benchmarkCase.frame);
+    int iterations = std::max(benchmarkCase.iterations, 1);
+    result = WatershedBenchmarkResult();
+    result.benchmarkCase = benchmarkCase;
+    
+    WatershedProfile profile;
+    WatershedWorkspace workspace;
+    workspace.profile = &profile;
+    workspace.useDepth = benchmarkCase.useDepth;
+    std::vector<WatershedLabelResult> results;
+    
+    // The warm-up call allocates the workspace, and is not part of the timings
+    uint64_t heapAllocations = heapAllocationCounter != nullptr ? heapAllocationCounter() : 0;
+    watershedMultiLabelMaskAndDepth(frame.mask, frame.depth, frame.labelValues, workspace, results);
+    if (heapAllocationCounter != nullptr) {
+        result.warmUpHeapAllocations = static_cast<double>(heapAllocationCounter() - heapAllocations);
+    }
+    result.warmUpWorkspaceReallocations = profile.workspaceReallocations;
+    profile.reset();
+    
+    heapAllocations = heapAllocationCounter != nullptr ? heapAllocationCounter() : 0;
+    result.watershedMs = averageMilliseconds(iterations, [&]() {
+        watershedMultiLabelMaskAndDepth(frame.mask, frame.depth, frame.labelValues, workspace, results);
+    });
+    if (heapAllocationCounter != nullptr) {
+        result.heapAllocationsPerFrame = static_cast<double>(heapAllocationCounter() - heapAllocations) / iterations;
+    }
+    result.timedWorkspaceReallocations = profile.workspaceReallocations;
+    
+    cv::Mat erased;
+    double eraseBordersMs = averageMilliseconds(iterations, [&]() {
+        eraseBorders(frame.mask, 2, erased);
+    });
+    cv::Mat transparent;
+    double transparentMs = averageMilliseconds(iterations, [&]() {
+        transparent = makeBackgroundTransparent(frame.mask, cv::Scalar(0, 0, 0, 255));
+    });
+    
+    for (const WatershedLabelResult &labelResult : results) {
+        result.instances += labelResult.contours.count();
+    }
+    double megapixels = frame.mask.total() / 1e6;
+    result.depthMsPerFrame = profile.stageSeconds[static_cast<int>(WatershedStage::DepthEdges)] * 1000.0 / iterations;
+    
+    char buffer[768];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"width\":%d,\"height\":%d,\"classes\":%zu,\"blob_density\":%.3f,\"use_depth\":%s,"
+                  "\"iterations\":%d,\"instances\":%zu,\"watershed_ms\":%.6f,\"frames_per_second\":%.3f,"
+                  "\"megapixels_per_second\":%.3f,\"erase_borders_ms\":%.6f,\"make_background_transparent_ms\":%.6f,"
+                  "\"warmup_workspace_reallocations\":%llu,\"timed_workspace_reallocations\":%llu,",
+                  frame.mask.cols, frame.mask.rows, frame.labelValues.size(), benchmarkCase.frame.blobDensity,
+                  benchmarkCase.useDepth ? "true" : "false", iterations, result.instances, result.watershedMs,
+                  1000.0 / result.watershedMs, megapixels * 1000.0 / result.watershedMs, eraseBordersMs, transparentMs,
+                  static_cast<unsigned long long>(result.warmUpWorkspaceReallocations),
+                  static_cast<unsigned long long>(result.timedWorkspaceReallocations));
+    std::string json = buffer;
+    if (heapAllocationCounter != nullptr) {
+        std::snprintf(buffer, sizeof(buffer), "\"warmup_heap_allocations\":%.0f,\"heap_allocations_per_frame\":%.3f,",
+                      result.warmUpHeapAllocations, result.heapAllocationsPerFrame);
+        json += buffer;
+    }
+    if (benchmarkCase.depthBudgetMs > 0) {
+        std::snprintf(buffer, sizeof(buffer), "\"depth_ms_per_frame\":%.6f,\"depth_budget_ms\":%.3f,\"depth_within_budget\":%s,",
+                      result.depthMsPerFrame, benchmarkCase.depthBudgetMs, result.withinDepthBudget() ? "true" : "false");
+        json += buffer;
+    }
+    json += "\"profile\":" + profile.toJSON() + "}";
+    return json;
+}
+
+std::string runWatershedBenchmark (const std::vector<WatershedBenchmarkCase> &cases,
+                                   std::vector<WatershedBenchmarkResult> *results,
+                                   HeapAllocationCounter heapAllocationCounter) {
+    if (results != nullptr) {
+        results->assign(cases.size(), WatershedBenchmarkResult());
+    }
+    std::string json = "{\"opencv_version\":\"" CV_VERSION "\",\"threads\":" + std::to_string(cv::getNumThreads()) + ",\"cases\":[";
+    for (size_t i = 0; i < cases.size(); i++) {
+        if (i > 0) {
+            json += ",";
+        }
+        WatershedBenchmarkResult result;
+        json += runBenchmarkCase(cases[i], heapAllocationCounter, result);
+        if (results != nullptr) {
+            (*results)[i] = result;
+        }
+    }
+    json += "]}";
+    return json;
+}
@@ -0,0 +1,95 @@
+//
+//  WatershedBenchmark.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef WatershedBenchmark_hpp
+#define WatershedBenchmark_hpp
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "Watershed.hpp"
+
+/**
+    Parameters of a synthetic segmentation frame.
+ */
+struct SyntheticFrameOptions {
+    cv::Size size = cv::Size(640, 480);
+    int classCount = 4;
+    /// Number of blobs per 100x100 pixels
+    float blobDensity = 1.0f;
+    uint32_t seed = 1;
+};
+
+/**
+    A synthetic segmentation mask (BGRA, with the label value in every color channel, like the masks of the segmentation models)
+    and a matching depth map (CV_32FC1, in meters), with every blob at its own depth.
+ */
+struct SyntheticFrame {
+    cv::Mat mask;
+    cv::Mat depth;
+    std::vector<int> labelValues;
+};
+
+/**
+    Draws random elliptical blobs of the given classes. The same options always give the same frame.
+ */
+SyntheticFrame makeSyntheticFrame (const SyntheticFrameOptions &options);
+
+/**
+    A single benchmark configuration.
+ */
+struct WatershedBenchmarkCase {
+    SyntheticFrameOptions frame;
+    int iterations = 20;
+    bool useDepth = false;
+    /// Budget of the depth edges stage, in milliseconds per frame, reported as met or not. 0 disables the check.
+    double depthBudgetMs = 0;
+};
+
+/**
+    The configurations that cover the resolutions (256x256 to 1920x1440), class counts and blob densities we care about.
+ */
+std::vector<WatershedBenchmarkCase> defaultWatershedBenchmarkCases ();
+
+/**
+    The measurements of a single case.
+ */
+struct WatershedBenchmarkResult {
+    WatershedBenchmarkCase benchmarkCase;
+    size_t instances = 0;
+    double watershedMs = 0;
+    double depthMsPerFrame = 0;
+    /// Workspace (re)allocations of the warm-up call, and of all the timed calls (which should be 0)
+    uint64_t warmUpWorkspaceReallocations = 0;
+    uint64_t timedWorkspaceReallocations = 0;
+    /// Heap allocations of the warm-up call, and per timed call, or -1 without an allocation counter
+    double warmUpHeapAllocations = -1;
+    double heapAllocationsPerFrame = -1;
+    
+    bool withinDepthBudget () const {
+        return benchmarkCase.depthBudgetMs <= 0 || depthMsPerFrame <= benchmarkCase.depthBudgetMs;
+    }
+};
+
+/**
+    Counter of the heap allocations of the whole process so far, such as an operator new hook.
+ */
+typedef uint64_t (*HeapAllocationCounter) ();
+
+/**
+    Runs the watershed (all the classes of each frame in one multi-label call), eraseBorders and makeBackgroundTransparent
+    on the synthetic frames of every case, and returns the results as a single JSON object.
+ 
+    Every case reports its per-stage timings, the workspace reallocations of the warm-up call and of the timed calls
+    (which should be 0), and the throughput in frames and megapixels per second. When a heap allocation counter is given,
+    every case also reports the heap allocations of the warm-up call and of every timed call; these include the scratch
+    memory that OpenCV allocates inside its own functions.
+    If results is not null, it is filled with the measurements of every case, in the order of the cases.
+ */
+std::string runWatershedBenchmark (const std::vector<WatershedBenchmarkCase> &cases,
+                                   std::vector<WatershedBenchmarkResult> *results = nullptr,
+                                   HeapAllocationCounter heapAllocationCounter = nullptr);
+
+#endif /* WatershedBenchmark_hpp */
@@ -0,0 +1,80 @@
+//
+//  WatershedProfile.cpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "WatershedProfile.hpp"
+#include <cstdio>
+
+void WatershedProfile::reset () {
+    stageSeconds.fill(0);
+    stageCalls.fill(0);
+    frames = 0;
+    workspaceReallocations = 0;
+}
+
+double WatershedProfile::totalSeconds () const {
+    double total = 0;
+    for (double seconds : stageSeconds) {
+        total += seconds;
+    }
+    return total;
+}
+
+const char *WatershedProfile::stageName (WatershedStage stage) {
+    switch (stage) {
+        case WatershedStage::GrayMask: return "gray_mask";
+        case WatershedStage::DepthEdges: return "depth_edges";
+        case WatershedStage::ValueBounds: return "value_bounds";
+        case WatershedStage::Landscape: return "landscape";
+        case WatershedStage::DistancePeaks: return "distance_peaks";
+        case WatershedStage::Markers: return "markers";
+        case WatershedStage::Flood: return "flood";
+        case WatershedStage::Colorize: return "colorize";
+        case WatershedStage::Contours: return "contours";
+        case WatershedStage::Warp: return "warp";
+        case WatershedStage::Count: break;
+    }
+    return "unknown";
+}
+
+std::string WatershedProfile::toJSON () const {
+    double frameCount = frames > 0 ? static_cast<double>(frames) : 1.0;
+    std::string json = "{\"frames\":" + std::to_string(frames)
+                     + ",\"workspace_reallocations\":" + std::to_string(workspaceReallocations);
+    char number[64];
+    std::snprintf(number, sizeof(number), "%.6f", totalSeconds() * 1000.0 / frameCount);
+    json += ",\"ms_per_frame\":";
+    json += number;
+    json += ",\"stages\":{";
+    for (int i = 0; i < stageCount; i++) {
+        if (i > 0) {
+            json += ",";
+        }
+        std::snprintf(number, sizeof(number), "%.6f", stageSeconds[i] * 1000.0);
+        json += "\"";
+        json += stageName(static_cast<WatershedStage>(i));
+        json += "\":{\"calls\":" + std::to_string(stageCalls[i]) + ",\"total_ms\":" + number;
+        std::snprintf(number, sizeof(number), "%.6f", stageSeconds[i] * 1000.0 / frameCount);
+        json += ",\"ms_per_frame\":";
+        json += number;
+        json += "}";
+    }
+    json += "}}";
+    return json;
+}
+
+std::string WatershedProfile::toCSV () const {
+    double frameCount = frames > 0 ? static_cast<double>(frames) : 1.0;
+    std::string csv = "stage,calls,total_ms,ms_per_frame\n";
+    char line[128];
+    for (int i = 0; i < stageCount; i++) {
+        std::snprintf(line, sizeof(line), "%s,%llu,%.6f,%.6f\n",
+                      stageName(static_cast<WatershedStage>(i)), static_cast<unsigned long long>(stageCalls[i]),
+                      stageSeconds[i] * 1000.0, stageSeconds[i] * 1000.0 / frameCount);
+        csv += line;
+    }
+    return csv;
+}
@@ -0,0 +1,102 @@
+//
+//  WatershedProfile.hpp
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef WatershedProfile_hpp
+#define WatershedProfile_hpp
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+    The stages of the watershed that are timed separately.
+ */
+enum class WatershedStage : int {
+    GrayMask = 0,       // grayscale conversion and border erasing
+    DepthEdges,         // depth resampling and discontinuities
+    ValueBounds,        // per-value bounding boxes
+    Landscape,          // label isolation, Laplacian sharpening and Otsu threshold
+    DistancePeaks,      // distance transform and marker peaks
+    Markers,            // marker contours and marker image
+    Flood,              // cv::watershed
+    Colorize,           // instance colors
+    Contours,           // contour flattening (and outlines in the temporal mode)
+    Warp,               // warping of the previous frame and dirty tiles, in the temporal mode
+    Count
+};
+
+/**
+    Accumulated per-stage timings of the watershed.
+ 
+    A profile is attached to a workspace, and every call with that workspace adds to it.
+    Profiling costs one clock read per stage, and nothing at all when no profile is attached.
+ */
+struct WatershedProfile {
+    static constexpr int stageCount = static_cast<int>(WatershedStage::Count);
+    
+    std::array<double, stageCount> stageSeconds {};
+    std::array<uint64_t, stageCount> stageCalls {};
+    /// Number of frames processed
+    uint64_t frames = 0;
+    /// Number of times the workspace had to (re)allocate its full frame buffers. This is not a count of heap allocations:
+    /// OpenCV also allocates scratch memory of its own inside some of the stages.
+    uint64_t workspaceReallocations = 0;
+    
+    void reset ();
+    
+    void add (WatershedStage stage, double seconds) {
+        stageSeconds[static_cast<int>(stage)] += seconds;
+        stageCalls[static_cast<int>(stage)]++;
+    }
+    
+    double totalSeconds () const;
+    
+    static const char *stageName (WatershedStage stage);
+    
+    /**
+        The profile as a JSON object, with the total and per-frame milliseconds of every stage.
+     */
+    std::string toJSON () const;
+    
+    /**
+        The profile as CSV rows of "stage,calls,total_ms,ms_per_frame", with a header row.
+     */
+    std::string toCSV () const;
+};
+
+/**
+    Adds the time from its construction to its destruction (or to the call to stop) to a stage of the profile, if there is one.
+ */
+class WatershedStageTimer {
+public:
+    WatershedStageTimer (WatershedProfile *profile, WatershedStage stage) : profile(profile), stage(stage) {
+        if (profile != nullptr) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    
+    ~WatershedStageTimer () {
+        stop();
+    }
+    
+    void stop () {
+        if (profile != nullptr) {
+            profile->add(stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            profile = nullptr;
+        }
+    }
+    
+    WatershedStageTimer (const WatershedStageTimer &) = delete;
+    WatershedStageTimer &operator= (const WatershedStageTimer &) = delete;
+    
+private:
+    WatershedProfile *profile;
+    WatershedStage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif /* WatershedProfile_hpp */
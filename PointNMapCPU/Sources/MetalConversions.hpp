@@ -0,0 +1,23 @@
+//
+//  MetalConversions.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef MetalConversions_hpp
+#define MetalConversions_hpp
+#include <cstdint>
+
+/**
+    uint(value) of the kernels. Apple GPUs saturate conversions that are out of range, where C++ leaves them undefined,
+    so negative values and NaN become 0, and the checks of the kernels for indices below 0 never fire.
+ */
+static inline uint32_t toUintSaturating (float value) {
+    if (!(value > 0.0f)) {
+        return 0;
+    }
+    return value >= 4294967296.0f ? UINT32_MAX : uint32_t(value);
+}
+
+#endif /* MetalConversions_hpp */
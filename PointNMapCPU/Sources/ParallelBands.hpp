@@ -0,0 +1,56 @@
+//
+//  ParallelBands.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef ParallelBands_hpp
+#define ParallelBands_hpp
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/// Number of threads to use for a requested count, where 0 means one per core
+static inline unsigned resolveThreadCount (unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    return std::max(threadCount, 1u);
+}
+
+/**
+    Runs body(band, worker) for every band in [0, bandCount), on up to threadCount threads, one of which is the caller.
+    Bands are claimed one at a time from a shared counter, so that bands with more work than others balance out.
+    The worker is the index of the thread in [0, threadCount), for bodies that keep scratch space per thread.
+ */
+template <typename Body>
+void parallelForBands (unsigned threadCount, size_t bandCount, const Body &body) {
+    size_t workerCount = std::min<size_t>(resolveThreadCount(threadCount), bandCount);
+    if (workerCount <= 1) {
+        for (size_t band = 0; band < bandCount; band++) {
+            body(band, 0u);
+        }
+        return;
+    }
+    std::atomic<size_t> nextBand { 0 };
+    auto work = [&nextBand, bandCount, &body] (unsigned worker) {
+        size_t band;
+        while ((band = nextBand.fetch_add(1, std::memory_order_relaxed)) < bandCount) {
+            body(band, worker);
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (unsigned worker = 1; worker < workerCount; worker++) {
+        threads.emplace_back(work, worker);
+    }
+    work(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+#endif /* ParallelBands_hpp */
@@ -0,0 +1,10 @@
+//
+//  ShaderTypesLayout.c
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+// ShaderTypes.h checks its layouts wherever it is included. The engines include it from C++,
+// and this file includes it from C, so that the host types of both languages are checked against the Metal layouts.
+#include "ShaderTypes.h"
@@ -0,0 +1,259 @@
+//
+//  SurfaceNormalsCPU.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "SurfaceNormalsCPU.hpp"
+#include "WorldPointsGridCPU.hpp"
+#include "MetalConversions.hpp"
+#include "ParallelBands.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/**
+    Rows of a grid from firstRow on, where cells points at the first cell of firstRow.
+    Either the full grid, or the tile of a thread.
+ */
+struct GridRows {
+    const WorldPointsGridCell *cells;
+    uint32_t firstRow;
+};
+
+uint32_t surfaceNormalsHaloRows (const SurfaceNormalsForPointsGridParams &params, uint32_t height) {
+    if (params.maxStep < params.minStep) {
+        return 0;
+    }
+    // Steps that are not finite reach row 0 through the saturating conversion, so they take the full grid
+    if (!std::isfinite(params.stepL.y) || !std::isfinite(params.stepT.y)) {
+        return height;
+    }
+    double steps = double(params.maxStep) - double(params.minStep) + 1.0;
+    double reach = steps * std::max(std::fabs(double(params.stepL.y)), std::fabs(double(params.stepT.y)));
+    // One more row for rounding the position to a row, and for the error of adding up the steps in float
+    double halo = std::ceil(reach) + 1.0;
+    return halo <= double(height) ? uint32_t(halo) : height;
+}
+
+/// walkDirection of SurfaceNormals.metal. Returns false where the kernel returns an invalid neighbor.
+static inline bool walkDirection (uint32_t startX, uint32_t startY, MTL_FLOAT2 step, float sign,
+                                  uint32_t minStep, uint32_t maxStep, uint32_t width, uint32_t height,
+                                  const GridRows &grid, float neighbor[3]) {
+    float posX = float(startX);
+    float posY = float(startY);
+    float sumX = 0.0f;
+    float sumY = 0.0f;
+    float sumZ = 0.0f;
+    float weightSum = 0.0f;
+    for (uint32_t i = minStep; i <= maxStep; i++) {
+        posX += step.x * sign;
+        posY += step.y * sign;
+        uint32_t xi = toUintSaturating(std::round(posX));
+        uint32_t yi = toUintSaturating(std::round(posY));
+        if (xi >= width || yi >= height) {
+            break;
+        }
+        const WorldPointsGridCell &cell = grid.cells[size_t(yi - grid.firstRow) * width + xi];
+        if (cell.isValid == 0) {
+            continue;
+        }
+        float weight = 1.0f / float(i);
+        sumX += cell.worldPoint.p.x * weight;
+        sumY += cell.worldPoint.p.y * weight;
+        sumZ += cell.worldPoint.p.z * weight;
+        weightSum += weight;
+    }
+    if (!(weightSum > 0.0f)) {
+        return false;
+    }
+    neighbor[0] = sumX / weightSum;
+    neighbor[1] = sumY / weightSum;
+    neighbor[2] = sumZ / weightSum;
+    return true;
+}
+
+/// The body of computeSurfaceNormals for a valid cell. Returns false where the kernel returns without writing.
+static bool surfaceNormalOfCell (uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                 const SurfaceNormalsForPointsGridParams &params, const GridRows &grid, MTL_FLOAT3 &normal) {
+    float lPlus[3];
+    float lMinus[3];
+    float tPlus[3];
+    float tMinus[3];
+    if (!walkDirection(x, y, params.stepL, 1.0f, params.minStep, params.maxStep, width, height, grid, lPlus) ||
+        !walkDirection(x, y, params.stepL, -1.0f, params.minStep, params.maxStep, width, height, grid, lMinus) ||
+        !walkDirection(x, y, params.stepT, 1.0f, params.minStep, params.maxStep, width, height, grid, tPlus) ||
+        !walkDirection(x, y, params.stepT, -1.0f, params.minStep, params.maxStep, width, height, grid, tMinus)) {
+        return false;
+    }
+    float lX = lPlus[0] - lMinus[0];
+    float lY = lPlus[1] - lMinus[1];
+    float lZ = lPlus[2] - lMinus[2];
+    float tX = tPlus[0] - tMinus[0];
+    float tY = tPlus[1] - tMinus[1];
+    float tZ = tPlus[2] - tMinus[2];
+    float longitudinalLength2 = (lX * lX + lY * lY) + lZ * lZ;
+    float lateralLength2 = (tX * tX + tY * tY) + tZ * tZ;
+    if (longitudinalLength2 < params.eps || lateralLength2 < params.eps) {
+        return false;
+    }
+    float nX = lY * tZ - lZ * tY;
+    float nY = lZ * tX - lX * tZ;
+    float nZ = lX * tY - lY * tX;
+    float normalLength2 = (nX * nX + nY * nY) + nZ * nZ;
+    float sinSq = normalLength2 / (longitudinalLength2 * lateralLength2);
+    if (sinSq < params.eps) {
+        return false;
+    }
+    // alignNormalWithReference
+    const MTL_FLOAT3 &reference = params.normalVector;
+    if ((nX * reference.x + nY * reference.y) + nZ * reference.z < 0.0f) {
+        nX = -nX;
+        nY = -nY;
+        nZ = -nZ;
+    }
+    float inverseLength = 1.0f / std::sqrt((nX * nX + nY * nY) + nZ * nZ);
+    normal.x = nX * inverseLength;
+    normal.y = nY * inverseLength;
+    normal.z = nZ * inverseLength;
+    return true;
+}
+
+/**
+    Computes the normals of rows [firstRow, lastRow), writing every cell of the rows, and returns the number of normals.
+    The grid must hold the rows that the walks of the rows reach.
+ */
+static size_t surfaceNormalsOfRows (const GridRows &grid, uint32_t firstRow, uint32_t lastRow, uint32_t width, uint32_t height,
+                                    const SurfaceNormalsForPointsGridParams &params, SurfaceNormalsForPointsGridCell *normals) {
+    memset(normals + size_t(firstRow) * width, 0, size_t(lastRow - firstRow) * width * sizeof(SurfaceNormalsForPointsGridCell));
+    size_t count = 0;
+    for (uint32_t y = firstRow; y < lastRow; y++) {
+        const WorldPointsGridCell *cells = grid.cells + size_t(y - grid.firstRow) * width;
+        SurfaceNormalsForPointsGridCell *rowNormals = normals + size_t(y) * width;
+        for (uint32_t x = 0; x < width; x++) {
+            if (cells[x].isValid == 0) {
+                continue;
+            }
+            MTL_FLOAT3 normal = {};
+            if (!surfaceNormalOfCell(x, y, width, height, params, grid, normal)) {
+                continue;
+            }
+            rowNormals[x].worldPoint = cells[x].worldPoint;
+            rowNormals[x].surfaceNormal = normal;
+            rowNormals[x].isValid = true;
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t computeSurfaceNormalsCPU (const WorldPointsGridCell *grid, uint32_t width, uint32_t height,
+                                 const SurfaceNormalsForPointsGridParams &params, SurfaceNormalsForPointsGridCell *normals,
+                                 const SurfaceNormalsCPUConfig &config) {
+    const uint32_t tileRows = std::max(config.tileRows, 1u);
+    const size_t tileCount = (size_t(height) + tileRows - 1) / tileRows;
+    const GridRows rows = { grid, 0 };
+    std::atomic<size_t> count { 0 };
+    parallelForBands(config.threads, tileCount, [&] (size_t tile, unsigned) {
+        uint32_t firstRow = uint32_t(tile) * tileRows;
+        uint32_t lastRow = std::min(firstRow + tileRows, height);
+        count.fetch_add(surfaceNormalsOfRows(rows, firstRow, lastRow, width, height, params, normals),
+                        std::memory_order_relaxed);
+    });
+    return count.load();
+}
+
+/**
+    Rows that projecting back can move a point by before the fused path gives up on tiles. A point lands on the row it comes from,
+    give or take the rounding of the two projections, when the grid has the camera of the points.
+ */
+static const uint32_t fusedReprojectionRows = 1;
+
+/**
+    Space of a thread of the fused pipeline: the points of a row, and the grid of a tile with its halo.
+ */
+struct SurfaceNormalsTile {
+    WorldPointsRow row;
+    std::vector<WorldPointsGridCell> cells;
+};
+
+/**
+    The staged path, for the frames whose points the fused path cannot place tile by tile:
+    the list of points in raster order, the grid they project back to, then its normals.
+ */
+static size_t surfaceNormalsStaged (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &worldPointsParams,
+                                    const WorldPointsGridParams &gridParams, const SurfaceNormalsForPointsGridParams &params,
+                                    SurfaceNormalsForPointsGridCell *normals, const SurfaceNormalsCPUConfig &config) {
+    WorldPointsCPUConfig pointsConfig;
+    pointsConfig.threads = config.threads;
+    pointsConfig.order = WorldPointsOrder::Raster;
+    std::vector<WorldPoint> points(size_t(worldPointsParams.imageSize.x) * worldPointsParams.imageSize.y);
+    size_t pointCount = computeWorldPointsCPU(images, targetValue, worldPointsParams, points.data(), nullptr, pointsConfig);
+    std::vector<WorldPointsGridCell> grid(size_t(gridParams.imageSize.x) * gridParams.imageSize.y);
+    restructureWorldPointsToGridCPU(points.data(), pointCount, gridParams, grid.data(), config.threads);
+    return computeSurfaceNormalsCPU(grid.data(), gridParams.imageSize.x, gridParams.imageSize.y, params, normals, config);
+}
+
+size_t computeSurfaceNormalsFusedCPU (const WorldPointsImages &images, uint8_t targetValue,
+                                      const WorldPointsParams &worldPointsParams, const WorldPointsGridParams &gridParams,
+                                      const SurfaceNormalsForPointsGridParams &params, SurfaceNormalsForPointsGridCell *normals,
+                                      const SurfaceNormalsCPUConfig &config) {
+    const bool reprojected = config.placement == WorldPointsGridPlacement::Reprojected;
+    if (reprojected && (gridParams.imageSize.x != worldPointsParams.imageSize.x ||
+                        gridParams.imageSize.y != worldPointsParams.imageSize.y)) {
+        return surfaceNormalsStaged(images, targetValue, worldPointsParams, gridParams, params, normals, config);
+    }
+    const uint32_t width = worldPointsParams.imageSize.x;
+    const uint32_t height = worldPointsParams.imageSize.y;
+    const uint32_t tileRows = std::max(config.tileRows, 1u);
+    const size_t tileCount = (size_t(height) + tileRows - 1) / tileRows;
+    const uint32_t halo = surfaceNormalsHaloRows(params, height);
+    // Rows above and below the grid of a tile whose points can project back into it
+    const uint32_t margin = reprojected ? fusedReprojectionRows : 0;
+    const size_t tileCells = size_t(std::min<uint64_t>(uint64_t(tileRows) + 2 * uint64_t(halo), height)) * width;
+    std::vector<SurfaceNormalsTile> tiles(resolveThreadCount(config.threads));
+    std::atomic<size_t> count { 0 };
+    std::atomic<bool> pointsMovedFar { false };
+    parallelForBands(config.threads, tileCount, [&] (size_t tileIndex, unsigned worker) {
+        SurfaceNormalsTile &tile = tiles[worker];
+        if (tile.cells.empty()) {
+            tile.row.resize(width);
+            tile.cells.resize(tileCells);
+        }
+        uint32_t firstRow = uint32_t(tileIndex) * tileRows;
+        uint32_t lastRow = std::min(firstRow + tileRows, height);
+        // The rows of the tile and of its halo, which the neighbouring tiles compute again for themselves
+        uint32_t gridFirstRow = firstRow - std::min(firstRow, halo);
+        uint32_t gridLastRow = uint32_t(std::min<uint64_t>(uint64_t(lastRow) + halo, height));
+        uint32_t sourceFirstRow = gridFirstRow - std::min(gridFirstRow, margin);
+        uint32_t sourceLastRow = uint32_t(std::min<uint64_t>(uint64_t(gridLastRow) + margin, height));
+        WorldPointsGridCell *cells = tile.cells.data();
+        memset(cells, 0, size_t(gridLastRow - gridFirstRow) * width * sizeof(WorldPointsGridCell));
+        for (uint32_t y = sourceFirstRow; y < sourceLastRow; y++) {
+            projectWorldPointsRow(images, targetValue, worldPointsParams, y, tile.row);
+            if (!reprojected) {
+                placeWorldPointsRow(tile.row, cells + size_t(y - gridFirstRow) * width);
+                continue;
+            }
+            // Rows are placed in raster order, so the last point of a cell wins, as in the staged path.
+            // Every row is a row of exactly one tile, which checks that no point of it lands beyond the margin.
+            uint32_t shift = reprojectWorldPointsRow(tile.row, y, gridParams, gridFirstRow, gridLastRow - gridFirstRow, cells);
+            if (shift > margin && y >= firstRow && y < lastRow) {
+                pointsMovedFar.store(true, std::memory_order_relaxed);
+            }
+        }
+        if (pointsMovedFar.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const GridRows rows = { cells, gridFirstRow };
+        count.fetch_add(surfaceNormalsOfRows(rows, firstRow, lastRow, width, height, params, normals),
+                        std::memory_order_relaxed);
+    });
+    if (pointsMovedFar.load()) {
+        // A tile may have missed points from rows it did not project, so its normals are not those of the staged path
+        return surfaceNormalsStaged(images, targetValue, worldPointsParams, gridParams, params, normals, config);
+    }
+    return count.load();
+}
@@ -0,0 +1,71 @@
+//
+//  SurfaceNormalsCPU.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef SurfaceNormalsCPU_hpp
+#define SurfaceNormalsCPU_hpp
+#include <cstddef>
+#include <cstdint>
+#include "ShaderTypes.h"
+#include "WorldPointsCPU.hpp"
+#include "WorldPointsGridCPU.hpp"
+
+/**
+    Surface normals of grids of world points on the CPU, in place of computeSurfaceNormals in SurfaceNormals.metal.
+
+    The normal of a cell is found like the kernel does: walks along stepL and stepT in both directions average the points they meet,
+    and the normal is the cross product of the differences, turned towards normalVector.
+    The operations are those of the kernel, in the same order and in float, under the same build flags as WorldPointsCPU.
+    Cells without a normal are zero in the output.
+ */
+
+struct SurfaceNormalsCPUConfig {
+    /// 0 uses one thread per core
+    unsigned threads = 0;
+    /// Rows of a tile, the unit of work of a thread
+    uint32_t tileRows = 64;
+    /// Where computeSurfaceNormalsFusedCPU places points. SourcePixel changes the normals; see computeSurfaceNormalsFusedCPU.
+    WorldPointsGridPlacement placement = WorldPointsGridPlacement::Reprojected;
+};
+
+/**
+    Rows above and below a cell that its walks can reach. A tile of rows, with this many more rows on either side,
+    holds every cell that the normals of the tile read.
+ */
+uint32_t surfaceNormalsHaloRows (const SurfaceNormalsForPointsGridParams &params, uint32_t height);
+
+/**
+    computeSurfaceNormals over a grid of width * height cells. Normals must have room for as many cells.
+    Returns the number of cells with a normal.
+ */
+size_t computeSurfaceNormalsCPU (const WorldPointsGridCell *grid, uint32_t width, uint32_t height,
+                                 const SurfaceNormalsForPointsGridParams &params, SurfaceNormalsForPointsGridCell *normals,
+                                 const SurfaceNormalsCPUConfig &config = SurfaceNormalsCPUConfig());
+
+/**
+    Normals straight from the segmentation and depth images, without the list of points or the grid of the full frame.
+    Every thread back-projects the rows of a tile and its halo into a grid of the tile, which stays in its cache,
+    and computes the normals of the tile from it.
+
+    With the default placement, Reprojected, points are projected back with gridParams, so the normals are those of
+    computeWorldPointsCPU in raster order, restructureWorldPointsToGridCPU and computeSurfaceNormalsCPU, bit for bit.
+    A tile also projects the row above and below its rows, which is where rounding moves points from. If a point lands further
+    from its row, as when gridParams is not the camera of worldPointsParams, or has another image size, the normals are
+    computed by those three steps instead.
+
+    SourcePixel is a change of behavior, to be asked for explicitly: points stay in the cell of the pixel they come from,
+    as in computeWorldPointsGridCPU, and gridParams is not used. The normals are then those of computeWorldPointsGridCPU
+    followed by computeSurfaceNormalsCPU, bit for bit, which differ from those of the staged path in most cells,
+    as projecting back moves about half of the points to a neighbouring cell.
+
+    Normals must have room for one cell per pixel of the grid. Returns the number of cells with a normal.
+ */
+size_t computeSurfaceNormalsFusedCPU (const WorldPointsImages &images, uint8_t targetValue,
+                                      const WorldPointsParams &worldPointsParams, const WorldPointsGridParams &gridParams,
+                                      const SurfaceNormalsForPointsGridParams &params, SurfaceNormalsForPointsGridCell *normals,
+                                      const SurfaceNormalsCPUConfig &config = SurfaceNormalsCPUConfig());
+
+#endif /* SurfaceNormalsCPU_hpp */
@@ -0,0 +1,266 @@
+//
+//  SurfaceNormalsSIMD.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "SurfaceNormalsSIMD.hpp"
+#include "MetalConversions.hpp"
+#include "ParallelBands.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t L = surfaceNormalsLanes;
+
+void WorldPointsGridSoA::assign (const WorldPointsGridCell *grid, uint32_t width, uint32_t height, unsigned threads) {
+    this->width = width;
+    this->height = height;
+    size_t cellCount = size_t(width) * height;
+    x.resize(cellCount);
+    y.resize(cellCount);
+    z.resize(cellCount);
+    valid.resize(cellCount);
+    parallelForBands(threads, height, [&] (size_t row, unsigned) {
+        size_t first = row * width;
+        for (size_t i = first; i < first + width; i++) {
+            x[i] = grid[i].worldPoint.p.x;
+            y[i] = grid[i].worldPoint.p.y;
+            z[i] = grid[i].worldPoint.p.z;
+            valid[i] = grid[i].isValid != 0;
+        }
+    });
+}
+
+/**
+    The coordinate of walkDirection along one axis after a step, which only depends on the coordinate before it.
+    Returns -1 outside [0, extent).
+ */
+static inline int32_t walkCoordinate (float &position, float step, float sign, uint32_t extent) {
+    position += step * sign;
+    uint32_t coordinate = toUintSaturating(std::round(position));
+    return coordinate < extent ? int32_t(coordinate) : -1;
+}
+
+/**
+    Steps until a walk along one axis has left [0, extent) from every start. Positions only move one way,
+    so a walk that has left stays out, and the kernel stops it there.
+ */
+static uint32_t walkAxisSteps (float step, float sign, uint32_t extent, uint32_t steps) {
+    uint32_t reach = 0;
+    for (uint32_t start = 0; start < extent && reach < steps; start++) {
+        float position = float(start);
+        uint32_t k = 0;
+        while (k < steps && walkCoordinate(position, step, sign, extent) >= 0) {
+            k++;
+        }
+        reach = std::max(reach, k);
+    }
+    return reach;
+}
+
+/// Fills steps rows of the coordinates reached from every start coordinate, stride apart
+static void fillWalkAxis (float step, float sign, uint32_t extent, uint32_t steps, size_t stride, int32_t *coordinates) {
+    for (uint32_t start = 0; start < extent; start++) {
+        float position = float(start);
+        for (uint32_t k = 0; k < steps; k++) {
+            coordinates[size_t(k) * stride + start] = walkCoordinate(position, step, sign, extent);
+        }
+    }
+}
+
+static void makeWalkTable (MTL_FLOAT2 step, float sign, const SurfaceNormalsForPointsGridParams &params,
+                           uint32_t width, uint32_t height, SurfaceNormalsWalkTable &walk) {
+    uint32_t steps = params.maxStep >= params.minStep ? params.maxStep - params.minStep + 1 : 0;
+    steps = walkAxisSteps(step.x, sign, width, steps);
+    steps = walkAxisSteps(step.y, sign, height, steps);
+    walk.steps = steps;
+    // Padded to whole blocks with columns outside the grid, so that the last block of a row loads every lane
+    walk.columnStride = (size_t(width) + L - 1) / L * L;
+    walk.columns.assign(size_t(steps) * walk.columnStride, -1);
+    walk.rows.resize(size_t(steps) * height);
+    walk.weights.resize(steps);
+    fillWalkAxis(step.x, sign, width, steps, walk.columnStride, walk.columns.data());
+    fillWalkAxis(step.y, sign, height, steps, height, walk.rows.data());
+    for (uint32_t k = 0; k < steps; k++) {
+        walk.weights[k] = 1.0f / float(params.minStep + k);
+    }
+}
+
+SurfaceNormalsWalkTables::SurfaceNormalsWalkTables (const SurfaceNormalsForPointsGridParams &params,
+                                                    uint32_t width, uint32_t height) {
+    // In the order of computeSurfaceNormals
+    makeWalkTable(params.stepL, 1.0f, params, width, height, walks[0]);
+    makeWalkTable(params.stepL, -1.0f, params, width, height, walks[1]);
+    makeWalkTable(params.stepT, 1.0f, params, width, height, walks[2]);
+    makeWalkTable(params.stepT, -1.0f, params, width, height, walks[3]);
+}
+
+/**
+    The lanes of a block, as vectors of GCC and Clang, which compile to the vectors of the target,
+    or to pairs of narrower ones. Masks are -1 in the lanes that are set, like the comparisons of the vectors give them.
+ */
+typedef float FloatLanes __attribute__((vector_size(sizeof(float) * L)));
+typedef int32_t MaskLanes __attribute__((vector_size(sizeof(int32_t) * L)));
+
+static inline bool anyLane (MaskLanes mask) {
+    int32_t any = 0;
+    for (uint32_t lane = 0; lane < L; lane++) {
+        any |= mask[lane];
+    }
+    return any != 0;
+}
+
+/**
+    walkDirection for the pixels of a block, and the mask of the active lanes whose walk meets a valid cell.
+    Invalid cells and cells outside the grid leave the sums as they are, like the kernel, so the sums are those of the kernel.
+ */
+static inline MaskLanes walkLanes (const WorldPointsGridSoA &grid, const SurfaceNormalsWalkTable &walk,
+                                   uint32_t blockX, uint32_t y, MaskLanes active, FloatLanes (&neighbor)[3]) {
+    FloatLanes sumX = {};
+    FloatLanes sumY = {};
+    FloatLanes sumZ = {};
+    FloatLanes weightSum = {};
+    const float *pointX = grid.x.data();
+    const float *pointY = grid.y.data();
+    const float *pointZ = grid.z.data();
+    const uint8_t *valid = grid.valid.data();
+    for (uint32_t k = 0; k < walk.steps; k++) {
+        int32_t row = walk.rows[size_t(k) * grid.height + y];
+        // Every lane shares the row, and the row stays outside the grid once it has left
+        if (row < 0) {
+            break;
+        }
+        MaskLanes columns;
+        memcpy(&columns, walk.columns.data() + size_t(k) * walk.columnStride + blockX, sizeof(columns));
+        MaskLanes inside = active & (columns >= 0);
+        columns &= inside;
+        // Loaded lane by lane, as gathers are not part of the baseline instruction sets
+        const size_t rowStart = size_t(row) * grid.width;
+        FloatLanes x;
+        FloatLanes y;
+        FloatLanes z;
+        MaskLanes cellValid;
+        for (uint32_t lane = 0; lane < L; lane++) {
+            size_t index = rowStart + size_t(columns[lane]);
+            x[lane] = pointX[index];
+            y[lane] = pointY[index];
+            z[lane] = pointZ[index];
+            cellValid[lane] = valid[index];
+        }
+        MaskLanes take = inside & (cellValid != 0);
+        const float weight = walk.weights[k];
+        sumX = take ? sumX + x * weight : sumX;
+        sumY = take ? sumY + y * weight : sumY;
+        sumZ = take ? sumZ + z * weight : sumZ;
+        weightSum = take ? weightSum + weight : weightSum;
+    }
+    neighbor[0] = sumX / weightSum;
+    neighbor[1] = sumY / weightSum;
+    neighbor[2] = sumZ / weightSum;
+    return active & (weightSum > 0.0f);
+}
+
+/**
+    The normals of the pixels of a block, with the operations of computeSurfaceNormals, written to the cells of the row.
+    Returns the number of normals.
+ */
+static size_t normalsOfBlock (const WorldPointsGridSoA &grid, const SurfaceNormalsWalkTables &tables,
+                              const SurfaceNormalsForPointsGridParams &params, uint32_t blockX, uint32_t y,
+                              SurfaceNormalsForPointsGridCell *rowNormals) {
+    const size_t rowStart = size_t(y) * grid.width;
+    MaskLanes active;
+    for (uint32_t lane = 0; lane < L; lane++) {
+        uint32_t x = blockX + lane;
+        active[lane] = x < grid.width && grid.valid[rowStart + x] != 0 ? -1 : 0;
+    }
+    // The kernel gives up on a pixel at the first walk that fails, which leaves the other lanes to go on
+    FloatLanes neighbors[4][3];
+    for (uint32_t walk = 0; walk < 4; walk++) {
+        if (!anyLane(active)) {
+            return 0;
+        }
+        active = walkLanes(grid, tables.walks[walk], blockX, y, active, neighbors[walk]);
+    }
+    if (!anyLane(active)) {
+        return 0;
+    }
+
+    // Longitudinal and lateral vectors, from the plus and minus walks
+    FloatLanes lX = neighbors[0][0] - neighbors[1][0];
+    FloatLanes lY = neighbors[0][1] - neighbors[1][1];
+    FloatLanes lZ = neighbors[0][2] - neighbors[1][2];
+    FloatLanes tX = neighbors[2][0] - neighbors[3][0];
+    FloatLanes tY = neighbors[2][1] - neighbors[3][1];
+    FloatLanes tZ = neighbors[2][2] - neighbors[3][2];
+    FloatLanes longitudinalLength2 = (lX * lX + lY * lY) + lZ * lZ;
+    FloatLanes lateralLength2 = (tX * tX + tY * tY) + tZ * tZ;
+    FloatLanes nX = lY * tZ - lZ * tY;
+    FloatLanes nY = lZ * tX - lX * tZ;
+    FloatLanes nZ = lX * tY - lY * tX;
+    FloatLanes normalLength2 = (nX * nX + nY * nY) + nZ * nZ;
+    FloatLanes sinSq = normalLength2 / (longitudinalLength2 * lateralLength2);
+    // The comparisons of the kernel, negated so that NaN fails them the same way
+    const float eps = params.eps;
+    active &= ~(longitudinalLength2 < eps) & ~(lateralLength2 < eps) & ~(sinSq < eps);
+    if (!anyLane(active)) {
+        return 0;
+    }
+    const MTL_FLOAT3 reference = params.normalVector;
+    MaskLanes flip = (nX * reference.x + nY * reference.y) + nZ * reference.z < 0.0f;
+    nX = flip ? -nX : nX;
+    nY = flip ? -nY : nY;
+    nZ = flip ? -nZ : nZ;
+    FloatLanes length2 = (nX * nX + nY * nY) + nZ * nZ;
+    FloatLanes length;
+    for (uint32_t lane = 0; lane < L; lane++) {
+        length[lane] = std::sqrt(length2[lane]);
+    }
+    FloatLanes inverseLength = 1.0f / length;
+    nX = nX * inverseLength;
+    nY = nY * inverseLength;
+    nZ = nZ * inverseLength;
+
+    size_t count = 0;
+    for (uint32_t lane = 0; lane < L; lane++) {
+        if (active[lane] == 0) {
+            continue;
+        }
+        uint32_t x = blockX + lane;
+        SurfaceNormalsForPointsGridCell &cell = rowNormals[x];
+        cell.worldPoint.p.x = grid.x[rowStart + x];
+        cell.worldPoint.p.y = grid.y[rowStart + x];
+        cell.worldPoint.p.z = grid.z[rowStart + x];
+        cell.surfaceNormal.x = nX[lane];
+        cell.surfaceNormal.y = nY[lane];
+        cell.surfaceNormal.z = nZ[lane];
+        cell.isValid = true;
+        count++;
+    }
+    return count;
+}
+
+size_t computeSurfaceNormalsSIMD (const WorldPointsGridSoA &grid, const SurfaceNormalsWalkTables &tables,
+                                  const SurfaceNormalsForPointsGridParams &params, SurfaceNormalsForPointsGridCell *normals,
+                                  const SurfaceNormalsCPUConfig &config) {
+    const uint32_t width = grid.width;
+    const uint32_t height = grid.height;
+    const uint32_t tileRows = std::max(config.tileRows, 1u);
+    const size_t tileCount = (size_t(height) + tileRows - 1) / tileRows;
+    std::atomic<size_t> count { 0 };
+    parallelForBands(config.threads, tileCount, [&] (size_t tile, unsigned) {
+        uint32_t firstRow = uint32_t(tile) * tileRows;
+        uint32_t lastRow = std::min(firstRow + tileRows, height);
+        memset(normals + size_t(firstRow) * width, 0, size_t(lastRow - firstRow) * width * sizeof(SurfaceNormalsForPointsGridCell));
+        size_t tileNormals = 0;
+        for (uint32_t y = firstRow; y < lastRow; y++) {
+            SurfaceNormalsForPointsGridCell *rowNormals = normals + size_t(y) * width;
+            for (uint32_t blockX = 0; blockX < width; blockX += L) {
+                tileNormals += normalsOfBlock(grid, tables, params, blockX, y, rowNormals);
+            }
+        }
+        count.fetch_add(tileNormals, std::memory_order_relaxed);
+    });
+    return count.load();
+}
@@ -0,0 +1,87 @@
+//
+//  SurfaceNormalsSIMD.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef SurfaceNormalsSIMD_hpp
+#define SurfaceNormalsSIMD_hpp
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ShaderTypes.h"
+#include "SurfaceNormalsCPU.hpp"
+
+/**
+    Surface normals of grids of world points, computed for several pixels at a time in SIMD lanes.
+
+    The walks of computeSurfaceNormals add up a float position step by step and round it to a cell. Along a walk, the column
+    only depends on the start column and the row only on the start row, so tables of the cells that every walk reaches
+    from every start column and every start row, made with the operations of the kernel, replace the positions and the rounding.
+    The weights 1 / i of the steps are in the tables too. A single offset per step, from the pixel to the cell,
+    would not be exact: adding up the steps rounds differently from different start coordinates, and the kernel
+    saturates positions below 0 to the first row or column rather than stopping.
+
+    The pixels of a row are processed in blocks of surfaceNormalsLanes, one per lane of the vectors of the compiler,
+    with the lanes whose walks have failed masked off. The grid is read from separate arrays of coordinates and validity.
+    The normals are those of computeSurfaceNormalsCPU, bit for bit.
+ */
+
+/// Pixels of a block: the floats of an AVX2 vector where the build targets AVX2, and of an SSE or NEON vector otherwise
+#if defined(__AVX2__)
+static const uint32_t surfaceNormalsLanes = 8;
+#else
+static const uint32_t surfaceNormalsLanes = 4;
+#endif
+
+/**
+    A grid of world points in separate arrays, for the loads of the lanes.
+ */
+struct WorldPointsGridSoA {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<uint8_t> valid;
+
+    /// Copies a grid of width * height cells
+    void assign (const WorldPointsGridCell *grid, uint32_t width, uint32_t height, unsigned threads = 0);
+};
+
+/**
+    The cells that a walk of computeSurfaceNormals reaches, from every start column and every start row.
+    Steps after the walk has left the grid from every start are dropped.
+ */
+struct SurfaceNormalsWalkTable {
+    /// Steps kept
+    uint32_t steps = 0;
+    /// Columns reached at every step, steps rows of columnStride entries, one per start column, or -1 outside the grid
+    std::vector<int32_t> columns;
+    size_t columnStride = 0;
+    /// Rows reached at every step, steps rows of height entries, one per start row, or -1 outside the grid
+    std::vector<int32_t> rows;
+    /// 1 / i of every step
+    std::vector<float> weights;
+};
+
+/**
+    The tables of the four walks of computeSurfaceNormals, along stepL and stepT in both directions, for a grid size.
+    They take steps * (width + height) * 16 bytes, and can be kept across frames with the same parameters.
+ */
+struct SurfaceNormalsWalkTables {
+    SurfaceNormalsWalkTable walks[4];
+
+    SurfaceNormalsWalkTables (const SurfaceNormalsForPointsGridParams &params, uint32_t width, uint32_t height);
+};
+
+/**
+    computeSurfaceNormals over a grid, with tables made for its size and for params. Normals must have room for every cell.
+    Returns the number of cells with a normal.
+ */
+size_t computeSurfaceNormalsSIMD (const WorldPointsGridSoA &grid, const SurfaceNormalsWalkTables &tables,
+                                  const SurfaceNormalsForPointsGridParams &params, SurfaceNormalsForPointsGridCell *normals,
+                                  const SurfaceNormalsCPUConfig &config = SurfaceNormalsCPUConfig());
+
+#endif /* SurfaceNormalsSIMD_hpp */
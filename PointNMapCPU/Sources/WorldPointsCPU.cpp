@@ -0,0 +1,329 @@
+//
+//  WorldPointsCPU.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "WorldPointsCPU.hpp"
+#include "ParallelBands.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+MTL_FLOAT3 projectPixelToWorldCPU (float pixelX, float pixelY, float depth,
+                                   const MTL_FLOAT4X4 &cameraTransform, const MTL_FLOAT3X3 &invIntrinsics) {
+    const MTL_FLOAT3 *k = invIntrinsics.columns;
+    const MTL_FLOAT4 *t = cameraTransform.columns;
+    // ray = invIntrinsics * float3(pixel, 1)
+    float rayX = (k[0].x * pixelX + k[1].x * pixelY) + k[2].x;
+    float rayY = (k[0].y * pixelX + k[1].y * pixelY) + k[2].y;
+    float rayZ = (k[0].z * pixelX + k[1].z * pixelY) + k[2].z;
+    // normalize(ray) * depth, flipped to the camera axes of ARKit
+    float inverseLength = 1.0f / std::sqrt((rayX * rayX + rayY * rayY) + rayZ * rayZ);
+    float cameraX = (rayX * inverseLength) * depth;
+    float cameraY = -((rayY * inverseLength) * depth);
+    float cameraZ = -((rayZ * inverseLength) * depth);
+    // cameraTransform * float4(cameraPoint, 1), divided by w
+    float worldX = ((t[0].x * cameraX + t[1].x * cameraY) + t[2].x * cameraZ) + t[3].x;
+    float worldY = ((t[0].y * cameraX + t[1].y * cameraY) + t[2].y * cameraZ) + t[3].y;
+    float worldZ = ((t[0].z * cameraX + t[1].z * cameraY) + t[2].z * cameraZ) + t[3].z;
+    float worldW = ((t[0].w * cameraX + t[1].w * cameraY) + t[2].w * cameraZ) + t[3].w;
+    MTL_FLOAT3 world = {};
+    world.x = worldX / worldW;
+    world.y = worldY / worldW;
+    world.z = worldZ / worldW;
+    return world;
+}
+
+/**
+    Whether a pixel becomes a point, as decided by computeWorldPoints, counting the reason in debugCounts.
+    The label is compared as a byte: round(unorm * 255) of the r8Unorm texture gives back the byte for every value.
+ */
+static inline bool acceptPixel (uint8_t label, float depth, uint8_t targetValue, const WorldPointsParams &params,
+                                uint32_t *debugCounts) {
+    if (label != targetValue) {
+        debugCounts[WorldPointsDebugUnmatchedSegmentation]++;
+        return false;
+    }
+    if (depth < params.minDepthThreshold) {
+        debugCounts[WorldPointsDebugBelowDepthRange]++;
+        return false;
+    }
+    if (depth > params.maxDepthThreshold) {
+        debugCounts[WorldPointsDebugAboveDepthRange]++;
+        return false;
+    }
+    // Counted, but still written, like the kernel does
+    if (depth == 0.0f) {
+        debugCounts[WorldPointsDebugDepthIsZero]++;
+    }
+    debugCounts[WorldPointsDebugWrotePoint]++;
+    return true;
+}
+
+static inline const uint8_t *segmentationRow (const WorldPointsImages &images, uint32_t y) {
+    return images.segmentation + size_t(y) * images.segmentationBytesPerRow;
+}
+
+static inline const float *depthRow (const WorldPointsImages &images, uint32_t y) {
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(images.depth) + size_t(y) * images.depthBytesPerRow);
+}
+
+size_t computeWorldPointsReference (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                                    WorldPoint *points, uint32_t *debugCounts) {
+    uint32_t counts[WorldPointsDebugSlotCount] = {};
+    size_t pointCount = 0;
+    for (uint32_t y = 0; y < params.imageSize.y; y++) {
+        const uint8_t *labels = segmentationRow(images, y);
+        const float *depths = depthRow(images, y);
+        for (uint32_t x = 0; x < params.imageSize.x; x++) {
+            if (!acceptPixel(labels[x], depths[x], targetValue, params, counts)) {
+                continue;
+            }
+            points[pointCount++].p = projectPixelToWorldCPU(
+                float(x), float(y), depths[x], params.cameraTransform, params.invIntrinsics
+            );
+        }
+    }
+    if (debugCounts != nullptr) {
+        memcpy(debugCounts, counts, sizeof(counts));
+    }
+    return pointCount;
+}
+
+void WorldPointsRow::resize (uint32_t width) {
+    pixelX.resize(width);
+    depth.resize(width);
+    worldX.resize(width);
+    worldY.resize(width);
+    worldZ.resize(width);
+}
+
+/**
+    Space of a thread for the points of a row, and for the points of a band.
+ */
+struct WorldPointsScratch {
+    WorldPointsRow row;
+    std::vector<WorldPoint> points;
+};
+
+/**
+    The decisions of acceptPixel as flags, so that rows are processed without branches,
+    as labels and depths change too often for branches to be predicted.
+ */
+struct PixelDecision {
+    bool matched;
+    bool below;
+    bool above;
+    bool accepted;
+};
+
+static inline PixelDecision decidePixel (uint8_t label, float depth, uint8_t targetValue, const WorldPointsParams &params) {
+    PixelDecision decision;
+    decision.matched = label == targetValue;
+    decision.below = decision.matched & (depth < params.minDepthThreshold);
+    decision.above = decision.matched & !decision.below & (depth > params.maxDepthThreshold);
+    decision.accepted = decision.matched & !decision.below & !decision.above;
+    return decision;
+}
+
+/// Counts the pixels of a row that become points, and the reasons of the others in debugCounts
+static size_t countRow (const uint8_t *labels, const float *depths, uint32_t width, uint8_t targetValue,
+                        const WorldPointsParams &params, uint32_t *debugCounts) {
+    uint32_t unmatched = 0;
+    uint32_t below = 0;
+    uint32_t above = 0;
+    uint32_t zero = 0;
+    uint32_t count = 0;
+    for (uint32_t x = 0; x < width; x++) {
+        PixelDecision decision = decidePixel(labels[x], depths[x], targetValue, params);
+        unmatched += !decision.matched;
+        below += decision.below;
+        above += decision.above;
+        zero += decision.accepted & (depths[x] == 0.0f);
+        count += decision.accepted;
+    }
+    debugCounts[WorldPointsDebugUnmatchedSegmentation] += unmatched;
+    debugCounts[WorldPointsDebugBelowDepthRange] += below;
+    debugCounts[WorldPointsDebugAboveDepthRange] += above;
+    debugCounts[WorldPointsDebugDepthIsZero] += zero;
+    debugCounts[WorldPointsDebugWrotePoint] += count;
+    return count;
+}
+
+/// Gathers the pixels of a row that become points into the scratch space, and returns their number
+static size_t gatherRow (const uint8_t *labels, const float *depths, uint32_t width, uint8_t targetValue,
+                         const WorldPointsParams &params, WorldPointsRow &row) {
+    float *__restrict pixelX = row.pixelX.data();
+    float *__restrict depth = row.depth.data();
+    size_t count = 0;
+    for (uint32_t x = 0; x < width; x++) {
+        // Written for every pixel, and kept only if the count moves past it
+        pixelX[count] = float(x);
+        depth[count] = depths[x];
+        count += decidePixel(labels[x], depths[x], targetValue, params).accepted;
+    }
+    return count;
+}
+
+/**
+    Computes the points of the gathered pixels of a row, with the operations of projectPixelToWorldCPU.
+    The loop has no branches and works on separate arrays, so that it is vectorized.
+ */
+static void projectRow (const WorldPointsParams &params, float pixelY, size_t count, WorldPointsRow &row) {
+    // Loaded once, as the compiler cannot tell that the stores of the loop leave the parameters alone
+    const MTL_FLOAT3 k0 = params.invIntrinsics.columns[0];
+    const MTL_FLOAT3 k2 = params.invIntrinsics.columns[2];
+    const MTL_FLOAT4 t0 = params.cameraTransform.columns[0];
+    const MTL_FLOAT4 t1 = params.cameraTransform.columns[1];
+    const MTL_FLOAT4 t2 = params.cameraTransform.columns[2];
+    const MTL_FLOAT4 t3 = params.cameraTransform.columns[3];
+    // The terms of the row, which are the same products as in projectPixelToWorldCPU
+    const float rowX = params.invIntrinsics.columns[1].x * pixelY;
+    const float rowY = params.invIntrinsics.columns[1].y * pixelY;
+    const float rowZ = params.invIntrinsics.columns[1].z * pixelY;
+    const float *__restrict pixelX = row.pixelX.data();
+    const float *__restrict depth = row.depth.data();
+    float *__restrict worldX = row.worldX.data();
+    float *__restrict worldY = row.worldY.data();
+    float *__restrict worldZ = row.worldZ.data();
+    for (size_t i = 0; i < count; i++) {
+        float rayX = (k0.x * pixelX[i] + rowX) + k2.x;
+        float rayY = (k0.y * pixelX[i] + rowY) + k2.y;
+        float rayZ = (k0.z * pixelX[i] + rowZ) + k2.z;
+        float inverseLength = 1.0f / std::sqrt((rayX * rayX + rayY * rayY) + rayZ * rayZ);
+        float cameraX = (rayX * inverseLength) * depth[i];
+        float cameraY = -((rayY * inverseLength) * depth[i]);
+        float cameraZ = -((rayZ * inverseLength) * depth[i]);
+        float x = ((t0.x * cameraX + t1.x * cameraY) + t2.x * cameraZ) + t3.x;
+        float y = ((t0.y * cameraX + t1.y * cameraY) + t2.y * cameraZ) + t3.y;
+        float z = ((t0.z * cameraX + t1.z * cameraY) + t2.z * cameraZ) + t3.z;
+        float w = ((t0.w * cameraX + t1.w * cameraY) + t2.w * cameraZ) + t3.w;
+        worldX[i] = x / w;
+        worldY[i] = y / w;
+        worldZ[i] = z / w;
+    }
+}
+
+size_t projectWorldPointsRow (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                             uint32_t y, WorldPointsRow &row) {
+    row.count = gatherRow(segmentationRow(images, y), depthRow(images, y), params.imageSize.x, targetValue, params, row);
+    projectRow(params, float(y), row.count, row);
+    return row.count;
+}
+
+/**
+    Computes the points of the rows of a band, in raster order, and returns their number.
+    If debugCounts is not null, the rows are also counted in it.
+ */
+static size_t projectBand (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                           uint32_t firstRow, uint32_t lastRow, WorldPointsScratch &scratch,
+                           WorldPoint *points, uint32_t *debugCounts) {
+    const uint32_t width = params.imageSize.x;
+    size_t pointCount = 0;
+    for (uint32_t y = firstRow; y < lastRow; y++) {
+        const uint8_t *labels = segmentationRow(images, y);
+        const float *depths = depthRow(images, y);
+        if (debugCounts != nullptr) {
+            countRow(labels, depths, width, targetValue, params, debugCounts);
+        }
+        WorldPointsRow &row = scratch.row;
+        size_t rowCount = projectWorldPointsRow(images, targetValue, params, y, row);
+        WorldPoint *rowPoints = points + pointCount;
+        for (size_t i = 0; i < rowCount; i++) {
+            rowPoints[i].p.x = row.worldX[i];
+            rowPoints[i].p.y = row.worldY[i];
+            rowPoints[i].p.z = row.worldZ[i];
+        }
+        pointCount += rowCount;
+    }
+    return pointCount;
+}
+
+size_t computeWorldPointsCPU (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                              WorldPoint *points, uint32_t *debugCounts, const WorldPointsCPUConfig &config) {
+    const uint32_t width = params.imageSize.x;
+    const uint32_t height = params.imageSize.y;
+    const uint32_t bandRows = std::max(config.bandRows, 1u);
+    const size_t bandCount = (size_t(height) + bandRows - 1) / bandRows;
+    const bool raster = config.order == WorldPointsOrder::Raster;
+    unsigned threadCount = resolveThreadCount(config.threads);
+
+    std::vector<WorldPointsScratch> scratches(threadCount);
+    std::atomic<size_t> pointCount { 0 };
+    std::atomic<uint32_t> counts[WorldPointsDebugSlotCount] = {};
+    auto bandRange = [bandRows, height] (size_t band, uint32_t &firstRow, uint32_t &lastRow) {
+        firstRow = uint32_t(band) * bandRows;
+        lastRow = std::min(firstRow + bandRows, height);
+    };
+    auto addCounts = [&counts] (const uint32_t *bandCounts) {
+        for (uint32_t slot = 0; slot < WorldPointsDebugSlotCount; slot++) {
+            counts[slot].fetch_add(bandCounts[slot], std::memory_order_relaxed);
+        }
+    };
+    auto prepareScratch = [&scratches, width, bandRows, raster] (unsigned worker) -> WorldPointsScratch & {
+        WorldPointsScratch &scratch = scratches[worker];
+        if (scratch.row.pixelX.empty()) {
+            scratch.row.resize(width);
+            // Bands of raster order are written in place
+            if (!raster) {
+                scratch.points.resize(size_t(width) * bandRows);
+            }
+        }
+        return scratch;
+    };
+
+    if (raster) {
+        // Counts the points of every band, then gives every band the offset of its points with an exclusive prefix sum
+        // of the counts, so that bands write their points in place, in raster order, whichever finishes first.
+        // The sum is over bands rather than pixels, so it takes no time next to the passes over the pixels.
+        std::vector<size_t> bandOffsets(bandCount + 1, 0);
+        parallelForBands(threadCount, bandCount, [&] (size_t band, unsigned) {
+            uint32_t bandCounts[WorldPointsDebugSlotCount] = {};
+            uint32_t firstRow;
+            uint32_t lastRow;
+            bandRange(band, firstRow, lastRow);
+            size_t bandPointCount = 0;
+            for (uint32_t y = firstRow; y < lastRow; y++) {
+                bandPointCount += countRow(segmentationRow(images, y), depthRow(images, y), width,
+                                           targetValue, params, bandCounts);
+            }
+            bandOffsets[band + 1] = bandPointCount;
+            addCounts(bandCounts);
+        });
+        for (size_t band = 0; band < bandCount; band++) {
+            bandOffsets[band + 1] += bandOffsets[band];
+        }
+        parallelForBands(threadCount, bandCount, [&] (size_t band, unsigned worker) {
+            uint32_t firstRow;
+            uint32_t lastRow;
+            bandRange(band, firstRow, lastRow);
+            projectBand(images, targetValue, params, firstRow, lastRow, prepareScratch(worker),
+                        points + bandOffsets[band], nullptr);
+        });
+        pointCount.store(bandOffsets[bandCount]);
+    } else {
+        parallelForBands(threadCount, bandCount, [&] (size_t band, unsigned worker) {
+            WorldPointsScratch &scratch = prepareScratch(worker);
+            uint32_t bandCounts[WorldPointsDebugSlotCount] = {};
+            uint32_t firstRow;
+            uint32_t lastRow;
+            bandRange(band, firstRow, lastRow);
+            size_t bandPointCount = projectBand(images, targetValue, params, firstRow, lastRow, scratch,
+                                                scratch.points.data(), bandCounts);
+            // One append per band, where the kernel has one per point
+            size_t start = pointCount.fetch_add(bandPointCount, std::memory_order_relaxed);
+            memcpy(points + start, scratch.points.data(), bandPointCount * sizeof(WorldPoint));
+            addCounts(bandCounts);
+        });
+    }
+
+    if (debugCounts != nullptr) {
+        for (uint32_t slot = 0; slot < WorldPointsDebugSlotCount; slot++) {
+            debugCounts[slot] = counts[slot].load();
+        }
+    }
+    return pointCount.load();
+}
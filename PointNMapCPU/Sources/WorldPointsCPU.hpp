@@ -0,0 +1,107 @@
+//
+//  WorldPointsCPU.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef WorldPointsCPU_hpp
+#define WorldPointsCPU_hpp
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ShaderTypes.h"
+
+/**
+    Back-projection of segmented depth pixels to world points on the CPU, in place of computeWorldPoints in WorldPoints.metal,
+    for hosts without a GPU.
+
+    Every point is computed with the operations of projectPixelToWorld, in the same order and in float,
+    so that points match the kernel to the last bit wherever the GPU rounds like IEEE arithmetic.
+    The matrix products are expanded column by column, (c0 * x + c1 * y) + c2 * z, and normalize is x * (1 / sqrt(dot(x, x))).
+    The engine must be compiled without floating-point contraction (-ffp-contract=off) and without fast math.
+
+    Rows are processed in bands on several threads. Within a row, the matching pixels are gathered first,
+    and the points of all of them are then computed in loops that the compiler vectorizes.
+    Like the kernel, bands append their points to the output in whichever order they finish, unless raster order is asked for.
+ */
+
+/// Slots of the debug counters, in the order of PlaneDebugSlot in WorldPoints.metal
+enum WorldPointsDebugSlot : uint32_t {
+    WorldPointsDebugOutsideImage = 0,
+    WorldPointsDebugUnmatchedSegmentation = 1,
+    WorldPointsDebugBelowDepthRange = 2,
+    WorldPointsDebugAboveDepthRange = 3,
+    WorldPointsDebugWrotePoint = 4,
+    WorldPointsDebugDepthIsZero = 5,
+    WorldPointsDebugSlotCount = 6
+};
+
+/**
+    Segmentation and depth images of the size of WorldPointsParams.imageSize, with rows from the top.
+ */
+struct WorldPointsImages {
+    /// Label of every pixel, as in the r8Unorm segmentation texture
+    const uint8_t *segmentation = nullptr;
+    size_t segmentationBytesPerRow = 0;
+    /// Depth of every pixel in meters, as in the r32Float depth texture
+    const float *depth = nullptr;
+    size_t depthBytesPerRow = 0;
+};
+
+enum class WorldPointsOrder {
+    /// Bands append their points as they finish, like the atomic counter of the kernel, so the order changes from run to run
+    Any,
+    /// Points are in raster order, the order of computeWorldPointsReference, on every run.
+    /// Bands count their points in a first pass, and write them in place in a second, at offsets found by a prefix sum.
+    Raster
+};
+
+struct WorldPointsCPUConfig {
+    /// 0 uses one thread per core
+    unsigned threads = 0;
+    /// Rows of a band, the unit of work of a thread
+    uint32_t bandRows = 16;
+    WorldPointsOrder order = WorldPointsOrder::Any;
+};
+
+/**
+    The points of the pixels of a row that become points, in order of x, in separate arrays.
+ */
+struct WorldPointsRow {
+    std::vector<float> pixelX;
+    std::vector<float> depth;
+    std::vector<float> worldX;
+    std::vector<float> worldY;
+    std::vector<float> worldZ;
+    size_t count = 0;
+
+    /// Makes room for a row of the given width
+    void resize (uint32_t width);
+};
+
+/// projectPixelToWorld of WorldPoints.metal for a single pixel
+MTL_FLOAT3 projectPixelToWorldCPU (float pixelX, float pixelY, float depth,
+                                   const MTL_FLOAT4X4 &cameraTransform, const MTL_FLOAT3X3 &invIntrinsics);
+
+/**
+    Back-projects the pixels of a label, like computeWorldPoints. Points must have room for one point per pixel.
+    Returns the number of points. If debugCounts is not null, it receives WorldPointsDebugSlotCount counters;
+    the outsideImage counter, which counts the padding threads of the GPU dispatch, is always 0.
+ */
+size_t computeWorldPointsCPU (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                              WorldPoint *points, uint32_t *debugCounts = nullptr,
+                              const WorldPointsCPUConfig &config = WorldPointsCPUConfig());
+
+/**
+    Computes the points of a single row, for pipelines that place points by the pixel they come from.
+    Returns the number of points. The debug counters are not kept.
+ */
+size_t projectWorldPointsRow (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                              uint32_t y, WorldPointsRow &row);
+
+/// One pixel at a time on the calling thread, in raster order. The reference that the engine is checked against.
+size_t computeWorldPointsReference (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                                    WorldPoint *points, uint32_t *debugCounts = nullptr);
+
+#endif /* WorldPointsCPU_hpp */
@@ -0,0 +1,116 @@
+//
+//  WorldPointsDump.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "WorldPointsDump.hpp"
+#include <cstdio>
+#include <cstring>
+
+static const char worldPointsDumpMagic[4] = { 'W', 'P', 'R', 'D' };
+static const size_t worldPointsDumpHeaderSize = 24;
+
+static uint32_t readU32 (const uint8_t *bytes) {
+    return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+static void writeU32 (uint8_t *bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = uint8_t(value >> (8 * i));
+    }
+}
+
+static bool readBytes (FILE *file, void *bytes, size_t size) {
+    return fread(bytes, 1, size, file) == size;
+}
+
+WorldPointsImages WorldPointsDump::images () const {
+    WorldPointsImages images;
+    images.segmentation = segmentation.data();
+    images.segmentationBytesPerRow = params.imageSize.x;
+    images.depth = depth.data();
+    images.depthBytesPerRow = size_t(params.imageSize.x) * sizeof(float);
+    return images;
+}
+
+static WorldPointsDumpStatus readDump (FILE *file, WorldPointsDump &dump) {
+    uint8_t header[worldPointsDumpHeaderSize];
+    if (!readBytes(file, header, sizeof(header))) {
+        return WorldPointsDumpStatus::Corrupt;
+    }
+    if (memcmp(header, worldPointsDumpMagic, sizeof(worldPointsDumpMagic)) != 0) {
+        return WorldPointsDumpStatus::Corrupt;
+    }
+    if (readU32(header + 4) != worldPointsDumpVersion
+        || readU32(header + 8) != sizeof(WorldPointsParams)
+        || readU32(header + 12) != sizeof(WorldPoint)
+        || readU32(header + 16) != WorldPointsDebugSlotCount) {
+        return WorldPointsDumpStatus::Unsupported;
+    }
+    dump.targetValue = header[20];
+
+    uint8_t counts[WorldPointsDebugSlotCount * 4 + 4];
+    if (!readBytes(file, &dump.params, sizeof(dump.params)) || !readBytes(file, counts, sizeof(counts))) {
+        return WorldPointsDumpStatus::Corrupt;
+    }
+    for (uint32_t slot = 0; slot < WorldPointsDebugSlotCount; slot++) {
+        dump.debugCounts[slot] = readU32(counts + 4 * slot);
+    }
+    size_t pixelCount = size_t(dump.params.imageSize.x) * dump.params.imageSize.y;
+    size_t pointCount = readU32(counts + 4 * WorldPointsDebugSlotCount);
+    if (pointCount > pixelCount) {
+        return WorldPointsDumpStatus::Corrupt;
+    }
+    dump.segmentation.resize(pixelCount);
+    dump.depth.resize(pixelCount);
+    dump.points.resize(pointCount);
+    if (!readBytes(file, dump.segmentation.data(), pixelCount)
+        || !readBytes(file, dump.depth.data(), pixelCount * sizeof(float))
+        || !readBytes(file, dump.points.data(), pointCount * sizeof(WorldPoint))) {
+        return WorldPointsDumpStatus::Corrupt;
+    }
+    return WorldPointsDumpStatus::Ok;
+}
+
+WorldPointsDumpStatus readWorldPointsDump (const std::string &path, WorldPointsDump &dump) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return WorldPointsDumpStatus::IoError;
+    }
+    WorldPointsDumpStatus status = readDump(file, dump);
+    fclose(file);
+    return status;
+}
+
+WorldPointsDumpStatus writeWorldPointsDump (const std::string &path, const WorldPointsDump &dump) {
+    size_t pixelCount = size_t(dump.params.imageSize.x) * dump.params.imageSize.y;
+    if (dump.segmentation.size() != pixelCount || dump.depth.size() != pixelCount) {
+        return WorldPointsDumpStatus::Corrupt;
+    }
+    uint8_t header[worldPointsDumpHeaderSize] = {};
+    memcpy(header, worldPointsDumpMagic, sizeof(worldPointsDumpMagic));
+    writeU32(header + 4, worldPointsDumpVersion);
+    writeU32(header + 8, sizeof(WorldPointsParams));
+    writeU32(header + 12, sizeof(WorldPoint));
+    writeU32(header + 16, WorldPointsDebugSlotCount);
+    header[20] = dump.targetValue;
+    uint8_t counts[WorldPointsDebugSlotCount * 4 + 4];
+    for (uint32_t slot = 0; slot < WorldPointsDebugSlotCount; slot++) {
+        writeU32(counts + 4 * slot, dump.debugCounts[slot]);
+    }
+    writeU32(counts + 4 * WorldPointsDebugSlotCount, uint32_t(dump.points.size()));
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return WorldPointsDumpStatus::IoError;
+    }
+    bool written = fwrite(header, 1, sizeof(header), file) == sizeof(header)
+        && fwrite(&dump.params, 1, sizeof(dump.params), file) == sizeof(dump.params)
+        && fwrite(counts, 1, sizeof(counts), file) == sizeof(counts)
+        && fwrite(dump.segmentation.data(), 1, pixelCount, file) == pixelCount
+        && fwrite(dump.depth.data(), sizeof(float), pixelCount, file) == pixelCount
+        && fwrite(dump.points.data(), sizeof(WorldPoint), dump.points.size(), file) == dump.points.size();
+    return fclose(file) == 0 && written ? WorldPointsDumpStatus::Ok : WorldPointsDumpStatus::IoError;
+}
@@ -0,0 +1,53 @@
+//
+//  WorldPointsDump.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef WorldPointsDump_hpp
+#define WorldPointsDump_hpp
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ShaderTypes.h"
+#include "WorldPointsCPU.hpp"
+
+/**
+    A recording of a run of computeWorldPoints on the GPU: its inputs, as read back from the textures, and its outputs.
+    Written by WorldPointsReferenceDumpExtension.swift, and used to check the CPU engine against the GPU.
+
+    Layout (little-endian): "WPRD", version, the sizes of WorldPointsParams and WorldPoint, the number of debug slots,
+    the target value and 3 bytes of padding, the WorldPointsParams as they were passed to the kernel,
+    the debug counters, the number of points, then the segmentation (1 byte per pixel) and the depth (a float per pixel),
+    both without row padding, and the points in the order the GPU wrote them.
+ */
+static const uint32_t worldPointsDumpVersion = 1;
+
+enum class WorldPointsDumpStatus {
+    Ok,
+    /// The file could not be opened, read or written
+    IoError,
+    /// A file of a later version, or with other struct layouts
+    Unsupported,
+    /// Not a valid file
+    Corrupt
+};
+
+struct WorldPointsDump {
+    uint8_t targetValue = 0;
+    WorldPointsParams params = {};
+    uint32_t debugCounts[WorldPointsDebugSlotCount] = {};
+    std::vector<uint8_t> segmentation;
+    std::vector<float> depth;
+    std::vector<WorldPoint> points;
+
+    /// The images of the dump, for computeWorldPointsCPU
+    WorldPointsImages images () const;
+};
+
+WorldPointsDumpStatus readWorldPointsDump (const std::string &path, WorldPointsDump &dump);
+WorldPointsDumpStatus writeWorldPointsDump (const std::string &path, const WorldPointsDump &dump);
+
+#endif /* WorldPointsDump_hpp */
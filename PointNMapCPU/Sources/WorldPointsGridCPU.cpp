@@ -0,0 +1,142 @@
+//
+//  WorldPointsGridCPU.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include "WorldPointsGridCPU.hpp"
+#include "MetalConversions.hpp"
+#include "ParallelBands.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/// Points per band of the parallel pass of restructuring
+static const size_t restructureBandPoints = 1 << 14;
+/// Cell of the points that are not placed
+static const uint32_t noCell = UINT32_MAX;
+
+MTL_FLOAT2 unprojectWorldToPixelCPU (const MTL_FLOAT3 &worldPoint, const MTL_FLOAT4X4 &viewMatrix,
+                                     const MTL_FLOAT3X3 &cameraIntrinsics) {
+    const MTL_FLOAT4 *v = viewMatrix.columns;
+    const MTL_FLOAT3 *k = cameraIntrinsics.columns;
+    MTL_FLOAT2 pixel = {};
+    // viewMatrix * float4(worldPoint, 1); w is not used
+    float clipX = ((v[0].x * worldPoint.x + v[1].x * worldPoint.y) + v[2].x * worldPoint.z) + v[3].x;
+    float clipY = ((v[0].y * worldPoint.x + v[1].y * worldPoint.y) + v[2].y * worldPoint.z) + v[3].y;
+    float clipZ = ((v[0].z * worldPoint.x + v[1].z * worldPoint.y) + v[2].z * worldPoint.z) + v[3].z;
+    if (clipZ > 0) {
+        pixel.x = -1.0f;
+        pixel.y = -1.0f;
+        return pixel;
+    }
+    float ndcX = clipX / (-clipZ);
+    float ndcY = -clipY / (-clipZ);
+    // cameraIntrinsics * float3(ndc, 1)
+    float imageX = (k[0].x * ndcX + k[1].x * ndcY) + k[2].x;
+    float imageY = (k[0].y * ndcX + k[1].y * ndcY) + k[2].y;
+    float imageZ = (k[0].z * ndcX + k[1].z * ndcY) + k[2].z;
+    pixel.x = imageX / imageZ;
+    pixel.y = imageY / imageZ;
+    return pixel;
+}
+
+/// The cell of restructureWorldPointsToGrid for a point, or noCell
+static inline uint32_t gridCellOfPoint (const MTL_FLOAT3 &point, const WorldPointsGridParams &params) {
+    MTL_FLOAT2 pixel = unprojectWorldToPixelCPU(point, params.viewMatrix, params.cameraIntrinsics);
+    if (!std::isfinite(pixel.x) || !std::isfinite(pixel.y)) {
+        return noCell;
+    }
+    uint32_t gridX = toUintSaturating(std::floor(pixel.x));
+    uint32_t gridY = toUintSaturating(std::floor(pixel.y));
+    if (gridX >= params.imageSize.x || gridY >= params.imageSize.y) {
+        return noCell;
+    }
+    return gridY * params.imageSize.x + gridX;
+}
+
+void restructureWorldPointsToGridCPU (const WorldPoint *points, size_t pointCount, const WorldPointsGridParams &params,
+                                      WorldPointsGridCell *grid, unsigned threads) {
+    memset(grid, 0, size_t(params.imageSize.x) * params.imageSize.y * sizeof(WorldPointsGridCell));
+    // The projections are the work, and are done in parallel. The cells are then written in the order of the points,
+    // so that the point that wins a cell is the same on every run.
+    std::vector<uint32_t> cells(pointCount);
+    size_t bandCount = (pointCount + restructureBandPoints - 1) / restructureBandPoints;
+    parallelForBands(threads, bandCount, [&] (size_t band, unsigned) {
+        size_t first = band * restructureBandPoints;
+        size_t last = std::min(first + restructureBandPoints, pointCount);
+        for (size_t i = first; i < last; i++) {
+            cells[i] = gridCellOfPoint(points[i].p, params);
+        }
+    });
+    for (size_t i = 0; i < pointCount; i++) {
+        if (cells[i] == noCell) {
+            continue;
+        }
+        grid[cells[i]].worldPoint = points[i];
+        grid[cells[i]].isValid = true;
+    }
+}
+
+void placeWorldPointsRow (const WorldPointsRow &row, WorldPointsGridCell *rowCells) {
+    for (size_t i = 0; i < row.count; i++) {
+        WorldPointsGridCell &cell = rowCells[uint32_t(row.pixelX[i])];
+        cell.worldPoint.p.x = row.worldX[i];
+        cell.worldPoint.p.y = row.worldY[i];
+        cell.worldPoint.p.z = row.worldZ[i];
+        cell.isValid = true;
+    }
+}
+
+uint32_t reprojectWorldPointsRow (const WorldPointsRow &row, uint32_t y, const WorldPointsGridParams &params,
+                                  uint32_t firstRow, uint32_t rowCount, WorldPointsGridCell *cells) {
+    const uint32_t width = params.imageSize.x;
+    uint32_t maxShift = 0;
+    for (size_t i = 0; i < row.count; i++) {
+        MTL_FLOAT3 point = { row.worldX[i], row.worldY[i], row.worldZ[i] };
+        uint32_t cell = gridCellOfPoint(point, params);
+        if (cell == noCell) {
+            continue;
+        }
+        uint32_t cellRow = cell / width;
+        maxShift = std::max(maxShift, cellRow > y ? cellRow - y : y - cellRow);
+        if (cellRow < firstRow || cellRow - firstRow >= rowCount) {
+            continue;
+        }
+        WorldPointsGridCell &gridCell = cells[size_t(cellRow - firstRow) * width + cell % width];
+        gridCell.worldPoint.p = point;
+        gridCell.isValid = true;
+    }
+    return maxShift;
+}
+
+size_t computeWorldPointsGridCPU (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                                  WorldPointsGridCell *grid, unsigned threads) {
+    const uint32_t width = params.imageSize.x;
+    const uint32_t height = params.imageSize.y;
+    const uint32_t bandRows = WorldPointsCPUConfig().bandRows;
+    const size_t bandCount = (size_t(height) + bandRows - 1) / bandRows;
+    std::vector<WorldPointsRow> rows(resolveThreadCount(threads));
+    std::atomic<size_t> pointCount { 0 };
+    parallelForBands(threads, bandCount, [&] (size_t band, unsigned worker) {
+        WorldPointsRow &row = rows[worker];
+        if (row.pixelX.empty()) {
+            row.resize(width);
+        }
+        uint32_t firstRow = uint32_t(band) * bandRows;
+        uint32_t lastRow = std::min(firstRow + bandRows, height);
+        WorldPointsGridCell *bandCells = grid + size_t(firstRow) * width;
+        memset(bandCells, 0, size_t(lastRow - firstRow) * width * sizeof(WorldPointsGridCell));
+        size_t bandPointCount = 0;
+        for (uint32_t y = firstRow; y < lastRow; y++) {
+            WorldPointsGridCell *rowCells = grid + size_t(y) * width;
+            bandPointCount += projectWorldPointsRow(images, targetValue, params, y, row);
+            placeWorldPointsRow(row, rowCells);
+        }
+        pointCount.fetch_add(bandPointCount, std::memory_order_relaxed);
+    });
+    return pointCount.load();
+}
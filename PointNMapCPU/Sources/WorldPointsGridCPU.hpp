@@ -0,0 +1,60 @@
+//
+//  WorldPointsGridCPU.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef WorldPointsGridCPU_hpp
+#define WorldPointsGridCPU_hpp
+#include <cstddef>
+#include <cstdint>
+#include "ShaderTypes.h"
+#include "WorldPointsCPU.hpp"
+
+/**
+    Grids of world points on the CPU, in place of restructureWorldPointsToGrid in WorldPoints.metal.
+    A grid has a cell per pixel of the image, in rows from the top, and cells without a point are zero.
+ */
+
+/// unprojectWorldToPixel of WorldPoints.metal, which gives (-1, -1) for points behind the camera
+MTL_FLOAT2 unprojectWorldToPixelCPU (const MTL_FLOAT3 &worldPoint, const MTL_FLOAT4X4 &viewMatrix,
+                                     const MTL_FLOAT3X3 &cameraIntrinsics);
+
+/**
+    Places every point in the cell of the pixel it projects to, like restructureWorldPointsToGrid.
+    Points that land in the same cell are resolved in the order of the list, the last one winning; on the GPU, any one wins.
+    Like on the GPU, where uint(-1) saturates to 0, points behind the camera land in the first cell.
+ */
+void restructureWorldPointsToGridCPU (const WorldPoint *points, size_t pointCount, const WorldPointsGridParams &params,
+                                      WorldPointsGridCell *grid, unsigned threads = 0);
+
+/// Writes the points of a row, from projectWorldPointsRow, to the cells of the pixels they come from
+void placeWorldPointsRow (const WorldPointsRow &row, WorldPointsGridCell *rowCells);
+
+/**
+    Writes the points of row y, from projectWorldPointsRow, to the cells they project back to, like restructureWorldPointsToGridCPU,
+    in cells that hold rows [firstRow, firstRow + rowCount) of the grid. Points that land on other rows are left out.
+    Returns the most rows that a point of the row lands away from y.
+ */
+uint32_t reprojectWorldPointsRow (const WorldPointsRow &row, uint32_t y, const WorldPointsGridParams &params,
+                                  uint32_t firstRow, uint32_t rowCount, WorldPointsGridCell *cells);
+
+/// Where a pipeline that starts from the images places points in the grid
+enum class WorldPointsGridPlacement {
+    /// The cell they project back to with a WorldPointsGridParams, like restructureWorldPointsToGridCPU
+    Reprojected,
+    /// The cell of the pixel they come from, like computeWorldPointsGridCPU
+    SourcePixel
+};
+
+/**
+    The grid that restructuring aims for, built straight from the images: every point in the cell of the pixel it comes from.
+    Projecting a point back to its pixel can land a cell off, as the pixel coordinates come back a little below
+    or above the integers they started from, so this grid differs from the restructured one in those cells.
+    Returns the number of points.
+ */
+size_t computeWorldPointsGridCPU (const WorldPointsImages &images, uint8_t targetValue, const WorldPointsParams &params,
+                                  WorldPointsGridCell *grid, unsigned threads = 0);
+
+#endif /* WorldPointsGridCPU_hpp */
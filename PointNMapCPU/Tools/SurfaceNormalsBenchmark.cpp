@@ -0,0 +1,175 @@
+//
+//  SurfaceNormalsBenchmark.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ParallelBands.hpp"
+#include "SurfaceNormalsComparison.hpp"
+#include "SurfaceNormalsCPU.hpp"
+#include "SyntheticFrame.hpp"
+#include "WorldPointsCPU.hpp"
+#include "WorldPointsGridCPU.hpp"
+
+/**
+    Times the surface normals of a synthetic frame four ways, for every thread count up to the number of cores:
+    - staged, like the GPU pipeline: the list of points, the grid they are restructured into, then the normals of the grid
+    - fused: computeSurfaceNormalsFusedCPU, with no list and no grid of the full frame
+    - direct: the grid built from the pixels the points come from, then its normals
+    - pixel: computeSurfaceNormalsFusedCPU with WorldPointsGridPlacement::SourcePixel
+    Checks that the fused normals are those of the staged path and the pixel normals those of the direct path, bit for bit,
+    and reports how far the pixel normals are from the staged ones.
+
+    Usage: SurfaceNormalsBenchmark [width] [height] [iterations] [tileRows]
+ */
+typedef std::chrono::steady_clock Clock;
+
+template <typename Run>
+static double millisecondsPerRun (unsigned iterations, const Run &run) {
+    run();
+    Clock::time_point start = Clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+        run();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+}
+
+/**
+    How the normals of the staged path compare with those of the pixel path, which differ where projecting back moves points.
+ */
+struct NormalsAgreement {
+    size_t both = 0;
+    size_t identical = 0;
+    size_t onlyStaged = 0;
+    size_t onlyPixel = 0;
+    double maxAngleDegrees = 0.0;
+};
+
+static NormalsAgreement compareNormals (const std::vector<SurfaceNormalsForPointsGridCell> &staged,
+                                        const std::vector<SurfaceNormalsForPointsGridCell> &pixel) {
+    NormalsAgreement agreement;
+    for (size_t i = 0; i < staged.size(); i++) {
+        if (!staged[i].isValid || !pixel[i].isValid) {
+            agreement.onlyStaged += staged[i].isValid && !pixel[i].isValid;
+            agreement.onlyPixel += pixel[i].isValid && !staged[i].isValid;
+            continue;
+        }
+        agreement.both++;
+        agreement.identical += sameNormalCell(staged[i], pixel[i]);
+        const MTL_FLOAT3 &a = staged[i].surfaceNormal;
+        const MTL_FLOAT3 &b = pixel[i].surfaceNormal;
+        double cosine = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+        double angle = std::acos(std::min(std::max(cosine, -1.0), 1.0)) * 180.0 / M_PI;
+        agreement.maxAngleDegrees = std::max(agreement.maxAngleDegrees, angle);
+    }
+    return agreement;
+}
+
+int main (int argc, char **argv) {
+    uint32_t width = argc > 1 ? uint32_t(atoi(argv[1])) : 1920;
+    uint32_t height = argc > 2 ? uint32_t(atoi(argv[2])) : 1440;
+    unsigned iterations = argc > 3 ? unsigned(atoi(argv[3])) : 5;
+    uint32_t tileRows = argc > 4 ? uint32_t(atoi(argv[4])) : SurfaceNormalsCPUConfig().tileRows;
+    if (width == 0 || height == 0 || iterations == 0) {
+        fprintf(stderr, "Usage: %s [width] [height] [iterations] [tileRows]\n", argv[0]);
+        return 2;
+    }
+
+    SyntheticFrame frame(width, height);
+    WorldPointsImages images = frame.images();
+    WorldPointsGridParams gridParams = frame.gridParams();
+    SurfaceNormalsForPointsGridParams normalsParams = frame.surfaceNormalsParams();
+    size_t pixelCount = size_t(width) * height;
+    uint32_t halo = surfaceNormalsHaloRows(normalsParams, height);
+    std::vector<WorldPoint> points(pixelCount);
+    std::vector<WorldPointsGridCell> stagedGrid(pixelCount);
+    std::vector<WorldPointsGridCell> directGrid(pixelCount);
+    std::vector<SurfaceNormalsForPointsGridCell> stagedNormals(pixelCount);
+    std::vector<SurfaceNormalsForPointsGridCell> directNormals(pixelCount);
+    std::vector<SurfaceNormalsForPointsGridCell> fusedNormals(pixelCount);
+    std::vector<SurfaceNormalsForPointsGridCell> pixelNormals(pixelCount);
+
+    bool allMatch = true;
+    unsigned cores = resolveThreadCount(0);
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, cores)) {
+        WorldPointsCPUConfig pointsConfig;
+        pointsConfig.threads = threads;
+        pointsConfig.order = WorldPointsOrder::Raster;
+        SurfaceNormalsCPUConfig config;
+        config.threads = threads;
+        config.tileRows = tileRows;
+        SurfaceNormalsCPUConfig pixelConfig = config;
+        pixelConfig.placement = WorldPointsGridPlacement::SourcePixel;
+
+        size_t pointCount = 0;
+        size_t stagedCount = 0;
+        size_t directCount = 0;
+        size_t fusedCount = 0;
+        size_t pixelNormalsCount = 0;
+        double pointsMs = millisecondsPerRun(iterations, [&] {
+            pointCount = computeWorldPointsCPU(images, SyntheticFrame::targetValue, frame.params, points.data(),
+                                               nullptr, pointsConfig);
+        });
+        double restructureMs = millisecondsPerRun(iterations, [&] {
+            restructureWorldPointsToGridCPU(points.data(), pointCount, gridParams, stagedGrid.data(), threads);
+        });
+        double stagedNormalsMs = millisecondsPerRun(iterations, [&] {
+            stagedCount = computeSurfaceNormalsCPU(stagedGrid.data(), width, height, normalsParams, stagedNormals.data(), config);
+        });
+        double directGridMs = millisecondsPerRun(iterations, [&] {
+            computeWorldPointsGridCPU(images, SyntheticFrame::targetValue, frame.params, directGrid.data(), threads);
+        });
+        double directNormalsMs = millisecondsPerRun(iterations, [&] {
+            directCount = computeSurfaceNormalsCPU(directGrid.data(), width, height, normalsParams, directNormals.data(), config);
+        });
+        double fusedMs = millisecondsPerRun(iterations, [&] {
+            fusedCount = computeSurfaceNormalsFusedCPU(images, SyntheticFrame::targetValue, frame.params, gridParams,
+                                                       normalsParams, fusedNormals.data(), config);
+        });
+        double pixelMs = millisecondsPerRun(iterations, [&] {
+            pixelNormalsCount = computeSurfaceNormalsFusedCPU(images, SyntheticFrame::targetValue, frame.params, gridParams,
+                                                        normalsParams, pixelNormals.data(), pixelConfig);
+        });
+
+        bool fusedMatches = fusedCount == stagedCount && sameNormalGrids(fusedNormals.data(), stagedNormals.data(), pixelCount);
+        bool pixelMatches = pixelNormalsCount == directCount && sameNormalGrids(pixelNormals.data(), directNormals.data(), pixelCount);
+        allMatch = allMatch && fusedMatches && pixelMatches;
+        NormalsAgreement agreement = compareNormals(stagedNormals, pixelNormals);
+        // Cells that projecting back fills differently from the pixels the points come from
+        size_t movedCells = 0;
+        for (size_t i = 0; i < pixelCount; i++) {
+            movedCells += stagedGrid[i].isValid != directGrid[i].isValid;
+        }
+
+        double stagedMs = pointsMs + restructureMs + stagedNormalsMs;
+        double directMs = directGridMs + directNormalsMs;
+        double stagedMB = double(pointCount * sizeof(WorldPoint) + pixelCount * sizeof(WorldPointsGridCell)) / 1e6;
+        double directMB = double(pixelCount * sizeof(WorldPointsGridCell)) / 1e6;
+        double fusedMB = double(std::min(threads, unsigned((height + tileRows - 1) / tileRows))) *
+            std::min<double>(tileRows + 2.0 * halo, height) * width * sizeof(WorldPointsGridCell) / 1e6;
+        printf("%ux%u, %u thread%s, %zu points, tiles of %u rows with %u rows of halo, %u iterations\n",
+               width, height, threads, threads == 1 ? "" : "s", pointCount, tileRows, halo, iterations);
+        printf("  %-8s %10s %10s %8s %16s  %s\n", "path", "ms/frame", "normals", "speedup", "intermediate MB", "stages");
+        printf("  %-8s %10.3f %10zu %8.2f %16.1f  points %.3f, restructure %.3f, normals %.3f\n", "staged",
+               stagedMs, stagedCount, 1.0, stagedMB, pointsMs, restructureMs, stagedNormalsMs);
+        printf("  %-8s %10.3f %10zu %8.2f %16.1f  %s\n", "fused",
+               fusedMs, fusedCount, stagedMs / fusedMs, fusedMB, fusedMatches ? "bit-exact with staged" : "MISMATCH with staged");
+        printf("  %-8s %10.3f %10zu %8.2f %16.1f  grid %.3f, normals %.3f\n", "direct",
+               directMs, directCount, stagedMs / directMs, directMB, directGridMs, directNormalsMs);
+        printf("  %-8s %10.3f %10zu %8.2f %16.1f  %s\n", "pixel",
+               pixelMs, pixelNormalsCount, stagedMs / pixelMs, fusedMB, pixelMatches ? "bit-exact with direct" : "MISMATCH with direct");
+        printf("  staged grid: %zu cells filled differently from the direct grid by projecting points back\n", movedCells);
+        printf("  staged against pixel: %zu cells with both, %zu identical, %zu only staged, %zu only pixel, max angle %.3f degrees\n",
+               agreement.both, agreement.identical, agreement.onlyStaged, agreement.onlyPixel, agreement.maxAngleDegrees);
+        if (threads == cores) {
+            break;
+        }
+    }
+    return allMatch ? 0 : 1;
+}
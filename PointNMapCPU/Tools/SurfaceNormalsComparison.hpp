@@ -0,0 +1,38 @@
+//
+//  SurfaceNormalsComparison.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef SurfaceNormalsComparison_hpp
+#define SurfaceNormalsComparison_hpp
+#include <cmath>
+#include <cstring>
+#include "ShaderTypes.h"
+
+/// Whether two floats have the same bits. NaNs are all the same, as IEEE leaves the sign and payload of results open.
+static inline bool sameFloatBits (float a, float b) {
+    return memcmp(&a, &b, sizeof(float)) == 0 || (std::isnan(a) && std::isnan(b));
+}
+
+/// Whether two cells are the same, bit for bit, leaving out the padding of the vectors
+static inline bool sameNormalCell (const SurfaceNormalsForPointsGridCell &a, const SurfaceNormalsForPointsGridCell &b) {
+    return a.isValid == b.isValid &&
+        sameFloatBits(a.worldPoint.p.x, b.worldPoint.p.x) && sameFloatBits(a.worldPoint.p.y, b.worldPoint.p.y) &&
+        sameFloatBits(a.worldPoint.p.z, b.worldPoint.p.z) && sameFloatBits(a.surfaceNormal.x, b.surfaceNormal.x) &&
+        sameFloatBits(a.surfaceNormal.y, b.surfaceNormal.y) && sameFloatBits(a.surfaceNormal.z, b.surfaceNormal.z);
+}
+
+/// Whether two grids of count cells are the same, bit for bit
+static inline bool sameNormalGrids (const SurfaceNormalsForPointsGridCell *a, const SurfaceNormalsForPointsGridCell *b,
+                                    size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (!sameNormalCell(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif /* SurfaceNormalsComparison_hpp */
@@ -0,0 +1,86 @@
+//
+//  SurfaceNormalsSIMDBenchmark.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ParallelBands.hpp"
+#include "SurfaceNormalsComparison.hpp"
+#include "SurfaceNormalsCPU.hpp"
+#include "SurfaceNormalsSIMD.hpp"
+#include "SyntheticFrame.hpp"
+#include "WorldPointsGridCPU.hpp"
+
+/**
+    Times computeSurfaceNormalsSIMD against the scalar computeSurfaceNormalsCPU, on the grid of a synthetic frame,
+    for walks of several lengths. Checks that both give the same normals bit for bit.
+
+    Usage: SurfaceNormalsSIMDBenchmark [width] [height] [iterations] [threads]
+ */
+typedef std::chrono::steady_clock Clock;
+
+template <typename Run>
+static double millisecondsPerRun (unsigned iterations, const Run &run) {
+    run();
+    Clock::time_point start = Clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+        run();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+}
+
+int main (int argc, char **argv) {
+    uint32_t width = argc > 1 ? uint32_t(atoi(argv[1])) : 1920;
+    uint32_t height = argc > 2 ? uint32_t(atoi(argv[2])) : 1440;
+    unsigned iterations = argc > 3 ? unsigned(atoi(argv[3])) : 3;
+    unsigned threads = argc > 4 ? unsigned(atoi(argv[4])) : 1;
+    if (width == 0 || height == 0 || iterations == 0) {
+        fprintf(stderr, "Usage: %s [width] [height] [iterations] [threads]\n", argv[0]);
+        return 2;
+    }
+
+    SyntheticFrame frame(width, height);
+    size_t pixelCount = size_t(width) * height;
+    std::vector<WorldPointsGridCell> grid(pixelCount);
+    size_t pointCount = computeWorldPointsGridCPU(frame.images(), SyntheticFrame::targetValue, frame.params, grid.data(), threads);
+    WorldPointsGridSoA gridSoA;
+    double soaMs = millisecondsPerRun(iterations, [&] {
+        gridSoA.assign(grid.data(), width, height, threads);
+    });
+    std::vector<SurfaceNormalsForPointsGridCell> reference(pixelCount);
+    std::vector<SurfaceNormalsForPointsGridCell> normals(pixelCount);
+    SurfaceNormalsCPUConfig config;
+    config.threads = threads;
+
+    printf("%ux%u, %zu points, %u thread%s, %u lanes, %u iterations, %.3f ms to copy the grid to separate arrays\n",
+           width, height, pointCount, resolveThreadCount(threads), resolveThreadCount(threads) == 1 ? "" : "s",
+           surfaceNormalsLanes, iterations, soaMs);
+    printf("%8s %10s %10s %10s %10s %10s %8s  %s\n", "maxStep", "normals", "tables ms", "scalar ms", "simd ms",
+           "Mpx/s", "speedup", "check");
+    bool allMatch = true;
+    for (uint32_t maxStep : { 4u, 6u, 10u, 16u, 24u, 32u }) {
+        SurfaceNormalsForPointsGridParams params = frame.surfaceNormalsParams(maxStep);
+        size_t referenceCount = 0;
+        size_t count = 0;
+        double scalarMs = millisecondsPerRun(iterations, [&] {
+            referenceCount = computeSurfaceNormalsCPU(grid.data(), width, height, params, reference.data(), config);
+        });
+        double tablesMs = millisecondsPerRun(iterations, [&] {
+            SurfaceNormalsWalkTables tables(params, width, height);
+        });
+        SurfaceNormalsWalkTables tables(params, width, height);
+        double simdMs = millisecondsPerRun(iterations, [&] {
+            count = computeSurfaceNormalsSIMD(gridSoA, tables, params, normals.data(), config);
+        });
+        bool matches = count == referenceCount && sameNormalGrids(reference.data(), normals.data(), pixelCount);
+        allMatch = allMatch && matches;
+        printf("%8u %10zu %10.3f %10.3f %10.3f %10.1f %8.2f  %s\n", maxStep, count, tablesMs, scalarMs, simdMs,
+               pixelCount / simdMs / 1e3, scalarMs / simdMs, matches ? "bit-exact" : "MISMATCH");
+    }
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+//
+//  SyntheticFrame.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef SyntheticFrame_hpp
+#define SyntheticFrame_hpp
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "ShaderTypes.h"
+#include "WorldPointsCPU.hpp"
+
+/**
+    A frame for benchmarks: blobs of labels over a sloped floor of depth, seen by a camera with the intrinsics of an iPhone,
+    scaled to the size of the frame. A few depths are 0, out of range or not a number, to exercise every branch of the kernel.
+ */
+struct SyntheticFrame {
+    static const uint8_t targetValue = 3;
+
+    WorldPointsParams params = {};
+    std::vector<uint8_t> segmentation;
+    std::vector<float> depth;
+
+    SyntheticFrame (uint32_t width, uint32_t height) : segmentation(size_t(width) * height), depth(size_t(width) * height) {
+        uint32_t state = 0x9e3779b9u;
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                state = state * 1664525u + 1013904223u;
+                size_t i = size_t(y) * width + x;
+                // Soft blobs of the target label, with noise at their edges
+                float blob = std::sin(float(x) * 0.013f) * std::cos(float(y) * 0.017f);
+                segmentation[i] = blob + float(state >> 24) / 1024.0f > 0.1f ? targetValue : uint8_t((state >> 8) % 8);
+                depth[i] = 0.4f + 5.0f * float(height - y) / float(height) + float(state >> 20) / 65536.0f;
+                switch (state >> 29) {
+                case 0:
+                    depth[i] = (state & 0x100) ? 0.0f : 7.5f;
+                    break;
+                case 1:
+                    if ((state & 0xff) == 0) {
+                        depth[i] = NAN;
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        float scale = float(width) / 1920.0f;
+        float focal = 1450.0f * scale;
+        params.imageSize.x = width;
+        params.imageSize.y = height;
+        params.minDepthThreshold = 0.0f;
+        params.maxDepthThreshold = 5.0f;
+        // Inverse of [f 0 cx; 0 f cy; 0 0 1], by column
+        params.invIntrinsics.columns[0].x = 1.0f / focal;
+        params.invIntrinsics.columns[1].y = 1.0f / focal;
+        params.invIntrinsics.columns[2].x = -(float(width) * 0.5f) / focal;
+        params.invIntrinsics.columns[2].y = -(float(height) * 0.5f) / focal;
+        params.invIntrinsics.columns[2].z = 1.0f;
+        // Turned about the vertical axis and raised, like a phone held at chest height
+        float angle = 0.3f;
+        params.cameraTransform.columns[0].x = std::cos(angle);
+        params.cameraTransform.columns[0].z = -std::sin(angle);
+        params.cameraTransform.columns[1].y = 1.0f;
+        params.cameraTransform.columns[2].x = std::sin(angle);
+        params.cameraTransform.columns[2].z = std::cos(angle);
+        params.cameraTransform.columns[3].x = 0.25f;
+        params.cameraTransform.columns[3].y = 1.4f;
+        params.cameraTransform.columns[3].z = -2.0f;
+        params.cameraTransform.columns[3].w = 1.0f;
+    }
+
+    /// The parameters that project the points of the frame back to its pixels: the inverses of the camera transform and intrinsics
+    WorldPointsGridParams gridParams () const {
+        WorldPointsGridParams grid = {};
+        grid.imageSize = params.imageSize;
+        // The camera transform is a rotation and a translation, so its inverse is the transposed rotation and the rotated translation
+        const MTL_FLOAT4 *t = params.cameraTransform.columns;
+        MTL_FLOAT4 *v = grid.viewMatrix.columns;
+        v[0].x = t[0].x; v[0].y = t[1].x; v[0].z = t[2].x;
+        v[1].x = t[0].y; v[1].y = t[1].y; v[1].z = t[2].y;
+        v[2].x = t[0].z; v[2].y = t[1].z; v[2].z = t[2].z;
+        v[3].x = -(t[0].x * t[3].x + t[0].y * t[3].y + t[0].z * t[3].z);
+        v[3].y = -(t[1].x * t[3].x + t[1].y * t[3].y + t[1].z * t[3].z);
+        v[3].z = -(t[2].x * t[3].x + t[2].y * t[3].y + t[2].z * t[3].z);
+        v[3].w = 1.0f;
+        float focal = 1.0f / params.invIntrinsics.columns[0].x;
+        grid.cameraIntrinsics.columns[0].x = focal;
+        grid.cameraIntrinsics.columns[1].y = focal;
+        grid.cameraIntrinsics.columns[2].x = float(params.imageSize.x) * 0.5f;
+        grid.cameraIntrinsics.columns[2].y = float(params.imageSize.y) * 0.5f;
+        grid.cameraIntrinsics.columns[2].z = 1.0f;
+        return grid;
+    }
+
+    /// Walks like those of SurfaceNormalsProcessor for a floor that recedes up the frame, with the defaults of its steps
+    SurfaceNormalsForPointsGridParams surfaceNormalsParams (uint32_t maxStep = 10) const {
+        SurfaceNormalsForPointsGridParams normals = {};
+        normals.minStep = 4;
+        normals.maxStep = maxStep;
+        normals.eps = 1e-5f;
+        normals.normalVector.y = 1.0f;
+        // Steps of makeStep, with the larger component at 1
+        normals.stepL.x = 0.2f;
+        normals.stepL.y = -1.0f;
+        normals.stepT.x = 1.0f;
+        normals.stepT.y = 0.1f;
+        return normals;
+    }
+
+    WorldPointsImages images () const {
+        WorldPointsImages images;
+        images.segmentation = segmentation.data();
+        images.segmentationBytesPerRow = params.imageSize.x;
+        images.depth = depth.data();
+        images.depthBytesPerRow = size_t(params.imageSize.x) * sizeof(float);
+        return images;
+    }
+};
+
+#endif /* SyntheticFrame_hpp */
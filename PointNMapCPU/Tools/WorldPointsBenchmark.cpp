@@ -0,0 +1,94 @@
+//
+//  WorldPointsBenchmark.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ParallelBands.hpp"
+#include "SyntheticFrame.hpp"
+#include "WorldPointsComparison.hpp"
+#include "WorldPointsCPU.hpp"
+
+/**
+    Times computeWorldPointsCPU on a synthetic frame, against the one-pixel-at-a-time reference,
+    for every thread count up to the number of cores, and in both orders.
+    Checks that every run gives the points of the reference bit for bit, and in raster order, in the same order.
+
+    Usage: WorldPointsBenchmark [width] [height] [iterations] [bandRows]
+ */
+typedef std::chrono::steady_clock Clock;
+
+template <typename Run>
+static double millisecondsPerRun (unsigned iterations, const Run &run) {
+    run();
+    Clock::time_point start = Clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+        run();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+}
+
+int main (int argc, char **argv) {
+    uint32_t width = argc > 1 ? uint32_t(atoi(argv[1])) : 1920;
+    uint32_t height = argc > 2 ? uint32_t(atoi(argv[2])) : 1440;
+    unsigned iterations = argc > 3 ? unsigned(atoi(argv[3])) : 20;
+    uint32_t bandRows = argc > 4 ? uint32_t(atoi(argv[4])) : WorldPointsCPUConfig().bandRows;
+    if (width == 0 || height == 0 || iterations == 0) {
+        fprintf(stderr, "Usage: %s [width] [height] [iterations] [bandRows]\n", argv[0]);
+        return 2;
+    }
+
+    SyntheticFrame frame(width, height);
+    WorldPointsImages images = frame.images();
+    size_t pixelCount = size_t(width) * height;
+    std::vector<WorldPoint> reference(pixelCount);
+    std::vector<WorldPoint> points(pixelCount);
+    uint32_t referenceCounts[WorldPointsDebugSlotCount];
+    uint32_t counts[WorldPointsDebugSlotCount];
+
+    size_t referenceCount = 0;
+    double referenceMs = millisecondsPerRun(iterations, [&] {
+        referenceCount = computeWorldPointsReference(images, SyntheticFrame::targetValue, frame.params,
+                                                     reference.data(), referenceCounts);
+    });
+    printf("%ux%u, %zu points, %u iterations\n", width, height, referenceCount, iterations);
+    printf("%-20s %10s %10s %8s  %s\n", "engine", "ms/frame", "Mpx/s", "speedup", "check");
+    printf("%-20s %10.3f %10.1f %8.2f  %s\n", "reference", referenceMs, pixelCount / referenceMs / 1e3, 1.0, "-");
+
+    bool allMatch = true;
+    unsigned cores = resolveThreadCount(0);
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, cores)) {
+        for (WorldPointsOrder order : { WorldPointsOrder::Any, WorldPointsOrder::Raster }) {
+            WorldPointsCPUConfig config;
+            config.threads = threads;
+            config.bandRows = bandRows;
+            config.order = order;
+            size_t count = 0;
+            double ms = millisecondsPerRun(iterations, [&] {
+                count = computeWorldPointsCPU(images, SyntheticFrame::targetValue, frame.params, points.data(), counts, config);
+            });
+            WorldPointsComparison comparison = compareWorldPoints(reference.data(), referenceCount, points.data(), count, 0);
+            bool matches = comparison.matches() && memcmp(counts, referenceCounts, sizeof(counts)) == 0;
+            if (order == WorldPointsOrder::Raster) {
+                for (size_t i = 0; matches && i < count; i++) {
+                    matches = pointUlpDistance(reference[i], points[i]) == 0;
+                }
+            }
+            allMatch = allMatch && matches;
+            char name[32];
+            snprintf(name, sizeof(name), "%u thread%s, %s", threads, threads == 1 ? "" : "s",
+                     order == WorldPointsOrder::Raster ? "raster" : "any");
+            printf("%-20s %10.3f %10.1f %8.2f  %s\n", name, ms, pixelCount / ms / 1e3, referenceMs / ms,
+                   !matches ? "MISMATCH" : order == WorldPointsOrder::Raster ? "bit-exact, in order" : "bit-exact");
+        }
+        if (threads == cores) {
+            break;
+        }
+    }
+    return allMatch ? 0 : 1;
+}
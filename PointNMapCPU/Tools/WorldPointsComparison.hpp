@@ -0,0 +1,169 @@
+//
+//  WorldPointsComparison.hpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#ifndef WorldPointsComparison_hpp
+#define WorldPointsComparison_hpp
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "ShaderTypes.h"
+
+/**
+    How closely two lists of points match, regardless of their order, since both the GPU and the engine append in any order.
+ */
+struct WorldPointsComparison {
+    /// Points that match to the last bit
+    size_t exact = 0;
+    /// Points that match within the tolerance, but not to the last bit
+    size_t close = 0;
+    /// Points of either list without a match in the other
+    size_t unmatchedExpected = 0;
+    size_t unmatchedActual = 0;
+    /// Largest difference of a coordinate of the matched points, in units in the last place
+    uint32_t maxUlp = 0;
+
+    bool matches () const {
+        return unmatchedExpected == 0 && unmatchedActual == 0;
+    }
+};
+
+/// Bits of a float, ordered like the floats, so that the distance between two of them counts the floats in between
+static inline int64_t orderedFloatBits (float value) {
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? int64_t(INT32_MIN) - bits : bits;
+}
+
+static inline uint32_t ulpDistance (float a, float b) {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b) ? 0 : UINT32_MAX;
+    }
+    int64_t distance = orderedFloatBits(a) - orderedFloatBits(b);
+    return uint32_t(std::min<int64_t>(distance < 0 ? -distance : distance, UINT32_MAX));
+}
+
+static inline uint32_t pointUlpDistance (const WorldPoint &a, const WorldPoint &b) {
+    return std::max(ulpDistance(a.p.x, b.p.x), std::max(ulpDistance(a.p.y, b.p.y), ulpDistance(a.p.z, b.p.z)));
+}
+
+/// Whether every coordinate of two points is within maxUlp, or within maxAbsolute for coordinates near 0, where few bits are left
+static inline bool pointWithin (const WorldPoint &a, const WorldPoint &b, uint32_t maxUlp, float maxAbsolute) {
+    auto within = [maxUlp, maxAbsolute] (float x, float y) {
+        return ulpDistance(x, y) <= maxUlp || std::fabs(x - y) <= maxAbsolute;
+    };
+    return within(a.p.x, b.p.x) && within(a.p.y, b.p.y) && within(a.p.z, b.p.z);
+}
+
+/**
+    Pairs every point of one list with an equal point of the other, or failing that, with the closest point within the tolerance.
+    Points that are not equal are looked up in a grid of millimeter cells, which is far coarser than the tolerance.
+ */
+static WorldPointsComparison compareWorldPoints (const WorldPoint *expected, size_t expectedCount,
+                                                 const WorldPoint *actual, size_t actualCount,
+                                                 uint32_t maxUlp, float maxAbsolute = 0.0f) {
+    struct Key {
+        uint32_t bits[3];
+        size_t index;
+        bool operator< (const Key &other) const {
+            return memcmp(bits, other.bits, sizeof(bits)) < 0;
+        }
+    };
+    auto makeKeys = [] (const WorldPoint *points, size_t count) {
+        std::vector<Key> keys(count);
+        for (size_t i = 0; i < count; i++) {
+            memcpy(&keys[i].bits[0], &points[i].p.x, 4);
+            memcpy(&keys[i].bits[1], &points[i].p.y, 4);
+            memcpy(&keys[i].bits[2], &points[i].p.z, 4);
+            keys[i].index = i;
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    };
+    std::vector<Key> expectedKeys = makeKeys(expected, expectedCount);
+    std::vector<Key> actualKeys = makeKeys(actual, actualCount);
+
+    WorldPointsComparison comparison;
+    std::vector<size_t> expectedLeft;
+    std::vector<size_t> actualLeft;
+    size_t e = 0;
+    size_t a = 0;
+    while (e < expectedKeys.size() && a < actualKeys.size()) {
+        if (expectedKeys[e] < actualKeys[a]) {
+            expectedLeft.push_back(expectedKeys[e++].index);
+        } else if (actualKeys[a] < expectedKeys[e]) {
+            actualLeft.push_back(actualKeys[a++].index);
+        } else {
+            comparison.exact++;
+            e++;
+            a++;
+        }
+    }
+    for (; e < expectedKeys.size(); e++) {
+        expectedLeft.push_back(expectedKeys[e].index);
+    }
+    for (; a < actualKeys.size(); a++) {
+        actualLeft.push_back(actualKeys[a].index);
+    }
+
+    const float cellSize = 1e-3f;
+    auto cellOf = [cellSize] (float coordinate) {
+        float cell = std::floor(coordinate / cellSize);
+        // Points that are not finite share a cell of their own, away from the neighbors of any other
+        return std::isfinite(cell) ? int32_t(std::max(std::min(cell, 1e9f), -1e9f)) : int32_t(2000000000);
+    };
+    auto cellKey = [] (int32_t x, int32_t y, int32_t z) {
+        return (uint64_t(uint32_t(x)) * 0x9e3779b97f4a7c15ull) ^ (uint64_t(uint32_t(y)) * 0xc2b2ae3d27d4eb4full) ^ uint64_t(uint32_t(z));
+    };
+    std::unordered_map<uint64_t, std::vector<size_t>> cells;
+    for (size_t index : expectedLeft) {
+        const MTL_FLOAT3 &p = expected[index].p;
+        cells[cellKey(cellOf(p.x), cellOf(p.y), cellOf(p.z))].push_back(index);
+    }
+    std::vector<bool> used(expectedCount, false);
+    for (size_t index : actualLeft) {
+        const MTL_FLOAT3 &p = actual[index].p;
+        int32_t cx = cellOf(p.x);
+        int32_t cy = cellOf(p.y);
+        int32_t cz = cellOf(p.z);
+        size_t best = SIZE_MAX;
+        uint32_t bestDistance = UINT32_MAX;
+        for (int32_t dz = -1; dz <= 1; dz++) {
+            for (int32_t dy = -1; dy <= 1; dy++) {
+                for (int32_t dx = -1; dx <= 1; dx++) {
+                    auto cell = cells.find(cellKey(cx + dx, cy + dy, cz + dz));
+                    if (cell == cells.end()) {
+                        continue;
+                    }
+                    for (size_t candidate : cell->second) {
+                        if (used[candidate] || !pointWithin(expected[candidate], actual[index], maxUlp, maxAbsolute)) {
+                            continue;
+                        }
+                        uint32_t distance = pointUlpDistance(expected[candidate], actual[index]);
+                        if (best == SIZE_MAX || distance < bestDistance) {
+                            best = candidate;
+                            bestDistance = distance;
+                        }
+                    }
+                }
+            }
+        }
+        if (best != SIZE_MAX) {
+            used[best] = true;
+            comparison.close++;
+            comparison.maxUlp = std::max(comparison.maxUlp, bestDistance);
+        } else {
+            comparison.unmatchedActual++;
+        }
+    }
+    comparison.unmatchedExpected = expectedLeft.size() - comparison.close;
+    return comparison;
+}
+
+#endif /* WorldPointsComparison_hpp */
@@ -0,0 +1,140 @@
+//
+//  WorldPointsCrossCheck.cpp
+//  PointNMapCPU
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "SyntheticFrame.hpp"
+#include "WorldPointsComparison.hpp"
+#include "WorldPointsCPU.hpp"
+#include "WorldPointsDump.hpp"
+
+/**
+    Checks computeWorldPointsCPU against dumps of computeWorldPoints recorded on the GPU,
+    with WorldPointsProcessor.getWorldPoints(referenceDumpURL:).
+
+    For every dump, the engine runs on the recorded textures and parameters, and must give the same debug counters
+    (other than outsideImage, which depends on the size of the dispatch) and the same points, in any order.
+    Points that are not equal to the last bit must be within --max-ulp, or within --max-absolute meters of a coordinate near 0.
+    The engine must also match the reference on the CPU bit for bit.
+
+    Usage: WorldPointsCrossCheck [--max-ulp N] [--max-absolute M] [--threads N] dump...
+           WorldPointsCrossCheck --synthesize path [width height]
+    --synthesize writes a dump with the points of the reference, to check the tool itself without a device.
+ */
+static const char *slotNames[WorldPointsDebugSlotCount] = {
+    "outsideImage", "unmatchedSegmentation", "belowDepthRange", "aboveDepthRange", "wrotePoint", "depthIsZero"
+};
+
+static const char *statusDescription (WorldPointsDumpStatus status) {
+    switch (status) {
+    case WorldPointsDumpStatus::Ok:
+        return "ok";
+    case WorldPointsDumpStatus::IoError:
+        return "could not be read";
+    case WorldPointsDumpStatus::Unsupported:
+        return "has another version or struct layout";
+    case WorldPointsDumpStatus::Corrupt:
+        return "is not a valid dump";
+    }
+    return "unknown";
+}
+
+static int synthesize (const char *path, uint32_t width, uint32_t height) {
+    SyntheticFrame frame(width, height);
+    WorldPointsDump dump;
+    dump.targetValue = SyntheticFrame::targetValue;
+    dump.params = frame.params;
+    dump.segmentation = frame.segmentation;
+    dump.depth = frame.depth;
+    dump.points.resize(size_t(width) * height);
+    dump.points.resize(computeWorldPointsReference(dump.images(), dump.targetValue, dump.params,
+                                                   dump.points.data(), dump.debugCounts));
+    WorldPointsDumpStatus status = writeWorldPointsDump(path, dump);
+    if (status != WorldPointsDumpStatus::Ok) {
+        fprintf(stderr, "%s: %s\n", path, statusDescription(status));
+        return 1;
+    }
+    printf("%s: %ux%u, %zu points\n", path, width, height, dump.points.size());
+    return 0;
+}
+
+static bool checkDump (const char *path, uint32_t maxUlp, float maxAbsolute, const WorldPointsCPUConfig &config) {
+    WorldPointsDump dump;
+    WorldPointsDumpStatus status = readWorldPointsDump(path, dump);
+    if (status != WorldPointsDumpStatus::Ok) {
+        printf("%s: FAIL, the file %s\n", path, statusDescription(status));
+        return false;
+    }
+    size_t pixelCount = dump.segmentation.size();
+    std::vector<WorldPoint> points(pixelCount);
+    std::vector<WorldPoint> reference(pixelCount);
+    uint32_t counts[WorldPointsDebugSlotCount];
+    uint32_t referenceCounts[WorldPointsDebugSlotCount];
+    WorldPointsImages images = dump.images();
+    size_t count = computeWorldPointsCPU(images, dump.targetValue, dump.params, points.data(), counts, config);
+    size_t referenceCount = computeWorldPointsReference(images, dump.targetValue, dump.params,
+                                                        reference.data(), referenceCounts);
+
+    bool passed = true;
+    printf("%s: %ux%u, target %u\n", path, dump.params.imageSize.x, dump.params.imageSize.y, dump.targetValue);
+    for (uint32_t slot = WorldPointsDebugUnmatchedSegmentation; slot < WorldPointsDebugSlotCount; slot++) {
+        if (counts[slot] != dump.debugCounts[slot]) {
+            printf("  %s: %u on the GPU, %u on the CPU\n", slotNames[slot], dump.debugCounts[slot], counts[slot]);
+            passed = false;
+        }
+    }
+    WorldPointsComparison gpu = compareWorldPoints(dump.points.data(), dump.points.size(), points.data(), count,
+                                                   maxUlp, maxAbsolute);
+    printf("  points: %zu on the GPU, %zu on the CPU; %zu bit-exact, %zu within tolerance (max %u ulp), "
+           "%zu and %zu unmatched\n", dump.points.size(), count, gpu.exact, gpu.close, gpu.maxUlp,
+           gpu.unmatchedExpected, gpu.unmatchedActual);
+    passed = passed && gpu.matches();
+
+    WorldPointsComparison cpu = compareWorldPoints(reference.data(), referenceCount, points.data(), count, 0);
+    if (!cpu.matches() || memcmp(counts, referenceCounts, sizeof(counts)) != 0) {
+        printf("  the engine does not match the reference on the CPU; check that it was built without fast math\n");
+        passed = false;
+    }
+    printf("  %s\n", passed ? "PASS" : "FAIL");
+    return passed;
+}
+
+int main (int argc, char **argv) {
+    uint32_t maxUlp = 4;
+    float maxAbsolute = 1e-6f;
+    WorldPointsCPUConfig config;
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--synthesize") == 0 && i + 1 < argc) {
+            uint32_t width = i + 3 < argc ? uint32_t(atoi(argv[i + 2])) : 256;
+            uint32_t height = i + 3 < argc ? uint32_t(atoi(argv[i + 3])) : 192;
+            return synthesize(argv[i + 1], width, height);
+        } else if (strcmp(argv[i], "--max-ulp") == 0 && i + 1 < argc) {
+            maxUlp = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--max-absolute") == 0 && i + 1 < argc) {
+            maxAbsolute = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = unsigned(strtoul(argv[++i], nullptr, 10));
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        fprintf(stderr, "Usage: %s [--max-ulp N] [--max-absolute M] [--threads N] dump...\n"
+                        "       %s --synthesize path [width height]\n", argv[0], argv[0]);
+        return 2;
+    }
+    size_t failed = 0;
+    for (const char *path : paths) {
+        failed += checkDump(path, maxUlp, maxAbsolute, config) ? 0 : 1;
+    }
+    printf("%zu of %zu dumps passed\n", paths.size() - failed, paths.size());
+    return failed == 0 ? 0 : 1;
+}
@@ -6,7 +6,9 @@
 //
 #pragma once
 
+#if defined(__METAL_VERSION__) || defined(__APPLE__)
 #include <simd/simd.h>
+#endif
 
 #ifdef __METAL_VERSION__
     #include <metal_stdlib>
@@ -16,10 +18,11 @@
     typedef uint               MTL_BOOL;      // use 0/1
     typedef float2             MTL_FLOAT2;
     typedef float3             MTL_FLOAT3;
+    typedef float4             MTL_FLOAT4;
     typedef float4x4           MTL_FLOAT4X4;
     typedef float3x3           MTL_FLOAT3X3;  // 48 bytes (3 cols, 16B aligned)
     typedef uint2              MTL_UINT2;
-#else
+#elif defined(__APPLE__)
     #include <simd/simd.h>
     #include <Metal/MTLTypes.h>
     typedef struct { float x; float y; float z; } packed_float3;
@@ -28,9 +31,24 @@
     typedef uint32_t           MTL_BOOL;      // 0/1
     typedef simd_float2        MTL_FLOAT2;
     typedef simd_float3        MTL_FLOAT3;
+    typedef simd_float4        MTL_FLOAT4;
     typedef simd_float4x4      MTL_FLOAT4X4;
     typedef simd_float3x3      MTL_FLOAT3X3;  // 48 bytes
     typedef simd_uint2         MTL_UINT2;
+#else
+    // Hosts without simd, such as the Linux tools of PointNMapCPU.
+    // Same size and alignment as the simd types, and the same member names (x, y, z, w, columns).
+    #include <stdint.h>
+    typedef struct { float x; float y; float z; } packed_float3;
+    typedef uint8_t            MTL_UINT8;     // 8-bit
+    typedef uint32_t           MTL_UINT;
+    typedef uint32_t           MTL_BOOL;      // 0/1
+    typedef struct __attribute__((aligned(8))) { float x; float y; } MTL_FLOAT2;
+    typedef struct __attribute__((aligned(16))) { float x; float y; float z; } MTL_FLOAT3;  // 16 bytes, like simd_float3
+    typedef struct __attribute__((aligned(16))) { float x; float y; float z; float w; } MTL_FLOAT4;
+    typedef struct { MTL_FLOAT4 columns[4]; } MTL_FLOAT4X4;
+    typedef struct { MTL_FLOAT3 columns[3]; } MTL_FLOAT3X3;  // 48 bytes
+    typedef struct __attribute__((aligned(8))) { uint32_t x; uint32_t y; } MTL_UINT2;
 #endif
 
 typedef struct RevertCenterCropParams {
@@ -210,3 +228,174 @@ typedef struct StdPolygonParams {
     MTL_FLOAT4X4    viewMatrix;
     MTL_FLOAT3X3    cameraIntrinsics;
 } StdPolygonParams;
+
+/**
+ Layouts of the types and structs, as the Metal compiler lays them out.
+ They are checked on every host, including the simd types of Apple platforms, so that a change to a struct,
+ or a host whose types differ, fails to compile instead of corrupting the buffers that are shared with the kernels.
+ Sizes include the padding at the end, which is what the stride of an array of the struct is.
+ */
+#ifndef __METAL_VERSION__
+    #include <stddef.h>
+    #ifdef __cplusplus
+        #define SHADER_TYPES_ASSERT(condition, message) static_assert(condition, message)
+        #define SHADER_TYPES_ALIGNOF(type) alignof(type)
+    #else
+        #define SHADER_TYPES_ASSERT(condition, message) _Static_assert(condition, message)
+        #define SHADER_TYPES_ALIGNOF(type) _Alignof(type)
+    #endif
+    #define SHADER_TYPES_LAYOUT(type, size, alignment) \
+        SHADER_TYPES_ASSERT(sizeof(type) == (size) && SHADER_TYPES_ALIGNOF(type) == (alignment), \
+                            #type " does not have the size and alignment of the Metal type")
+    #define SHADER_TYPES_OFFSET(type, field, offset) \
+        SHADER_TYPES_ASSERT(offsetof(type, field) == (offset), #type "." #field " is not at its offset in the Metal type")
+
+    SHADER_TYPES_LAYOUT(MTL_UINT2, 8, 8);
+    SHADER_TYPES_LAYOUT(MTL_FLOAT2, 8, 8);
+    SHADER_TYPES_LAYOUT(MTL_FLOAT3, 16, 16);
+    SHADER_TYPES_LAYOUT(MTL_FLOAT4, 16, 16);
+    SHADER_TYPES_LAYOUT(MTL_FLOAT3X3, 48, 16);
+    SHADER_TYPES_LAYOUT(MTL_FLOAT4X4, 64, 16);
+    SHADER_TYPES_LAYOUT(packed_float3, 12, 4);
+
+    SHADER_TYPES_LAYOUT(RevertCenterCropParams, 32, 8);
+    SHADER_TYPES_OFFSET(RevertCenterCropParams, srcWidth, 0);
+    SHADER_TYPES_OFFSET(RevertCenterCropParams, srcHeight, 4);
+    SHADER_TYPES_OFFSET(RevertCenterCropParams, dstWidth, 8);
+    SHADER_TYPES_OFFSET(RevertCenterCropParams, dstHeight, 12);
+    SHADER_TYPES_OFFSET(RevertCenterCropParams, scale, 16);
+    SHADER_TYPES_OFFSET(RevertCenterCropParams, offset, 24);
+
+    SHADER_TYPES_LAYOUT(MeshTriangle, 36, 4);
+    SHADER_TYPES_OFFSET(MeshTriangle, a, 0);
+    SHADER_TYPES_OFFSET(MeshTriangle, b, 12);
+    SHADER_TYPES_OFFSET(MeshTriangle, c, 24);
+
+    SHADER_TYPES_LAYOUT(MeshParams, 272, 16);
+    SHADER_TYPES_OFFSET(MeshParams, faceCount, 0);
+    SHADER_TYPES_OFFSET(MeshParams, totalCount, 4);
+    SHADER_TYPES_OFFSET(MeshParams, indicesPerFace, 8);
+    SHADER_TYPES_OFFSET(MeshParams, hasClass, 12);
+    SHADER_TYPES_OFFSET(MeshParams, anchorTransform, 16);
+    SHADER_TYPES_OFFSET(MeshParams, cameraTransform, 80);
+    SHADER_TYPES_OFFSET(MeshParams, viewMatrix, 144);
+    SHADER_TYPES_OFFSET(MeshParams, intrinsics, 208);
+    SHADER_TYPES_OFFSET(MeshParams, imageSize, 256);
+
+    SHADER_TYPES_LAYOUT(SegmentationMeshClassificationParams, 1028, 4);
+    SHADER_TYPES_OFFSET(SegmentationMeshClassificationParams, classificationLookupTable, 0);
+    SHADER_TYPES_OFFSET(SegmentationMeshClassificationParams, labelValue, 1024);
+    SHADER_TYPES_OFFSET(SegmentationMeshClassificationParams, padding, 1025);
+
+    SHADER_TYPES_LAYOUT(BoundsParams, 16, 4);
+    SHADER_TYPES_OFFSET(BoundsParams, minX, 0);
+    SHADER_TYPES_OFFSET(BoundsParams, minY, 4);
+    SHADER_TYPES_OFFSET(BoundsParams, maxX, 8);
+    SHADER_TYPES_OFFSET(BoundsParams, maxY, 12);
+
+    SHADER_TYPES_LAYOUT(WorldPoint, 16, 16);
+    SHADER_TYPES_OFFSET(WorldPoint, p, 0);
+
+    SHADER_TYPES_LAYOUT(WorldSTPoint, 8, 4);
+    SHADER_TYPES_OFFSET(WorldSTPoint, s, 0);
+    SHADER_TYPES_OFFSET(WorldSTPoint, t, 4);
+
+    SHADER_TYPES_LAYOUT(WorldPointsParams, 128, 16);
+    SHADER_TYPES_OFFSET(WorldPointsParams, imageSize, 0);
+    SHADER_TYPES_OFFSET(WorldPointsParams, minDepthThreshold, 8);
+    SHADER_TYPES_OFFSET(WorldPointsParams, maxDepthThreshold, 12);
+    SHADER_TYPES_OFFSET(WorldPointsParams, cameraTransform, 16);
+    SHADER_TYPES_OFFSET(WorldPointsParams, invIntrinsics, 80);
+
+    SHADER_TYPES_LAYOUT(ProjectedPointsParams, 192, 16);
+    SHADER_TYPES_OFFSET(ProjectedPointsParams, imageSize, 0);
+    SHADER_TYPES_OFFSET(ProjectedPointsParams, cameraTransform, 16);
+    SHADER_TYPES_OFFSET(ProjectedPointsParams, cameraIntrinsics, 80);
+    SHADER_TYPES_OFFSET(ProjectedPointsParams, longitudinalVector, 128);
+    SHADER_TYPES_OFFSET(ProjectedPointsParams, lateralVector, 144);
+    SHADER_TYPES_OFFSET(ProjectedPointsParams, normalVector, 160);
+    SHADER_TYPES_OFFSET(ProjectedPointsParams, origin, 176);
+
+    SHADER_TYPES_LAYOUT(ProjectedPointBinningParams, 20, 4);
+    SHADER_TYPES_OFFSET(ProjectedPointBinningParams, sMin, 0);
+    SHADER_TYPES_OFFSET(ProjectedPointBinningParams, sMax, 4);
+    SHADER_TYPES_OFFSET(ProjectedPointBinningParams, sBinSize, 8);
+    SHADER_TYPES_OFFSET(ProjectedPointBinningParams, binCount, 12);
+    SHADER_TYPES_OFFSET(ProjectedPointBinningParams, maxValuesPerBin, 16);
+
+    SHADER_TYPES_LAYOUT(MeshProjectedPointBinningParams, 96, 16);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, sMin, 0);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, sMax, 4);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, sBinSize, 8);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, binCount, 12);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, maxTrianglesPerBin, 16);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, longitudinalVector, 32);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, lateralVector, 48);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, normalVector, 64);
+    SHADER_TYPES_OFFSET(MeshProjectedPointBinningParams, origin, 80);
+
+    SHADER_TYPES_LAYOUT(WorldPointsGridCell, 32, 16);
+    SHADER_TYPES_OFFSET(WorldPointsGridCell, worldPoint, 0);
+    SHADER_TYPES_OFFSET(WorldPointsGridCell, isValid, 16);
+
+    SHADER_TYPES_LAYOUT(WorldPointsGridParams, 128, 16);
+    SHADER_TYPES_OFFSET(WorldPointsGridParams, imageSize, 0);
+    SHADER_TYPES_OFFSET(WorldPointsGridParams, viewMatrix, 16);
+    SHADER_TYPES_OFFSET(WorldPointsGridParams, cameraIntrinsics, 80);
+
+    SHADER_TYPES_LAYOUT(SurfaceNormalsForPointsGridCell, 48, 16);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridCell, worldPoint, 0);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridCell, surfaceNormal, 16);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridCell, isValid, 32);
+
+    SHADER_TYPES_LAYOUT(SurfaceNormalsForPointsGridParams, 128, 16);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, minStep, 0);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, maxStep, 4);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, eps, 8);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, longitudinalVector, 16);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, lateralVector, 32);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, normalVector, 48);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, origin, 64);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, projectedLongitudinalVector, 80);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, projectedLateralVector, 88);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, projectedNormalVector, 96);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, projectedOrigin, 104);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, stepL, 112);
+    SHADER_TYPES_OFFSET(SurfaceNormalsForPointsGridParams, stepT, 120);
+
+    SHADER_TYPES_LAYOUT(SurfaceNormalForMeshGridCell, 80, 16);
+    SHADER_TYPES_OFFSET(SurfaceNormalForMeshGridCell, triangle, 0);
+    SHADER_TYPES_OFFSET(SurfaceNormalForMeshGridCell, surfaceNormal, 48);
+    SHADER_TYPES_OFFSET(SurfaceNormalForMeshGridCell, isValid, 64);
+
+    SHADER_TYPES_LAYOUT(SurfaceNormalsWithinBoundsParams, 144, 16);
+    SHADER_TYPES_OFFSET(SurfaceNormalsWithinBoundsParams, gridWidth, 0);
+    SHADER_TYPES_OFFSET(SurfaceNormalsWithinBoundsParams, gridHeight, 4);
+    SHADER_TYPES_OFFSET(SurfaceNormalsWithinBoundsParams, boxCount, 8);
+    SHADER_TYPES_OFFSET(SurfaceNormalsWithinBoundsParams, viewMatrix, 16);
+    SHADER_TYPES_OFFSET(SurfaceNormalsWithinBoundsParams, cameraIntrinsics, 80);
+    SHADER_TYPES_OFFSET(SurfaceNormalsWithinBoundsParams, imageSize, 128);
+
+    SHADER_TYPES_LAYOUT(DeviantNormalParams, 32, 16);
+    SHADER_TYPES_OFFSET(DeviantNormalParams, normalVector, 0);
+    SHADER_TYPES_OFFSET(DeviantNormalParams, angularDeviationCosThreshold, 16);
+
+    SHADER_TYPES_LAYOUT(StdNormalParams, 16, 16);
+    SHADER_TYPES_OFFSET(StdNormalParams, normalVector, 0);
+
+    SHADER_TYPES_LAYOUT(AreaWithinBoundsPolygonParams, 128, 16);
+    SHADER_TYPES_OFFSET(AreaWithinBoundsPolygonParams, imageSize, 0);
+    SHADER_TYPES_OFFSET(AreaWithinBoundsPolygonParams, viewMatrix, 16);
+    SHADER_TYPES_OFFSET(AreaWithinBoundsPolygonParams, cameraIntrinsics, 80);
+
+    SHADER_TYPES_LAYOUT(StdPolygonParams, 144, 16);
+    SHADER_TYPES_OFFSET(StdPolygonParams, normalVector, 0);
+    SHADER_TYPES_OFFSET(StdPolygonParams, imageSize, 16);
+    SHADER_TYPES_OFFSET(StdPolygonParams, viewMatrix, 32);
+    SHADER_TYPES_OFFSET(StdPolygonParams, cameraIntrinsics, 96);
+
+    #undef SHADER_TYPES_OFFSET
+    #undef SHADER_TYPES_LAYOUT
+    #undef SHADER_TYPES_ALIGNOF
+    #undef SHADER_TYPES_ASSERT
+#endif
@@ -0,0 +1,68 @@
+//
+//  WorldPointsReferenceDumpExtension.swift
+//  IOSAccessAssessment
+//
+//  Created by Himanshu on 10/16/26.
+//
+
+import MetalKit
+import simd
+import PointNMapShaderTypes
+
+/**
+ Extension for recording a run of the computeWorldPoints kernel, to check the CPU engine of PointNMapCPU against the GPU.
+
+ The layout is read by WorldPointsDump.cpp of PointNMapCPU, and both have to change together.
+ */
+extension WorldPointsProcessor {
+    static let referenceDumpVersion: UInt32 = 1
+
+    func writeReferenceDump(
+        to url: URL,
+        segmentationLabelTexture: MTLTexture,
+        depthTexture: MTLTexture,
+        targetValue: UInt8,
+        params: WorldPointsParams,
+        debugBuffer: MTLBuffer,
+        debugCountSlots: Int,
+        pointsBuffer: MTLBuffer,
+        pointCount: Int
+    ) throws {
+        let width = segmentationLabelTexture.width
+        let height = segmentationLabelTexture.height
+        guard depthTexture.width == width, depthTexture.height == height else {
+            throw WorldPointsProcessorError.unableToProcessBufferData
+        }
+        var data = Data()
+        func append<T>(_ value: T) {
+            withUnsafeBytes(of: value) { data.append(contentsOf: $0) }
+        }
+        data.append(contentsOf: Array("WPRD".utf8))
+        append(WorldPointsProcessor.referenceDumpVersion)
+        append(UInt32(MemoryLayout<WorldPointsParams>.size))
+        append(UInt32(MemoryLayout<WorldPoint>.stride))
+        append(UInt32(debugCountSlots))
+        append(targetValue)
+        data.append(contentsOf: [UInt8](repeating: 0, count: 3))
+        append(params)
+        data.append(Data(bytes: debugBuffer.contents(), count: MemoryLayout<UInt32>.stride * debugCountSlots))
+        append(UInt32(pointCount))
+
+        /// The textures as the kernel read them, without row padding
+        let region = MTLRegionMake2D(0, 0, width, height)
+        var segmentation = [UInt8](repeating: 0, count: width * height)
+        segmentation.withUnsafeMutableBytes { bytes in
+            segmentationLabelTexture.getBytes(bytes.baseAddress!, bytesPerRow: width, from: region, mipmapLevel: 0)
+        }
+        data.append(contentsOf: segmentation)
+        var depth = [Float](repeating: 0, count: width * height)
+        depth.withUnsafeMutableBytes { bytes in
+            depthTexture.getBytes(
+                bytes.baseAddress!, bytesPerRow: width * MemoryLayout<Float>.stride, from: region, mipmapLevel: 0
+            )
+        }
+        depth.withUnsafeBytes { data.append(contentsOf: $0) }
+        data.append(Data(bytes: pointsBuffer.contents(), count: MemoryLayout<WorldPoint>.stride * pointCount))
+        try data.write(to: url)
+    }
+}
@@ -88,6 +88,9 @@ public struct WorldPointsProcessor {
     
     /**
         Extract world points from segmentation and depth images (GPU version).
+     
+        If referenceDumpURL is set, the inputs and outputs of the kernel are also written to it,
+        for checking the CPU engine of PointNMapCPU against the GPU.
      */
     public func getWorldPoints(
         segmentationLabelImage: CIImage,
@@ -96,7 +99,8 @@ public struct WorldPointsProcessor {
         cameraTransform: simd_float4x4,
         cameraIntrinsics: simd_float3x3,
         depthMinThreshold: Float = PointNMapConstants.DepthConstants.depthMinThreshold,
-        depthMaxThreshold: Float = PointNMapConstants.DepthConstants.depthMaxThreshold
+        depthMaxThreshold: Float = PointNMapConstants.DepthConstants.depthMaxThreshold,
+        referenceDumpURL: URL? = nil
     ) throws -> [WorldPoint] {
         guard let commandBuffer = self.commandQueue.makeCommandBuffer() else {
             throw WorldPointsProcessorError.metalPipelineCreationError
@@ -187,6 +191,15 @@ public struct WorldPointsProcessor {
                 worldPoints.append(point)
             }
         }
+        if let referenceDumpURL {
+            try self.writeReferenceDump(
+                to: referenceDumpURL,
+                segmentationLabelTexture: segmentationLabelTexture, depthTexture: depthTexture,
+                targetValue: targetValue, params: params,
+                debugBuffer: debugBuffer, debugCountSlots: debugCountSlots,
+                pointsBuffer: pointsBuffer, pointCount: actualPointCount
+            )
+        }
 //        let dbg = debugBuffer.contents().bindMemory(to: UInt32.self, capacity: debugCountSlots)
 //        debugWorldPoints(worldPoints)
         return worldPoints